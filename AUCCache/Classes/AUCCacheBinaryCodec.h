@@ -0,0 +1,43 @@
+//
+//  AUCCacheBinaryCodec.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/30.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCProtocolsDefine.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 内置二进制编解码器的标签
+FOUNDATION_EXTERN const uint8_t AUCCacheCodecTagBinary;
+
+/// ``内置二进制编解码器``
+///
+/// 把 JSON 对象树编码为带偏移表的二进制格式，解码时返回直接读取缓冲区的懒加载字典与数组，不构建整棵对象树
+/// ```
+/// binaryData
+///    ├── header       magic、版本、根节点偏移、长度（16 字节）
+///    └── records      类型（1 字节）+ 内容，所有偏移均相对数据开头
+///         ├── null / false / true
+///         ├── int64 / uint64 / double        8 字节
+///         ├── string                          长度（4 字节）+ UTF-8
+///         ├── array                           数量（4 字节）+ 元素偏移表
+///         └── dictionary                      数量（4 字节）+ (键偏移, 值偏移) 表，按键的 UTF-8 字节序排列
+/// ```
+///
+/// - Note: 懒加载字典按键二分查找，每次访问只解析被访问的字段；子容器同样是懒加载的，字符串与数字在访问时生成
+/// - Note: 懒加载对象持有缓冲区（可以是内存映射数据），不可变，`copy` 返回自身，`mutableCopy` 生成完整的可变对象
+/// - Note: 相同的键与短字符串只保存一份，接口响应中重复的字段名不会重复占用空间
+/// - Warning: 懒加载对象每次访问都会生成新的字符串与数字对象，需要反复遍历整棵树时建议先 `mutableCopy` 或使用 JSON 格式
+@interface AUCCacheBinaryCodec : NSObject <AUCCacheCodecProtocol>
+
+/// 懒加载对象（`decodedObjectWithData:` 返回的字典与数组）引用的缓冲区长度，其他对象返回 0
+///
+/// - Note: 同一个缓冲区中的子容器返回相同的长度，用于估算内存缓存成本
++ (NSUInteger)bufferLengthOfLazyObject:(id)object;
+
+@end
+
+NS_ASSUME_NONNULL_END
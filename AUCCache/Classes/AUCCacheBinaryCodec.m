@@ -0,0 +1,490 @@
+//
+//  AUCCacheBinaryCodec.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/30.
+//
+
+#import "AUCCacheBinaryCodec.h"
+
+const uint8_t AUCCacheCodecTagBinary = 2;
+
+// 'AUCB'
+static const uint32_t AUC_BINARY_MAGIC = 0x42435541;
+static const uint16_t AUC_BINARY_VERSION = 1;
+// 记录类型
+static const uint8_t AUC_BINARY_TYPE_NULL = 0;
+static const uint8_t AUC_BINARY_TYPE_FALSE = 1;
+static const uint8_t AUC_BINARY_TYPE_TRUE = 2;
+static const uint8_t AUC_BINARY_TYPE_INT64 = 3;
+static const uint8_t AUC_BINARY_TYPE_UINT64 = 4;
+static const uint8_t AUC_BINARY_TYPE_DOUBLE = 5;
+static const uint8_t AUC_BINARY_TYPE_STRING = 6;
+static const uint8_t AUC_BINARY_TYPE_ARRAY = 7;
+static const uint8_t AUC_BINARY_TYPE_DICTIONARY = 8;
+// 不超过该长度的字符串去重
+static const NSUInteger AUC_BINARY_INTERN_MAX_LENGTH = 64;
+// 最大嵌套深度，避免异常数据导致栈溢出
+static const NSUInteger AUC_BINARY_MAX_DEPTH = 512;
+// 查找时键的 UTF-8 栈缓冲区长度，更长的键转为 NSData
+#define AUC_BINARY_KEY_BUFFER_LENGTH 256
+
+/// 二进制数据头部，所有字段均为小端序
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    /// 根节点偏移
+    uint32_t root;
+    /// 数据总长度（含头部）
+    uint32_t length;
+} AUCBinaryHeader;
+
+#define AUC_BINARY_HEADER_LENGTH 16
+_Static_assert(sizeof(AUCBinaryHeader) == AUC_BINARY_HEADER_LENGTH, "binary header must be 16 bytes");
+
+// 类型 + 数量
+#define AUC_BINARY_CONTAINER_HEADER_LENGTH 5
+
+static inline BOOL AUCBinaryRead32(const uint8_t *bytes, NSUInteger length, NSUInteger offset, uint32_t *value) {
+    if (offset > length || length - offset < 4) return NO;
+    memcpy(value, bytes + offset, 4);
+    return YES;
+}
+
+static inline BOOL AUCBinaryRead64(const uint8_t *bytes, NSUInteger length, NSUInteger offset, void *value) {
+    if (offset > length || length - offset < 8) return NO;
+    memcpy(value, bytes + offset, 8);
+    return YES;
+}
+
+/// 字符串记录的 UTF-8 字节，不是合法字符串记录时返回 NO
+static BOOL AUCBinaryReadString(const uint8_t *bytes, NSUInteger length, uint32_t offset, const uint8_t **stringBytes, uint32_t *stringLength) {
+    if (offset >= length || bytes[offset] != AUC_BINARY_TYPE_STRING) return NO;
+    if (!AUCBinaryRead32(bytes, length, offset + 1, stringLength)) return NO;
+    NSUInteger start = (NSUInteger)offset + AUC_BINARY_CONTAINER_HEADER_LENGTH;
+    if (*stringLength > length - start) return NO;
+    *stringBytes = bytes + start;
+    return YES;
+}
+
+/// 容器记录的元素数量，表长度超出数据时返回 NO
+static BOOL AUCBinaryReadContainer(const uint8_t *bytes, NSUInteger length, uint32_t offset, uint8_t type, NSUInteger entryLength, NSUInteger *count) {
+    if (offset >= length || bytes[offset] != type) return NO;
+    uint32_t value;
+    if (!AUCBinaryRead32(bytes, length, offset + 1, &value)) return NO;
+    NSUInteger start = (NSUInteger)offset + AUC_BINARY_CONTAINER_HEADER_LENGTH;
+    if (value > (length - start) / entryLength) return NO;
+    *count = value;
+    return YES;
+}
+
+static inline NSComparisonResult AUCBinaryCompareBytes(const uint8_t *bytes1, NSUInteger length1, const uint8_t *bytes2, NSUInteger length2) {
+    int result = memcmp(bytes1, bytes2, MIN(length1, length2));
+    if (result != 0) return result < 0 ? NSOrderedAscending : NSOrderedDescending;
+    if (length1 == length2) return NSOrderedSame;
+    return length1 < length2 ? NSOrderedAscending : NSOrderedDescending;
+}
+
+static id AUCBinaryObjectAtOffset(NSData *buffer, uint32_t offset);
+static id AUCBinaryMutableCopyOfObject(id object);
+
+#pragma mark - Lazy Array
+@interface _AUCBinaryArray : NSArray {
+@public
+    NSData *_buffer;
+    uint32_t _offset;
+    NSUInteger _count;
+}
+@end
+
+@implementation _AUCBinaryArray
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"*** -[%@ objectAtIndex:]: index %lu beyond bounds [0 .. %ld]", self.class, (unsigned long)index, (long)_count - 1];
+    }
+    uint32_t elementOffset = 0;
+    AUCBinaryRead32(_buffer.bytes, _buffer.length, (NSUInteger)_offset + AUC_BINARY_CONTAINER_HEADER_LENGTH + index * 4, &elementOffset);
+    // 数组不能包含 nil，损坏的元素以 NSNull 代替
+    return AUCBinaryObjectAtOffset(_buffer, elementOffset) ?: NSNull.null;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+// 默认实现只复制一层，子容器仍是懒加载的，这里逐层生成可变对象
+- (id)mutableCopyWithZone:(NSZone *)zone {
+    NSMutableArray *array = [[NSMutableArray allocWithZone:zone] initWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; i++) {
+        [array addObject:AUCBinaryMutableCopyOfObject([self objectAtIndex:i])];
+    }
+    return array;
+}
+
+@end
+
+#pragma mark - Lazy Dictionary
+@interface _AUCBinaryDictionary : NSDictionary {
+@public
+    NSData *_buffer;
+    uint32_t _offset;
+    NSUInteger _count;
+}
+@end
+
+@implementation _AUCBinaryDictionary
+
+- (NSUInteger)count {
+    return _count;
+}
+
+/// 第 `index` 项的键偏移与值偏移
+- (void)getEntryAtIndex:(NSUInteger)index keyOffset:(uint32_t *)keyOffset valueOffset:(uint32_t *)valueOffset {
+    NSUInteger entryOffset = (NSUInteger)_offset + AUC_BINARY_CONTAINER_HEADER_LENGTH + index * 8;
+    *keyOffset = *valueOffset = 0;
+    AUCBinaryRead32(_buffer.bytes, _buffer.length, entryOffset, keyOffset);
+    AUCBinaryRead32(_buffer.bytes, _buffer.length, entryOffset + 4, valueOffset);
+}
+
+- (id)objectForKey:(id)aKey {
+    if (![aKey isKindOfClass:NSString.class] || _count == 0) return nil;
+    NSString *key = (NSString *)aKey;
+    uint8_t stackBuffer[AUC_BINARY_KEY_BUFFER_LENGTH];
+    const uint8_t *keyBytes = stackBuffer;
+    NSUInteger keyLength = 0;
+    NSRange remainingRange;
+    NSData *keyData = nil;
+    [key getBytes:stackBuffer maxLength:AUC_BINARY_KEY_BUFFER_LENGTH usedLength:&keyLength encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, key.length) remainingRange:&remainingRange];
+    if (remainingRange.length > 0) {
+        keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+        keyBytes = keyData.bytes;
+        keyLength = keyData.length;
+    }
+
+    const uint8_t *bytes = _buffer.bytes;
+    NSUInteger length = _buffer.length;
+    NSUInteger low = 0, high = _count;
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        uint32_t keyOffset, valueOffset, entryKeyLength;
+        const uint8_t *entryKeyBytes;
+        [self getEntryAtIndex:middle keyOffset:&keyOffset valueOffset:&valueOffset];
+        if (!AUCBinaryReadString(bytes, length, keyOffset, &entryKeyBytes, &entryKeyLength)) return nil;
+        NSComparisonResult result = AUCBinaryCompareBytes(entryKeyBytes, entryKeyLength, keyBytes, keyLength);
+        if (result == NSOrderedSame) return AUCBinaryObjectAtOffset(_buffer, valueOffset);
+        if (result == NSOrderedAscending) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return nil;
+}
+
+- (NSEnumerator *)keyEnumerator {
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; i++) {
+        uint32_t keyOffset, valueOffset;
+        [self getEntryAtIndex:i keyOffset:&keyOffset valueOffset:&valueOffset];
+        NSString *key = AUCBinaryObjectAtOffset(_buffer, keyOffset);
+        if ([key isKindOfClass:NSString.class]) [keys addObject:key];
+    }
+    return keys.objectEnumerator;
+}
+
+// 顺序读取偏移表，避免默认实现对每个键再二分查找一次
+- (void)enumerateKeysAndObjectsWithOptions:(NSEnumerationOptions)opts usingBlock:(void (NS_NOESCAPE ^)(id key, id obj, BOOL *stop))block {
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < _count && !stop; i++) {
+        uint32_t keyOffset, valueOffset;
+        [self getEntryAtIndex:i keyOffset:&keyOffset valueOffset:&valueOffset];
+        NSString *key = AUCBinaryObjectAtOffset(_buffer, keyOffset);
+        id value = AUCBinaryObjectAtOffset(_buffer, valueOffset);
+        if (![key isKindOfClass:NSString.class] || !value) continue;
+        block(key, value, &stop);
+    }
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (NS_NOESCAPE ^)(id key, id obj, BOOL *stop))block {
+    [self enumerateKeysAndObjectsWithOptions:0 usingBlock:block];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone {
+    NSMutableDictionary *dictionary = [[NSMutableDictionary allocWithZone:zone] initWithCapacity:_count];
+    [self enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+        dictionary[key] = AUCBinaryMutableCopyOfObject(obj);
+    }];
+    return dictionary;
+}
+
+@end
+
+/// 懒加载容器转换为可变容器，其他对象原样返回
+static id AUCBinaryMutableCopyOfObject(id object) {
+    if ([object isKindOfClass:_AUCBinaryDictionary.class] || [object isKindOfClass:_AUCBinaryArray.class]) {
+        return [object mutableCopy];
+    }
+    return object;
+}
+
+static id AUCBinaryObjectAtOffset(NSData *buffer, uint32_t offset) {
+    const uint8_t *bytes = buffer.bytes;
+    NSUInteger length = buffer.length;
+    if (offset >= length) return nil;
+    switch (bytes[offset]) {
+        case AUC_BINARY_TYPE_NULL:
+            return NSNull.null;
+        case AUC_BINARY_TYPE_FALSE:
+            return @NO;
+        case AUC_BINARY_TYPE_TRUE:
+            return @YES;
+        case AUC_BINARY_TYPE_INT64: {
+            int64_t value;
+            return AUCBinaryRead64(bytes, length, (NSUInteger)offset + 1, &value) ? @(value) : nil;
+        }
+        case AUC_BINARY_TYPE_UINT64: {
+            uint64_t value;
+            return AUCBinaryRead64(bytes, length, (NSUInteger)offset + 1, &value) ? @(value) : nil;
+        }
+        case AUC_BINARY_TYPE_DOUBLE: {
+            double value;
+            return AUCBinaryRead64(bytes, length, (NSUInteger)offset + 1, &value) ? @(value) : nil;
+        }
+        case AUC_BINARY_TYPE_STRING: {
+            const uint8_t *stringBytes;
+            uint32_t stringLength;
+            if (!AUCBinaryReadString(bytes, length, offset, &stringBytes, &stringLength)) return nil;
+            return [[NSString alloc] initWithBytes:stringBytes length:stringLength encoding:NSUTF8StringEncoding];
+        }
+        case AUC_BINARY_TYPE_ARRAY: {
+            NSUInteger count;
+            if (!AUCBinaryReadContainer(bytes, length, offset, AUC_BINARY_TYPE_ARRAY, 4, &count)) return nil;
+            _AUCBinaryArray *array = [_AUCBinaryArray new];
+            array->_buffer = buffer;
+            array->_offset = offset;
+            array->_count = count;
+            return array;
+        }
+        case AUC_BINARY_TYPE_DICTIONARY: {
+            NSUInteger count;
+            if (!AUCBinaryReadContainer(bytes, length, offset, AUC_BINARY_TYPE_DICTIONARY, 8, &count)) return nil;
+            _AUCBinaryDictionary *dictionary = [_AUCBinaryDictionary new];
+            dictionary->_buffer = buffer;
+            dictionary->_offset = offset;
+            dictionary->_count = count;
+            return dictionary;
+        }
+        default:
+            return nil;
+    }
+}
+
+#pragma mark - Writer
+/// 后序写入：先写子节点，再写引用子节点偏移的容器记录
+@interface _AUCBinaryWriter : NSObject
+
+@property (nonatomic, strong, nonnull) NSMutableData *output;
+/// 短字符串 -> 偏移
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSString *, NSNumber *> *strings;
+/// null、false、true 只写入一次，0 表示尚未写入（偏移 0 为头部，不会是记录）
+@property (nonatomic, assign) uint32_t nullOffset;
+@property (nonatomic, assign) uint32_t falseOffset;
+@property (nonatomic, assign) uint32_t trueOffset;
+
+@end
+
+@implementation _AUCBinaryWriter
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _output = [NSMutableData dataWithLength:AUC_BINARY_HEADER_LENGTH];
+        _strings = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+/// 写入记录，返回其偏移；数据超过 4GB 时返回 NO
+- (BOOL)appendType:(uint8_t)type bytes:(const void *)bytes length:(NSUInteger)length offset:(uint32_t *)offset {
+    NSUInteger position = self.output.length;
+    if (position + 1 + length > UINT32_MAX) return NO;
+    [self.output appendBytes:&type length:1];
+    if (length > 0) [self.output appendBytes:bytes length:length];
+    *offset = (uint32_t)position;
+    return YES;
+}
+
+- (BOOL)writeString:(NSString *)string offset:(uint32_t *)offset {
+    BOOL shouldIntern = string.length <= AUC_BINARY_INTERN_MAX_LENGTH;
+    NSNumber *existing = shouldIntern ? self.strings[string] : nil;
+    if (existing) {
+        *offset = existing.unsignedIntValue;
+        return YES;
+    }
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    if (!data || data.length > UINT32_MAX) return NO;
+    uint32_t length = (uint32_t)data.length;
+    NSUInteger position = self.output.length;
+    if (![self appendType:AUC_BINARY_TYPE_STRING bytes:&length length:4 offset:offset]) return NO;
+    if (position + AUC_BINARY_CONTAINER_HEADER_LENGTH + data.length > UINT32_MAX) return NO;
+    [self.output appendData:data];
+    if (shouldIntern) self.strings[string] = @(*offset);
+    return YES;
+}
+
+- (BOOL)writeNumber:(NSNumber *)number offset:(uint32_t *)offset {
+    if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+        BOOL value = number.boolValue;
+        uint32_t cached = value ? self.trueOffset : self.falseOffset;
+        if (cached > 0) {
+            *offset = cached;
+            return YES;
+        }
+        if (![self appendType:(value ? AUC_BINARY_TYPE_TRUE : AUC_BINARY_TYPE_FALSE) bytes:NULL length:0 offset:offset]) return NO;
+        if (value) {
+            self.trueOffset = *offset;
+        } else {
+            self.falseOffset = *offset;
+        }
+        return YES;
+    }
+    const char *type = number.objCType;
+    if (type[0] == 'd' || type[0] == 'f' || [number isKindOfClass:NSDecimalNumber.class]) {
+        double value = number.doubleValue;
+        return [self appendType:AUC_BINARY_TYPE_DOUBLE bytes:&value length:8 offset:offset];
+    }
+    if ((type[0] == 'Q' || type[0] == 'L') && number.unsignedLongLongValue > INT64_MAX) {
+        uint64_t value = number.unsignedLongLongValue;
+        return [self appendType:AUC_BINARY_TYPE_UINT64 bytes:&value length:8 offset:offset];
+    }
+    int64_t value = number.longLongValue;
+    return [self appendType:AUC_BINARY_TYPE_INT64 bytes:&value length:8 offset:offset];
+}
+
+/// 写入容器记录：类型、数量与偏移表
+- (BOOL)appendContainerType:(uint8_t)type count:(NSUInteger)count table:(const uint32_t *)table tableLength:(NSUInteger)tableLength offset:(uint32_t *)offset {
+    if (count > UINT32_MAX) return NO;
+    uint32_t count32 = (uint32_t)count;
+    NSUInteger position = self.output.length;
+    if (position + AUC_BINARY_CONTAINER_HEADER_LENGTH + tableLength * 4 > UINT32_MAX) return NO;
+    if (![self appendType:type bytes:&count32 length:4 offset:offset]) return NO;
+    if (tableLength > 0) [self.output appendBytes:table length:tableLength * 4];
+    return YES;
+}
+
+- (BOOL)writeObject:(id)object depth:(NSUInteger)depth offset:(uint32_t *)offset {
+    if (depth > AUC_BINARY_MAX_DEPTH) return NO;
+    if ([object isKindOfClass:NSString.class]) {
+        return [self writeString:object offset:offset];
+    }
+    if ([object isKindOfClass:NSNumber.class]) {
+        return [self writeNumber:object offset:offset];
+    }
+    if (object == (id)kCFNull) {
+        if (self.nullOffset == 0) {
+            uint32_t nullOffset;
+            if (![self appendType:AUC_BINARY_TYPE_NULL bytes:NULL length:0 offset:&nullOffset]) return NO;
+            self.nullOffset = nullOffset;
+        }
+        *offset = self.nullOffset;
+        return YES;
+    }
+    if ([object isKindOfClass:NSArray.class]) {
+        NSArray *array = (NSArray *)object;
+        NSUInteger count = array.count;
+        uint32_t *table = malloc(MAX(count, (NSUInteger)1) * 4);
+        if (!table) return NO;
+        BOOL succeeded = YES;
+        NSUInteger index = 0;
+        for (id element in array) {
+            if (![self writeObject:element depth:depth + 1 offset:&table[index++]]) {
+                succeeded = NO;
+                break;
+            }
+        }
+        succeeded = succeeded && [self appendContainerType:AUC_BINARY_TYPE_ARRAY count:count table:table tableLength:count offset:offset];
+        free(table);
+        return succeeded;
+    }
+    if ([object isKindOfClass:NSDictionary.class]) {
+        NSDictionary *dictionary = (NSDictionary *)object;
+        NSUInteger count = dictionary.count;
+        // 按键的 UTF-8 字节序排列，读取时二分查找
+        NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:count];
+        NSMutableDictionary<NSString *, NSData *> *keyBytes = [NSMutableDictionary dictionaryWithCapacity:count];
+        for (id key in dictionary) {
+            if (![key isKindOfClass:NSString.class]) return NO;
+            NSData *data = [(NSString *)key dataUsingEncoding:NSUTF8StringEncoding];
+            if (!data) return NO;
+            [keys addObject:key];
+            keyBytes[key] = data;
+        }
+        [keys sortUsingComparator:^NSComparisonResult(NSString *key1, NSString *key2) {
+            NSData *data1 = keyBytes[key1], *data2 = keyBytes[key2];
+            return AUCBinaryCompareBytes(data1.bytes, data1.length, data2.bytes, data2.length);
+        }];
+        uint32_t *table = malloc(MAX(count, (NSUInteger)1) * 8);
+        if (!table) return NO;
+        BOOL succeeded = YES;
+        for (NSUInteger i = 0; i < count && succeeded; i++) {
+            succeeded = [self writeString:keys[i] offset:&table[i * 2]]
+                && [self writeObject:dictionary[keys[i]] depth:depth + 1 offset:&table[i * 2 + 1]];
+        }
+        succeeded = succeeded && [self appendContainerType:AUC_BINARY_TYPE_DICTIONARY count:count table:table tableLength:count * 2 offset:offset];
+        free(table);
+        return succeeded;
+    }
+    return NO;
+}
+
+@end
+
+#pragma mark - Codec
+@implementation AUCCacheBinaryCodec
+
+- (uint8_t)codecTag {
+    return AUCCacheCodecTagBinary;
+}
+
+- (BOOL)canEncodeObject:(id)object {
+    return ([object isKindOfClass:NSDictionary.class] || [object isKindOfClass:NSArray.class]) && [NSJSONSerialization isValidJSONObject:object];
+}
+
+- (NSData *)encodedDataWithObject:(id)object {
+    _AUCBinaryWriter *writer = [_AUCBinaryWriter new];
+    uint32_t root;
+    if (![writer writeObject:object depth:0 offset:&root]) return nil;
+    AUCBinaryHeader header = {0};
+    header.magic = AUC_BINARY_MAGIC;
+    header.version = AUC_BINARY_VERSION;
+    header.root = root;
+    header.length = (uint32_t)writer.output.length;
+    [writer.output replaceBytesInRange:NSMakeRange(0, AUC_BINARY_HEADER_LENGTH) withBytes:&header];
+    return writer.output;
+}
+
+- (id)decodedObjectWithData:(NSData *)data {
+    if (data.length < AUC_BINARY_HEADER_LENGTH) return nil;
+    AUCBinaryHeader header;
+    memcpy(&header, data.bytes, AUC_BINARY_HEADER_LENGTH);
+    if (header.magic != AUC_BINARY_MAGIC || header.version != AUC_BINARY_VERSION || header.length != data.length) return nil;
+    if (header.root < AUC_BINARY_HEADER_LENGTH) return nil;
+    return AUCBinaryObjectAtOffset(data, header.root);
+}
+
++ (NSUInteger)bufferLengthOfLazyObject:(id)object {
+    if ([object isKindOfClass:_AUCBinaryDictionary.class]) return ((_AUCBinaryDictionary *)object)->_buffer.length;
+    if ([object isKindOfClass:_AUCBinaryArray.class]) return ((_AUCBinaryArray *)object)->_buffer.length;
+    return 0;
+}
+
+@end
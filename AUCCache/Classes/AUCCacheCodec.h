@@ -0,0 +1,105 @@
+//
+//  AUCCacheCodec.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/29.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCProtocolsDefine.h"
+#import "AUCCacheBinaryCodec.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 内置 JSON 编解码器的标签
+FOUNDATION_EXTERN const uint8_t AUCCacheCodecTagJSON;
+
+/// ``内置 JSON 编解码器``
+///
+/// 编码 `NSJSONSerialization` 支持的 `NSDictionary`/`NSArray` 树，默认输出紧凑格式（无换行与缩进）
+@interface AUCCacheJSONCodec : NSObject <AUCCacheCodecProtocol>
+
+/// 编码选项
+///
+/// - Note: 默认为`0 - 紧凑格式`，调试时可设置为 `NSJSONWritingPrettyPrinted`，不影响读取
+@property (nonatomic, assign) NSJSONWritingOptions writingOptions;
+
+/// 解码时是否使用基于 SIMD 结构索引的解析器（`AUCJSONParser`）
+///
+/// - Note: 默认为`NO`，使用 `NSJSONSerialization`。开启后结构索引解析器无法解析的数据（非 UTF-8、非法 JSON 等）仍回退到 `NSJSONSerialization`，结果与关闭时相同
+@property (nonatomic, assign) BOOL usesStructuralIndexParser;
+
+@end
+
+/// ``磁盘数据编解码``
+///
+/// 按注册顺序选择编解码器编码缓存对象，并在数据前加上带标签的帧头；读取时按标签选择解码器，每次命中只解码一次
+/// ```
+/// encodedData
+///    ├── header    magic、标签、版本、头部校验和（8 字节）
+///    └── payload   编解码器输出的数据
+/// ```
+///
+/// - Note: `NSData` 与 `NSString`（UTF-8）按原样保存，不带帧头，与早期版本写入的数据相同
+/// - Note: 不带帧头的数据按早期规则解码：可以解析为 JSON 时返回解析结果，否则返回原始数据
+/// - Note: 帧头标签没有对应的解码器（例如移除了自定义编解码器）或解码失败时返回 nil，按未命中处理
+/// - Note: 编码在压缩之前，帧头与数据一起压缩
+/// - Note: 内置 JSON 与二进制（`AUCCacheBinaryCodec`）编解码器总是可以解码，切换编码格式不影响已有缓存的读取
+@interface AUCCacheCodecRegistry : NSObject
+
+/// 创建编解码器注册表
+///
+/// - Parameters:
+///     - codecs: 自定义编解码器，编码时先于内置编解码器选择；与已注册编解码器标签相同的会被忽略
+///     - binaryFormat: 是否以二进制格式编码 JSON 对象树，为 NO 时以 JSON 编码
+- (instancetype)initWithCodecs:(nullable NSArray<id<AUCCacheCodecProtocol>> *)codecs binaryFormat:(BOOL)binaryFormat NS_DESIGNATED_INITIALIZER;
+
+/// 以 JSON 编码 JSON 对象树
+- (instancetype)initWithCodecs:(nullable NSArray<id<AUCCacheCodecProtocol>> *)codecs;
+
+/// 只包含内置编解码器
+- (instancetype)init;
+
+/// 内置 JSON 编解码器
+@property (nonatomic, strong, readonly) AUCCacheJSONCodec *JSONCodec;
+
+/// 内置二进制编解码器
+@property (nonatomic, strong, readonly) AUCCacheBinaryCodec *binaryCodec;
+
+/// 编码缓存对象
+///
+/// - Returns: 待写入磁盘的数据，没有编解码器支持该对象或编码失败时返回 nil
+- (nullable NSData *)encodedDataForObject:(id)object;
+
+/// 解码磁盘数据
+///
+/// - Returns: 缓存对象，数据损坏或缺少解码器时返回 nil
+- (nullable id)decodedObjectForData:(NSData *)data;
+
+/// 去掉帧头后的数据，不拷贝；不带帧头的数据原样返回
+- (NSData *)payloadOfData:(NSData *)data;
+
+/// 以 `NSData` 返回给调用方的数据：二进制格式的数据转换为 JSON，其余去掉帧头后返回
+///
+/// - Note: 调用方拿到的始终是与关闭二进制格式时相同的 JSON 字节，不会看到 `AUCCacheBinaryCodec` 的内部格式；转换失败时返回 nil
+- (nullable NSData *)externalDataOfData:(NSData *)data;
+
+/// 数据帧头中的标签，不带帧头时返回 0
++ (uint8_t)codecTagOfData:(NSData *)data;
+
+#pragma mark - Statistics
+/// 解码次数
+@property (nonatomic, assign, readonly) NSUInteger decodeCount;
+
+/// 解码的总字节数
+@property (nonatomic, assign, readonly) uint64_t decodedBytes;
+
+/// 解码累计耗时，单位为【秒】
+@property (nonatomic, assign, readonly) NSTimeInterval decodeTime;
+
+/// 清零统计数据
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
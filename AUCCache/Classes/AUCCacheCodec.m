@@ -0,0 +1,202 @@
+//
+//  AUCCacheCodec.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/29.
+//
+
+#import "AUCCacheCodec.h"
+#import "AUCChecksum.h"
+#import "AUCJSONParser.h"
+#import <stdatomic.h>
+
+const uint8_t AUCCacheCodecTagJSON = 1;
+
+// 'AUCT'
+static const uint32_t AUC_CODEC_MAGIC = 0x54435541;
+static const uint8_t AUC_CODEC_VERSION = 1;
+
+/// 编解码帧头，所有字段均为小端序
+typedef struct {
+    uint32_t magic;
+    uint8_t tag;
+    uint8_t version;
+    /// 头部前 6 字节 CRC32C 的低 16 位，用于区分带帧头的数据与恰好以 magic 开头的原始数据
+    uint16_t headerChecksum;
+} AUCCodecHeader;
+
+#define AUC_CODEC_HEADER_LENGTH 8
+_Static_assert(sizeof(AUCCodecHeader) == AUC_CODEC_HEADER_LENGTH, "codec header must be 8 bytes");
+
+static inline uint16_t AUCCodecHeaderChecksum(const AUCCodecHeader *header) {
+    return (uint16_t)AUCCRC32C(0, header, offsetof(AUCCodecHeader, headerChecksum));
+}
+
+/// 解析帧头，不带帧头时返回 NO
+static BOOL AUCCodecReadHeader(NSData *data, AUCCodecHeader *header) {
+    if (data.length < AUC_CODEC_HEADER_LENGTH) return NO;
+    memcpy(header, data.bytes, AUC_CODEC_HEADER_LENGTH);
+    return header->magic == AUC_CODEC_MAGIC && header->headerChecksum == AUCCodecHeaderChecksum(header);
+}
+
+/// 不拷贝地截取帧头之后的数据，返回的数据持有原数据
+static NSData *AUCCodecPayload(NSData *data) {
+    return [[NSData alloc] initWithBytesNoCopy:(uint8_t *)data.bytes + AUC_CODEC_HEADER_LENGTH length:data.length - AUC_CODEC_HEADER_LENGTH deallocator:^(void *bytes, NSUInteger length) {
+        (void)data;
+    }];
+}
+
+static inline uint64_t AUCCodecNanosecondsSince(CFAbsoluteTime start) {
+    return (uint64_t)((CFAbsoluteTimeGetCurrent() - start) * NSEC_PER_SEC);
+}
+
+@implementation AUCCacheJSONCodec
+
+- (uint8_t)codecTag {
+    return AUCCacheCodecTagJSON;
+}
+
+- (BOOL)canEncodeObject:(id)object {
+    return ([object isKindOfClass:NSDictionary.class] || [object isKindOfClass:NSArray.class]) && [NSJSONSerialization isValidJSONObject:object];
+}
+
+- (NSData *)encodedDataWithObject:(id)object {
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:object options:self.writingOptions error:&error];
+    return error == nil ? data : nil;
+}
+
+- (id)decodedObjectWithData:(NSData *)data {
+    if (self.usesStructuralIndexParser) {
+        id object = [AUCJSONParser JSONObjectWithData:data];
+        if (object) return object;
+    }
+    return [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingFragmentsAllowed error:nil];
+}
+
+@end
+
+@implementation AUCCacheCodecRegistry {
+    /// 编码时的选择顺序
+    NSArray<id<AUCCacheCodecProtocol>> *_codecs;
+    /// 标签 -> 编解码器
+    id<AUCCacheCodecProtocol> _codecsByTag[256];
+
+    _Atomic(uint64_t) _decodeCount;
+    _Atomic(uint64_t) _decodedBytes;
+    _Atomic(uint64_t) _decodeNanoseconds;
+}
+
+- (instancetype)init {
+    return [self initWithCodecs:nil];
+}
+
+- (instancetype)initWithCodecs:(NSArray<id<AUCCacheCodecProtocol>> *)codecs {
+    return [self initWithCodecs:codecs binaryFormat:NO];
+}
+
+- (instancetype)initWithCodecs:(NSArray<id<AUCCacheCodecProtocol>> *)codecs binaryFormat:(BOOL)binaryFormat {
+    if (self = [super init]) {
+        _JSONCodec = [AUCCacheJSONCodec new];
+        _binaryCodec = [AUCCacheBinaryCodec new];
+        // 两个内置编解码器支持的对象相同，排在前面的用于编码，另一个只用于解码
+        NSArray<id<AUCCacheCodecProtocol>> *builtinCodecs = binaryFormat ? @[_binaryCodec, _JSONCodec] : @[_JSONCodec, _binaryCodec];
+        NSMutableArray<id<AUCCacheCodecProtocol>> *orderedCodecs = [NSMutableArray arrayWithCapacity:codecs.count + builtinCodecs.count];
+        for (id<AUCCacheCodecProtocol> codec in [(codecs ?: @[]) arrayByAddingObjectsFromArray:builtinCodecs]) {
+            uint8_t tag = codec.codecTag;
+            NSAssert(tag != 0 && !_codecsByTag[tag], @"编解码器标签不能为 0，也不能与已注册的编解码器相同");
+            if (tag == 0 || _codecsByTag[tag]) continue;
+            _codecsByTag[tag] = codec;
+            [orderedCodecs addObject:codec];
+        }
+        _codecs = [orderedCodecs copy];
+    }
+    return self;
+}
+
+#pragma mark - Encode
+- (NSData *)encodedDataForObject:(id)object {
+    if ([object isKindOfClass:NSData.class]) return object;
+    if ([object isKindOfClass:NSString.class]) return [(NSString *)object dataUsingEncoding:NSUTF8StringEncoding];
+
+    for (id<AUCCacheCodecProtocol> codec in _codecs) {
+        if (![codec canEncodeObject:object]) continue;
+        NSData *payload = [codec encodedDataWithObject:object];
+        if (!payload) return nil;
+        AUCCodecHeader header = {0};
+        header.magic = AUC_CODEC_MAGIC;
+        header.tag = codec.codecTag;
+        header.version = AUC_CODEC_VERSION;
+        header.headerChecksum = AUCCodecHeaderChecksum(&header);
+        NSMutableData *data = [NSMutableData dataWithCapacity:AUC_CODEC_HEADER_LENGTH + payload.length];
+        [data appendBytes:&header length:AUC_CODEC_HEADER_LENGTH];
+        [data appendData:payload];
+        return data;
+    }
+    return nil;
+}
+
+#pragma mark - Decode
+- (id)decodedObjectForData:(NSData *)data {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    id object = nil;
+    AUCCodecHeader header;
+    if (AUCCodecReadHeader(data, &header)) {
+        id<AUCCacheCodecProtocol> codec = _codecsByTag[header.tag];
+        if (!codec) return nil;
+        object = [codec decodedObjectWithData:AUCCodecPayload(data)];
+    } else {
+        // 早期版本写入或按原样保存的数据
+        object = [_JSONCodec decodedObjectWithData:data] ?: data;
+    }
+    atomic_fetch_add_explicit(&_decodeCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_decodedBytes, data.length, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_decodeNanoseconds, AUCCodecNanosecondsSince(start), memory_order_relaxed);
+    return object;
+}
+
+- (NSData *)payloadOfData:(NSData *)data {
+    AUCCodecHeader header;
+    return AUCCodecReadHeader(data, &header) ? AUCCodecPayload(data) : data;
+}
+
+- (NSData *)externalDataOfData:(NSData *)data {
+    AUCCodecHeader header;
+    if (!AUCCodecReadHeader(data, &header)) return data;
+    if (header.tag != AUCCacheCodecTagBinary) return AUCCodecPayload(data);
+
+    id object = [self decodedObjectForData:data];
+    return object ? [_JSONCodec encodedDataWithObject:object] : nil;
+}
+
++ (uint8_t)codecTagOfData:(NSData *)data {
+    AUCCodecHeader header;
+    return AUCCodecReadHeader(data, &header) ? header.tag : 0;
+}
+
+#pragma mark - Statistics
+- (NSUInteger)decodeCount {
+    return (NSUInteger)atomic_load_explicit(&_decodeCount, memory_order_relaxed);
+}
+
+- (uint64_t)decodedBytes {
+    return atomic_load_explicit(&_decodedBytes, memory_order_relaxed);
+}
+
+- (NSTimeInterval)decodeTime {
+    return (NSTimeInterval)atomic_load_explicit(&_decodeNanoseconds, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+- (void)resetStatistics {
+    atomic_store_explicit(&_decodeCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_decodedBytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&_decodeNanoseconds, 0, memory_order_relaxed);
+}
+
+- (NSString *)description {
+    NSUInteger decodeCount = self.decodeCount;
+    return [NSString stringWithFormat:@"<%@: %p, codecs: %lu, decodeCount: %lu, averageDecodeTime: %.1fus>",
+            self.class, self, (unsigned long)_codecs.count, (unsigned long)decodeCount, decodeCount > 0 ? self.decodeTime * 1e6 / decodeCount : 0];
+}
+
+@end
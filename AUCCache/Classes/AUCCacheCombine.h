@@ -9,9 +9,22 @@
 #import <UIKit/UIKit.h>
 #import "AUCCacheConfig.h"
 #import "AUCProtocolsDefine.h"
+#import "AUCCacheCompressor.h"
+#import "AUCCacheCodec.h"
+#import "AUCCallbackExecutor.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// 磁盘 IO 优先级，值为 `AUCIOPriority` 的 `NSNumber`
+///
+/// 未指定时查询为 `AUCIOPriorityInteractive`，异步写入为 `AUCIOPriorityWriteBack`；例如把列表预加载的查询设为 `AUCIOPriorityPrefetch`，不与用户正在等待的读取竞争
+FOUNDATION_EXTERN AUCacheContextOption const AUCCacheContextIOPriority;
+
+/// 本次调用完成回调的执行器，值为 `AUCCallbackExecutor`
+///
+/// 未指定时使用 `AUCCacheConfig.callbackExecutor`；例如后台预加载传入 `AUCCallbackExecutor.inlineExecutor`，回调不经过主线程
+FOUNDATION_EXTERN AUCacheContextOption const AUCCacheContextCallbackExecutor;
+
 /// `AUCCacheCombine`维护一个``内存缓存``和一个``磁盘缓存``
 /// 磁盘缓存的写入操作是异步执行的，并且做了相应的优化，因此不会给用户界面增加不必要的延迟
 ///
@@ -20,6 +33,8 @@ NS_ASSUME_NONNULL_BEGIN
 ///    ├── AUCCacheConfig       缓存配置
 ///    ├── AUCMemoryCache       内存缓存
 ///    ├── AUCDiskCache         磁盘缓存
+///    ├── AUCCacheCompressor   磁盘数据压缩
+///    ├── AUCCacheCodecRegistry 磁盘数据编解码
 ///    ├── AUCCacheDirectory    缓存目录管理(暂未依据优先级划分)
 /// ```
 @interface AUCCacheCombine : NSObject
@@ -47,6 +62,16 @@ NS_ASSUME_NONNULL_BEGIN
 /// 默认磁盘缓存路径
 @property (nonatomic, copy, nonnull, readonly) NSString *diskCachePath;
 
+/// 磁盘数据压缩器，由 `diskCacheCompression*` 配置创建
+///
+/// - Note: 可读取压缩率（`compressionRatio`）与解压吞吐量（`decodeThroughput`）评估压缩效果
+@property (nonatomic, strong, readonly, nonnull) AUCCacheCompressor *compressor;
+
+/// 磁盘数据编解码器注册表，由 `diskCacheCodecs` 配置创建
+///
+/// - Note: 可读取解码次数（`decodeCount`）与解码耗时（`decodeTime`）评估磁盘命中的解码开销
+@property (nonatomic, strong, readonly, nonnull) AUCCacheCodecRegistry *codecRegistry;
+
 /// 自定义预加载缓存的附加缓存路径
 /// 如果磁盘缓存中的查询不存在，则检查附加磁盘缓存路径
 ///
@@ -130,6 +155,21 @@ NS_ASSUME_NONNULL_BEGIN
            toDisk:(BOOL)toDisk
        completion:(nullable AUCVoidParamsBlock)completionBlock;
 
+/// 以``异步``方式将JSON数据按给定键值存储到内存和磁盘缓存中
+///
+/// - Parameters:
+///     - data: 需要存储的数据 - 通常为NSDictionary、NSArray、JSON String、JSON Data类型，超出以上类型存储会被短暂存储到内存缓存中，不会做持久化处理
+///     - key: 数据缓存键，通常是请求的URL
+///     - toDisk: 如果为YES，则将图像存储到磁盘缓存
+///     - context: 参考`AUCCacheContext`，目前支持 `AUCCacheContextIOPriority`、`AUCCacheContextCallbackExecutor`
+///     - completionBlock: 操作完成后执行的块
+/// - Note: 开启组提交时写入统一以 `AUCIOPriorityWriteBack` 提交，`AUCCacheContextIOPriority` 不生效
+- (void)storeData:(nullable id)data
+           forKey:(nullable NSString *)key
+           toDisk:(BOOL)toDisk
+          context:(nullable AUCCacheContext *)context
+       completion:(nullable AUCVoidParamsBlock)completionBlock;
+
 
 #pragma mark - Contains、Check Ops
 /// ``【异步】``检查磁盘缓存中是否已存在数据【不加载】
@@ -137,9 +177,19 @@ NS_ASSUME_NONNULL_BEGIN
 /// - Parameters:
 ///     - key: 数据缓存键
 ///     - completionBlock: 检查完成后要执行的回调
-/// - Note: 完成块将始终在主队列中执行
+/// - Note: 完成块由 `AUCCacheConfig.callbackExecutor` 执行，默认在主队列
 - (void)diskCacheExistsWithKey:(nullable NSString *)key completion:(nullable AUCCacheCheckCompletionBlock)completionBlock;
 
+/// ``【异步】``检查磁盘缓存中是否已存在数据【不加载】
+///
+/// - Parameters:
+///     - key: 数据缓存键
+///     - context: 参考`AUCCacheContext`，目前支持 `AUCCacheContextCallbackExecutor`
+///     - completionBlock: 检查完成后要执行的回调
+- (void)diskCacheExistsWithKey:(nullable NSString *)key
+                       context:(nullable AUCCacheContext *)context
+                    completion:(nullable AUCCacheCheckCompletionBlock)completionBlock;
+
 /// 【同步】检查磁盘缓存中是否已存在数据【不加载】
 ///
 /// - Parameter key: 数据缓存键
@@ -178,7 +228,7 @@ NS_ASSUME_NONNULL_BEGIN
 ///     - key: 数据缓存键
 ///     - loadOptions: 缓存加载选项所使用选项标识，具体参考`AUCCacheLoadOptions`
 ///     - doneBlock: 查询完成后的回调。若操作被取消，则不会被调用
-///     - context: 参考`AUCCacheContext`，可扩展保存 “options” 枚举无法保存的额外对象
+///     - context: 参考`AUCCacheContext`，可扩展保存 “options” 枚举无法保存的额外对象，目前支持 `AUCCacheContextIOPriority`、`AUCCacheContextCallbackExecutor`
 /// - Returns: 缓存查询操作的 NSOperation 实例
 - (nullable NSOperation *)queryCacheOperationForKey:(nullable NSString *)key
                                             options:(AUCCacheLoadOptions)loadOptions
@@ -206,6 +256,20 @@ NS_ASSUME_NONNULL_BEGIN
 /// - Note: 如果没有找到则返回nil
 - (nullable id)dataFromCacheForKey:(nullable NSString *)key;
 
+/// ``【异步】``预读一批即将访问的磁盘缓存数据，例如首屏接口或列表下一页
+///
+/// - Parameter keys: 缓存键列表
+/// - Note: 只在 IO 队列中向内核发出预读提示，随后的读取可以直接命中页缓存；磁盘缓存未实现 `prefetchDataForKeys:` 时不做任何处理
+- (void)prefetchDiskDataForKeys:(nullable NSArray<NSString *> *)keys;
+
+/// ``【异步】``批量查询磁盘缓存中的扩展数据
+///
+/// - Parameters:
+///     - keys: 缓存键列表
+///     - completionBlock: 查询完成后由 `AUCCacheConfig.callbackExecutor` 回调
+/// - Note: 磁盘缓存实现了 `extendedDataForKeys:` 时一次完成整批读取，否则逐个调用 `extendedDataForKey:`
+- (void)diskCacheExtendedDataForKeys:(nullable NSArray<NSString *> *)keys completion:(nullable AUCCacheExtendedDataCompletionBlock)completionBlock;
+
 #pragma mark - Remove Ops
 /// ``【异步】``从内存和磁盘缓存中删除
 ///
@@ -222,6 +286,20 @@ NS_ASSUME_NONNULL_BEGIN
 ///     - completion: 缓存数据被删除后需要执行的 nullable 回调代码块
 - (void)removeCacheForKey:(nullable NSString *)key fromDisk:(BOOL)fromDisk withCompletion:(nullable AUCVoidParamsBlock)completion;
 
+/// ``【异步】``从内存和磁盘缓存中删除
+///
+/// - Parameters:
+///     - key: 数据缓存键
+///     - fromMemory: 是否从内存缓存中删除
+///     - fromDisk: 如果该值为YES，将【异步】从磁盘中删除缓存条目。如果该值为NO，则同步回调completion block
+///     - context: 参考`AUCCacheContext`，目前支持 `AUCCacheContextCallbackExecutor`
+///     - completion: 缓存数据被删除后需要执行的 nullable 回调代码块
+- (void)removeCacheForKey:(nullable NSString *)key
+               fromMemory:(BOOL)fromMemory
+                 fromDisk:(BOOL)fromDisk
+                  context:(nullable AUCCacheContext *)context
+           withCompletion:(nullable AUCVoidParamsBlock)completion;
+
 #pragma mark - Cache clean Ops
 /// ``【同步】``清除所有内存缓存数据
 - (void)clearMemory;
@@ -238,12 +316,27 @@ NS_ASSUME_NONNULL_BEGIN
 /// - Warning: 非阻塞方法，完成回调会立马执行
 - (void)deleteOldFilesWithCompletionBlock:(nullable AUCVoidParamsBlock)completionBlock;
 
+/// ``【异步】``获取磁盘缓存启动恢复报告
+///
+/// 初始化后会在 IO 队列中分片执行启动恢复（元数据与数据文件对账、清除残缺尾部、删除崩溃遗留的孤立文件），每个时间片不超过 `diskCacheMaintenanceTimeBudget`
+///
+/// - Parameter completion: 恢复完成后由 `AUCCacheConfig.callbackExecutor` 回调，已完成时立即回调
+/// - Note: 恢复期间仍可正常读写，磁盘缓存未实现 `recoverWithTimeBudget:report:` 时报告为空
+- (void)diskCacheRecoveryReportWithCompletion:(nonnull AUCCacheRecoveryCompletionBlock)completion;
+
 #pragma mark - Cache Info
 /// 总磁盘占用内存大小
 - (NSUInteger)totalDiskSize;
 /// 磁盘缓存中的数量
 - (NSUInteger)totalDiskCount;
 
+/// 磁盘 IO 排队耗时的分位数，单位为秒，例如 `diskIOWaitTimePercentile:0.99 priority:AUCIOPriorityInteractive` 为交互读取的 p99
+///
+/// - Note: 从初始化或上次 `resetDiskIOStatistics` 起统计，精度为 1/4 个数量级
+- (NSTimeInterval)diskIOWaitTimePercentile:(double)percentile priority:(AUCIOPriority)priority;
+/// 清空磁盘 IO 排队耗时统计
+- (void)resetDiskIOStatistics;
+
 @end
 
 /// AUCCacheCombine 是缓存管理器的内置缓存实现
@@ -7,10 +7,35 @@
 
 #import "AUCCacheCombine.h"
 #import "AUCMemoryCache.h"
+#import "AUCShardedMemoryCache.h"
 #import "AUCDiskCache.h"
+#import "AUCSQLiteDiskCache.h"
+#import "AUCSegmentDiskCache.h"
 #import "AUCCacheConfig.h"
 #import "AUCCompat.h"
 #import "AUCCacheOperation.h"
+#import "AUCCacheCostEstimator.h"
+#import "AUCCacheCodec.h"
+#import "AUCDiskWriteBatcher.h"
+#import "AUCIOScheduler.h"
+#import "AUCDiskCacheRecoveryReport.h"
+#import "AUCCacheKey.h"
+#import "AUCInternalMacros.h"
+#import <stdatomic.h>
+
+// 白名单版本号，所有实例共用，保证缓存键上的白名单判定不会被其他实例的同号版本误用
+static _Atomic(NSUInteger) AUCCacheWhitelistGeneration = 0;
+AUCacheContextOption const AUCCacheContextIOPriority = @"AUCCacheContextIOPriority";
+AUCacheContextOption const AUCCacheContextCallbackExecutor = @"AUCCacheContextCallbackExecutor";
+
+// 自动选择 IO 并发数时的上限，磁盘带宽有限，更多的并发只会增加排队
+static const NSUInteger DEFAULT_CACHE_IO_MAX_CONCURRENCY = 4;
+// 启动后延迟后台校验的时间
+static const NSTimeInterval DEFAULT_CACHE_SCRUB_DELAY = 30;
+// 每次启动后台校验读取的最大字节数，多次启动轮转完成全部校验
+static const NSUInteger DEFAULT_CACHE_SCRUB_BYTES_PER_LAUNCH = 16 * 1024 * 1024;
+// 后台校验每个时间片读取的字节数
+static const NSUInteger DEFAULT_CACHE_SCRUB_BYTES_PER_SLICE = 1024 * 1024;
 
 @interface AUCCacheCombine ()
 
@@ -18,7 +43,23 @@
 @property (nonatomic, strong, readwrite, nonnull) id<AUCDiskCacheProtocol> diskCache;
 @property (nonatomic, copy, readwrite, nonnull) AUCCacheConfig *config;
 @property (nonatomic, copy, readwrite, nonnull) NSString *diskCachePath;
-@property (nonatomic, strong, nullable) dispatch_queue_t ioQueue;
+@property (nonatomic, strong, readwrite, nonnull) AUCCacheCompressor *compressor;
+@property (nonatomic, strong, readwrite, nonnull) AUCCacheCodecRegistry *codecRegistry;
+@property (nonatomic, strong, nullable) AUCIOScheduler *ioScheduler;
+/// 磁盘写入组提交，`diskCacheWriteBatchInterval` 为 0 时为 nil
+@property (nonatomic, strong, nullable) AUCDiskWriteBatcher *writeBatcher;
+/// 估算待写入对象的大小，用于组提交的字节阈值
+@property (nonatomic, strong, nullable) AUCCacheCostEstimator *writeCostEstimator;
+/// 启动恢复报告与等待恢复完成的回调，只在 IO 队列中访问
+@property (nonatomic, strong, nonnull) AUCDiskCacheRecoveryReport *recoveryReport;
+@property (nonatomic, strong, nonnull) NSMutableArray<AUCCacheRecoveryCompletionBlock> *recoveryCompletions;
+@property (nonatomic, assign) CFAbsoluteTime recoveryStartTime;
+/// 白名单展开后的完整 URL 集合，`whitelistAPIs` 或 `baseURL` 变化时重建
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t whitelistLock;
+@property (nonatomic, copy, nullable) NSSet<NSString *> *whitelist;
+@property (nonatomic, assign) NSUInteger whitelistGeneration;
+@property (nonatomic, strong, nullable) NSArray<NSString *> *whitelistSourceAPIs;
+@property (nonatomic, strong, nullable) NSString *whitelistSourceBaseURL;
 
 @end
 
@@ -52,19 +93,34 @@
     if ((self = [super init])) {
         NSAssert(ns, @"缓存的 namespace 不可以为 nil");
         
-        // 创建 IO 串行队列
-        _ioQueue = dispatch_queue_create("com.vantage.AUCCache", DISPATCH_QUEUE_SERIAL);
-        
         if (!config) {
             config = AUCCacheConfig.defaultConfig;
         }
         
+        // 创建 IO 调度器：不同键的操作并行，同一个键的操作串行
+        NSUInteger ioConcurrency = config.diskCacheIOConcurrency;
+        if (ioConcurrency == 0) {
+            // 内置磁盘缓存可以在多个线程中访问不同的键，自定义磁盘缓存保持串行
+            Class diskCacheClass = config.diskCacheClass;
+            BOOL isBuiltIn = diskCacheClass == [AUCDiskCache class] || diskCacheClass == [AUCSQLiteDiskCache class] || diskCacheClass == [AUCSegmentDiskCache class];
+            ioConcurrency = isBuiltIn ? MIN(NSProcessInfo.processInfo.activeProcessorCount, DEFAULT_CACHE_IO_MAX_CONCURRENCY) : 1;
+        }
+        _ioScheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache" concurrency:ioConcurrency];
+        
         // 确保更改当前配置不会意外影响其他缓存的配置
         _config = [config copy];
+        _whitelistLock = dispatch_semaphore_create(1);
         
         // 初始化内存缓存
         NSAssert([config.memoryCacheClass conformsToProtocol:@protocol(AUCMemoryCacheProtocol)], @"自定义内存缓存类必须符合 `AUCMemoryCache` 协议");
-        _memoryCache = [[config.memoryCacheClass alloc] initWithConfig:_config];
+        Class memoryCacheClass = config.memoryCacheClass;
+        if (config.memoryCacheEvictionPolicy == AUCCacheMemoryEvictionPolicyTinyLFU && memoryCacheClass == [AUCMemoryCache class]) {
+            // `NSCache` 无法定制淘汰策略，TinyLFU 由分片内存缓存实现
+            memoryCacheClass = [AUCShardedMemoryCache class];
+        }
+        NSAssert(config.memoryCacheEvictionPolicy != AUCCacheMemoryEvictionPolicyTinyLFU || [memoryCacheClass isSubclassOfClass:[AUCShardedMemoryCache class]],
+                 @"自定义内存缓存类 `%@` 不支持 `AUCCacheMemoryEvictionPolicyTinyLFU`，请使用 `AUCShardedMemoryCache` 或改用 LRU 策略", NSStringFromClass(memoryCacheClass));
+        _memoryCache = [[memoryCacheClass alloc] initWithConfig:_config];
         
         // 初始化磁盘缓存
         if (directory != nil) {
@@ -79,6 +135,43 @@
         
         // 如果需要，检查并迁移磁盘缓存目录
         [self migrateDiskCacheDirectory];
+        
+        // 启动恢复，分片执行以保证启动后首次查询的延迟
+        [self startDiskCacheRecovery];
+        
+        // 启动一段时间后分片校验缓存文件，在读取之前发现损坏的数据
+        [self scheduleDiskCacheScrub];
+        
+        // 磁盘数据压缩，前缀的适配规则与白名单相同
+        NSMutableDictionary<NSString *, NSData *> *compressionDictionaries = [NSMutableDictionary dictionaryWithCapacity:_config.diskCacheCompressionDictionaries.count];
+        [_config.diskCacheCompressionDictionaries enumerateKeysAndObjectsUsingBlock:^(NSString *api, NSData *dictionary, BOOL *stop) {
+            compressionDictionaries[[AUCCacheCombine URLForAPI:api baseURL:config.baseURL]] = dictionary;
+        }];
+        _compressor = [[AUCCacheCompressor alloc] initWithThreshold:_config.diskCacheCompressionThreshold
+                                                           maxRatio:_config.diskCacheCompressionMaxRatio
+                                                       dictionaries:compressionDictionaries];
+        
+        // 磁盘数据编解码
+        _codecRegistry = [[AUCCacheCodecRegistry alloc] initWithCodecs:_config.diskCacheCodecs binaryFormat:_config.shouldUseBinaryDiskFormat];
+        _codecRegistry.JSONCodec.usesStructuralIndexParser = _config.shouldUseSIMDJSONParser;
+        
+        // 磁盘写入组提交
+        if (_config.diskCacheWriteBatchInterval > 0) {
+            __weak typeof(self) weakSelf = self;
+            AUCCacheCompressor *compressor = _compressor;
+            AUCCacheCodecRegistry *codecRegistry = _codecRegistry;
+            _writeCostEstimator = [AUCCacheCostEstimator new];
+            _writeBatcher = [[AUCDiskWriteBatcher alloc] initWithScheduler:_ioScheduler
+                                                                  interval:_config.diskCacheWriteBatchInterval
+                                                                 byteLimit:_config.diskCacheWriteBatchBytes
+                                                               encodeBlock:^NSData * _Nullable(id object, NSString *key) {
+                // 压缩与编码一起并行执行
+                NSData *diskData = [codecRegistry encodedDataForObject:object];
+                return diskData ? [compressor compressedDataForData:diskData key:key] : nil;
+            } commitBlock:^(NSDictionary<NSString *, NSData *> *dataBatch) {
+                [weakSelf _storeDataBatchToDisk:dataBatch];
+            }];
+        }
 
 #if AU_UIKIT
         // 订阅 Application 事件
@@ -126,9 +219,9 @@
             NSString *newDefaultPath = [[[self userCacheDirectory] stringByAppendingPathComponent:@"com.vantage.AUCCache"] stringByAppendingPathComponent:@"default"];
             // ~/Library/Caches/default/com.vantage.AUCCache.default/
             NSString *oldDefaultPath = [[[self userCacheDirectory] stringByAppendingPathComponent:@"default"] stringByAppendingPathComponent:@"com.vantage.AUCCache.default"];
-            dispatch_async(self.ioQueue, ^{
+            [self.ioScheduler dispatchBarrierAsync:^{
                 [((AUCDiskCache *)self.diskCache) moveCacheDirectoryFromPath:oldDefaultPath toPath:newDefaultPath];
-            });
+            }];
         });
     }
 }
@@ -147,54 +240,66 @@
     return [self storeData:data forKey:key toMemory:YES toDisk:toDisk completion:completionBlock];
 }
 
+- (void)storeData:(id)data
+           forKey:(NSString *)key
+           toDisk:(BOOL)toDisk
+          context:(AUCCacheContext *)context
+       completion:(AUCVoidParamsBlock)completionBlock {
+    [self storeData:data forKey:key toMemory:YES toDisk:toDisk context:context completion:completionBlock];
+}
+
+- (void)storeData:(nullable id)data
+            forKey:(nullable NSString *)key
+          toMemory:(BOOL)toMemory
+            toDisk:(BOOL)toDisk
+        completion:(nullable AUCVoidParamsBlock)completionBlock {
+    [self storeData:data forKey:key toMemory:toMemory toDisk:toDisk context:nil completion:completionBlock];
+}
+
 - (void)storeData:(nullable id)data
             forKey:(nullable NSString *)key
           toMemory:(BOOL)toMemory
             toDisk:(BOOL)toDisk
+           context:(nullable AUCCacheContext *)context
         completion:(nullable AUCVoidParamsBlock)completionBlock {
     if (!data || [data isKindOfClass:NSNull.class] || !key) {
         if (completionBlock) completionBlock();
         return;
     }
+    key = [AUCCacheKey keyWithString:key];
     
     // 如果内存缓存被允许的话
     if (toMemory && self.config.shouldCacheInMemory) {
-        NSUInteger cost = 0;
-        // TODO: 调整此缓存对象的“成本” (cost)值, `NSCache` 会根据所有缓存对象的成本以及设定的最大成本 (totalCostLimit) 来决定何时自动清除缓存对象。当缓存的总成本超过设定的 `totalCostLimit` 时，系统会根据需要自动移除一些缓存对象，优先移除成本较大的对象，以释放空间。
+        // `NSCache` 会根据所有缓存对象的成本以及设定的最大成本 (totalCostLimit) 来决定何时自动清除缓存对象
+        NSUInteger cost = [self memoryCostForData:data];
         [self.memoryCache setObject:data forKey:key cost:cost];
     }
     
-    if (toDisk) {
-        dispatch_async(self.ioQueue, ^{
+    if (toDisk && self.writeBatcher) {
+        // 加入组提交，窗口结束后统一编码、落盘
+        NSUInteger bytes = [data isKindOfClass:NSData.class] ? [(NSData *)data length] : [self.writeCostEstimator costForObject:data];
+        AUCVoidParamsBlock batchCompletion = nil;
+        if (completionBlock) {
+            AUCCallbackExecutor *executor = [self callbackExecutorFromContext:context];
+            batchCompletion = ^{
+                [executor executeBlock:completionBlock];
+            };
+        }
+        [self.writeBatcher addObject:data forKey:key estimatedBytes:bytes completion:batchCompletion];
+    } else if (toDisk) {
+        AUCCallbackExecutor *executor = [self callbackExecutorFromContext:context];
+        [self.ioScheduler dispatchAsyncForKey:key priority:[self IOPriorityFromContext:context defaultPriority:AUCIOPriorityWriteBack] block:^{
             @autoreleasepool {
-                NSData *transferData = nil;
-                NSError *error = nil;
-                /**
-                 * @note `NSJSONWritingOptions` 枚举各参数
-                 * `NSJSONWritingPrettyPrinted` - 使生成的 `JSON` 更具可读性（即带有换行和缩进）。适用于调试或开发中希望查看整齐的 `JSON` 格式。此选项生成的 `JSON` 体积稍大，适合调试或非生产环境。对于生产环境，通常不使用这个选项。
-                 * `NSJSONWritingSortedKeys` (iOS 11.0+) - 确保字典的键在 `JSON` 输出中按字母顺序排列。对于需要对 `JSON` 进行排序（如生成一致的签名或调试）的情况很有用。
-                 * `NSJSONWritingFragmentsAllowed` (iOS 13.0+) - 通常 `JSON` 必须以数组或字典作为顶层结构，使用此选项可以将其他基本类型（如字符串、数字、布尔值）序列化为有效的`JSON`。
-                 * `NSJSONWritingWithoutEscapingSlashes` - 使用此选项时，`JSON` 中的斜杠字符（/）将不会被转义为 \/。
-                 */
-                if ([data isKindOfClass:NSData.class]) {
-                    transferData = (NSData *)data;
-                } else if ([data isKindOfClass:NSString.class]) {
-                    transferData = [(NSString *)data dataUsingEncoding:NSUTF8StringEncoding];
-                } else if ([data isKindOfClass:NSDictionary.class] || [data isKindOfClass:NSArray.class]) {
-                    transferData = [NSJSONSerialization dataWithJSONObject:data options:NSJSONWritingPrettyPrinted error:&error];
-                }
-                
-                if (transferData && error == nil) {
+                NSData *transferData = [self.codecRegistry encodedDataForObject:data];
+                if (transferData) {
                     [self _storeDataToDisk:transferData forKey:key];
                 }
             }
             
             if (completionBlock) {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    completionBlock();
-                });
+                [executor executeBlock:completionBlock];
             }
-        });
+        }];
     } else {
         if (completionBlock) {
             completionBlock();
@@ -202,76 +307,123 @@
     }
 }
 
+/// 上下文中指定的 IO 优先级，未指定或无效时返回 `defaultPriority`
+- (AUCIOPriority)IOPriorityFromContext:(nullable AUCCacheContext *)context defaultPriority:(AUCIOPriority)defaultPriority {
+    id value = context[AUCCacheContextIOPriority];
+    if (![value isKindOfClass:NSNumber.class]) return defaultPriority;
+    NSUInteger priority = [(NSNumber *)value unsignedIntegerValue];
+    return priority < AUCIOPriorityCount ? (AUCIOPriority)priority : defaultPriority;
+}
+
+/// 上下文中指定的回调执行器，未指定或无效时使用配置中的执行器
+///
+/// - Note: 直接执行器的回调在 IO 线程上执行，回调中调用同步接口由 `AUCIOScheduler` 检测重入（参考 `isCurrentThreadRunningTask`）
+- (nonnull AUCCallbackExecutor *)callbackExecutorFromContext:(nullable AUCCacheContext *)context {
+    id value = context[AUCCacheContextCallbackExecutor];
+    if ([value isKindOfClass:AUCCallbackExecutor.class]) return value;
+    return self.config.callbackExecutor ?: AUCCallbackExecutor.mainQueueExecutor;
+}
+
 - (void)storeDataToMemory:(id)data forKey:(NSString *)key {
     if (!data || !key) return;
-    NSUInteger cost = 0;
+    key = [AUCCacheKey keyWithString:key];
+    NSUInteger cost = [self memoryCostForData:data];
     [self.memoryCache setObject:data forKey:key cost:cost];
 }
 
 - (void)storeDataToDisk:(nullable NSData *)data
                  forKey:(nullable NSString *)key {
     if (!data || !key) return;
+    key = [AUCCacheKey keyWithString:key];
     
-    dispatch_sync(self.ioQueue, ^{
+    // 同步写入覆盖尚未提交的异步写入
+    [self.writeBatcher discardPendingWriteForKey:key];
+    [self.ioScheduler dispatchSyncForKey:key priority:AUCIOPriorityInteractive block:^{
         [self _storeDataToDisk:data forKey:key];
-    });
+    }];
 }
 
-// 确保按调用者从 io 队列调用
+// 确保从该键的 io 队列调用
 - (void)_storeDataToDisk:(nullable NSData *)data forKey:(nullable NSString *)key {
     if (!data || !key) return;
     
-    [self.diskCache setData:data forKey:key];
+    [self.diskCache setData:[self.compressor compressedDataForData:data key:key] forKey:key];
+}
+
+// 确保从 io 独占任务调用，组提交的数据已在编码时压缩
+- (void)_storeDataBatchToDisk:(nonnull NSDictionary<NSString *, NSData *> *)dataBatch {
+    if ([self.diskCache respondsToSelector:@selector(setDataBatch:)]) {
+        [self.diskCache setDataBatch:dataBatch];
+    } else {
+        [dataBatch enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSData *data, BOOL *stop) {
+            [self.diskCache setData:data forKey:key];
+        }];
+    }
 }
 
 #pragma mark - Query and Retrieve Ops
 - (void)diskCacheExistsWithKey:(nullable NSString *)key completion:(nullable AUCCacheCheckCompletionBlock)completionBlock {
-    dispatch_async(self.ioQueue, ^{
+    [self diskCacheExistsWithKey:key context:nil completion:completionBlock];
+}
+
+- (void)diskCacheExistsWithKey:(nullable NSString *)key context:(nullable AUCCacheContext *)context completion:(nullable AUCCacheCheckCompletionBlock)completionBlock {
+    key = [AUCCacheKey keyWithString:key];
+    AUCCallbackExecutor *executor = [self callbackExecutorFromContext:context];
+    [self.ioScheduler dispatchAsyncForKey:key priority:AUCIOPriorityInteractive block:^{
         BOOL exists = [self _diskCacheDataExistsWithKey:key];
         if (completionBlock) {
-            dispatch_async(dispatch_get_main_queue(), ^{
+            [executor executeBlock:^{
                 completionBlock(exists);
-            });
+            }];
         }
-    });
+    }];
 }
 
 - (BOOL)diskCacheExistsWithKey:(nullable NSString *)key {
     if (!key) return NO;
+    key = [AUCCacheKey keyWithString:key];
     
     __block BOOL exists = NO;
-    dispatch_sync(self.ioQueue, ^{
+    [self.ioScheduler dispatchSyncForKey:key priority:AUCIOPriorityInteractive block:^{
         exists = [self _diskCacheDataExistsWithKey:key];
-    });
+    }];
     
     return exists;
 }
 
-// 确保从 io 队列调用
+// 确保从该键的 io 队列调用
 - (BOOL)_diskCacheDataExistsWithKey:(nullable NSString *)key {
     if (!key) return NO;
+    if ([self.writeBatcher hasPendingWriteForKey:key]) return YES;
     
     return [self.diskCache containsDataForKey:key];
 }
 
 - (nullable NSData *)diskCacheDataForKey:(nullable NSString *)key {
     if (!key) return nil;
+    key = [AUCCacheKey keyWithString:key];
     __block NSData *data = nil;
-    dispatch_sync(self.ioQueue, ^{
+    [self.ioScheduler dispatchSyncForKey:key priority:AUCIOPriorityInteractive block:^{
         data = [self diskCacheDataBySearchingAllPathsForKey:key];
-    });
+    }];
     
-    return data;
+    return data ? [self.codecRegistry externalDataOfData:data] : nil;
+}
+
+// 内存缓存成本，未配置估算器时为 0
+- (NSUInteger)memoryCostForData:(nullable id)data {
+    return [self.config.memoryCostEstimator costForObject:data];
 }
 
 - (nullable id)dataFromMemoryCacheForKey:(nullable NSString *)key {
-    return [self.memoryCache objectForKey:key];
+    return [self.memoryCache objectForKey:[AUCCacheKey keyWithString:key]];
 }
 
 - (nullable id)dataFromDiskCacheForKey:(nullable NSString *)key {
+    key = [AUCCacheKey keyWithString:key];
     id diskData = [self diskCacheDataForKey:key];
     if (diskData && self.config.shouldCacheInMemory) {
-        NSUInteger cost = 0;
+        NSUInteger cost = [self memoryCostForData:diskData];
         [self.memoryCache setObject:diskData forKey:key cost:cost];
     }
 
@@ -279,6 +431,7 @@
 }
 
 - (nullable id)dataFromCacheForKey:(nullable NSString *)key {
+    key = [AUCCacheKey keyWithString:key];
     // 首先查询内存缓存
     id data = [self dataFromMemoryCacheForKey:key];
     if (data) return data;
@@ -288,13 +441,24 @@
     return data;
 }
 
+// 返回解压后、解码前的数据（带编解码帧头）
 - (nullable NSData *)diskCacheDataBySearchingAllPathsForKey:(nullable NSString *)key {
     if (!key) {
         return nil;
     }
     
-    NSData *data = [self.diskCache dataForKey:key];
-    if (data) return data;
+    // 尚未落盘的写入优先
+    NSData *data = [self.writeBatcher pendingDataForKey:key];
+    if (data) return [self.compressor decompressedDataForData:data];
+    
+    data = [self.diskCache dataForKey:key];
+    if (data) {
+        NSData *decompressedData = [self.compressor decompressedDataForData:data];
+        if (decompressedData) return decompressedData;
+        // 数据损坏或压缩时使用的字典已被移除，按未命中处理
+        [self.diskCache removeCacheForKey:key];
+        data = nil;
+    }
     
     // 自定义预加载缓存的附加缓存路径
     if (self.additionalCachePathBlock) {
@@ -320,6 +484,8 @@
         if (doneBlock) doneBlock(nil, AUCCacheTypeNone);
         return nil;
     }
+    // 之后的内存查询、磁盘路径解析共用同一个缓存键
+    key = [AUCCacheKey keyWithString:key];
     
     // 首先检查内存缓存
     id memoryData = [self dataFromMemoryCacheForKey:key];
@@ -337,6 +503,7 @@
     // 2. 内存缓存未命中 & diskDataSync
     BOOL shouldQueryDiskSync = ((memoryData && loadOptions & AUCCacheLoadFromMemoryDataSync) ||
                                 (!memoryData && loadOptions & AUCCacheLoadFromDiskDataSync));
+    AUCCallbackExecutor *executor = shouldQueryDiskSync ? nil : [self callbackExecutorFromContext:context];
     void(^queryDiskBlock)(void) =  ^{
         if (operation.isCancelled) {
             if (doneBlock) doneBlock(nil, AUCCacheTypeNone);
@@ -346,59 +513,86 @@
         @autoreleasepool {
             NSData *diskData = [self diskCacheDataBySearchingAllPathsForKey:key];
             AUCCacheType cacheType = AUCCacheTypeNone;
+            id diskObject = nil;
 
             if (diskData) {
                 cacheType = AUCCacheTypeDisk;
-                if (self.config.shouldCacheInMemory) {
-                    NSUInteger cost = 0;
-                    NSError *error = nil;
-                    id localeResponse = [NSJSONSerialization JSONObjectWithData:diskData options:NSJSONReadingFragmentsAllowed error:&error];
-                    if (error) {
-                        [self.memoryCache setObject:diskData forKey:key cost:cost];
-                    } else {
-                        [self.memoryCache setObject:localeResponse forKey:key cost:cost];
-                    }
+                // 只解码一次，内存缓存与回调共用解码结果
+                diskObject = [self.codecRegistry decodedObjectForData:diskData];
+                if (diskObject && self.config.shouldCacheInMemory) {
+                    [self.memoryCache setObject:diskObject forKey:key cost:[self memoryCostForData:diskObject]];
                 }
             }
             // NSDictionary、NSArray、NSString、NSData
             // 保持回调给上层的数据结构和内存缓存一致
+            id callbackData = nil;
             if (memoryData && [memoryData isKindOfClass:NSData.class]) {
-                if (doneBlock) {
-                    if (shouldQueryDiskSync) {
-                        doneBlock(diskData, cacheType);
-                    } else {
-                        dispatch_async(dispatch_get_main_queue(), ^{
-                            doneBlock(diskData, cacheType);
-                        });
-                    }
-                }
-            } else if (diskData) {
-                // 将磁盘 `Data` 数据转换成 `JSON` 数据返回给上层
-                NSError *error = nil;
-                id localeResponse = [NSJSONSerialization JSONObjectWithData:diskData options:NSJSONReadingFragmentsAllowed error:&error];
-                if (!error && doneBlock) {
-                    if (shouldQueryDiskSync) {
-                        doneBlock(localeResponse, cacheType);
-                    } else {
-                        dispatch_async(dispatch_get_main_queue(), ^{
-                            doneBlock(localeResponse, cacheType);
-                        });
-                    }
+                callbackData = diskData ? [self.codecRegistry externalDataOfData:diskData] : nil;
+            } else if (diskObject) {
+                callbackData = diskObject;
+            } else {
+                return;
+            }
+            if (doneBlock) {
+                if (shouldQueryDiskSync) {
+                    doneBlock(callbackData, cacheType);
+                } else {
+                    [executor executeBlock:^{
+                        doneBlock(callbackData, cacheType);
+                    }];
                 }
             }
         }
     };
     
-    // 在 ioQueue 中查询，以确保 IO 安全
+    // 在该键的 io 队列中查询，以确保 IO 安全；不同键的查询（包括 JSON 解析）并行执行
+    AUCIOPriority priority = [self IOPriorityFromContext:context defaultPriority:AUCIOPriorityInteractive];
     if (shouldQueryDiskSync) {
-        dispatch_sync(self.ioQueue, queryDiskBlock);
+        [self.ioScheduler dispatchSyncForKey:key priority:priority block:queryDiskBlock];
     } else {
-        dispatch_async(self.ioQueue, queryDiskBlock);
+        [self.ioScheduler dispatchAsyncForKey:key priority:priority block:queryDiskBlock];
     }
     
     return operation;
 }
 
+- (void)prefetchDiskDataForKeys:(NSArray<NSString *> *)keys {
+    if (keys.count == 0 || ![self.diskCache respondsToSelector:@selector(prefetchDataForKeys:)]) {
+        return;
+    }
+    NSArray<NSString *> *prefetchKeys = [keys copy];
+    // 预读只是建议，不需要与其他操作排序
+    [self.ioScheduler dispatchAsyncForKey:nil priority:AUCIOPriorityPrefetch block:^{
+        [self.diskCache prefetchDataForKeys:prefetchKeys];
+    }];
+}
+
+- (void)diskCacheExtendedDataForKeys:(NSArray<NSString *> *)keys completion:(AUCCacheExtendedDataCompletionBlock)completionBlock {
+    NSArray<NSString *> *queryKeys = [keys copy] ?: @[];
+    AUCCallbackExecutor *executor = [self callbackExecutorFromContext:nil];
+    // 涉及多个键，以屏障执行，保证读到之前提交的写入
+    [self.ioScheduler dispatchBarrierAsync:^{
+        NSDictionary<NSString *, NSData *> *extendedDataMap = nil;
+        @autoreleasepool {
+            if ([self.diskCache respondsToSelector:@selector(extendedDataForKeys:)]) {
+                extendedDataMap = [self.diskCache extendedDataForKeys:queryKeys];
+            } else {
+                NSMutableDictionary<NSString *, NSData *> *map = [NSMutableDictionary dictionaryWithCapacity:queryKeys.count];
+                for (NSString *key in queryKeys) {
+                    NSData *extendedData = [self.diskCache extendedDataForKey:key];
+                    if (extendedData) map[key] = extendedData;
+                }
+                extendedDataMap = map;
+            }
+        }
+        if (completionBlock) {
+            [executor executeBlock:^{
+                completionBlock(extendedDataMap);
+            }];
+        }
+    }];
+}
+
 #pragma mark - Remove Ops
 - (void)removeCacheForKey:(nullable NSString *)key withCompletion:(nullable AUCVoidParamsBlock)completion {
     [self removeCacheForKey:key fromDisk:YES withCompletion:completion];
@@ -409,22 +603,27 @@
 }
 
 - (void)removeCacheForKey:(nullable NSString *)key fromMemory:(BOOL)fromMemory fromDisk:(BOOL)fromDisk withCompletion:(nullable AUCVoidParamsBlock)completion {
+    [self removeCacheForKey:key fromMemory:fromMemory fromDisk:fromDisk context:nil withCompletion:completion];
+}
+
+- (void)removeCacheForKey:(nullable NSString *)key fromMemory:(BOOL)fromMemory fromDisk:(BOOL)fromDisk context:(nullable AUCCacheContext *)context withCompletion:(nullable AUCVoidParamsBlock)completion {
     if (key == nil) return;
+    key = [AUCCacheKey keyWithString:key];
 
     if (fromMemory && self.config.shouldCacheInMemory) {
         [self.memoryCache removeObjectForKey:key];
     }
 
     if (fromDisk) {
-        dispatch_async(self.ioQueue, ^{
+        [self.writeBatcher discardPendingWriteForKey:key];
+        AUCCallbackExecutor *executor = [self callbackExecutorFromContext:context];
+        [self.ioScheduler dispatchAsyncForKey:key priority:AUCIOPriorityWriteBack block:^{
             [self.diskCache removeCacheForKey:key];
             
             if (completion) {
-                dispatch_async(dispatch_get_main_queue(), ^{
-                    completion();
-                });
+                [executor executeBlock:completion];
             }
-        });
+        }];
     } else if (completion) {
         completion();
     }
@@ -436,30 +635,136 @@
 }
 
 - (void)clearDiskOnCompletion:(nullable AUCVoidParamsBlock)completion {
-    dispatch_async(self.ioQueue, ^{
+    [self.writeBatcher discardAllPendingWrites];
+    [self.ioScheduler dispatchBarrierAsync:^{
         [self.diskCache removeAllData];
         if (completion) {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                completion();
-            });
+            [[self callbackExecutorFromContext:nil] executeBlock:completion];
         }
-    });
+    }];
 }
 
 - (void)deleteOldFilesWithCompletionBlock:(nullable AUCVoidParamsBlock)completionBlock {
-    dispatch_async(self.ioQueue, ^{
+    [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+        [self _deleteOldFilesSliceWithCompletionBlock:completionBlock];
+    }];
+}
+
+// 确保从 io 独占任务调用
+// 每个时间片结束后重新入队，以维护优先级与读写操作竞争，用户正在等待的读取先执行
+- (void)_deleteOldFilesSliceWithCompletionBlock:(nullable AUCVoidParamsBlock)completionBlock {
+    BOOL finished = YES;
+    if ([self.diskCache respondsToSelector:@selector(removeExpiredDataWithTimeBudget:)]) {
+        finished = [self.diskCache removeExpiredDataWithTimeBudget:self.config.diskCacheMaintenanceTimeBudget];
+    } else {
         [self.diskCache removeExpiredData];
-        if (completionBlock) {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                completionBlock();
-            });
-        }
+    }
+    
+    if (!finished) {
+        [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+            [self _deleteOldFilesSliceWithCompletionBlock:completionBlock];
+        }];
+        return;
+    }
+    
+    if (completionBlock) {
+        [[self callbackExecutorFromContext:nil] executeBlock:completionBlock];
+    }
+}
+
+#pragma mark - Recovery Ops
+- (void)startDiskCacheRecovery {
+    self.recoveryReport = [AUCDiskCacheRecoveryReport new];
+    self.recoveryCompletions = [NSMutableArray array];
+    self.recoveryStartTime = CFAbsoluteTimeGetCurrent();
+    [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+        [self _diskCacheRecoverySlice];
+    }];
+}
+
+// 确保从 io 独占任务调用
+// 与过期清理相同，每个时间片结束后重新入队，排在其后的读写操作可以先执行
+- (void)_diskCacheRecoverySlice {
+    AUCDiskCacheRecoveryReport *report = self.recoveryReport;
+    BOOL finished = YES;
+    if ([self.diskCache respondsToSelector:@selector(recoverWithTimeBudget:report:)]) {
+        CFAbsoluteTime sliceStartTime = CFAbsoluteTimeGetCurrent();
+        finished = [self.diskCache recoverWithTimeBudget:self.config.diskCacheMaintenanceTimeBudget report:report];
+        report.duration += CFAbsoluteTimeGetCurrent() - sliceStartTime;
+        report.sliceCount++;
+    }
+    
+    if (!finished) {
+        [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+            [self _diskCacheRecoverySlice];
+        }];
+        return;
+    }
+    
+    report.elapsedTime = CFAbsoluteTimeGetCurrent() - self.recoveryStartTime;
+    report.finished = YES;
+    NSArray<AUCCacheRecoveryCompletionBlock> *completions = [self.recoveryCompletions copy];
+    [self.recoveryCompletions removeAllObjects];
+    if (completions.count > 0) {
+        [[self callbackExecutorFromContext:nil] executeBlock:^{
+            for (AUCCacheRecoveryCompletionBlock completion in completions) {
+                completion(report);
+            }
+        }];
+    }
+}
+
+- (void)scheduleDiskCacheScrub {
+    if (self.config.diskCacheChecksumMode == AUCCacheDiskChecksumModeOff) return;
+    if (![self.diskCache respondsToSelector:@selector(scrubDataWithByteLimit:)]) return;
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(DEFAULT_CACHE_SCRUB_DELAY * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_BACKGROUND, 0), ^{
+        AUCIOScheduler *ioScheduler = weakSelf.ioScheduler;
+        [ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+            // 缓存较小时不重复校验同一批文件
+            NSUInteger byteLimit = MIN(DEFAULT_CACHE_SCRUB_BYTES_PER_LAUNCH, weakSelf.diskCache.totalSize);
+            [weakSelf _diskCacheScrubSliceWithRemainingBytes:byteLimit];
+        }];
     });
 }
 
+// 确保从 io 独占任务调用
+// 校验会删除损坏数据的索引项与文件，与写入并发时可能删除刚写入的文件，因此与过期清理相同，在独占任务中分片执行
+- (void)_diskCacheScrubSliceWithRemainingBytes:(NSUInteger)remainingBytes {
+    if (remainingBytes == 0) return;
+    NSUInteger sliceBytes = MIN(remainingBytes, DEFAULT_CACHE_SCRUB_BYTES_PER_SLICE);
+    [self.diskCache scrubDataWithByteLimit:sliceBytes];
+    remainingBytes -= sliceBytes;
+    if (remainingBytes == 0) return;
+    [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+        [self _diskCacheScrubSliceWithRemainingBytes:remainingBytes];
+    }];
+}
+
+- (void)diskCacheRecoveryReportWithCompletion:(AUCCacheRecoveryCompletionBlock)completion {
+    if (!completion) return;
+    // 与恢复时间片同在独占任务中访问恢复状态
+    [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityInteractive block:^{
+        AUCDiskCacheRecoveryReport *report = self.recoveryReport;
+        if (!report.finished) {
+            [self.recoveryCompletions addObject:[completion copy]];
+            return;
+        }
+        [[self callbackExecutorFromContext:nil] executeBlock:^{
+            completion(report);
+        }];
+    }];
+}
+
 #pragma mark - UIApplicationWillTerminateNotification
 #if AU_UIKIT || AU_OS_MAC
 - (void)applicationWillTerminate:(NSNotification *)notification {
+    // 进程即将退出，同步提交尚未落盘的写入
+    if (self.writeBatcher) {
+        [self.ioScheduler dispatchBarrierSync:^{
+            [self.writeBatcher flush];
+        }];
+    }
     [self deleteOldFilesWithCompletionBlock:nil];
 }
 #endif
@@ -467,6 +772,12 @@
 #pragma mark - UIApplicationDidEnterBackgroundNotification
 #if AU_UIKIT
 - (void)applicationDidEnterBackground:(NSNotification *)notification {
+    if (self.writeBatcher) {
+        // 进入后台后可能被挂起，不等窗口结束立即提交
+        [self.ioScheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityInteractive block:^{
+            [self.writeBatcher flush];
+        }];
+    }
     if (!self.config.shouldRemoveExpiredDataWhenEnterBackground) return;
     
     Class ApplicationClass = NSClassFromString(@"UIApplication");
@@ -492,42 +803,70 @@
 #pragma mark - Cache Info
 - (NSUInteger)totalDiskSize {
     __block NSUInteger size = 0;
-    dispatch_sync(self.ioQueue, ^{
+    [self.ioScheduler dispatchSyncForKey:nil priority:AUCIOPriorityInteractive block:^{
         size = [self.diskCache totalSize];
-    });
+    }];
     return size;
 }
 
 - (NSUInteger)totalDiskCount {
     __block NSUInteger count = 0;
-    dispatch_sync(self.ioQueue, ^{
+    [self.ioScheduler dispatchSyncForKey:nil priority:AUCIOPriorityInteractive block:^{
         count = [self.diskCache totalCount];
-    });
+    }];
     return count;
 }
 
+- (NSTimeInterval)diskIOWaitTimePercentile:(double)percentile priority:(AUCIOPriority)priority {
+    return [self.ioScheduler waitTimePercentile:percentile priority:priority];
+}
+
+- (void)resetDiskIOStatistics {
+    [self.ioScheduler resetStatistics];
+}
+
 - (BOOL)isWhitelistApisContainsKey:(NSString *)key {
+    AUCCacheKey *cacheKey = [AUCCacheKey keyWithString:key];
+    if (!cacheKey) return NO;
+    
+    NSUInteger generation = 0;
+    NSSet<NSString *> *whitelist = [self whitelistWithGeneration:&generation];
+    // 同一个键在白名单不变时只判断一次
     BOOL isContains = NO;
+    if ([cacheKey getWhitelistVerdict:&isContains generation:generation]) return isContains;
+    isContains = [whitelist containsObject:cacheKey.string];
+    [cacheKey setWhitelistVerdict:isContains generation:generation];
+    return isContains;
+}
+
+/// 把配置中的 API 适配为完整 URL：`http` 开头的直接使用，其余拼接在 `baseURL` 之后
++ (NSString *)URLForAPI:(NSString *)api baseURL:(nullable NSString *)baseURL {
+    if ([api hasPrefix:@"http"]) return api;
+    if ([api hasPrefix:@"/"]) return [NSString stringWithFormat:@"%@%@", baseURL, api];
+    return [NSString stringWithFormat:@"%@/%@", baseURL, api];
+}
+
+/// 白名单展开后的完整 URL 集合，配置中的 `whitelistAPIs`、`baseURL` 被重新赋值时重建并递增版本号
+- (NSSet<NSString *> *)whitelistWithGeneration:(NSUInteger *)generation {
     AUCCacheConfig *config = self.config;
-    for (NSString *api in config.whitelistAPIs) {
-        if (![api hasPrefix:@"http"]) {
-            NSString *adaptApi = api;
-            if ([api hasPrefix:@"/"]) {
-                adaptApi = [NSString stringWithFormat:@"%@%@", config.baseURL, api];
-            } else {
-                adaptApi = [NSString stringWithFormat:@"%@/%@", config.baseURL, api];
-            }
-            if ([adaptApi isEqualToString:key]) {
-                isContains = YES;
-                break;
-            }
-            continue;
-        } else if ([api isEqualToString:key]) {
-            isContains = YES;
-            break;
+    NSArray<NSString *> *whitelistAPIs = config.whitelistAPIs;
+    NSString *baseURL = config.baseURL;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.whitelistLock);
+    // 两个属性均为 copy，内容变化必然伴随对象变化，比较指针即可
+    if (!self.whitelist || self.whitelistSourceAPIs != whitelistAPIs || self.whitelistSourceBaseURL != baseURL) {
+        NSMutableSet<NSString *> *whitelist = [NSMutableSet setWithCapacity:whitelistAPIs.count];
+        for (NSString *api in whitelistAPIs) {
+            [whitelist addObject:[AUCCacheCombine URLForAPI:api baseURL:baseURL]];
         }
+        self.whitelist = whitelist;
+        self.whitelistSourceAPIs = whitelistAPIs;
+        self.whitelistSourceBaseURL = baseURL;
+        self.whitelistGeneration = atomic_fetch_add(&AUCCacheWhitelistGeneration, 1) + 1;
     }
-    return isContains;
+    NSSet<NSString *> *whitelist = self.whitelist;
+    *generation = self.whitelistGeneration;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.whitelistLock);
+    return whitelist;
 }
 
 @end
@@ -539,7 +878,8 @@
                                                options:(AUCCacheOptions)options
                                                context:(nullable AUCCacheContext *)context
                                             completion:(nullable AUCCacheQueryCompletionBlock)completionBlock {
-    // 白名单过滤
+    // 白名单过滤，之后的查询复用同一个缓存键
+    key = [AUCCacheKey keyWithString:key];
     BOOL isContains = [self isWhitelistApisContainsKey:key];
     if (!isContains && manually == NO) return nil;
     
@@ -556,7 +896,8 @@
          manually:(BOOL)manually
         cacheType:(AUCCacheType)cacheType
        completion:(nullable AUCVoidParamsBlock)completionBlock {
-    // 白名单过滤
+    // 白名单过滤，之后的存储复用同一个缓存键
+    key = [AUCCacheKey keyWithString:key];
     BOOL isContains = [self isWhitelistApisContainsKey:key];
     if (!isContains && manually == NO) return;
     
@@ -681,15 +1022,15 @@
 }
 
 - (void)calculateCacheSize:(AUCCacheCalculateSizeBlock)completionBlock {
-    dispatch_async(self.ioQueue, ^{
+    [self.ioScheduler dispatchAsyncForKey:nil priority:AUCIOPriorityInteractive block:^{
         NSUInteger fileCount = [self.diskCache totalCount];
         NSUInteger totalSize = [self.diskCache totalSize];
         if (completionBlock) {
-            dispatch_async(dispatch_get_main_queue(), ^{
+            [[self callbackExecutorFromContext:nil] executeBlock:^{
                 completionBlock(fileCount, totalSize);
-            });
+            }];
         }
-    });
+    }];
 }
 
 - (void)storeDataManually:(id)data
@@ -0,0 +1,88 @@
+//
+//  AUCCacheCompressor.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/26.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``磁盘数据压缩``
+///
+/// 写入磁盘前按条目选择是否以 zlib（deflate）压缩，读取时根据帧头自动解压，磁盘缓存只看到不透明的数据
+/// ```
+/// compressedData
+///    ├── header    magic、编码、标记位、预置字典 ID、原始长度、头部校验和（24 字节）
+///    └── deflate   原始 deflate 流（不含 zlib 头尾）
+/// ```
+///
+/// - Note: 键匹配到预置字典（按 API 前缀配置）时使用 `deflateSetDictionary` 压缩，接口响应中重复的字段名、枚举值可以直接引用字典，小数据的压缩率明显提高
+/// - Note: 小于阈值的数据、压缩后节省不足的数据按原样保存；大数据先试压缩开头一段，压缩率不达标时不再压缩整段
+/// - Note: 不带帧头的数据（早期版本写入或未压缩）原样返回，开启、关闭压缩都不影响已有缓存的读取
+/// - Warning: 解压需要写入时使用的字典，删除或修改字典后，用旧字典压缩的数据读取失败并按未命中处理
+@interface AUCCacheCompressor : NSObject
+
+/// 创建压缩器
+///
+/// - Parameters:
+///     - threshold: 不小于该大小的数据尝试压缩，0 表示不压缩（仍可解压已压缩的数据）
+///     - maxRatio: 压缩后大小（含帧头）与原大小之比不超过该值时才保存压缩数据
+///     - dictionaries: 完整 URL 前缀 -> 预置字典，键匹配多个前缀时使用最长的
+- (instancetype)initWithThreshold:(NSUInteger)threshold
+                         maxRatio:(double)maxRatio
+                     dictionaries:(nullable NSDictionary<NSString *, NSData *> *)dictionaries NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// 按条目选择编码，压缩不划算时返回原数据
+- (NSData *)compressedDataForData:(NSData *)data key:(nullable NSString *)key;
+
+/// 解压数据，不带帧头的数据原样返回
+///
+/// - Returns: 原始数据，数据损坏或缺少压缩时使用的字典时返回 nil
+- (nullable NSData *)decompressedDataForData:(NSData *)data;
+
+/// 数据是否带有压缩帧头
++ (BOOL)isCompressedData:(NSData *)data;
+
+/// 从接口响应样本中训练预置字典
+///
+/// 统计样本中重复出现的字段名（`"key":`）与取值，按出现次数 × 长度排序，收益最高的片段放在字典末尾（距离最近，引用代价最低）
+///
+/// - Parameters:
+///     - samples: 同一个 API 前缀下的响应样本，建议数十个
+///     - maxLength: 字典最大长度，超过 deflate 窗口（32KB）的部分不会被引用
+/// - Returns: 字典，样本中没有重复片段时返回空数据
++ (NSData *)trainDictionaryWithSamples:(NSArray<NSData *> *)samples maxLength:(NSUInteger)maxLength;
+
+#pragma mark - Statistics
+/// 以压缩形式保存的条目数量
+@property (nonatomic, assign, readonly) NSUInteger compressedCount;
+
+/// 以压缩形式保存的条目压缩前的总字节数
+@property (nonatomic, assign, readonly) uint64_t uncompressedBytes;
+
+/// 以压缩形式保存的条目压缩后的总字节数（含帧头）
+@property (nonatomic, assign, readonly) uint64_t compressedBytes;
+
+/// 压缩率：压缩后总字节数 / 压缩前总字节数，没有压缩过数据时为 1
+@property (nonatomic, assign, readonly) double compressionRatio;
+
+/// 解压得到的总字节数
+@property (nonatomic, assign, readonly) uint64_t decodedBytes;
+
+/// 解压累计耗时，单位为【秒】
+@property (nonatomic, assign, readonly) NSTimeInterval decodeTime;
+
+/// 解压吞吐量，单位为【字节/秒】，没有解压过数据时为 0
+///
+/// - Note: 与设备的磁盘顺序读取速度比较：解压吞吐量高于读取速度时，读取压缩数据的总耗时（读取 + 解压）低于读取原始数据
+@property (nonatomic, assign, readonly) double decodeThroughput;
+
+/// 清零统计数据
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,322 @@
+//
+//  AUCCacheCompressor.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/26.
+//
+
+#import "AUCCacheCompressor.h"
+#import "AUCChecksum.h"
+#import <stdatomic.h>
+#import <zlib.h>
+
+// 'AUCZ'
+static const uint32_t AUC_COMPRESSOR_MAGIC = 0x5A435541;
+static const uint8_t AUC_COMPRESSOR_CODEC_DEFLATE = 1;
+// 帧头标记位：使用了预置字典
+static const uint8_t AUC_COMPRESSOR_FLAG_DICTIONARY = 1 << 0;
+// 大于该大小的数据先试压缩开头一段判断可压缩性
+static const NSUInteger AUC_COMPRESSOR_PROBE_THRESHOLD = 64 * 1024;
+static const NSUInteger AUC_COMPRESSOR_PROBE_LENGTH = 4 * 1024;
+// 训练字典时单个片段的最大长度，更长的片段几乎不会在其他响应中原样出现
+static const NSUInteger AUC_COMPRESSOR_MAX_FRAGMENT_LENGTH = 256;
+static const NSUInteger AUC_COMPRESSOR_MIN_FRAGMENT_LENGTH = 3;
+
+/// 压缩帧头，所有字段均为小端序
+typedef struct {
+    uint32_t magic;
+    uint8_t codec;
+    uint8_t flags;
+    uint16_t reserved;
+    /// 原始数据长度
+    uint64_t length;
+    /// 预置字典的 Adler-32，未使用字典时为 0
+    uint32_t dictionaryID;
+    /// 头部前 20 字节的 CRC32C，用于区分压缩数据与恰好以 magic 开头的原始数据
+    uint32_t headerChecksum;
+} AUCCompressorHeader;
+
+#define AUC_COMPRESSOR_HEADER_LENGTH 24
+_Static_assert(sizeof(AUCCompressorHeader) == AUC_COMPRESSOR_HEADER_LENGTH, "compressor header must be 24 bytes");
+
+static inline uint32_t AUCCompressorHeaderChecksum(const AUCCompressorHeader *header) {
+    return AUCCRC32C(0, header, offsetof(AUCCompressorHeader, headerChecksum));
+}
+
+/// 解析帧头，不是压缩数据时返回 NO
+static BOOL AUCCompressorReadHeader(NSData *data, AUCCompressorHeader *header) {
+    if (data.length < AUC_COMPRESSOR_HEADER_LENGTH) return NO;
+    memcpy(header, data.bytes, AUC_COMPRESSOR_HEADER_LENGTH);
+    return header->magic == AUC_COMPRESSOR_MAGIC && header->headerChecksum == AUCCompressorHeaderChecksum(header);
+}
+
+/// 以原始 deflate 格式压缩，输出前预留 `headerLength` 字节，失败时返回 nil
+static NSMutableData *AUCDeflate(const void *bytes, size_t length, NSData *dictionary, size_t headerLength) {
+    z_stream stream = {0};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) return nil;
+    if (dictionary.length > 0 && deflateSetDictionary(&stream, dictionary.bytes, (uInt)dictionary.length) != Z_OK) {
+        deflateEnd(&stream);
+        return nil;
+    }
+    uLong bound = deflateBound(&stream, (uLong)length);
+    NSMutableData *output = [NSMutableData dataWithLength:headerLength + bound];
+    stream.next_in = (Bytef *)bytes;
+    stream.avail_in = (uInt)length;
+    stream.next_out = (Bytef *)output.mutableBytes + headerLength;
+    stream.avail_out = (uInt)bound;
+    int status = deflate(&stream, Z_FINISH);
+    output.length = headerLength + stream.total_out;
+    deflateEnd(&stream);
+    return status == Z_STREAM_END ? output : nil;
+}
+
+static inline uint64_t AUCCompressorNanosecondsSince(CFAbsoluteTime start) {
+    return (uint64_t)((CFAbsoluteTimeGetCurrent() - start) * NSEC_PER_SEC);
+}
+
+@interface _AUCCompressionDictionary : NSObject
+@property (nonatomic, copy) NSString *prefix;
+@property (nonatomic, copy) NSData *data;
+@property (nonatomic, assign) uint32_t dictionaryID;
+@end
+
+@implementation _AUCCompressionDictionary
+@end
+
+@implementation AUCCacheCompressor {
+    NSUInteger _threshold;
+    double _maxRatio;
+    /// 按前缀长度降序排列，第一个匹配的即最长前缀
+    NSArray<_AUCCompressionDictionary *> *_dictionaries;
+    NSDictionary<NSNumber *, NSData *> *_dictionariesByID;
+
+    _Atomic(uint64_t) _compressedCount;
+    _Atomic(uint64_t) _uncompressedBytes;
+    _Atomic(uint64_t) _compressedBytes;
+    _Atomic(uint64_t) _decodedBytes;
+    _Atomic(uint64_t) _decodeNanoseconds;
+}
+
+- (instancetype)initWithThreshold:(NSUInteger)threshold maxRatio:(double)maxRatio dictionaries:(NSDictionary<NSString *, NSData *> *)dictionaries {
+    if (self = [super init]) {
+        _threshold = threshold;
+        _maxRatio = maxRatio;
+
+        NSMutableArray<_AUCCompressionDictionary *> *entries = [NSMutableArray arrayWithCapacity:dictionaries.count];
+        NSMutableDictionary<NSNumber *, NSData *> *dictionariesByID = [NSMutableDictionary dictionaryWithCapacity:dictionaries.count];
+        [dictionaries enumerateKeysAndObjectsUsingBlock:^(NSString *prefix, NSData *data, BOOL *stop) {
+            if (data.length == 0) return;
+            _AUCCompressionDictionary *entry = [_AUCCompressionDictionary new];
+            entry.prefix = prefix;
+            entry.data = data;
+            // 与 zlib 流中的 DICTID 相同，取字典的 Adler-32
+            entry.dictionaryID = (uint32_t)adler32(adler32(0, Z_NULL, 0), data.bytes, (uInt)data.length);
+            [entries addObject:entry];
+            dictionariesByID[@(entry.dictionaryID)] = data;
+        }];
+        [entries sortUsingComparator:^NSComparisonResult(_AUCCompressionDictionary *entry1, _AUCCompressionDictionary *entry2) {
+            if (entry1.prefix.length == entry2.prefix.length) return NSOrderedSame;
+            return entry1.prefix.length > entry2.prefix.length ? NSOrderedAscending : NSOrderedDescending;
+        }];
+        _dictionaries = [entries copy];
+        _dictionariesByID = [dictionariesByID copy];
+    }
+    return self;
+}
+
+#pragma mark - Compress
+- (NSData *)compressedDataForData:(NSData *)data key:(NSString *)key {
+    NSUInteger length = data.length;
+    if (_threshold == 0 || length < _threshold || length > UINT32_MAX) return data;
+
+    _AUCCompressionDictionary *dictionary = [self dictionaryForKey:key];
+    // 大数据先试压缩开头一段，已压缩的格式（图片、压缩包）不必完整压缩一遍
+    if (length > AUC_COMPRESSOR_PROBE_THRESHOLD) {
+        NSData *probe = AUCDeflate(data.bytes, AUC_COMPRESSOR_PROBE_LENGTH, dictionary.data, 0);
+        if (!probe || probe.length > AUC_COMPRESSOR_PROBE_LENGTH * _maxRatio) return data;
+    }
+
+    NSMutableData *compressedData = AUCDeflate(data.bytes, length, dictionary.data, AUC_COMPRESSOR_HEADER_LENGTH);
+    if (!compressedData || compressedData.length > length * _maxRatio) return data;
+
+    AUCCompressorHeader header = {0};
+    header.magic = AUC_COMPRESSOR_MAGIC;
+    header.codec = AUC_COMPRESSOR_CODEC_DEFLATE;
+    header.length = length;
+    if (dictionary) {
+        header.flags |= AUC_COMPRESSOR_FLAG_DICTIONARY;
+        header.dictionaryID = dictionary.dictionaryID;
+    }
+    header.headerChecksum = AUCCompressorHeaderChecksum(&header);
+    memcpy(compressedData.mutableBytes, &header, AUC_COMPRESSOR_HEADER_LENGTH);
+
+    atomic_fetch_add_explicit(&_compressedCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_uncompressedBytes, length, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_compressedBytes, compressedData.length, memory_order_relaxed);
+    return compressedData;
+}
+
+- (nullable _AUCCompressionDictionary *)dictionaryForKey:(nullable NSString *)key {
+    if (!key) return nil;
+    for (_AUCCompressionDictionary *dictionary in _dictionaries) {
+        if ([key hasPrefix:dictionary.prefix]) return dictionary;
+    }
+    return nil;
+}
+
+#pragma mark - Decompress
+- (NSData *)decompressedDataForData:(NSData *)data {
+    AUCCompressorHeader header;
+    if (!AUCCompressorReadHeader(data, &header)) return data;
+    if (header.codec != AUC_COMPRESSOR_CODEC_DEFLATE || header.length > UINT32_MAX) return nil;
+
+    NSData *dictionary = nil;
+    if (header.flags & AUC_COMPRESSOR_FLAG_DICTIONARY) {
+        dictionary = _dictionariesByID[@(header.dictionaryID)];
+        if (!dictionary) return nil;
+    }
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    z_stream stream = {0};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) return nil;
+    // 原始 deflate 流在初始化后即可设置字典
+    if (dictionary && inflateSetDictionary(&stream, dictionary.bytes, (uInt)dictionary.length) != Z_OK) {
+        inflateEnd(&stream);
+        return nil;
+    }
+    NSMutableData *output = [NSMutableData dataWithLength:(NSUInteger)header.length];
+    stream.next_in = (Bytef *)data.bytes + AUC_COMPRESSOR_HEADER_LENGTH;
+    stream.avail_in = (uInt)(data.length - AUC_COMPRESSOR_HEADER_LENGTH);
+    stream.next_out = output.mutableBytes;
+    stream.avail_out = (uInt)header.length;
+    int status = inflate(&stream, Z_FINISH);
+    BOOL valid = status == Z_STREAM_END && stream.total_out == header.length && stream.avail_in == 0;
+    inflateEnd(&stream);
+    if (!valid) return nil;
+
+    atomic_fetch_add_explicit(&_decodedBytes, header.length, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_decodeNanoseconds, AUCCompressorNanosecondsSince(start), memory_order_relaxed);
+    return output;
+}
+
++ (BOOL)isCompressedData:(NSData *)data {
+    AUCCompressorHeader header;
+    return AUCCompressorReadHeader(data, &header);
+}
+
+#pragma mark - Dictionary training
++ (NSData *)trainDictionaryWithSamples:(NSArray<NSData *> *)samples maxLength:(NSUInteger)maxLength {
+    // 片段 -> 出现该片段的样本数，只在一个响应中重复的片段已能被 deflate 窗口引用，字典收益来自跨响应重复
+    NSMutableDictionary<NSData *, NSNumber *> *sampleCounts = [NSMutableDictionary dictionary];
+    for (NSData *sample in samples) {
+        @autoreleasepool {
+            NSMutableSet<NSData *> *fragments = [NSMutableSet set];
+            const uint8_t *p = sample.bytes;
+            NSUInteger n = sample.length;
+            NSUInteger i = 0;
+            while (i < n) {
+                NSUInteger start = i;
+                NSUInteger end;
+                if (p[i] == '"') {
+                    // 字符串，后面紧跟 `:` 时连同 `:` 作为字段名
+                    NSUInteger j = i + 1;
+                    while (j < n && p[j] != '"') j += (p[j] == '\\') ? 2 : 1;
+                    end = MIN(j + 1, n);
+                    NSUInteger k = end;
+                    while (k < n && (p[k] == ' ' || p[k] == '\n' || p[k] == '\r' || p[k] == '\t')) k++;
+                    if (k < n && p[k] == ':') end = k + 1;
+                } else if (isalnum(p[i]) || p[i] == '-') {
+                    // 数字与 true、false、null
+                    NSUInteger j = i;
+                    while (j < n && (isalnum(p[j]) || p[j] == '.' || p[j] == '-' || p[j] == '+')) j++;
+                    end = j;
+                } else {
+                    i++;
+                    continue;
+                }
+                NSUInteger fragmentLength = end - start;
+                if (fragmentLength >= AUC_COMPRESSOR_MIN_FRAGMENT_LENGTH && fragmentLength <= AUC_COMPRESSOR_MAX_FRAGMENT_LENGTH) {
+                    [fragments addObject:[NSData dataWithBytes:p + start length:fragmentLength]];
+                }
+                i = end;
+            }
+            for (NSData *fragment in fragments) {
+                sampleCounts[fragment] = @(sampleCounts[fragment].unsignedIntegerValue + 1);
+            }
+        }
+    }
+
+    // 只有一个样本时无法判断跨响应重复，保留全部片段
+    NSUInteger minSampleCount = MIN(samples.count, (NSUInteger)2);
+    NSMutableArray<NSData *> *candidates = [NSMutableArray array];
+    [sampleCounts enumerateKeysAndObjectsUsingBlock:^(NSData *fragment, NSNumber *count, BOOL *stop) {
+        if (count.unsignedIntegerValue >= minSampleCount) [candidates addObject:fragment];
+    }];
+    // 收益 = 出现的样本数 × 长度，降序
+    [candidates sortUsingComparator:^NSComparisonResult(NSData *fragment1, NSData *fragment2) {
+        NSUInteger score1 = sampleCounts[fragment1].unsignedIntegerValue * fragment1.length;
+        NSUInteger score2 = sampleCounts[fragment2].unsignedIntegerValue * fragment2.length;
+        if (score1 == score2) return NSOrderedSame;
+        return score1 > score2 ? NSOrderedAscending : NSOrderedDescending;
+    }];
+
+    NSMutableArray<NSData *> *selected = [NSMutableArray array];
+    NSUInteger totalLength = 0;
+    for (NSData *fragment in candidates) {
+        if (totalLength + fragment.length > maxLength) continue;
+        [selected addObject:fragment];
+        totalLength += fragment.length;
+    }
+    // 收益最高的片段放在字典末尾
+    NSMutableData *dictionary = [NSMutableData dataWithCapacity:totalLength];
+    for (NSData *fragment in selected.reverseObjectEnumerator) {
+        [dictionary appendData:fragment];
+    }
+    return dictionary;
+}
+
+#pragma mark - Statistics
+- (NSUInteger)compressedCount {
+    return (NSUInteger)atomic_load_explicit(&_compressedCount, memory_order_relaxed);
+}
+
+- (uint64_t)uncompressedBytes {
+    return atomic_load_explicit(&_uncompressedBytes, memory_order_relaxed);
+}
+
+- (uint64_t)compressedBytes {
+    return atomic_load_explicit(&_compressedBytes, memory_order_relaxed);
+}
+
+- (double)compressionRatio {
+    uint64_t uncompressedBytes = self.uncompressedBytes;
+    return uncompressedBytes > 0 ? (double)self.compressedBytes / uncompressedBytes : 1;
+}
+
+- (uint64_t)decodedBytes {
+    return atomic_load_explicit(&_decodedBytes, memory_order_relaxed);
+}
+
+- (NSTimeInterval)decodeTime {
+    return (NSTimeInterval)atomic_load_explicit(&_decodeNanoseconds, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+- (double)decodeThroughput {
+    NSTimeInterval decodeTime = self.decodeTime;
+    return decodeTime > 0 ? self.decodedBytes / decodeTime : 0;
+}
+
+- (void)resetStatistics {
+    atomic_store_explicit(&_compressedCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_uncompressedBytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&_compressedBytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&_decodedBytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&_decodeNanoseconds, 0, memory_order_relaxed);
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p, compressedCount: %lu, compressionRatio: %.3f, decodeThroughput: %.1fMB/s>",
+            self.class, self, (unsigned long)self.compressedCount, self.compressionRatio, self.decodeThroughput / (1024 * 1024)];
+}
+
+@end
@@ -10,6 +10,9 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class AUCCacheCostEstimator;
+@class AUCCallbackExecutor;
+@protocol AUCCacheCodecProtocol;
 /// ``缓存配置类``
 @interface AUCCacheConfig : NSObject <NSCopying>
 
@@ -68,6 +71,118 @@ NS_ASSUME_NONNULL_BEGIN
 /// - Note: 以字节为单位，默认为`0 - 即没有缓存大小限制`
 @property (assign, nonatomic) NSUInteger maxDiskSize;
 
+/// 过期清理每个时间片的时间预算，单位为【秒】
+///
+/// - Note: 默认为`0.01`，设置为`0或负值表示不分片，一次完成清理`
+/// - Note: 仅对实现了 `removeExpiredDataWithTimeBudget:` 的磁盘缓存生效，时间片之间会让出 IO 队列给其他读写操作
+@property (assign, nonatomic) NSTimeInterval diskCacheMaintenanceTimeBudget;
+
+/// 磁盘 IO 并发数，即 `AUCCacheCombine` 同时执行的磁盘操作（读取、写入、删除、查询是否存在）数量
+///
+/// - Note: 默认为`0 - 自动`：内置磁盘缓存使用 CPU 核数（不超过 4），自定义磁盘缓存为 1；设置为`1`时所有操作串行执行
+/// - Note: 同一个键的操作总是按调用顺序串行执行，不同键的操作按优先级（交互读取 > 预取 > 写入 > 维护）执行，参考 `AUCIOPriority`
+/// - Note: 清空、过期清理、组提交等作用于整个缓存的操作独占执行，执行期间不执行其他操作
+/// - Warning: 自定义磁盘缓存设置大于 1 的值时，必须保证不同键的方法可以在多个线程中同时调用
+@property (assign, nonatomic) NSUInteger diskCacheIOConcurrency;
+
+/// 磁盘写入组提交的收集窗口，单位为【秒】
+///
+/// - Note: 默认为`0 - 禁用`，每次写入单独提交；设置为大于 0 的值（如`0.05`）时，窗口内的写入合并为一批，并行编码后一次提交
+/// - Note: 启用后写入的 completion 会延迟到所在批次落盘后回调，最多延迟一个窗口
+/// - Note: 窗口内对同一个键的多次写入只落盘最后一次，尚未落盘的数据仍可以正常读取
+@property (assign, nonatomic) NSTimeInterval diskCacheWriteBatchInterval;
+
+/// 磁盘写入组提交的字节阈值
+///
+/// - Note: 以字节为单位，默认为`1MB`。待写入数据的估算大小达到该值时不等窗口结束立即提交，设置为`0表示不限制`
+@property (assign, nonatomic) NSUInteger diskCacheWriteBatchBytes;
+
+/// 磁盘缓存读取时的校验方式
+///
+/// - Note: 默认值 - `AUCCacheDiskChecksumModeLazy`。校验失败的数据会被删除并按未命中处理
+/// - Note: 该值只决定读取时是否校验，与文件格式无关：`AUCDiskCache` 写入的文件总是带有校验头部，早期版本写入的无头部文件仍按原样读取，迁移方式参考 `AUCDiskEntryFormat`
+/// - Note: 不为 `AUCCacheDiskChecksumModeOff` 时，启动一段时间后会在 IO 队列中以维护优先级分片校验一部分缓存文件（`AUCDiskCache`），提前删除损坏的数据
+/// - Note: 仅对 `AUCDiskCache` 生效，`AUCSegmentDiskCache` 在启动扫描分段时校验每条记录，`AUCSQLiteDiskCache` 由 SQLite 保证完整性
+@property (assign, nonatomic) AUCCacheDiskChecksumMode diskCacheChecksumMode;
+
+/// 磁盘缓存使用内存映射读取数据的大小阈值
+///
+/// - Note: 以字节为单位，默认为`64KB`。不小于该大小的数据以 `mmap` 映射返回，不拷贝到堆内存，设置为`0表示禁用`
+/// - Note: `AUCDiskCache`、`AUCSQLiteDiskCache` 仅在 `diskCacheWritingOptions` 包含 `NSDataWritingAtomic` 时使用映射
+@property (assign, nonatomic) NSUInteger diskCacheMappingThreshold;
+
+/// SQLite 磁盘缓存（`AUCSQLiteDiskCache`）内联保存数据的大小上限
+///
+/// - Note: 以字节为单位，默认为`16KB`。不超过该大小的数据直接保存在数据库中，超过的数据写入独立文件
+@property (assign, nonatomic) NSUInteger diskCacheInlineThreshold;
+
+/// 分段磁盘缓存（`AUCSegmentDiskCache`）单个分段文件的预分配大小
+///
+/// - Note: 以字节为单位，默认为`4MB`。超过该大小的单条记录会独占一个分段
+@property (assign, nonatomic) NSUInteger diskSegmentSize;
+
+/// 磁盘数据压缩阈值
+///
+/// - Note: 以字节为单位，默认为`0 - 不压缩`。不小于该大小的数据写入磁盘前尝试以 zlib 压缩，接口 JSON 建议设置为`1KB`
+/// - Note: 压缩数据带有帧头，读取时自动解压，开启或关闭压缩不影响已有缓存的读取
+@property (assign, nonatomic) NSUInteger diskCacheCompressionThreshold;
+
+/// 保存压缩数据的最大压缩率（压缩后大小 / 原大小）
+///
+/// - Note: 默认为`0.9`，压缩后节省不足 10% 的数据按原样保存，读取时省去解压
+@property (assign, nonatomic) double diskCacheCompressionMaxRatio;
+
+/// 磁盘数据压缩的预置字典，`API 前缀 -> 字典`
+///
+/// - Note: 默认为 nil。前缀的适配规则与 `whitelistAPIs` 相同，键匹配多个前缀时使用最长的；字典可以由 `AUCCacheCompressor` 从响应样本中训练
+/// - Warning: 解压需要写入时使用的字典，删除或修改字典后，用旧字典压缩的数据按未命中处理
+@property (copy, nonatomic, nullable) NSDictionary<NSString *, NSData *> *diskCacheCompressionDictionaries;
+
+/// 自定义磁盘数据编解码器
+///
+/// - Note: 默认为 nil，只使用内置 JSON 编解码器（紧凑格式）。写入时按数组顺序选择第一个支持该对象的编解码器，都不支持时再尝试内置 JSON 编解码器
+/// - Note: 编码结果带有编解码器标签，读取时按标签解码，磁盘命中只解码一次，结果同时写入内存缓存与回调
+/// - Warning: 移除编解码器后，用其编码的数据按未命中处理；该值不支持动态更改
+@property (copy, nonatomic, nullable) NSArray<id<AUCCacheCodecProtocol>> *diskCacheCodecs;
+
+/// 是否以二进制格式保存 JSON 对象树（`NSDictionary`/`NSArray`）
+///
+/// - Note: 默认为`NO`，以紧凑 JSON 保存。开启后磁盘命中返回懒加载的字典与数组（`AUCCacheBinaryCodec`），只解析被访问的字段，适合只读取少数顶层字段的接口响应
+/// - Note: 两种格式总是都可以读取，开启或关闭不影响已有缓存
+/// - Note: 返回 `NSData` 的接口（`diskCacheDataForKey:` 等）仍返回 JSON，二进制格式只在磁盘上使用
+/// - Warning: 懒加载对象每次访问都会生成新的字符串与数字对象，需要反复遍历整棵树时不建议开启；该值不支持动态更改
+@property (assign, nonatomic) BOOL shouldUseBinaryDiskFormat;
+
+/// 是否使用基于 SIMD 结构索引的 JSON 解析器解码磁盘命中的 JSON 数据
+///
+/// - Note: 默认为`NO`，使用 `NSJSONSerialization`。开启后先用 NEON/AVX2/SSE2 一次定位所有结构字符，再沿索引构建对象树（`AUCJSONParser`），结果与 `NSJSONSerialization` 相同
+/// - Note: 结构索引解析器无法处理的数据回退到 `NSJSONSerialization`，包括早期版本写入的不带帧头的数据
+/// - Warning: 解析时额外分配数据长度 4 倍的索引缓冲区；该值不支持动态更改
+@property (assign, nonatomic) BOOL shouldUseSIMDJSONParser;
+
+/// 是否对内容相同的磁盘数据去重
+///
+/// - Note: 默认为`NO`。仅 `AUCDiskCache` 支持：内容相同的数据只保存一份，各个键以硬链接引用，最后一个引用删除时共享数据随之删除
+/// - Note: 磁盘缓存的总大小仍按每个键的数据大小统计，`maxDiskSize` 清理偏保守；去重节省的空间见 `-[AUCDiskCache deduplicatedSize]`
+@property (assign, nonatomic) BOOL shouldDeduplicateDiskData;
+
+/// 磁盘数据差量存储阈值
+///
+/// - Note: 以字节为单位，默认为`0 - 不使用差量存储`。仅 `AUCDiskCache` 支持：不小于该大小的数据覆盖写入时，与上一个完整版本比较，差异较小时只写入差量
+/// - Note: 适合重新请求后只有少量字段变化的接口（分页列表、计数等）；读取时读入基准版本并还原一次差量
+/// - Note: 与 `diskCacheCompressionThreshold` 同时开启时，压缩后的数据即使原文只改动少量字段也差异很大，差量存储基本不会生效
+@property (assign, nonatomic) NSUInteger diskCacheDeltaThreshold;
+
+/// 保存差量的最大比例（差量大小 / 新版本大小）
+///
+/// - Note: 默认为`0.5`，差量超过新版本一半时改为写入完整版本，并以其作为新的基准版本
+@property (assign, nonatomic) double diskCacheDeltaMaxRatio;
+
+/// 两个完整版本之间最多连续写入的差量次数
+///
+/// - Note: 默认为`8`。差量总是相对上一个完整版本计算，随修改累积逐渐变大，达到次数后写入完整版本重新作为基准
+@property (assign, nonatomic) NSUInteger diskCacheDeltaMaxRevisions;
+
  /// 内存数据缓存的最大`总成本`，成本函数是内存中的字节数
 ///
 /// - Note: 默认为`0 - 没有内存成本限制`
@@ -78,6 +193,33 @@ NS_ASSUME_NONNULL_BEGIN
 /// - Note: 默认为`0 - 没有内存数量限制`
 @property (assign, nonatomic) NSUInteger maxMemoryCount;
 
+/// 分片内存缓存（`AUCShardedMemoryCache`）的分片数量
+///
+/// - Note: 默认为`0 - 根据活跃 CPU 核心数自动计算`，实际取值会向上取整为 2 的整数次幂，且不超过 64
+/// - Warning: 该值不支持动态更改。这意味着在缓存【启动后】对该值的进一步修改将不起作用
+@property (assign, nonatomic) NSUInteger memoryCacheShardCount;
+
+/// 内存缓存的准入与淘汰策略
+///
+/// - Note: 默认值 - `AUCCacheMemoryEvictionPolicyLRU`
+/// - Note: `AUCCacheMemoryEvictionPolicyTinyLFU` 由 `AUCShardedMemoryCache` 实现，`memoryCacheClass` 为默认的 `AUCMemoryCache` 时将自动改用 `AUCShardedMemoryCache`
+/// - Warning: 其他自定义 `memoryCacheClass`（非 `AUCShardedMemoryCache` 子类）无法使用 TinyLFU 策略，Debug 下创建缓存时会触发断言，Release 下按该类自身的淘汰方式工作
+/// - Note: 只有设置了 `maxMemoryCount` 或 `maxMemoryCost` 时，准入策略才会生效
+/// - Warning: 该值不支持动态更改。这意味着在缓存【启动后】对该值的进一步修改将不起作用
+@property (assign, nonatomic) AUCCacheMemoryEvictionPolicy memoryCacheEvictionPolicy;
+
+/// 内存缓存成本估算器，写入内存缓存或从磁盘提升到内存缓存时，用于计算数据的近似常驻字节数
+///
+/// - Note: 默认为一个新的 `AUCCacheCostEstimator` 实例，配置拷贝时只传递引用
+/// - Note: 设置为 nil 时所有成本均为 0，此时 `maxMemoryCost` 将不起作用
+@property (strong, nonatomic, nullable) AUCCacheCostEstimator *memoryCostEstimator;
+
+/// 异步操作（写入、删除、清除、存在性检查、大小统计、查询等）完成回调的执行器
+///
+/// - Note: 默认为 `AUCCallbackExecutor.mainQueueExecutor`，在主队列回调并合并同一轮完成的回调；设置为 nil 时同默认值，配置拷贝时只传递引用
+/// - Note: 后台使用方可以设置为自己队列的执行器或 `inlineExecutor`，单次调用可以通过 `AUCCacheContextCallbackExecutor` 覆盖
+@property (strong, nonatomic, nullable) AUCCallbackExecutor *callbackExecutor;
+
 /// 清除磁盘缓存时将检查缓存过期方式
 ///
 /// - Note: 默认值为`AUCCacheConfigExpireTypeModificationDate`，根据【创建或修改缓存】作为过期依据
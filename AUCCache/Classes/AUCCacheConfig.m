@@ -8,9 +8,20 @@
 #import "AUCCacheConfig.h"
 #import "AUCMemoryCache.h"
 #import "AUCDiskCache.h"
+#import "AUCCacheCostEstimator.h"
+#import "AUCCallbackExecutor.h"
 
 static AUCCacheConfig *_defaultConfig;
 static const NSInteger DEFAULT_CACHE_MAX_DISK_AGE = 60 * 60 * 24 * 7; // 1 week
+static const NSTimeInterval DEFAULT_CACHE_DISK_MAINTENANCE_TIME_BUDGET = 0.01; // 10ms
+static const NSTimeInterval DEFAULT_CACHE_DISK_WRITE_BATCH_INTERVAL = 0; // 默认不启用组提交
+static const NSUInteger DEFAULT_CACHE_DISK_WRITE_BATCH_BYTES = 1024 * 1024; // 1MB
+static const NSUInteger DEFAULT_CACHE_DISK_MAPPING_THRESHOLD = 64 * 1024; // 64KB
+static const NSUInteger DEFAULT_CACHE_DISK_INLINE_THRESHOLD = 16 * 1024; // 16KB
+static const NSUInteger DEFAULT_CACHE_DISK_SEGMENT_SIZE = 4 * 1024 * 1024; // 4MB
+static const double DEFAULT_CACHE_DISK_COMPRESSION_MAX_RATIO = 0.9;
+static const double DEFAULT_CACHE_DISK_DELTA_MAX_RATIO = 0.5;
+static const NSUInteger DEFAULT_CACHE_DISK_DELTA_MAX_REVISIONS = 8;
 @implementation AUCCacheConfig
 + (AUCCacheConfig *)defaultConfig {
     static dispatch_once_t onceToken;
@@ -30,10 +41,29 @@ static const NSInteger DEFAULT_CACHE_MAX_DISK_AGE = 60 * 60 * 24 * 7; // 1 week
         _diskCacheWritingOptions = NSDataWritingAtomic;
         _maxDiskAge = DEFAULT_CACHE_MAX_DISK_AGE;
         _maxDiskSize = 0;
+        _diskCacheWriteBatchInterval = DEFAULT_CACHE_DISK_WRITE_BATCH_INTERVAL;
+        _diskCacheWriteBatchBytes = DEFAULT_CACHE_DISK_WRITE_BATCH_BYTES;
+        _diskCacheChecksumMode = AUCCacheDiskChecksumModeLazy;
+        _diskCacheMappingThreshold = DEFAULT_CACHE_DISK_MAPPING_THRESHOLD;
+        _diskCacheInlineThreshold = DEFAULT_CACHE_DISK_INLINE_THRESHOLD;
+        _diskSegmentSize = DEFAULT_CACHE_DISK_SEGMENT_SIZE;
+        _diskCacheCompressionThreshold = 0;
+        _diskCacheCompressionMaxRatio = DEFAULT_CACHE_DISK_COMPRESSION_MAX_RATIO;
+        _shouldUseBinaryDiskFormat = NO;
+        _shouldUseSIMDJSONParser = NO;
+        _shouldDeduplicateDiskData = NO;
+        _diskCacheDeltaThreshold = 0;
+        _diskCacheDeltaMaxRatio = DEFAULT_CACHE_DISK_DELTA_MAX_RATIO;
+        _diskCacheDeltaMaxRevisions = DEFAULT_CACHE_DISK_DELTA_MAX_REVISIONS;
+        _diskCacheMaintenanceTimeBudget = DEFAULT_CACHE_DISK_MAINTENANCE_TIME_BUDGET;
+        _diskCacheIOConcurrency = 0;
         _diskCacheExpireType = AUCCacheConfigExpireTypeModificationDate;
+        _memoryCacheEvictionPolicy = AUCCacheMemoryEvictionPolicyLRU;
         _memoryCacheClass = [AUCMemoryCache class];
         _diskCacheClass = [AUCDiskCache class];
         _whitelistAPIs = @[];
+        _memoryCostEstimator = [AUCCacheCostEstimator new];
+        _callbackExecutor = AUCCallbackExecutor.mainQueueExecutor;
     }
     return self;
 }
@@ -49,14 +79,36 @@ static const NSInteger DEFAULT_CACHE_MAX_DISK_AGE = 60 * 60 * 24 * 7; // 1 week
     config.diskCacheWritingOptions = self.diskCacheWritingOptions;
     config.maxDiskAge = self.maxDiskAge;
     config.maxDiskSize = self.maxDiskSize;
+    config.diskCacheWriteBatchInterval = self.diskCacheWriteBatchInterval;
+    config.diskCacheWriteBatchBytes = self.diskCacheWriteBatchBytes;
+    config.diskCacheChecksumMode = self.diskCacheChecksumMode;
+    config.diskCacheMappingThreshold = self.diskCacheMappingThreshold;
+    config.diskCacheInlineThreshold = self.diskCacheInlineThreshold;
+    config.diskSegmentSize = self.diskSegmentSize;
+    config.diskCacheCompressionThreshold = self.diskCacheCompressionThreshold;
+    config.diskCacheCompressionMaxRatio = self.diskCacheCompressionMaxRatio;
+    config.diskCacheCompressionDictionaries = self.diskCacheCompressionDictionaries;
+    config.diskCacheCodecs = self.diskCacheCodecs;
+    config.shouldUseBinaryDiskFormat = self.shouldUseBinaryDiskFormat;
+    config.shouldUseSIMDJSONParser = self.shouldUseSIMDJSONParser;
+    config.shouldDeduplicateDiskData = self.shouldDeduplicateDiskData;
+    config.diskCacheDeltaThreshold = self.diskCacheDeltaThreshold;
+    config.diskCacheDeltaMaxRatio = self.diskCacheDeltaMaxRatio;
+    config.diskCacheDeltaMaxRevisions = self.diskCacheDeltaMaxRevisions;
+    config.diskCacheMaintenanceTimeBudget = self.diskCacheMaintenanceTimeBudget;
+    config.diskCacheIOConcurrency = self.diskCacheIOConcurrency;
     config.maxMemoryCost = self.maxMemoryCost;
     config.maxMemoryCount = self.maxMemoryCount;
+    config.memoryCacheShardCount = self.memoryCacheShardCount;
+    config.memoryCacheEvictionPolicy = self.memoryCacheEvictionPolicy;
     config.diskCacheExpireType = self.diskCacheExpireType;
     
     /// NSFileManager 并未遵守 NSCopying协议，只需传递引用
     config.fileManager = self.fileManager;
     config.memoryCacheClass = self.memoryCacheClass;
     config.diskCacheClass = self.diskCacheClass;
+    config.memoryCostEstimator = self.memoryCostEstimator;
+    config.callbackExecutor = self.callbackExecutor;
     config.baseURL = self.baseURL;
     config.whitelistAPIs = [[NSArray alloc] initWithArray:self.whitelistAPIs copyItems:YES];
     
@@ -0,0 +1,65 @@
+//
+//  AUCCacheCostEstimator.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/06.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 自定义类型的成本计算回调
+///
+/// - Parameter object: 需要计算成本的对象（为注册类型或其子类的实例）
+/// - Returns: 对象常驻内存的近似字节数
+typedef NSUInteger (^AUCCacheCostBlock)(id _Nonnull object);
+
+/// ``内存缓存成本估算器``
+///
+/// 遍历缓存对象图，估算其常驻内存的近似字节数，作为内存缓存 `setObject:forKey:cost:` 的成本
+/// 支持 `NSData`、`NSString`、`NSNumber`、`NSNull`，以及 `NSJSONSerialization` 生成的 `NSDictionary`/`NSArray` 树
+/// ```
+/// 对象头          16 字节（按 malloc 16 字节对齐）
+/// NSData        对象头 + length
+/// NSString      对象头 + length（ASCII 存储） 或 length * 2（UTF-16 存储）
+/// NSArray       对象头 + count * 指针 + 子节点成本
+/// NSDictionary  对象头 + count * 2 * 指针 * 哈希表装载系数 + 键值成本
+/// ```
+///
+/// - Note: 容器元素数超过 `samplingThreshold` 时启用采样，只计算 `sampleCount` 个均匀分布的子节点并按比例放大
+/// - Note: 可以通过 `setCostBlock:forClass:` 为指定类型（包含其子类）覆盖默认估算方式
+/// - Note: `AUCCacheBinaryCodec` 解码的懒加载字典与数组按其持有的缓冲区长度估算，不遍历
+@interface AUCCacheCostEstimator : NSObject
+
+/// 容器采样阈值，元素数量大于该值的容器将按采样估算
+///
+/// - Note: 默认值 - 512，设置为 0 表示不采样，总是完整遍历
+@property (nonatomic, assign) NSUInteger samplingThreshold;
+
+/// 采样模式下每个容器实际计算的子节点数量
+///
+/// - Note: 默认值 - 32
+@property (nonatomic, assign) NSUInteger sampleCount;
+
+/// 最大遍历深度，超出深度的子树只计算对象头
+///
+/// - Note: 默认值 - 64
+@property (nonatomic, assign) NSUInteger maxDepth;
+
+/// 为指定类型注册自定义成本计算
+///
+/// - Parameters:
+///     - block: 成本计算回调，传 nil 表示移除
+///     - cls: 类型，其子类同样生效，最接近的注册类型优先
+- (void)setCostBlock:(nullable AUCCacheCostBlock)block forClass:(nonnull Class)cls;
+
+/// 估算对象常驻内存的近似字节数
+///
+/// - Parameter object: 需要计算的对象
+/// - Returns: 近似字节数，nil 返回 0
+- (NSUInteger)costForObject:(nullable id)object;
+
+@end
+
+NS_ASSUME_NONNULL_END
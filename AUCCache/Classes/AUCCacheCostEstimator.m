@@ -0,0 +1,149 @@
+//
+//  AUCCacheCostEstimator.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/06.
+//
+
+#import "AUCCacheCostEstimator.h"
+#import "AUCInternalMacros.h"
+#import "AUCCacheBinaryCodec.h"
+#import <objc/runtime.h>
+
+// malloc 最小分配粒度
+#define AUC_MALLOC_ALIGN(size) (((size) + 15) & ~((NSUInteger)15))
+// 对象头（isa + 引用计数等）
+static const NSUInteger AUC_OBJECT_HEADER_COST = 16;
+// 哈希表装载系数（按 3/2 估算桶数组开销）
+#define AUC_HASH_TABLE_SLOTS(count) ((count) + (count) / 2)
+
+@interface AUCCacheCostEstimator ()
+
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t hooksLock;
+/// 写时复制，读取时只需取一次快照
+@property (nonatomic, copy, nullable) NSDictionary<id, AUCCacheCostBlock> *costBlocks;
+
+@end
+
+@implementation AUCCacheCostEstimator
+- (instancetype)init {
+    if (self = [super init]) {
+        _samplingThreshold = 512;
+        _sampleCount = 32;
+        _maxDepth = 64;
+        _hooksLock = dispatch_semaphore_create(1);
+    }
+    return self;
+}
+
+- (void)setCostBlock:(AUCCacheCostBlock)block forClass:(Class)cls {
+    NSParameterAssert(cls);
+    if (!cls) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.hooksLock);
+    NSMutableDictionary<id, AUCCacheCostBlock> *costBlocks = [NSMutableDictionary dictionaryWithDictionary:_costBlocks ?: @{}];
+    if (block) {
+        costBlocks[(id<NSCopying>)cls] = [block copy];
+    } else {
+        [costBlocks removeObjectForKey:cls];
+    }
+    _costBlocks = costBlocks.count > 0 ? [costBlocks copy] : nil;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.hooksLock);
+}
+
+- (NSUInteger)costForObject:(id)object {
+    if (!object) return 0;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.hooksLock);
+    NSDictionary<id, AUCCacheCostBlock> *costBlocks = _costBlocks;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.hooksLock);
+    return [self costForObject:object depth:0 costBlocks:costBlocks];
+}
+
+#pragma mark - Private
+- (nullable AUCCacheCostBlock)costBlockForObject:(id)object inBlocks:(NSDictionary<id, AUCCacheCostBlock> *)costBlocks {
+    for (Class cls = object_getClass(object); cls; cls = class_getSuperclass(cls)) {
+        AUCCacheCostBlock block = costBlocks[cls];
+        if (block) return block;
+    }
+    return nil;
+}
+
+- (NSUInteger)costForObject:(id)object depth:(NSUInteger)depth costBlocks:(nullable NSDictionary<id, AUCCacheCostBlock> *)costBlocks {
+    if (costBlocks) {
+        AUCCacheCostBlock block = [self costBlockForObject:object inBlocks:costBlocks];
+        if (block) return block(object);
+    }
+
+    if ([object isKindOfClass:NSData.class]) {
+        return AUC_OBJECT_HEADER_COST + AUC_MALLOC_ALIGN([(NSData *)object length]);
+    }
+    if ([object isKindOfClass:NSString.class]) {
+        NSString *string = (NSString *)object;
+        // CFString 的 fastestEncoding 即内部存储编码，O(1) 且不拷贝；只有单字节存储时才会返回 ASCII 等 8 位编码
+        BOOL isUnicodeStorage = string.fastestEncoding == NSUnicodeStringEncoding;
+        NSUInteger length = string.length * (isUnicodeStorage ? 2 : 1);
+        return AUC_OBJECT_HEADER_COST + AUC_MALLOC_ALIGN(length);
+    }
+    if ([object isKindOfClass:NSNumber.class]) {
+        return AUC_OBJECT_HEADER_COST;
+    }
+    if (object == (id)kCFNull) {
+        return 0;
+    }
+    // 懒加载字典与数组只持有缓冲区，遍历会生成整棵对象树
+    NSUInteger bufferLength = [AUCCacheBinaryCodec bufferLengthOfLazyObject:object];
+    if (bufferLength > 0) {
+        return AUC_OBJECT_HEADER_COST + AUC_MALLOC_ALIGN(bufferLength);
+    }
+
+    BOOL exceedsDepth = (self.maxDepth > 0 && depth >= self.maxDepth);
+    if ([object isKindOfClass:NSArray.class]) {
+        NSArray *array = (NSArray *)object;
+        NSUInteger count = array.count;
+        NSUInteger cost = AUC_OBJECT_HEADER_COST + AUC_MALLOC_ALIGN(count * sizeof(void *));
+        if (exceedsDepth || count == 0) return cost;
+
+        if ([self shouldSampleCount:count]) {
+            // 均匀跨步采样，按平均成本放大
+            NSUInteger sampleCount = self.sampleCount;
+            NSUInteger sampled = 0;
+            for (NSUInteger i = 0; i < sampleCount; i++) {
+                sampled += [self costForObject:array[i * count / sampleCount] depth:depth + 1 costBlocks:costBlocks];
+            }
+            return cost + sampled / sampleCount * count;
+        }
+        for (id element in array) {
+            cost += [self costForObject:element depth:depth + 1 costBlocks:costBlocks];
+        }
+        return cost;
+    }
+    if ([object isKindOfClass:NSDictionary.class]) {
+        NSDictionary *dictionary = (NSDictionary *)object;
+        NSUInteger count = dictionary.count;
+        NSUInteger cost = AUC_OBJECT_HEADER_COST + AUC_MALLOC_ALIGN(AUC_HASH_TABLE_SLOTS(count) * 2 * sizeof(void *));
+        if (exceedsDepth || count == 0) return cost;
+
+        BOOL shouldSample = [self shouldSampleCount:count];
+        NSUInteger limit = shouldSample ? self.sampleCount : count;
+        __block NSUInteger visited = 0;
+        __block NSUInteger childrenCost = 0;
+        [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+            childrenCost += [self costForObject:key depth:depth + 1 costBlocks:costBlocks];
+            childrenCost += [self costForObject:value depth:depth + 1 costBlocks:costBlocks];
+            // 字典的遍历顺序由哈希决定，取前 N 个即可近似为随机采样
+            if (++visited >= limit) *stop = YES;
+        }];
+        if (shouldSample && visited > 0) {
+            childrenCost = childrenCost / visited * count;
+        }
+        return cost + childrenCost;
+    }
+
+    // 未知类型按实例大小估算
+    return AUC_MALLOC_ALIGN(class_getInstanceSize(object_getClass(object)));
+}
+
+- (BOOL)shouldSampleCount:(NSUInteger)count {
+    return self.samplingThreshold > 0 && self.sampleCount > 0 && count > self.samplingThreshold && count > self.sampleCount;
+}
+
+@end
@@ -0,0 +1,45 @@
+//
+//  AUCCacheDelta.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/27.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``二进制差量``
+///
+/// 以基准版本为参照描述新版本，由拷贝（引用基准版本中的一段）与插入（新增字节）两种指令组成
+/// ```
+/// delta
+///    ├── header   magic、修订号、基准版本长度与 CRC32C、新版本长度（32 字节）
+///    └── ops      varint(长度 << 1 | 是否拷贝)，拷贝指令后跟 varint(基准偏移)，插入指令后跟原始字节
+/// ```
+///
+/// - Note: 以 16 字节为块建立基准版本的哈希表，逐字节在新版本中查找匹配并向前后扩展，适合只有少量字段变化的接口 JSON
+/// - Note: 应用差量时校验基准版本的长度与 CRC32C，基准版本不匹配时返回 nil，不会生成错误的数据
+@interface AUCCacheDelta : NSObject
+
+/// 计算差量
+///
+/// - Parameters:
+///     - base: 基准版本
+///     - data: 新版本
+///     - revision: 写入差量头部的修订号，由调用方记录距离上一个完整版本的次数
+///     - maxLength: 差量的最大长度，超过时放弃计算，0 表示不限制
+/// - Returns: 差量，超过 `maxLength` 时返回 nil
++ (nullable NSData *)deltaFromData:(NSData *)base toData:(NSData *)data revision:(uint32_t)revision maxLength:(NSUInteger)maxLength;
+
+/// 应用差量
+///
+/// - Returns: 新版本，差量损坏或基准版本不匹配时返回 nil
++ (nullable NSData *)dataByApplyingDelta:(NSData *)delta toData:(NSData *)base;
+
+/// 差量头部记录的修订号，不是合法差量时返回 0
++ (uint32_t)revisionOfDelta:(NSData *)delta;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,221 @@
+//
+//  AUCCacheDelta.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/27.
+//
+
+#import "AUCCacheDelta.h"
+#import "AUCChecksum.h"
+
+// 'AUCD'
+static const uint32_t AUC_DELTA_MAGIC = 0x44435541;
+static const uint16_t AUC_DELTA_VERSION = 1;
+// 匹配的最小长度，也是基准版本建立哈希表的步长
+#define AUC_DELTA_BLOCK_LENGTH 16
+// 哈希表最多 2^22 项（16MB），更大的基准版本按块稀疏索引
+static const int AUC_DELTA_MAX_TABLE_BITS = 22;
+
+/// 差量头部，所有字段均为小端序
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    /// 距离上一个完整版本的次数
+    uint32_t revision;
+    /// 基准版本的 CRC32C
+    uint32_t baseChecksum;
+    uint64_t baseLength;
+    /// 新版本长度
+    uint64_t length;
+} AUCDeltaHeader;
+
+#define AUC_DELTA_HEADER_LENGTH 32
+_Static_assert(sizeof(AUCDeltaHeader) == AUC_DELTA_HEADER_LENGTH, "delta header must be 32 bytes");
+
+/// 输出缓冲区，超过 `limit` 时写入失败
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+    size_t limit;
+} AUCDeltaBuffer;
+
+static BOOL AUCDeltaBufferReserve(AUCDeltaBuffer *buffer, size_t length) {
+    size_t required = buffer->length + length;
+    if (buffer->limit > 0 && required > buffer->limit) return NO;
+    if (required <= buffer->capacity) return YES;
+    size_t capacity = MAX(required, buffer->capacity * 2);
+    uint8_t *bytes = realloc(buffer->bytes, capacity);
+    if (!bytes) return NO;
+    buffer->bytes = bytes;
+    buffer->capacity = capacity;
+    return YES;
+}
+
+static BOOL AUCDeltaWriteVarint(AUCDeltaBuffer *buffer, uint64_t value) {
+    if (!AUCDeltaBufferReserve(buffer, 10)) return NO;
+    while (value >= 0x80) {
+        buffer->bytes[buffer->length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer->bytes[buffer->length++] = (uint8_t)value;
+    return YES;
+}
+
+static BOOL AUCDeltaReadVarint(const uint8_t *bytes, size_t length, size_t *position, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *position < length; shift += 7) {
+        uint8_t byte = bytes[(*position)++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static BOOL AUCDeltaWriteInsert(AUCDeltaBuffer *buffer, const uint8_t *bytes, size_t length) {
+    if (length == 0) return YES;
+    if (!AUCDeltaWriteVarint(buffer, (uint64_t)length << 1) || !AUCDeltaBufferReserve(buffer, length)) return NO;
+    memcpy(buffer->bytes + buffer->length, bytes, length);
+    buffer->length += length;
+    return YES;
+}
+
+static BOOL AUCDeltaWriteCopy(AUCDeltaBuffer *buffer, size_t offset, size_t length) {
+    return AUCDeltaWriteVarint(buffer, ((uint64_t)length << 1) | 1) && AUCDeltaWriteVarint(buffer, offset);
+}
+
+static inline uint32_t AUCDeltaHashBlock(const uint8_t *bytes, int bits) {
+    uint64_t a, b;
+    memcpy(&a, bytes, 8);
+    memcpy(&b, bytes + 8, 8);
+    return (uint32_t)(((a * 0x9E3779B97F4A7C15ULL) ^ (b * 0xC2B2AE3D27D4EB4FULL)) >> (64 - bits));
+}
+
+/// 编码指令，超过缓冲区上限时返回 NO
+static BOOL AUCDeltaEncode(const uint8_t *base, size_t baseLength, const uint8_t *target, size_t targetLength, AUCDeltaBuffer *buffer) {
+    size_t blockCount = baseLength / AUC_DELTA_BLOCK_LENGTH;
+    uint32_t *table = NULL;
+    int bits = 0;
+    size_t stride = 1;
+    if (blockCount > 0) {
+        bits = 4;
+        while (bits < AUC_DELTA_MAX_TABLE_BITS && ((size_t)1 << bits) < blockCount * 2) bits++;
+        // 基准版本过大时每隔几个块索引一次，仍能找到足够长的匹配
+        stride = MAX((size_t)1, blockCount / ((size_t)1 << (bits - 1)));
+        table = calloc((size_t)1 << bits, sizeof(uint32_t));
+        if (!table) return NO;
+        for (size_t i = 0; i < blockCount; i += stride) {
+            table[AUCDeltaHashBlock(base + i * AUC_DELTA_BLOCK_LENGTH, bits)] = (uint32_t)(i + 1);
+        }
+    }
+
+    BOOL succeeded = YES;
+    size_t literalStart = 0;
+    size_t position = 0;
+    while (table && position + AUC_DELTA_BLOCK_LENGTH <= targetLength) {
+        uint32_t slot = table[AUCDeltaHashBlock(target + position, bits)];
+        size_t baseOffset = (size_t)(slot - 1) * AUC_DELTA_BLOCK_LENGTH;
+        if (slot == 0 || memcmp(base + baseOffset, target + position, AUC_DELTA_BLOCK_LENGTH) != 0) {
+            position++;
+            continue;
+        }
+        // 匹配向前扩展到尚未输出的插入内容中，向后扩展到不一致为止
+        size_t start = position, baseStart = baseOffset;
+        while (start > literalStart && baseStart > 0 && target[start - 1] == base[baseStart - 1]) {
+            start--;
+            baseStart--;
+        }
+        size_t end = position + AUC_DELTA_BLOCK_LENGTH, baseEnd = baseOffset + AUC_DELTA_BLOCK_LENGTH;
+        while (end < targetLength && baseEnd < baseLength && target[end] == base[baseEnd]) {
+            end++;
+            baseEnd++;
+        }
+        if (!AUCDeltaWriteInsert(buffer, target + literalStart, start - literalStart) || !AUCDeltaWriteCopy(buffer, baseStart, end - start)) {
+            succeeded = NO;
+            break;
+        }
+        position = literalStart = end;
+    }
+    free(table);
+    return succeeded && AUCDeltaWriteInsert(buffer, target + literalStart, targetLength - literalStart);
+}
+
+/// 按指令生成新版本，指令越界或长度不一致时返回 NO
+static BOOL AUCDeltaDecode(const uint8_t *base, size_t baseLength, const uint8_t *ops, size_t opsLength, uint8_t *output, size_t outputLength) {
+    size_t position = 0, written = 0;
+    while (position < opsLength) {
+        uint64_t op, offset;
+        if (!AUCDeltaReadVarint(ops, opsLength, &position, &op)) return NO;
+        uint64_t length = op >> 1;
+        if (length > outputLength - written) return NO;
+        if (op & 1) {
+            if (!AUCDeltaReadVarint(ops, opsLength, &position, &offset) || offset > baseLength || length > baseLength - offset) return NO;
+            memcpy(output + written, base + offset, (size_t)length);
+        } else {
+            if (length > opsLength - position) return NO;
+            memcpy(output + written, ops + position, (size_t)length);
+            position += (size_t)length;
+        }
+        written += (size_t)length;
+    }
+    return written == outputLength;
+}
+
+/// 解析头部，不是合法差量时返回 NO
+static BOOL AUCDeltaReadHeader(NSData *delta, AUCDeltaHeader *header) {
+    if (delta.length < AUC_DELTA_HEADER_LENGTH) return NO;
+    memcpy(header, delta.bytes, AUC_DELTA_HEADER_LENGTH);
+    return header->magic == AUC_DELTA_MAGIC && header->version == AUC_DELTA_VERSION;
+}
+
+@implementation AUCCacheDelta
+
++ (NSData *)deltaFromData:(NSData *)base toData:(NSData *)data revision:(uint32_t)revision maxLength:(NSUInteger)maxLength {
+    NSParameterAssert(base);
+    NSParameterAssert(data);
+    if (base.length / AUC_DELTA_BLOCK_LENGTH >= UINT32_MAX) return nil;
+    AUCDeltaBuffer buffer = {0};
+    buffer.limit = maxLength;
+    if (!AUCDeltaBufferReserve(&buffer, AUC_DELTA_HEADER_LENGTH + 64)) {
+        free(buffer.bytes);
+        return nil;
+    }
+    buffer.length = AUC_DELTA_HEADER_LENGTH;
+    if (!AUCDeltaEncode(base.bytes, base.length, data.bytes, data.length, &buffer)) {
+        free(buffer.bytes);
+        return nil;
+    }
+    AUCDeltaHeader header = {0};
+    header.magic = AUC_DELTA_MAGIC;
+    header.version = AUC_DELTA_VERSION;
+    header.revision = revision;
+    header.baseChecksum = AUCCRC32C(0, base.bytes, base.length);
+    header.baseLength = base.length;
+    header.length = data.length;
+    memcpy(buffer.bytes, &header, AUC_DELTA_HEADER_LENGTH);
+    return [NSData dataWithBytesNoCopy:buffer.bytes length:buffer.length freeWhenDone:YES];
+}
+
++ (NSData *)dataByApplyingDelta:(NSData *)delta toData:(NSData *)base {
+    NSParameterAssert(delta);
+    NSParameterAssert(base);
+    AUCDeltaHeader header;
+    if (!AUCDeltaReadHeader(delta, &header) || header.baseLength != base.length || header.length > NSIntegerMax) return nil;
+    if (header.baseChecksum != AUCCRC32C(0, base.bytes, base.length)) return nil;
+    NSMutableData *data = [NSMutableData dataWithLength:(NSUInteger)header.length];
+    if (!data) return nil;
+    const uint8_t *ops = (const uint8_t *)delta.bytes + AUC_DELTA_HEADER_LENGTH;
+    if (!AUCDeltaDecode(base.bytes, base.length, ops, delta.length - AUC_DELTA_HEADER_LENGTH, data.mutableBytes, data.length)) return nil;
+    return data;
+}
+
++ (uint32_t)revisionOfDelta:(NSData *)delta {
+    AUCDeltaHeader header;
+    return AUCDeltaReadHeader(delta, &header) ? header.revision : 0;
+}
+
+@end
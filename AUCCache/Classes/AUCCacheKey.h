@@ -0,0 +1,66 @@
+//
+//  AUCCacheKey.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/25.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 键摘要长度（MD5）
+#define AUC_CACHE_KEY_DIGEST_LENGTH 16
+
+/// ``缓存键``
+///
+/// 不可变的 `NSString` 子类，创建时计算一次键的派生值并缓存，同一次操作的内存查询、磁盘路径解析与白名单判断共用同一个实例
+/// ```
+/// AUCCacheKey
+///    ├── string       原始键
+///    ├── hash         与原始键的 -hash 一致，NSCache、分片内存缓存直接读取
+///    ├── digest       MD5 摘要（128 位），磁盘缓存文件名与索引使用
+///    ├── fileName     十六进制摘要 + URL 扩展名
+///    └── 白名单判定    按白名单版本缓存
+/// ```
+///
+/// - Note: 与内容相同的 `NSString` 互相 `isEqual:` 且 `hash` 相同，可以混用作为字典、`NSCache` 的键
+/// - Note: `keyWithString:` 在一张有上限的表中复用最近使用的实例，重复访问同一个键时不再重新计算
+@interface AUCCacheKey : NSString
+
+/// 原始键
+@property (nonatomic, copy, readonly) NSString *string;
+
+/// 键的 MD5 摘要，长度为 `AUC_CACHE_KEY_DIGEST_LENGTH`
+@property (nonatomic, assign, readonly) const unsigned char *digest NS_RETURNS_INNER_POINTER;
+
+/// 磁盘缓存文件名：32 位十六进制摘要，键可以解析出扩展名时附加 `.扩展名`
+@property (nonatomic, copy, readonly) NSString *fileName;
+
+/// 返回 `string` 对应的缓存键，`string` 已经是 `AUCCacheKey` 时直接返回，为 nil 时返回 nil
++ (nullable instancetype)keyWithString:(nullable NSString *)string;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// 读取已缓存的白名单判定
+///
+/// - Parameters:
+///     - contained: 返回是否在白名单中
+///     - generation: 白名单版本，白名单变化后版本号递增，旧版本的判定失效
+/// - Returns: 是否存在该版本的判定
+- (BOOL)getWhitelistVerdict:(BOOL *)contained generation:(NSUInteger)generation;
+
+/// 缓存白名单判定
+- (void)setWhitelistVerdict:(BOOL)contained generation:(NSUInteger)generation;
+
+@end
+
+/// 把二进制数据编码为小写十六进制字符，`hex` 至少需要 `length * 2` 字节，不追加 `\0`
+///
+/// - Note: arm64 使用 NEON、x86_64 使用 SSE2 每次编码 16 字节
+FOUNDATION_EXTERN void AUCHexEncode(const void *bytes, size_t length, char *hex);
+
+/// 由摘要和扩展名生成磁盘缓存文件名
+FOUNDATION_EXTERN NSString *AUCCacheKeyFileNameForDigest(const unsigned char *digest, NSString * _Nullable extension);
+
+NS_ASSUME_NONNULL_END
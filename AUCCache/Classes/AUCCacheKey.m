@@ -0,0 +1,205 @@
+//
+//  AUCCacheKey.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/25.
+//
+
+#import "AUCCacheKey.h"
+#import <CommonCrypto/CommonDigest.h>
+#import <stdatomic.h>
+#if defined(__aarch64__)
+#import <arm_neon.h>
+#elif defined(__x86_64__)
+#import <emmintrin.h>
+#endif
+
+// 复用表中最多保留的缓存键数量
+static const NSUInteger AUC_CACHE_KEY_TABLE_COUNT_LIMIT = 512;
+// 文件系统有文件名长度限制，扩展名过长时不添加到文件名中
+#define AUC_CACHE_KEY_MAX_FILE_EXTENSION_LENGTH (NAME_MAX - AUC_CACHE_KEY_DIGEST_LENGTH * 2 - 1)
+
+void AUCHexEncode(const void *bytes, size_t length, char *hex) {
+    const uint8_t *p = bytes;
+#if defined(__aarch64__)
+    // 高低半字节分别查表，再交错写出
+    const uint8x16_t digits = vld1q_u8((const uint8_t *)"0123456789abcdef");
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    while (length >= 16) {
+        uint8x16_t v = vld1q_u8(p);
+        uint8x16x2_t out = vzipq_u8(vqtbl1q_u8(digits, vshrq_n_u8(v, 4)), vqtbl1q_u8(digits, vandq_u8(v, mask)));
+        vst1q_u8((uint8_t *)hex, out.val[0]);
+        vst1q_u8((uint8_t *)hex + 16, out.val[1]);
+        p += 16;
+        hex += 32;
+        length -= 16;
+    }
+#elif defined(__x86_64__)
+    // SSE2 没有字节查表指令：半字节 + '0'，大于 9 的再加上 'a' 与 '9' + 1 的差
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i gap = _mm_set1_epi8('a' - '0' - 10);
+    while (length >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        __m128i low = _mm_and_si128(v, mask);
+        high = _mm_add_epi8(_mm_add_epi8(high, zero), _mm_and_si128(_mm_cmpgt_epi8(high, nine), gap));
+        low = _mm_add_epi8(_mm_add_epi8(low, zero), _mm_and_si128(_mm_cmpgt_epi8(low, nine), gap));
+        _mm_storeu_si128((__m128i *)hex, _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(hex + 16), _mm_unpackhi_epi8(high, low));
+        p += 16;
+        hex += 32;
+        length -= 16;
+    }
+#endif
+    static const char digits[] = "0123456789abcdef";
+    while (length--) {
+        *hex++ = digits[*p >> 4];
+        *hex++ = digits[*p++ & 0x0f];
+    }
+}
+
+NSString *AUCCacheKeyFileNameForDigest(const unsigned char *digest, NSString *extension) {
+    char buffer[NAME_MAX + 1];
+    AUCHexEncode(digest, AUC_CACHE_KEY_DIGEST_LENGTH, buffer);
+    size_t length = AUC_CACHE_KEY_DIGEST_LENGTH * 2;
+    const char *ext = extension.length > 0 ? extension.UTF8String : NULL;
+    size_t extLength = ext ? strlen(ext) : 0;
+    if (extLength > 0 && length + 1 + extLength > NAME_MAX) {
+        // 超长的扩展名无法作为文件名写入，保持与原始格式一致
+        return [NSString stringWithFormat:@"%@.%@", [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding], extension];
+    }
+    if (extLength > 0) {
+        buffer[length++] = '.';
+        memcpy(buffer + length, ext, extLength);
+        length += extLength;
+    }
+    return [[NSString alloc] initWithBytes:buffer length:length encoding:NSUTF8StringEncoding];
+}
+
+static NSCache<NSString *, AUCCacheKey *> *AUCCacheKeyTable(void) {
+    static NSCache *table;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        table = [NSCache new];
+        table.countLimit = AUC_CACHE_KEY_TABLE_COUNT_LIMIT;
+    });
+    return table;
+}
+
+@implementation AUCCacheKey {
+    NSString *_string;
+    NSString *_fileName;
+    NSUInteger _hash;
+    unsigned char _digest[AUC_CACHE_KEY_DIGEST_LENGTH];
+    /// 白名单判定：高位为白名单版本，最低位为判定结果，版本从 1 开始
+    _Atomic(uint64_t) _whitelistVerdict;
+}
+
++ (instancetype)keyWithString:(NSString *)string {
+    if (!string) return nil;
+    if ([string isKindOfClass:AUCCacheKey.class]) return (AUCCacheKey *)string;
+    NSCache<NSString *, AUCCacheKey *> *table = AUCCacheKeyTable();
+    AUCCacheKey *key = [table objectForKey:string];
+    if (!key) {
+        key = [[self alloc] initWithString:string];
+        [table setObject:key forKey:key.string];
+    }
+    return key;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+- (instancetype)initWithString:(NSString *)string {
+    if (self = [super init]) {
+        _string = [string copy];
+        _hash = _string.hash;
+
+        const char *str = _string.UTF8String;
+        if (str == NULL) {
+            str = "";
+        }
+        CC_MD5(str, (CC_LONG)strlen(str), _digest);
+
+        NSURL *keyURL = [NSURL URLWithString:_string];
+        NSString *ext = keyURL ? keyURL.pathExtension : _string.pathExtension;
+        if (ext.length > AUC_CACHE_KEY_MAX_FILE_EXTENSION_LENGTH) {
+            ext = nil;
+        }
+        _fileName = AUCCacheKeyFileNameForDigest(_digest, ext);
+    }
+    return self;
+}
+#pragma clang diagnostic pop
+
+- (NSString *)string {
+    return _string;
+}
+
+- (const unsigned char *)digest {
+    return _digest;
+}
+
+- (NSString *)fileName {
+    return _fileName;
+}
+
+- (BOOL)getWhitelistVerdict:(BOOL *)contained generation:(NSUInteger)generation {
+    uint64_t verdict = atomic_load_explicit(&_whitelistVerdict, memory_order_relaxed);
+    if (verdict == 0 || (verdict >> 1) != generation) return NO;
+    if (contained) *contained = (verdict & 1) != 0;
+    return YES;
+}
+
+- (void)setWhitelistVerdict:(BOOL)contained generation:(NSUInteger)generation {
+    atomic_store_explicit(&_whitelistVerdict, ((uint64_t)generation << 1) | (contained ? 1 : 0), memory_order_relaxed);
+}
+
+#pragma mark - NSString
+- (NSUInteger)length {
+    return _string.length;
+}
+
+- (unichar)characterAtIndex:(NSUInteger)index {
+    return [_string characterAtIndex:index];
+}
+
+- (void)getCharacters:(unichar *)buffer range:(NSRange)range {
+    [_string getCharacters:buffer range:range];
+}
+
+- (const char *)UTF8String {
+    return _string.UTF8String;
+}
+
+- (NSUInteger)hash {
+    return _hash;
+}
+
+- (BOOL)isEqual:(id)object {
+    if (self == object) return YES;
+    if ([object isKindOfClass:AUCCacheKey.class]) {
+        AUCCacheKey *other = object;
+        return _hash == other->_hash && [_string isEqualToString:other->_string];
+    }
+    return [object isKindOfClass:NSString.class] && [_string isEqualToString:object];
+}
+
+- (BOOL)isEqualToString:(NSString *)aString {
+    if ([aString isKindOfClass:AUCCacheKey.class]) {
+        return [self isEqual:aString];
+    }
+    return [_string isEqualToString:aString];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    // 不可变
+    return self;
+}
+
+- (NSString *)description {
+    return _string;
+}
+
+@end
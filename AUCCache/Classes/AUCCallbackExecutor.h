@@ -0,0 +1,71 @@
+//
+//  AUCCallbackExecutor.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCTypeDefines.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``回调执行器``
+///
+/// 决定异步操作完成后 completion 在哪里执行
+/// ```
+/// AUCCallbackTargetMainQueue   主队列，同一轮主队列循环之前完成的回调合并为一次派发，按完成顺序依次执行
+/// AUCCallbackTargetQueue       调用方提供的队列，每个回调单独派发
+/// AUCCallbackTargetInline      在完成操作的线程（通常是 IO 线程）直接执行，不切换线程
+/// ```
+///
+/// - Note: 主队列执行器是共享的，所有缓存实例完成的回调一起合并；负载较高时主队列只收到少量派发，而不是每个操作一次
+/// - Note: 后台使用方可以使用自己的队列或 `inlineExecutor`，避免先切到主线程再切回后台的两次线程切换
+@interface AUCCallbackExecutor : NSObject
+
+/// 主队列执行器（合并派发），缓存的默认执行器
+@property (nonatomic, class, readonly, nonnull) AUCCallbackExecutor *mainQueueExecutor;
+
+/// 直接执行器
+///
+/// - Warning: 回调在完成操作的 IO 线程上执行，此时该线程仍占用着 IO 调度器的一个组，只应做轻量工作。
+///   不能在回调中调用同一个缓存的同步接口（如 `diskCacheDataForKey:`、`AUCCacheQueryDiskDataSync`），
+///   同步接口会等待需要这个组的任务而死锁：Debug 下会断言失败，Release 下改为在当前线程直接执行，不再与同一个键的其他操作排序。
+///   需要在回调中继续访问缓存时，使用异步接口或 `executorWithQueue:`
+@property (nonatomic, class, readonly, nonnull) AUCCallbackExecutor *inlineExecutor;
+
+/// 在指定队列中执行回调
+///
+/// - Parameter queue: 回调队列，传入主队列时返回 `mainQueueExecutor`
++ (nonnull instancetype)executorWithQueue:(nonnull dispatch_queue_t)queue;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+/// 回调位置
+@property (nonatomic, assign, readonly) AUCCallbackTarget target;
+
+/// 回调队列，`AUCCallbackTargetInline` 时为 nil
+@property (nonatomic, strong, readonly, nullable) dispatch_queue_t queue;
+
+/// 执行回调，可在任意线程调用
+///
+/// - Note: 主队列与队列执行器总是异步执行，即使当前已在主线程
+- (void)executeBlock:(nonnull dispatch_block_t)block;
+
+#pragma mark - Statistics
+/// 执行的回调数量
+@property (nonatomic, assign, readonly) NSUInteger callbackCount;
+
+/// 向队列派发的次数，主队列执行器合并后小于 `callbackCount`
+@property (nonatomic, assign, readonly) NSUInteger dispatchCount;
+
+/// 回调累计耗时，单位为【秒】；主队列执行器即为在主线程上花费的时间
+@property (nonatomic, assign, readonly) NSTimeInterval callbackTime;
+
+/// 清零统计数据
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
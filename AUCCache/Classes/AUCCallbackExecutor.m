@@ -0,0 +1,152 @@
+//
+//  AUCCallbackExecutor.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import "AUCCallbackExecutor.h"
+#import "AUCInternalMacros.h"
+#import <stdatomic.h>
+
+@interface AUCCallbackExecutor ()
+
+@property (nonatomic, assign, readwrite) AUCCallbackTarget target;
+@property (nonatomic, strong, readwrite, nullable) dispatch_queue_t queue;
+/// 等待派发到主队列的回调，只在主队列执行器中使用
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t lock;
+@property (nonatomic, strong, nonnull) NSMutableArray<dispatch_block_t> *pendingBlocks;
+/// 是否已派发尚未执行的合并任务
+@property (nonatomic, assign) BOOL drainScheduled;
+
+@end
+
+@implementation AUCCallbackExecutor {
+    _Atomic(uint64_t) _callbackCount;
+    _Atomic(uint64_t) _dispatchCount;
+    _Atomic(uint64_t) _callbackNanoseconds;
+}
+
++ (AUCCallbackExecutor *)mainQueueExecutor {
+    static AUCCallbackExecutor *executor;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        executor = [[AUCCallbackExecutor alloc] initWithTarget:AUCCallbackTargetMainQueue queue:dispatch_get_main_queue()];
+    });
+    return executor;
+}
+
++ (AUCCallbackExecutor *)inlineExecutor {
+    static AUCCallbackExecutor *executor;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        executor = [[AUCCallbackExecutor alloc] initWithTarget:AUCCallbackTargetInline queue:nil];
+    });
+    return executor;
+}
+
++ (instancetype)executorWithQueue:(dispatch_queue_t)queue {
+    if (queue == dispatch_get_main_queue()) return self.mainQueueExecutor;
+    return [[self alloc] initWithTarget:AUCCallbackTargetQueue queue:queue];
+}
+
+- (instancetype)initWithTarget:(AUCCallbackTarget)target queue:(nullable dispatch_queue_t)queue {
+    if (self = [super init]) {
+        _target = target;
+        _queue = queue;
+        _lock = dispatch_semaphore_create(1);
+        _pendingBlocks = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)executeBlock:(dispatch_block_t)block {
+    if (!block) return;
+    switch (self.target) {
+        case AUCCallbackTargetMainQueue: {
+            BOOL scheduleDrain = NO;
+            AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+            [self.pendingBlocks addObject:[block copy]];
+            if (!self.drainScheduled) {
+                self.drainScheduled = YES;
+                scheduleDrain = YES;
+            }
+            AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+            if (scheduleDrain) {
+                atomic_fetch_add_explicit(&_dispatchCount, 1, memory_order_relaxed);
+                dispatch_async(self.queue, ^{
+                    [self drainPendingBlocks];
+                });
+            }
+        }
+            break;
+        case AUCCallbackTargetQueue: {
+            atomic_fetch_add_explicit(&_dispatchCount, 1, memory_order_relaxed);
+            dispatch_async(self.queue, ^{
+                [self runBlock:block];
+            });
+        }
+            break;
+        case AUCCallbackTargetInline:
+        default: {
+            [self runBlock:block];
+        }
+            break;
+    }
+}
+
+#pragma mark - Private
+/// 执行已合并的回调；执行期间新完成的回调进入下一次派发，不会让本轮主队列任务无限延长
+- (void)drainPendingBlocks {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSArray<dispatch_block_t> *blocks = self.pendingBlocks;
+    self.pendingBlocks = [NSMutableArray array];
+    self.drainScheduled = NO;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    [self runBlocks:blocks];
+}
+
+- (void)runBlocks:(NSArray<dispatch_block_t> *)blocks {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (dispatch_block_t block in blocks) {
+        @autoreleasepool {
+            block();
+        }
+    }
+    atomic_fetch_add_explicit(&_callbackCount, blocks.count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_callbackNanoseconds, (uint64_t)((CFAbsoluteTimeGetCurrent() - start) * NSEC_PER_SEC), memory_order_relaxed);
+}
+
+- (void)runBlock:(dispatch_block_t)block {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    block();
+    atomic_fetch_add_explicit(&_callbackCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_callbackNanoseconds, (uint64_t)((CFAbsoluteTimeGetCurrent() - start) * NSEC_PER_SEC), memory_order_relaxed);
+}
+
+#pragma mark - Statistics
+- (NSUInteger)callbackCount {
+    return (NSUInteger)atomic_load_explicit(&_callbackCount, memory_order_relaxed);
+}
+
+- (NSUInteger)dispatchCount {
+    return (NSUInteger)atomic_load_explicit(&_dispatchCount, memory_order_relaxed);
+}
+
+- (NSTimeInterval)callbackTime {
+    return (NSTimeInterval)atomic_load_explicit(&_callbackNanoseconds, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+- (void)resetStatistics {
+    atomic_store_explicit(&_callbackCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_dispatchCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_callbackNanoseconds, 0, memory_order_relaxed);
+}
+
+- (NSString *)description {
+    static NSString * const targetNames[] = {@"main", @"queue", @"inline"};
+    return [NSString stringWithFormat:@"<%@: %p, target: %@, callbackCount: %lu, dispatchCount: %lu, callbackTime: %.1fms>",
+            self.class, self, targetNames[self.target], (unsigned long)self.callbackCount, (unsigned long)self.dispatchCount, self.callbackTime * 1e3];
+}
+
+@end
@@ -0,0 +1,27 @@
+//
+//  AUCChecksum.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/12.
+//
+
+#ifndef AUCChecksum_h
+#define AUCChecksum_h
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 计算 CRC32C（Castagnoli）校验值
+///
+/// - Note: 运行时检测 CPU 特性，优先使用 ARMv8 CRC32 扩展或 x86 SSE4.2 `crc32` 指令，不支持时退化为查表法（slicing-by-8）
+/// - Parameters:
+///     - crc: 上一段数据的校验值，首段传 0，可分段累加计算
+///     - bytes: 数据起始地址
+///     - length: 数据长度
+/// - Returns: 校验值
+FOUNDATION_EXTERN uint32_t AUCCRC32C(uint32_t crc, const void * _Nullable bytes, size_t length);
+
+NS_ASSUME_NONNULL_END
+
+#endif /* AUCChecksum_h */
@@ -0,0 +1,163 @@
+//
+//  AUCChecksum.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/12.
+//
+
+#import "AUCChecksum.h"
+#if defined(__APPLE__)
+#import <sys/sysctl.h>
+#elif defined(__linux__) && defined(__aarch64__)
+#import <sys/auxv.h>
+#import <asm/hwcap.h>
+#endif
+#if defined(__aarch64__)
+#import <arm_acle.h>
+#elif defined(__x86_64__)
+#import <nmmintrin.h>
+#endif
+
+// CRC32C 反射多项式
+#define AUC_CRC32C_POLY 0x82F63B78u
+
+static uint32_t AUCCRC32CTable[8][256];
+
+static void AUCCRC32CInitTable(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ AUC_CRC32C_POLY : crc >> 1;
+        }
+        AUCCRC32CTable[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            uint32_t prev = AUCCRC32CTable[t - 1][i];
+            AUCCRC32CTable[t][i] = (prev >> 8) ^ AUCCRC32CTable[0][prev & 0xff];
+        }
+    }
+}
+
+/// 查表法（slicing-by-8），每次处理 8 字节
+static uint32_t AUCCRC32CSoftware(uint32_t crc, const uint8_t *p, size_t length) {
+    crc = ~crc;
+    while (length > 0 && ((uintptr_t)p & 7)) {
+        crc = (crc >> 8) ^ AUCCRC32CTable[0][(crc ^ *p++) & 0xff];
+        length--;
+    }
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        word ^= crc;
+        crc = AUCCRC32CTable[7][word & 0xff] ^
+              AUCCRC32CTable[6][(word >> 8) & 0xff] ^
+              AUCCRC32CTable[5][(word >> 16) & 0xff] ^
+              AUCCRC32CTable[4][(word >> 24) & 0xff] ^
+              AUCCRC32CTable[3][(word >> 32) & 0xff] ^
+              AUCCRC32CTable[2][(word >> 40) & 0xff] ^
+              AUCCRC32CTable[1][(word >> 48) & 0xff] ^
+              AUCCRC32CTable[0][word >> 56];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ AUCCRC32CTable[0][(crc ^ *p++) & 0xff];
+    }
+    return ~crc;
+}
+
+#if defined(__APPLE__)
+/// sysctl 布尔项是否为 1
+static BOOL AUCChecksumSysctlEnabled(const char *name) {
+    int supported = 0;
+    size_t size = sizeof(supported);
+    return sysctlbyname(name, &supported, &size, NULL, 0) == 0 && supported;
+}
+#endif
+
+#if defined(__aarch64__)
+/// ARMv8 CRC32 扩展指令，每条指令处理 8 字节
+__attribute__((target("crc")))
+static uint32_t AUCCRC32CHardware(uint32_t crc, const uint8_t *p, size_t length) {
+    crc = ~crc;
+    while (length > 0 && ((uintptr_t)p & 7)) {
+        crc = __crc32cb(crc, *p++);
+        length--;
+    }
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return ~crc;
+}
+
+/// Apple 平台查询 sysctl，Linux 查询 `AT_HWCAP`
+static BOOL AUCCRC32CHardwareSupported(void) {
+#if defined(__APPLE__)
+    return AUCChecksumSysctlEnabled("hw.optional.armv8_crc32");
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return NO;
+#endif
+}
+#elif defined(__x86_64__)
+/// SSE4.2 `crc32` 指令（模拟器、macOS），每条指令处理 8 字节
+__attribute__((target("sse4.2")))
+static uint32_t AUCCRC32CHardware(uint32_t crc, const uint8_t *p, size_t length) {
+    uint64_t crc64 = ~crc;
+    while (length > 0 && ((uintptr_t)p & 7)) {
+        crc64 = _mm_crc32_u8((uint32_t)crc64, *p++);
+        length--;
+    }
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc64 = _mm_crc32_u8((uint32_t)crc64, *p++);
+    }
+    return ~(uint32_t)crc64;
+}
+
+/// Apple 平台查询 sysctl，其余平台使用编译器内建的 CPUID 检测
+static BOOL AUCCRC32CHardwareSupported(void) {
+#if defined(__APPLE__)
+    return AUCChecksumSysctlEnabled("hw.optional.sse4_2");
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+#endif
+}
+#endif
+
+typedef uint32_t (*AUCCRC32CFunction)(uint32_t crc, const uint8_t *p, size_t length);
+
+/// 运行时检测 CPU 是否支持 CRC32C 指令，不支持时使用查表法
+static AUCCRC32CFunction AUCCRC32CSelectFunction(void) {
+#if defined(__aarch64__) || defined(__x86_64__)
+    if (AUCCRC32CHardwareSupported()) return AUCCRC32CHardware;
+#endif
+    AUCCRC32CInitTable();
+    return AUCCRC32CSoftware;
+}
+
+uint32_t AUCCRC32C(uint32_t crc, const void *bytes, size_t length) {
+    static AUCCRC32CFunction function;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        function = AUCCRC32CSelectFunction();
+    });
+    if (!bytes || length == 0) return crc;
+    return function(crc, (const uint8_t *)bytes, length);
+}
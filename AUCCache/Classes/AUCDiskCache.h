@@ -12,6 +12,23 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class AUCCacheConfig;
 /// ``磁盘缓存``
+///
+/// - Note: 缓存文件以 `AUCDiskEntryFormat` 头部开头，`cachePathForKey:` 对应的文件不能直接当作原始数据读取
+/// - Note: 缓存文件按键摘要的前两个字节分布在两级子目录中，避免单个目录下文件过多拖慢查找与枚举
+/// ```
+/// default/
+///    ├── .auc_index
+///    ├── .auc_layout          目录布局版本
+///    ├── .auc_blobs/          去重模式下按内容 SHA-256 命名的共享数据，同样分布在两级子目录中
+///    ├── .auc_deltas/         差量存储的基准版本（上一个完整版本），按摘要命名
+///    └── 3f/
+///         └── a2/
+///              └── 3fa2...e1.json
+/// ```
+/// - Note: 扩展数据内联在缓存文件末尾，与数据一次写入；早期版本保存在扩展属性（xattr）中的扩展数据仍可读取
+/// - Note: `shouldDeduplicateDiskData` 开启时，缓存文件是共享数据的硬链接，链接数即引用计数
+/// - Note: `diskCacheDeltaThreshold` 开启时，缓存文件可能只保存相对基准版本的差量，`cachePathForKey:` 对应的文件不是完整数据
+/// - Note: 旧版本直接保存在缓存目录下的文件由 `recoverWithTimeBudget:report:` 在后台分批迁移，迁移期间读取自动回退到旧路径
 @interface AUCDiskCache : NSObject <AUCDiskCacheProtocol>
 
 @property (nonatomic, strong, nonnull, readonly) AUCCacheConfig *config;
@@ -26,8 +43,27 @@ NS_ASSUME_NONNULL_BEGIN
 /// - Note: 如果新位置不存在，则只移动目录。
 /// - Note: 如果新位置确实存在，将移动并合并旧位置的文件。
 /// - Note: 如果新位置确实存在，但不是一个目录，则将删除它并移动目录。
+/// - Note: 新位置为当前缓存目录时，移动完成后同步迁移目录布局并重建索引。
 - (void)moveCacheDirectoryFromPath:(nonnull NSString *)srcPath toPath:(nonnull NSString *)dstPath;
 
+/// ``校验缓存文件，删除已损坏的数据``
+///
+/// 从上次中断的位置继续，按索引槽位顺序逐个完整读取并校验缓存文件，读取量达到 `byteLimit` 后停止
+///
+/// - Parameter byteLimit - 本次最多读取的字节数，0 表示校验全部
+/// - Returns: 删除的损坏数据数量
+/// - Note: 校验先删除索引项再删除文件，不能与写入同时进行；`AUCCacheCombine` 以独占的维护任务分片调用
+/// - Note: `diskCacheChecksumMode` 不为 `AUCCacheDiskChecksumModeOff` 时，`AUCCacheCombine` 启动一段时间后会自动调用
+- (NSUInteger)scrubDataWithByteLimit:(NSUInteger)byteLimit;
+
+/// ``去重节省的磁盘空间``
+///
+/// 遍历共享数据目录，统计被多个键引用的共享数据除第一份之外的大小
+///
+/// - Returns: 节省的字节数，未开启去重时为 0
+/// - Note: 需要遍历共享数据目录，不要在主线程频繁调用
+- (uint64_t)deduplicatedSize;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -8,17 +8,55 @@
 #import "AUCDiskCache.h"
 #import "AUCCacheConfig.h"
 #import "AUCFileAttributeHelper.h"
+#import "AUCDiskCacheIndex.h"
+#import "AUCMappedData.h"
+#import "AUCDiskEntryFormat.h"
+#import "AUCDiskCacheRecoveryReport.h"
+#import "AUCIOAdvice.h"
+#import "AUCInternalMacros.h"
+#import "AUCCacheKey.h"
+#import "AUCCacheDelta.h"
 #import <CommonCrypto/CommonDigest.h>
+#import <dirent.h>
+#import <unistd.h>
+#import <sys/stat.h>
 
+// 早期版本保存扩展数据的扩展属性名，现在扩展数据内联在缓存文件中，只用于读取旧文件
 static NSString * const AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME = @"com.vantage.AUCCache";
+// 启动后延迟清理孤立的共享数据与基准版本的时间
+static const NSTimeInterval AU_DISK_CACHE_SCRUB_DELAY = 30;
+// 过期清理每批从索引中取出的数量
+#define AU_DISK_CACHE_EVICTION_BATCH_COUNT 32
+// 目录布局版本：1 - 所有文件直接位于缓存目录下，2 - 按摘要前缀分布在两级子目录中
+static const NSInteger AU_DISK_CACHE_LAYOUT_VERSION = 2;
+// 去重模式下按内容寻址的共享数据目录，以 `.` 开头，索引对账与布局迁移时跳过
+static NSString * const AU_DISK_CACHE_BLOB_DIRECTORY_NAME = @".auc_blobs";
+// 差量存储的基准版本目录，同样以 `.` 开头
+static NSString * const AU_DISK_CACHE_DELTA_BASE_DIRECTORY_NAME = @".auc_deltas";
 @interface AUCDiskCache ()
 
 @property (nonatomic, copy) NSString *diskCachePath;
 @property (nonatomic, strong, nonnull) NSFileManager *fileManager;
+/// 持久化索引，存在性判断与未命中查询不访问文件系统
+@property (nonatomic, strong, nonnull) AUCDiskCacheIndex *index;
+/// 正在按 `maxDiskSize` 清理，直到低于最大大小的一半
+@property (nonatomic, assign) BOOL trimmingToSize;
+/// 目录布局迁移尚未完成，文件可能仍位于缓存目录下的旧路径
+@property (atomic, assign) BOOL migratingLayout;
+/// 启动恢复中的索引对账已完成，之后的时间片用于迁移目录布局
+@property (nonatomic, assign) BOOL indexRecovered;
 
 @end
 
-@implementation AUCDiskCache
+@implementation AUCDiskCache {
+    /// 目录布局迁移状态，仅在 IO 队列中访问
+    DIR *_migrationDirectory;
+    BOOL _migrationFailed;
+    /// 共享数据目录存在，写入与删除前需要检查文件是否为共享数据的引用
+    BOOL _hasBlobs;
+    /// 基准版本目录存在，完整写入与删除时需要删除基准版本
+    BOOL _hasDeltaBases;
+}
 - (instancetype)init {
     NSAssert(NO, @"请使用 `initWithCachePath:` 用磁盘缓存路径创建实例对象");
     return nil;
@@ -40,44 +78,147 @@ static NSString * const AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME = @"com.vantage.AU
     } else {
         self.fileManager = [NSFileManager new];
     }
+    BOOL orderByAccessTime = self.config.diskCacheExpireType == AUCCacheConfigExpireTypeAccessDate;
+    // 索引需要重建时不在此处扫描目录，由 `recoverWithTimeBudget:report:` 增量完成
+    self.index = [[AUCDiskCacheIndex alloc] initWithDirectory:self.diskCachePath fileManager:self.fileManager orderByAccessTime:orderByAccessTime];
+    self.index.deltaBaseDirectory = self.deltaBasePath;
+    // 没有版本标记的目录可能包含旧版本布局的文件，由 `recoverWithTimeBudget:report:` 迁移
+    NSString *layoutVersion = [NSString stringWithContentsOfFile:self.layoutFilePath encoding:NSUTF8StringEncoding error:nil];
+    self.migratingLayout = layoutVersion.integerValue < AU_DISK_CACHE_LAYOUT_VERSION;
+    // 关闭去重后已有的共享数据仍需按引用计数删除
+    _hasBlobs = access(self.blobPath.fileSystemRepresentation, F_OK) == 0;
+    _hasDeltaBases = access(self.deltaBasePath.fileSystemRepresentation, F_OK) == 0;
+    
+    __weak typeof(self) weakSelf = self;
+    // 清理写入共享数据后、链接前进程退出留下的无引用共享数据
+    if (_hasBlobs) {
+        CFAbsoluteTime launchTime = CFAbsoluteTimeGetCurrent();
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(AU_DISK_CACHE_SCRUB_DELAY * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_BACKGROUND, 0), ^{
+            [weakSelf removeOrphanBlobsModifiedBefore:launchTime + kCFAbsoluteTimeIntervalSince1970];
+        });
+    }
+    if (_hasDeltaBases) {
+        CFAbsoluteTime launchTime = CFAbsoluteTimeGetCurrent();
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(AU_DISK_CACHE_SCRUB_DELAY * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_BACKGROUND, 0), ^{
+            [weakSelf removeOrphanDeltaBasesModifiedBefore:launchTime + kCFAbsoluteTimeIntervalSince1970];
+        });
+    }
+}
+
+- (void)dealloc {
+    if (_migrationDirectory) closedir(_migrationDirectory);
 }
 
 - (BOOL)containsDataForKey:(NSString *)key {
     NSParameterAssert(key);
-    NSString *filePath = [self cachePathForKey:key];
-    BOOL exists = [self.fileManager fileExistsAtPath:filePath];
-    
-    if (!exists) {
-        exists = [self.fileManager fileExistsAtPath:filePath.stringByDeletingPathExtension];
-    }
-    
-    return exists;
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    AUCDiskCacheDigestForKey(key, digest);
+    AUCDiskCacheIndexEntry entry;
+    return [self getIndexEntry:&entry forKey:key digest:digest];
 }
 
 - (NSData *)dataForKey:(NSString *)key {
     NSParameterAssert(key);
-    NSString *filePath = [self cachePathForKey:key];
-    NSData *data = [NSData dataWithContentsOfFile:filePath options:self.config.diskCacheReadingOptions error:nil];
-    if (data) return data;
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    AUCDiskCacheDigestForKey(key, digest);
+    AUCDiskCacheIndexEntry entry;
+    if (![self getIndexEntry:&entry forKey:key digest:digest]) return nil;
     
-    data = [NSData dataWithContentsOfFile:filePath.stringByDeletingPathExtension options:self.config.diskCacheReadingOptions error:nil];
-    if (data) return data;
+    NSString *filePath = [self filePathForKey:key entry:&entry];
+    NSData *entryData = nil;
+    if ([self shouldMapDataOfLength:entry.size]) {
+        // 读出的数据随后会被解析并放入内存缓存，磁盘上的页不会被立即再次使用
+        entryData = [AUCMappedData dataWithContentsOfFile:filePath accessPattern:AUCIOAccessPatternSequential];
+    }
+    if (!entryData) {
+        entryData = [NSData dataWithContentsOfFile:filePath options:[self readingOptionsForLength:entry.size] error:nil];
+    }
+    if (!entryData) {
+        // 文件已被外部删除，修正索引
+        [self.index removeDigest:digest];
+        return nil;
+    }
     
-    return nil;
+    AUCCacheDiskChecksumMode checksumMode = self.config.diskCacheChecksumMode;
+    BOOL verify = checksumMode == AUCCacheDiskChecksumModeOnRead
+        || (checksumMode == AUCCacheDiskChecksumModeLazy && !(entry.flags & AUCDiskCacheIndexEntryFlagVerified));
+    AUCDiskEntryStatus status;
+    NSData *data = [AUCDiskEntryFormat payloadOfEntryData:entryData verify:verify status:&status];
+    if (data && ([AUCDiskEntryFormat flagsOfEntryData:entryData] & AUCDiskEntryFlagDelta)) {
+        data = [self dataByApplyingDelta:data basePath:[self deltaBasePathForFileName:filePath.lastPathComponent]];
+    }
+    if (!data) {
+        // 文件已被截断或损坏，按未命中处理
+        [self removeCacheFileForEntry:&entry];
+        return nil;
+    }
+    if (verify && status == AUCDiskEntryStatusValid) {
+        [self.index addFlags:AUCDiskCacheIndexEntryFlagVerified forDigest:digest];
+    }
+    [self.index touchDigest:digest accessTime:AUCDiskCacheCurrentTime()];
+    return data;
 }
 
 - (void)setData:(NSData *)data forKey:(NSString *)key {
+    [self setData:data extendedData:nil forKey:key];
+}
+
+- (void)setData:(NSData *)data extendedData:(NSData *)extendedData forKey:(NSString *)key {
     NSParameterAssert(data);
     NSParameterAssert(key);
-    if (![self.fileManager fileExistsAtPath:self.diskCachePath]) {
-        [self.fileManager createDirectoryAtPath:self.diskCachePath withIntermediateDirectories:YES attributes:nil error:NULL];
-    }
-    
+    [self writeData:data extendedData:extendedData forKey:key modificationTime:AUCDiskCacheCurrentTime()];
+}
+
+/// 写入数据与扩展数据，`modificationTime` 为索引项记录的修改时间
+- (void)writeData:(NSData *)data extendedData:(nullable NSData *)extendedData forKey:(NSString *)key modificationTime:(int64_t)modificationTime {
     // 获取对应 `key` 的缓存路径
     NSString *cachePathForKey = [self cachePathForKey:key];
     NSURL *fileURL = [NSURL fileURLWithPath:cachePathForKey];
     
-    [data writeToURL:fileURL options:self.config.diskCacheWritingOptions error:nil];
+    // 文件内容为头部 + 数据 + 扩展数据，头部记录校验和，扩展数据与数据一次写入
+    NSString *deltaBasePath = [self deltaBasePathForFileName:cachePathForKey.lastPathComponent];
+    uint64_t deltaBaseLength = 0;
+    NSData *entryData = [self deltaEntryDataWithData:data extendedData:extendedData path:cachePathForKey basePath:deltaBasePath baseLength:&deltaBaseLength];
+    if (!entryData) {
+        entryData = [AUCDiskEntryFormat entryDataWithData:data extendedData:extendedData];
+    }
+    if (self.config.shouldDeduplicateDiskData) {
+        if (![self linkEntryData:entryData toPath:cachePathForKey]) return;
+    } else {
+        // 旧文件可能是共享数据的最后一个引用，替换前先释放
+        [self releaseBlobOfFileAtPath:cachePathForKey];
+        if (![self writeData:entryData toPath:cachePathForKey]) return;
+    }
+    if (deltaBaseLength == 0) {
+        // 写入了完整版本，旧的基准版本不再需要
+        [self removeDeltaBaseAtPath:deltaBasePath];
+    }
+    if (self.migratingLayout) {
+        // 旧路径上的文件已过期，避免迁移时与新数据混淆
+        unlink([self.diskCachePath stringByAppendingPathComponent:cachePathForKey.lastPathComponent].fileSystemRepresentation);
+    }
+    
+    // 文件写入成功后再更新索引，中途崩溃最多留下一个未被索引的文件
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    AUCDiskCacheDigestForKey(key, digest);
+    int64_t now = AUCDiskCacheCurrentTime();
+    AUCDiskCacheIndexEntry entry = {0};
+    if (![self.index getEntry:&entry forDigest:digest]) {
+        memcpy(entry.digest, digest, AUC_DISK_CACHE_DIGEST_LENGTH);
+        entry.creationTime = now;
+    }
+    // 差量与基准版本都计入大小
+    entry.size = entryData.length + deltaBaseLength;
+    entry.modificationTime = modificationTime;
+    entry.accessTime = now;
+    // 校验和由本次写入计算，无需在读取时再次校验；索引记录是否有扩展数据，没有时读取扩展数据无需访问文件
+    entry.flags &= ~AUCDiskCacheIndexEntryFlagHasExtendedData;
+    entry.flags |= AUCDiskCacheIndexEntryFlagVerified | AUCDiskCacheIndexEntryFlagInlineExtendedData;
+    if (extendedData) {
+        entry.flags |= AUCDiskCacheIndexEntryFlagHasExtendedData;
+    }
+    [AUCDiskCacheIndex setExtension:cachePathForKey.pathExtension forEntry:&entry];
+    [self.index setEntry:&entry];
     
     // 禁用 `iCloud` 备份
     if (self.config.shouldDisableICloud) {
@@ -88,34 +229,61 @@ static NSString * const AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME = @"com.vantage.AU
 
 - (NSData *)extendedDataForKey:(NSString *)key {
     NSParameterAssert(key);
-    
-    // 获取对应 `key` 的缓存路径
-    NSString *cachePathForKey = [self cachePathForKey:key];
-    
-    NSData *extendedData = [AUCFileAttributeHelper extendedAttribute:AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME atPath:cachePathForKey traverseLink:NO error:nil];
-    
-    return extendedData;
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    AUCDiskCacheDigestForKey(key, digest);
+    AUCDiskCacheIndexEntry entry;
+    if (![self getIndexEntry:&entry forKey:key digest:digest]) return nil;
+    return [self extendedDataForKey:key entry:&entry];
+}
+
+- (NSDictionary<NSString *, NSData *> *)extendedDataForKeys:(NSArray<NSString *> *)keys {
+    NSMutableDictionary<NSString *, NSData *> *extendedDataMap = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    for (NSString *key in keys) {
+        @autoreleasepool {
+            unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+            AUCDiskCacheDigestForKey(key, digest);
+            AUCDiskCacheIndexEntry entry;
+            // 不存在或没有扩展数据的键只查询索引
+            if (![self getIndexEntry:&entry forKey:key digest:digest]) continue;
+            NSData *extendedData = [self extendedDataForKey:key entry:&entry];
+            if (extendedData) extendedDataMap[key] = extendedData;
+        }
+    }
+    return extendedDataMap;
 }
 
 - (void)setExtendedData:(NSData *)extendedData forKey:(NSString *)key {
     NSParameterAssert(key);
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    AUCDiskCacheDigestForKey(key, digest);
+    AUCDiskCacheIndexEntry entry;
+    if (![self getIndexEntry:&entry forKey:key digest:digest]) return;
+    if (!extendedData && (entry.flags & AUCDiskCacheIndexEntryFlagInlineExtendedData) && !(entry.flags & AUCDiskCacheIndexEntryFlagHasExtendedData)) return;
     
-    // 获取对应 `key` 的缓存路径
-    NSString *cachePathForKey = [self cachePathForKey:key];
+    // 扩展数据与数据写在同一个文件中，重写整个文件以保证原子性，修改时间保持不变
+    NSData *data = [self dataForKey:key];
+    if (!data) return;
+    [self writeData:data extendedData:extendedData forKey:key modificationTime:entry.modificationTime];
+}
+
+/// 读取索引项对应缓存文件中的扩展数据，早期版本写入的文件回退到扩展属性
+- (nullable NSData *)extendedDataForKey:(NSString *)key entry:(const AUCDiskCacheIndexEntry *)entry {
+    BOOL inlined = (entry->flags & AUCDiskCacheIndexEntryFlagInlineExtendedData) != 0;
+    if (inlined && !(entry->flags & AUCDiskCacheIndexEntryFlagHasExtendedData)) return nil;
     
-    if (!extendedData) {
-        // 删除
-        [AUCFileAttributeHelper removeExtendedAttribute:AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME atPath:cachePathForKey traverseLink:NO error:nil];
-    } else {
-        // 覆盖
-        [AUCFileAttributeHelper setExtendedAttribute:AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME value:extendedData atPath:cachePathForKey traverseLink:NO overwrite:YES error:nil];
-    }
+    NSString *filePath = [self filePathForKey:key entry:entry];
+    AUCDiskEntryStatus status;
+    NSData *extendedData = [AUCDiskEntryFormat extendedDataOfFileAtPath:filePath status:&status];
+    if (extendedData || inlined || status == AUCDiskEntryStatusCorrupt) return extendedData;
+    return [AUCFileAttributeHelper extendedAttribute:AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME atPath:filePath traverseLink:NO error:nil];
 }
 
 - (void)removeCacheForKey:(NSString *)key {
     NSParameterAssert(key);
-    NSString *filePath = [self cachePathForKey:key];
-    [self.fileManager removeItemAtPath:filePath error:nil];
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    AUCDiskCacheDigestForKey(key, digest);
+    [self.index removeDigest:digest];
+    [self removeFileName:AUCDiskCacheFileNameForKey(key)];
 }
 
 - (void)removeAllData {
@@ -124,98 +292,184 @@ static NSString * const AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME = @"com.vantage.AU
             withIntermediateDirectories:YES
                              attributes:nil
                                   error:NULL];
+    [self.index removeAllEntries];
+    _hasBlobs = NO;
+    _hasDeltaBases = NO;
+    // 空目录无需迁移
+    if (_migrationDirectory) {
+        closedir(_migrationDirectory);
+        _migrationDirectory = NULL;
+    }
+    [self finishLayoutMigration];
 }
 
 - (void)removeExpiredData {
-    NSURL *diskCacheURL = [NSURL fileURLWithPath:self.diskCachePath isDirectory:YES];
+    [self removeExpiredDataWithTimeBudget:0];
+}
+
+- (BOOL)removeExpiredDataWithTimeBudget:(NSTimeInterval)timeBudget {
+    CFAbsoluteTime deadline = timeBudget > 0 ? CFAbsoluteTimeGetCurrent() + timeBudget : DBL_MAX;
+    int64_t expirationTime = (self.config.maxDiskAge < 0) ? INT64_MIN : AUCDiskCacheCurrentTime() - (int64_t)(self.config.maxDiskAge * 1000);
+    AUCCacheConfigExpireType expireType = self.config.diskCacheExpireType;
     
-    // 计算用于测试的内容日期密钥
-    NSURLResourceKey cacheContentDateKey = NSURLContentModificationDateKey;
-    switch (self.config.diskCacheExpireType) {
-        case AUCCacheConfigExpireTypeAccessDate:
-            cacheContentDateKey = NSURLContentAccessDateKey;
-            break;
-        case AUCCacheConfigExpireTypeModificationDate:
-            cacheContentDateKey = NSURLContentModificationDateKey;
-            break;
-        case AUCCacheConfigExpireTypeCreationDate:
-            cacheContentDateKey = NSURLCreationDateKey;
-            break;
-        case AUCCacheConfigExpireTypeChangeDate:
-            cacheContentDateKey = NSURLAttributeModificationDateKey;
-            break;
-        default:
-            break;
+    // 超过最大大小后开始清理，目标是最大缓存大小的一半，清理状态跨时间片保留
+    NSUInteger maxDiskSize = self.config.maxDiskSize;
+    if (maxDiskSize > 0 && self.index.totalSize > maxDiskSize) {
+        self.trimmingToSize = YES;
     }
     
-    NSArray<NSString *> *resourceKeys = @[NSURLIsDirectoryKey, cacheContentDateKey, NSURLTotalFileAllocatedSizeKey];
-    // 该枚举器为缓存文件预取有用的属性
-    NSDirectoryEnumerator *fileEnumerator = [self.fileManager enumeratorAtURL:diskCacheURL
-                                                   includingPropertiesForKeys:resourceKeys
-                                                                      options:NSDirectoryEnumerationSkipsHiddenFiles
-                                                                 errorHandler:NULL];
-    
-    NSDate *expirationDate = (self.config.maxDiskAge < 0) ? nil: [NSDate dateWithTimeIntervalSinceNow:-self.config.maxDiskAge];
-    NSMutableDictionary<NSURL *, NSDictionary<NSString *, id> *> *cacheFiles = [NSMutableDictionary dictionary];
-    NSUInteger currentCacheSize = 0;
     /**
-     * 枚举缓存目录中的所有文件。
+     * 从淘汰链表头部（最旧）开始逐批处理。
      *
-     * 这个循环有两个目的：
-     * 1. 删除超过有效期的文件。
-     * 2. 为基于大小的清理传递存储文件属性。
+     * 链表按写入时间（或访问时间）排序：
+     * 1. 过期的数据直接删除。
+     * 2. 需要按大小清理时，未过期的数据同样从旧到新删除。
+     * 3. 遇到未过期且无需按大小清理的数据时，其后的数据写入得更晚，维护完成。
      */
-    NSMutableArray<NSURL *> *urlsToDelete = [[NSMutableArray alloc] init];
-    for (NSURL *fileURL in fileEnumerator) {
-        NSError *error;
-        NSDictionary<NSString *, id> *resourceValues = [fileURL resourceValuesForKeys:resourceKeys error:&error];
-        
-        // 跳过目录和错误
-        if (error || !resourceValues || [resourceValues[NSURLIsDirectoryKey] boolValue]) continue;
+    AUCDiskCacheIndexEntry entries[AU_DISK_CACHE_EVICTION_BATCH_COUNT];
+    while (YES) {
+        NSUInteger count = [self.index getOldestEntries:entries maxCount:AU_DISK_CACHE_EVICTION_BATCH_COUNT];
+        if (count == 0) break;
         
-        // 删除早于过期日期的文件
-        NSDate *modifiedDate = resourceValues[cacheContentDateKey];
-        if (expirationDate && [[modifiedDate laterDate:expirationDate] isEqualToDate:expirationDate]) {
-            [urlsToDelete addObject:fileURL];
-            continue;
+        for (NSUInteger i = 0; i < count; i++) {
+            AUCDiskCacheIndexEntry *entry = &entries[i];
+            if (self.trimmingToSize && self.index.totalSize < maxDiskSize / 2) {
+                self.trimmingToSize = NO;
+            }
+            BOOL expired = AUCDiskCacheEntryDate(entry, expireType) <= expirationTime;
+            if (!expired && !self.trimmingToSize) return YES;
+            
+            [self removeCacheFileForEntry:entry];
+            if (CFAbsoluteTimeGetCurrent() >= deadline) return NO;
         }
-        
-        // 存储该文件的引用，并计算其总大小。
-        NSNumber *totalAllocatedSize = resourceValues[NSURLTotalFileAllocatedSizeKey];
-        currentCacheSize += totalAllocatedSize.unsignedIntegerValue;
-        cacheFiles[fileURL] = resourceValues;
     }
-    
-    for (NSURL *fileURL in urlsToDelete) {
-        [self.fileManager removeItemAtURL:fileURL error:nil];
+    self.trimmingToSize = NO;
+    return YES;
+}
+
+- (BOOL)recoverWithTimeBudget:(NSTimeInterval)timeBudget report:(AUCDiskCacheRecoveryReport *)report {
+    CFAbsoluteTime deadline = timeBudget > 0 ? CFAbsoluteTimeGetCurrent() + timeBudget : DBL_MAX;
+    if (!self.indexRecovered) {
+        if (![self.index recoverWithDeadline:deadline report:report]) return NO;
+        self.indexRecovered = YES;
     }
-    
-    // 如果剩余磁盘缓存超过了配置的最大大小，则执行第二次基于大小的清理。
-    // 会先删除最旧的文件。
-    NSUInteger maxDiskSize = self.config.maxDiskSize;
-    if (maxDiskSize > 0 && currentCacheSize > maxDiskSize) {
-        // 清理的目标是最大缓存大小的一半
-        const NSUInteger desiredCacheSize = maxDiskSize / 2;
-        
-        // 按最后修改时间或最后访问时间（最旧的在前）对剩余的缓存文件进行排序
-        NSArray<NSURL *> *sortedFiles = [cacheFiles keysSortedByValueWithOptions:NSSortConcurrent
-                                                                 usingComparator:^NSComparisonResult(id obj1, id obj2) {
-                                                                     return [obj1[cacheContentDateKey] compare:obj2[cacheContentDateKey]];
-                                                                 }];
-        
-        // 删除文件，直到低于所需的缓存大小
-        for (NSURL *fileURL in sortedFiles) {
-            if ([self.fileManager removeItemAtURL:fileURL error:nil]) {
-                NSDictionary<NSString *, id> *resourceValues = cacheFiles[fileURL];
-                NSNumber *totalAllocatedSize = resourceValues[NSURLTotalFileAllocatedSizeKey];
-                currentCacheSize -= totalAllocatedSize.unsignedIntegerValue;
+    if (!self.migratingLayout) return YES;
+    return [self migrateLayoutWithDeadline:deadline report:report];
+}
+
+/// 查询索引项，索引正在重建时未命中回退到文件系统确认
+- (BOOL)getIndexEntry:(AUCDiskCacheIndexEntry *)entry forKey:(NSString *)key digest:(const unsigned char *)digest {
+    if ([self.index getEntry:entry forDigest:digest]) return YES;
+    if (!self.index.incomplete) return NO;
+    // 早期版本写入的缓存文件名不带扩展名
+    return [self.index addEntryForFilePath:[self filePathForFileName:AUCDiskCacheFileNameForKey(key)] entry:entry]
+        || [self.index addEntryForFilePath:[self filePathForFileName:AUCDiskCacheFileNameForDigest(digest, nil)] entry:entry];
+}
+
+- (NSUInteger)scrubDataWithByteLimit:(NSUInteger)byteLimit {
+    NSUInteger removedCount = 0;
+    NSUInteger scannedBytes = 0;
+    NSUInteger position = self.index.scrubPosition;
+    AUCDiskCacheIndexEntry entries[AU_DISK_CACHE_EVICTION_BATCH_COUNT];
+    while (byteLimit == 0 || scannedBytes < byteLimit) {
+        NSUInteger count = [self.index getEntries:entries maxCount:AU_DISK_CACHE_EVICTION_BATCH_COUNT position:&position];
+        if (count == 0) {
+            // 已校验到末尾，下次从头开始
+            position = 0;
+            break;
+        }
+        for (NSUInteger i = 0; i < count; i++) {
+            @autoreleasepool {
+                AUCDiskCacheIndexEntry *entry = &entries[i];
+                // 扩展名未内联保存的文件需要查找目录，留给读取时校验
+                if (entry->flags & AUCDiskCacheIndexEntryFlagExtensionTruncated) continue;
                 
-                if (currentCacheSize < desiredCacheSize) {
-                    break;
+                NSString *extension = (entry->flags & AUCDiskCacheIndexEntryFlagHasExtension) ? [NSString stringWithUTF8String:entry->extension] : nil;
+                NSString *filePath = [self filePathForFileName:AUCDiskCacheFileNameForDigest(entry->digest, extension)];
+                scannedBytes += entry->size;
+                AUCDiskEntryStatus status = [AUCDiskEntryFormat verifyFileAtPath:filePath];
+                if (status == AUCDiskEntryStatusValid) {
+                    [self.index addFlags:AUCDiskCacheIndexEntryFlagVerified forDigest:entry->digest];
+                } else if (status == AUCDiskEntryStatusCorrupt) {
+                    // 只有校验期间没有被重新写入时才删除
+                    if ([self.index removeDigest:entry->digest modificationTime:entry->modificationTime]) {
+                        [self releaseBlobOfFileAtPath:filePath];
+                        [self.fileManager removeItemAtPath:filePath error:nil];
+                        [self removeDeltaBaseAtPath:[self deltaBasePathForFileName:filePath.lastPathComponent]];
+                        removedCount++;
+                    }
                 }
             }
         }
     }
+    self.index.scrubPosition = position;
+    return removedCount;
+}
+
+/// 大数据使用内存映射读取，只有原子写入（写新文件再替换）时映射才不会因文件被原地截断而失效
+- (BOOL)shouldMapDataOfLength:(uint64_t)length {
+    NSUInteger threshold = self.config.diskCacheMappingThreshold;
+    if (threshold == 0 || length < threshold) return NO;
+    return AUC_OPTIONS_CONTAINS(self.config.diskCacheWritingOptions, NSDataWritingAtomic);
+}
+
+/// 无法映射的大数据读取时绕过页缓存，避免一次性读取挤出应用反复使用的页
+- (NSDataReadingOptions)readingOptionsForLength:(uint64_t)length {
+    NSDataReadingOptions options = self.config.diskCacheReadingOptions;
+    NSUInteger threshold = self.config.diskCacheMappingThreshold;
+    if (threshold > 0 && length >= threshold) {
+        options |= NSDataReadingUncached;
+    }
+    return options;
+}
+
+- (void)prefetchDataForKeys:(NSArray<NSString *> *)keys {
+    for (NSString *key in keys) {
+        unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+        AUCDiskCacheDigestForKey(key, digest);
+        AUCDiskCacheIndexEntry entry;
+        if (![self.index getEntry:&entry forDigest:digest]) continue;
+        AUCIOPrefetchFile([self filePathForKey:key entry:&entry]);
+    }
+}
+
+/// 删除索引项对应的缓存文件并同步删除索引项
+- (void)removeCacheFileForEntry:(const AUCDiskCacheIndexEntry *)entry {
+    [self.index removeDigest:entry->digest];
+    
+    NSString *fileName = AUCDiskCacheFileNameForDigest(entry->digest, nil);
+    if (entry->flags & AUCDiskCacheIndexEntryFlagExtensionTruncated) {
+        // 扩展名未内联保存，按摘要前缀在所在子目录（迁移期间还有缓存目录）中查找
+        NSString *directory = [self.diskCachePath stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName].stringByDeletingLastPathComponent];
+        NSArray<NSString *> *directories = self.migratingLayout ? @[directory, self.diskCachePath] : @[directory];
+        for (NSString *path in directories) {
+            NSArray<NSString *> *fileNames = [self.fileManager contentsOfDirectoryAtPath:path error:nil];
+            for (NSString *name in fileNames) {
+                if (name.length > fileName.length && [name hasPrefix:fileName]) {
+                    NSString *filePath = [path stringByAppendingPathComponent:name];
+                    [self releaseBlobOfFileAtPath:filePath];
+                    [self.fileManager removeItemAtPath:filePath error:nil];
+                }
+            }
+        }
+        [self removeDeltaBaseAtPath:[self deltaBasePathForFileName:fileName]];
+        return;
+    }
+    if (entry->flags & AUCDiskCacheIndexEntryFlagHasExtension) {
+        fileName = AUCDiskCacheFileNameForDigest(entry->digest, [NSString stringWithUTF8String:entry->extension]);
+    }
+    [self removeFileName:fileName];
+}
+
+/// 删除缓存文件，迁移期间同时删除旧路径上的文件
+- (void)removeFileName:(NSString *)fileName {
+    NSString *filePath = [self.diskCachePath stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName]];
+    [self releaseBlobOfFileAtPath:filePath];
+    unlink(filePath.fileSystemRepresentation);
+    [self removeDeltaBaseAtPath:[self deltaBasePathForFileName:fileName]];
+    if (self.migratingLayout) {
+        unlink([self.diskCachePath stringByAppendingPathComponent:fileName].fileSystemRepresentation);
+    }
 }
 
 - (nullable NSString *)cachePathForKey:(NSString *)key {
@@ -224,27 +478,297 @@ static NSString * const AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME = @"com.vantage.AU
 }
 
 - (NSUInteger)totalSize {
-    NSUInteger size = 0;
-    NSDirectoryEnumerator *fileEnumerator = [self.fileManager enumeratorAtPath:self.diskCachePath];
-    for (NSString *fileName in fileEnumerator) {
-        NSString *filePath = [self.diskCachePath stringByAppendingPathComponent:fileName];
-        NSDictionary<NSString *, id> *attrs = [self.fileManager attributesOfItemAtPath:filePath error:nil];
-        size += [attrs fileSize];
-    }
-    return size;
+    // 计数随每次增删改同步更新，无需遍历目录
+    return self.index.totalSize;
 }
 
 - (NSUInteger)totalCount {
-    NSUInteger count = 0;
-    NSDirectoryEnumerator *fileEnumerator = [self.fileManager enumeratorAtPath:self.diskCachePath];
-    count = fileEnumerator.allObjects.count;
-    return count;
+    return self.index.count;
 }
 
 #pragma mark - Cache paths
 - (nullable NSString *)cachePathForKey:(nullable NSString *)key inPath:(nonnull NSString *)path {
     NSString *filename = AUCDiskCacheFileNameForKey(key);
-    return [path stringByAppendingPathComponent:filename];
+    return [path stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:filename]];
+}
+
+/// 索引项对应的缓存文件路径
+- (NSString *)filePathForKey:(NSString *)key entry:(const AUCDiskCacheIndexEntry *)entry {
+    NSString *fileName = AUCDiskCacheFileNameForKey(key);
+    // 早期版本写入的缓存文件名不带扩展名
+    if (!(entry->flags & AUCDiskCacheIndexEntryFlagHasExtension)) {
+        fileName = fileName.stringByDeletingPathExtension;
+    }
+    return [self filePathForFileName:fileName];
+}
+
+/// 缓存文件路径，迁移期间新路径不存在时回退到旧路径
+- (NSString *)filePathForFileName:(NSString *)fileName {
+    NSString *filePath = [self.diskCachePath stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName]];
+    if (self.migratingLayout && access(filePath.fileSystemRepresentation, F_OK) != 0) {
+        NSString *legacyPath = [self.diskCachePath stringByAppendingPathComponent:fileName];
+        if (access(legacyPath.fileSystemRepresentation, F_OK) == 0) return legacyPath;
+    }
+    return filePath;
+}
+
+- (NSString *)layoutFilePath {
+    return [self.diskCachePath stringByAppendingPathComponent:AUCDiskCacheIndex.layoutFileName];
+}
+
+- (NSString *)blobPath {
+    return [self.diskCachePath stringByAppendingPathComponent:AU_DISK_CACHE_BLOB_DIRECTORY_NAME];
+}
+
+/// 写入文件，子目录按需创建：只在第一次写入失败时检查，不为每次写入增加一次目录查询
+- (BOOL)writeData:(NSData *)data toPath:(NSString *)path {
+    NSURL *fileURL = [NSURL fileURLWithPath:path];
+    if ([data writeToURL:fileURL options:self.config.diskCacheWritingOptions error:nil]) return YES;
+    [self.fileManager createDirectoryAtPath:path.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+    return [data writeToURL:fileURL options:self.config.diskCacheWritingOptions error:nil];
+}
+
+#pragma mark - Delta
+/**
+ * 差量存储：数据较大且与上一个完整版本差异较小时，只写入差量，完整版本作为基准版本移入基准版本目录
+ * 1. 缓存文件头部带有 `AUCDiskEntryFlagDelta`，索引重建后仍能识别；扩展数据照常内联在缓存文件中。
+ * 2. 差量总是相对基准版本而不是上一个差量，读取时只需还原一次，耗时与差量次数无关。
+ * 3. 差量超过 `diskCacheDeltaMaxRatio` 或次数超过 `diskCacheDeltaMaxRevisions` 时重新写入完整版本，基准版本随之删除。
+ */
+
+- (NSString *)deltaBasePath {
+    return [self.diskCachePath stringByAppendingPathComponent:AU_DISK_CACHE_DELTA_BASE_DIRECTORY_NAME];
+}
+
+/// 基准版本路径，按摘要命名，不带扩展名
+- (NSString *)deltaBasePathForFileName:(NSString *)fileName {
+    return [self.deltaBasePath stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName.stringByDeletingPathExtension]];
+}
+
+- (nullable NSData *)entryDataAtPath:(NSString *)path {
+    return [AUCMappedData dataWithContentsOfFile:path accessPattern:AUCIOAccessPatternSequential] ?: [NSData dataWithContentsOfFile:path];
+}
+
+/// 与基准版本差异较小的数据只生成差量，返回 nil 时写入完整数据
+///
+/// - Parameter baseLength: 返回基准版本文件的大小
+/// - Note: 当前文件是完整版本时，将其重命名为基准版本，不重新写入数据
+- (nullable NSData *)deltaEntryDataWithData:(NSData *)data extendedData:(nullable NSData *)extendedData path:(NSString *)path basePath:(NSString *)basePath baseLength:(uint64_t *)baseLength {
+    NSUInteger threshold = self.config.diskCacheDeltaThreshold;
+    if (threshold == 0 || data.length < threshold) return nil;
+    NSData *currentData = [self entryDataAtPath:path];
+    if (!currentData) return nil;
+    BOOL verify = self.config.diskCacheChecksumMode != AUCCacheDiskChecksumModeOff;
+    AUCDiskEntryStatus status;
+    NSData *currentPayload = [AUCDiskEntryFormat payloadOfEntryData:currentData extendedData:NULL verify:verify status:&status];
+    if (status != AUCDiskEntryStatusValid) return nil;
+    
+    BOOL currentIsDelta = ([AUCDiskEntryFormat flagsOfEntryData:currentData] & AUCDiskEntryFlagDelta) != 0;
+    NSData *baseEntryData = currentIsDelta ? [self entryDataAtPath:basePath] : currentData;
+    NSData *base = currentIsDelta ? (baseEntryData ? [AUCDiskEntryFormat payloadOfEntryData:baseEntryData extendedData:NULL verify:verify status:NULL] : nil) : currentPayload;
+    if (!base) return nil;
+    uint32_t revision = currentIsDelta ? [AUCCacheDelta revisionOfDelta:currentPayload] + 1 : 1;
+    if (revision > self.config.diskCacheDeltaMaxRevisions) return nil;
+    NSUInteger maxLength = (NSUInteger)(data.length * self.config.diskCacheDeltaMaxRatio);
+    NSData *delta = [AUCCacheDelta deltaFromData:base toData:data revision:revision maxLength:MAX(maxLength, 1)];
+    if (!delta) return nil;
+    
+    if (!currentIsDelta) {
+        // 替换的旧基准版本可能是共享数据的最后一个引用
+        [self releaseBlobOfFileAtPath:basePath];
+        if (rename(path.fileSystemRepresentation, basePath.fileSystemRepresentation) != 0) {
+            [self.fileManager createDirectoryAtPath:basePath.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+            if (rename(path.fileSystemRepresentation, basePath.fileSystemRepresentation) != 0) return nil;
+        }
+        _hasDeltaBases = YES;
+    }
+    *baseLength = baseEntryData.length;
+    return [AUCDiskEntryFormat entryDataWithData:delta extendedData:extendedData flags:AUCDiskEntryFlagDelta];
+}
+
+/// 读取基准版本并还原差量，基准版本缺失或不匹配时返回 nil
+- (nullable NSData *)dataByApplyingDelta:(NSData *)delta basePath:(NSString *)basePath {
+    NSData *baseEntryData = [self entryDataAtPath:basePath];
+    // 差量记录了基准版本的校验和，还原时总会校验
+    NSData *base = baseEntryData ? [AUCDiskEntryFormat payloadOfEntryData:baseEntryData extendedData:NULL verify:NO status:NULL] : nil;
+    return base ? [AUCCacheDelta dataByApplyingDelta:delta toData:base] : nil;
+}
+
+- (void)removeDeltaBaseAtPath:(NSString *)basePath {
+    if (!_hasDeltaBases) return;
+    [self releaseBlobOfFileAtPath:basePath];
+    unlink(basePath.fileSystemRepresentation);
+}
+
+/// 删除对应的键已不在索引中的基准版本，`date` 之后修改的可能正在写入，不删除
+- (NSUInteger)removeOrphanDeltaBasesModifiedBefore:(NSTimeInterval)date {
+    // 索引重建完成前无法判断键是否存在
+    if (self.index.incomplete) return 0;
+    NSUInteger removedCount = 0;
+    NSDirectoryEnumerator<NSString *> *enumerator = [self.fileManager enumeratorAtPath:self.deltaBasePath];
+    for (NSString *relativePath in enumerator) {
+        @autoreleasepool {
+            NSString *filePath = [self.deltaBasePath stringByAppendingPathComponent:relativePath];
+            struct stat st;
+            if (lstat(filePath.fileSystemRepresentation, &st) != 0 || !S_ISREG(st.st_mode) || st.st_mtime >= date) continue;
+            unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+            if ([AUCDiskCacheIndex getDigest:digest fromFileName:filePath.lastPathComponent]
+                && [self.index getEntry:NULL forDigest:digest]) continue;
+            [self releaseBlobOfFileAtPath:filePath];
+            if (unlink(filePath.fileSystemRepresentation) == 0) removedCount++;
+        }
+    }
+    return removedCount;
+}
+
+#pragma mark - Deduplication
+/**
+ * 去重模式下，文件内容（头部 + 数据 + 扩展数据）以 SHA-256 命名保存在共享数据目录中，键对应的缓存文件是共享数据的硬链接：
+ * 1. 引用计数即文件系统的链接数，共享数据自身占一个，每个键占一个，不需要额外持久化的计数。
+ * 2. 删除键时链接数为 2 说明是最后一个引用，同时删除共享数据；只有这时才需要读取文件计算摘要。
+ * 3. 读取路径不变，键对应的路径上就是完整的缓存文件。
+ */
+
+/// 共享数据路径
+- (NSString *)blobPathForEntryData:(NSData *)entryData {
+    unsigned char hash[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(entryData.bytes, (CC_LONG)entryData.length, hash);
+    char hex[CC_SHA256_DIGEST_LENGTH * 2];
+    AUCHexEncode(hash, CC_SHA256_DIGEST_LENGTH, hex);
+    NSString *blobName = [[NSString alloc] initWithBytes:hex length:sizeof(hex) encoding:NSASCIIStringEncoding];
+    return [self.blobPath stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:blobName]];
+}
+
+/// 把缓存文件写为共享数据的引用，内容相同的共享数据已存在时只创建硬链接
+- (BOOL)linkEntryData:(NSData *)entryData toPath:(NSString *)path {
+    NSString *blobPath = [self blobPathForEntryData:entryData];
+    struct stat blobStat, fileStat;
+    BOOL blobExists = lstat(blobPath.fileSystemRepresentation, &blobStat) == 0;
+    // 重复写入相同内容，无需任何修改
+    if (blobExists && lstat(path.fileSystemRepresentation, &fileStat) == 0
+        && fileStat.st_ino == blobStat.st_ino && fileStat.st_dev == blobStat.st_dev) return YES;
+    
+    [self releaseBlobOfFileAtPath:path];
+    _hasBlobs = YES;
+    // 先链接到临时路径再重命名，替换旧文件是原子的；临时文件以 `.` 开头，崩溃遗留时由索引对账删除
+    NSString *tempPath = [path.stringByDeletingLastPathComponent stringByAppendingPathComponent:[NSString stringWithFormat:@".%@.link", path.lastPathComponent]];
+    for (NSUInteger attempt = 0; attempt < 2; attempt++) {
+        if (!blobExists && ![self writeData:entryData toPath:blobPath]) return NO;
+        unlink(tempPath.fileSystemRepresentation);
+        if (link(blobPath.fileSystemRepresentation, tempPath.fileSystemRepresentation) == 0) {
+            if (rename(tempPath.fileSystemRepresentation, path.fileSystemRepresentation) == 0) return YES;
+            unlink(tempPath.fileSystemRepresentation);
+            return NO;
+        }
+        if (errno != ENOENT) return NO;
+        // 缓存文件的子目录尚未创建，或共享数据刚被后台清理删除
+        [self.fileManager createDirectoryAtPath:tempPath.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+        blobExists = access(blobPath.fileSystemRepresentation, F_OK) == 0;
+    }
+    return NO;
+}
+
+/// 删除或替换缓存文件前调用：文件是共享数据的最后一个引用时，同时删除共享数据
+- (void)releaseBlobOfFileAtPath:(NSString *)path {
+    if (!_hasBlobs) return;
+    struct stat st;
+    if (lstat(path.fileSystemRepresentation, &st) != 0 || st.st_nlink != 2) return;
+    NSData *entryData = [AUCMappedData dataWithContentsOfFile:path accessPattern:AUCIOAccessPatternNoReuse] ?: [NSData dataWithContentsOfFile:path];
+    if (!entryData) return;
+    NSString *blobPath = [self blobPathForEntryData:entryData];
+    struct stat blobStat;
+    // 另一个链接可能是布局迁移或写入中的临时路径，只删除确实指向同一个文件的共享数据
+    if (lstat(blobPath.fileSystemRepresentation, &blobStat) == 0 && blobStat.st_ino == st.st_ino && blobStat.st_dev == st.st_dev) {
+        unlink(blobPath.fileSystemRepresentation);
+    }
+}
+
+/// 删除没有任何键引用的共享数据，`date` 之后修改的可能正在写入，不删除
+- (NSUInteger)removeOrphanBlobsModifiedBefore:(NSTimeInterval)date {
+    NSUInteger removedCount = 0;
+    NSDirectoryEnumerator<NSString *> *enumerator = [self.fileManager enumeratorAtPath:self.blobPath];
+    for (NSString *relativePath in enumerator) {
+        @autoreleasepool {
+            NSString *filePath = [self.blobPath stringByAppendingPathComponent:relativePath];
+            struct stat st;
+            if (lstat(filePath.fileSystemRepresentation, &st) != 0 || !S_ISREG(st.st_mode) || st.st_nlink != 1) continue;
+            if (st.st_mtime >= date) continue;
+            if (unlink(filePath.fileSystemRepresentation) == 0) removedCount++;
+        }
+    }
+    return removedCount;
+}
+
+- (uint64_t)deduplicatedSize {
+    uint64_t savedSize = 0;
+    NSDirectoryEnumerator<NSString *> *enumerator = [self.fileManager enumeratorAtPath:self.blobPath];
+    for (NSString *relativePath in enumerator) {
+        @autoreleasepool {
+            struct stat st;
+            NSString *filePath = [self.blobPath stringByAppendingPathComponent:relativePath];
+            // 第一个键的引用占用实际空间，之后每个键节省一份
+            if (lstat(filePath.fileSystemRepresentation, &st) == 0 && S_ISREG(st.st_mode) && st.st_nlink > 2) {
+                savedSize += (uint64_t)(st.st_nlink - 2) * (uint64_t)st.st_size;
+            }
+        }
+    }
+    return savedSize;
+}
+
+#pragma mark - Layout migration
+/// 在截止时间前把缓存目录下的旧版本文件移动到两级子目录中，返回迁移是否已完成
+- (BOOL)migrateLayoutWithDeadline:(CFAbsoluteTime)deadline report:(nullable AUCDiskCacheRecoveryReport *)report {
+    if (!_migrationDirectory) {
+        _migrationDirectory = opendir(self.diskCachePath.fileSystemRepresentation);
+        _migrationFailed = NO;
+        if (!_migrationDirectory) return YES;
+    }
+    NSUInteger scanned = 0;
+    struct dirent *dirent;
+    while ((dirent = readdir(_migrationDirectory))) {
+        @autoreleasepool {
+            NSString *fileName = [self.fileManager stringWithFileSystemRepresentation:dirent->d_name length:strlen(dirent->d_name)];
+            if ([self migrateFileName:fileName]) report.migratedFileCount++;
+        }
+        if ((++scanned & 15) == 0 && CFAbsoluteTimeGetCurrent() >= deadline) return NO;
+    }
+    closedir(_migrationDirectory);
+    _migrationDirectory = NULL;
+    // 有文件未能迁移时不写入版本标记，下次启动重试
+    if (!_migrationFailed) {
+        [self finishLayoutMigration];
+    }
+    return YES;
+}
+
+/// 迁移单个文件，返回是否迁移
+- (BOOL)migrateFileName:(NSString *)fileName {
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    if ([fileName hasPrefix:@"."] || ![AUCDiskCacheIndex getDigest:digest fromFileName:fileName]) return NO;
+    NSString *srcPath = [self.diskCachePath stringByAppendingPathComponent:fileName];
+    struct stat st;
+    if (lstat(srcPath.fileSystemRepresentation, &st) != 0 || !S_ISREG(st.st_mode)) return NO;
+    
+    NSString *dstPath = [self.diskCachePath stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName]];
+    [self.fileManager createDirectoryAtPath:dstPath.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+    /**
+     * 硬链接后删除旧路径，而不是重命名：
+     * 1. 硬链接不会覆盖已存在的文件，新路径已存在说明迁移期间被重新写入，旧文件直接删除。
+     * 2. 链接后、删除前进程退出时两个路径指向同一个文件，下次迁移时同样直接删除旧路径。
+     * 3. 文件的修改时间与扩展属性保持不变，索引无需更新。
+     */
+    if (link(srcPath.fileSystemRepresentation, dstPath.fileSystemRepresentation) != 0 && errno != EEXIST) {
+        _migrationFailed = YES;
+        return NO;
+    }
+    unlink(srcPath.fileSystemRepresentation);
+    return YES;
+}
+
+- (void)finishLayoutMigration {
+    NSString *version = [NSString stringWithFormat:@"%ld", (long)AU_DISK_CACHE_LAYOUT_VERSION];
+    [version writeToFile:self.layoutFilePath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    self.migratingLayout = NO;
 }
 
 - (void)moveCacheDirectoryFromPath:(nonnull NSString *)srcPath toPath:(nonnull NSString *)dstPath {
@@ -277,35 +801,54 @@ static NSString * const AU_DISK_CACHE_EXTENDED_ATTRIBUTE_NAME = @"com.vantage.AU
         NSDirectoryEnumerator *dirEnumerator = [self.fileManager enumeratorAtPath:srcPath];
         NSString *file;
         while ((file = [dirEnumerator nextObject])) {
+            // 旧目录中的索引与布局标记对新目录无效
+            if ([file isEqualToString:AUCDiskCacheIndex.indexFileName] || [file isEqualToString:AUCDiskCacheIndex.layoutFileName]) continue;
             [self.fileManager moveItemAtPath:[srcPath stringByAppendingPathComponent:file] toPath:[dstPath stringByAppendingPathComponent:file] error:nil];
         }
         // 删除旧路径
         [self.fileManager removeItemAtPath:srcPath error:nil];
     }
+    
+    // 目录内容已变化，旧目录可能是旧版本布局：迁移布局后重建索引
+    if ([dstPath isEqualToString:self.diskCachePath]) {
+        if (_migrationDirectory) {
+            closedir(_migrationDirectory);
+            _migrationDirectory = NULL;
+        }
+        self.migratingLayout = YES;
+        [self migrateLayoutWithDeadline:DBL_MAX report:nil];
+        [self.index rebuild];
+    }
 }
 
 #pragma mark - Hash
-#define AU_MAX_FILE_EXTENSION_LENGTH (NAME_MAX - CC_MD5_DIGEST_LENGTH * 2 - 1)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+static inline void AUCDiskCacheDigestForKey(NSString * _Nullable key, unsigned char * _Nonnull digest) {
+    memcpy(digest, [AUCCacheKey keyWithString:key ?: @""].digest, AUC_DISK_CACHE_DIGEST_LENGTH);
+}
+
 static inline NSString * _Nonnull AUCDiskCacheFileNameForKey(NSString * _Nullable key) {
-    const char *str = key.UTF8String;
-    if (str == NULL) {
-        str = "";
-    }
-    unsigned char r[CC_MD5_DIGEST_LENGTH];
-    CC_MD5(str, (CC_LONG)strlen(str), r);
-    NSURL *keyURL = [NSURL URLWithString:key];
-    NSString *ext = keyURL ? keyURL.pathExtension : key.pathExtension;
-    // 文件系统有文件名长度限制，我们需要检查 `ext` 是否过长，否则不会将其添加到文件名中
-    if (ext.length > AU_MAX_FILE_EXTENSION_LENGTH) {
-        ext = nil;
-    }
-    NSString *filename = [NSString stringWithFormat:@"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%@",
-                          r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8], r[9], r[10],
-                          r[11], r[12], r[13], r[14], r[15], ext.length == 0 ? @"" : [NSString stringWithFormat:@".%@", ext]];
-    return filename;
-}
-#pragma clang diagnostic pop
+    return [AUCCacheKey keyWithString:key ?: @""].fileName;
+}
+
+static inline NSString * _Nonnull AUCDiskCacheFileNameForDigest(const unsigned char * _Nonnull r, NSString * _Nullable ext) {
+    return AUCCacheKeyFileNameForDigest(r, ext);
+}
+
+static inline int64_t AUCDiskCacheCurrentTime(void) {
+    return (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+}
+
+/// 过期检查使用的时间
+static inline int64_t AUCDiskCacheEntryDate(const AUCDiskCacheIndexEntry * _Nonnull entry, AUCCacheConfigExpireType expireType) {
+    switch (expireType) {
+        case AUCCacheConfigExpireTypeAccessDate:
+            return entry->accessTime;
+        case AUCCacheConfigExpireTypeCreationDate:
+            return entry->creationTime;
+        default:
+            // 属性修改时间未单独记录，与修改时间一致
+            return entry->modificationTime;
+    }
+}
 
 @end
@@ -0,0 +1,168 @@
+//
+//  AUCDiskCacheIndex.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/14.
+//
+
+#import <Foundation/Foundation.h>
+
+@class AUCDiskCacheRecoveryReport;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 键摘要长度（MD5）
+#define AUC_DISK_CACHE_DIGEST_LENGTH 16
+/// 索引项内联保存的扩展名最大长度（UTF-8 字节数）
+#define AUC_DISK_CACHE_INDEX_MAX_EXTENSION_LENGTH 35
+
+typedef NS_OPTIONS(uint32_t, AUCDiskCacheIndexEntryFlags) {
+    /// 缓存文件名带有键的扩展名
+    AUCDiskCacheIndexEntryFlagHasExtension = 1 << 0,
+    /// 扩展名过长未能内联保存，需要按摘要前缀在目录中查找文件
+    AUCDiskCacheIndexEntryFlagExtensionTruncated = 1 << 1,
+    /// 缓存文件写入后已通过校验，延迟校验模式下读取时不再重复校验
+    AUCDiskCacheIndexEntryFlagVerified = 1 << 2,
+    /// 缓存文件按内联扩展数据的格式写入，不需要再读取早期版本使用的扩展属性（xattr）
+    AUCDiskCacheIndexEntryFlagInlineExtendedData = 1 << 3,
+    /// 缓存文件中内联了扩展数据
+    AUCDiskCacheIndexEntryFlagHasExtendedData = 1 << 4,
+};
+
+/// 索引项，时间单位均为毫秒
+typedef struct {
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    /// 缓存文件大小
+    uint64_t size;
+    int64_t creationTime;
+    int64_t modificationTime;
+    int64_t accessTime;
+    AUCDiskCacheIndexEntryFlags flags;
+    /// 扩展名（不含 `.`），以 `\0` 结尾
+    char extension[AUC_DISK_CACHE_INDEX_MAX_EXTENSION_LENGTH + 1];
+} AUCDiskCacheIndexEntry;
+
+/// ``磁盘缓存持久化索引``
+///
+/// 以内存映射文件保存 `键摘要 -> 缓存文件信息` 的开放寻址哈希表，`AUCDiskCache` 的存在性判断与未命中查询无需访问文件系统
+/// ```
+/// .auc_index
+///    ├── header    magic、版本、容量、数量、总大小、脏标记、校验游标、重建标记（64 字节）
+///    ├── slot[0]   摘要、大小、创建/修改/访问时间、标记位、淘汰链表指针、扩展名（96 字节）
+///    ├── ...
+///    ├── slot[N-1]
+/// ```
+///
+/// - Note: 缓存文件名即为键的 MD5 摘要，因此索引丢失或损坏时可以从缓存目录完整重建
+/// - Note: 缓存文件按摘要前两个字节分布在两级子目录中（`ab/cd/abcd...`），对账时同时识别旧版本直接位于缓存目录下的文件
+/// - Note: 每次修改前设置脏标记、修改后清除，进程在修改中途被终止时，下次启动会检测到脏标记并重建索引
+/// - Note: 所有索引项按写入（或访问）时间串成一条持久化的双向链表，链表头即最旧的数据，淘汰最旧的 k 项只需 O(k)
+/// - Note: 索引文件无法映射时退化为纯内存索引，每次启动从缓存目录重建
+/// - Note: 索引不存在、损坏或上次未正常写完时不在初始化时同步重建，而是标记为不完整，由 `recoverWithDeadline:report:` 增量重建
+@interface AUCDiskCacheIndex : NSObject
+
+/// 索引文件名，位于缓存目录下，以 `.` 开头以便目录枚举时跳过
+@property (nonatomic, class, readonly, nonnull) NSString *indexFileName;
+
+/// 目录布局版本标记文件名，位于缓存目录下，对账时跳过
+@property (nonatomic, class, readonly, nonnull) NSString *layoutFileName;
+
+/// 当前索引项数量
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/// 所有缓存文件的大小之和，随每次增删改同步更新并持久化在索引头部
+@property (nonatomic, assign, readonly) NSUInteger totalSize;
+
+/// 索引是否不完整（正在从缓存目录重建），此时索引未命中不代表文件不存在，需要回退到文件系统确认
+@property (nonatomic, assign, readonly) BOOL incomplete;
+
+/// 差量基准版本目录，按 `ab/cd/<摘要>` 布局；对账时缓存文件的大小加上同一摘要的基准版本大小，与写入时记录的大小一致
+///
+/// - Note: 默认为 nil，不检查基准版本；应在开始对账之前设置
+@property (nonatomic, copy, nullable) NSString *deltaBaseDirectory;
+
+/// 后台校验的槽位游标，持久化在索引头部，使校验跨进程轮转进行
+@property (nonatomic, assign) NSUInteger scrubPosition;
+
+/// 打开缓存目录下的索引，索引不存在、损坏或上次未正常写完时创建空索引并标记为不完整
+///
+/// - Parameters:
+///     - directory: 缓存目录
+///     - fileManager: 用于创建目录
+///     - orderByAccessTime: 淘汰链表是否按访问时间排序，为 NO 时按写入时间排序；与已有索引不一致时重建
+- (nonnull instancetype)initWithDirectory:(nonnull NSString *)directory fileManager:(nonnull NSFileManager *)fileManager orderByAccessTime:(BOOL)orderByAccessTime NS_DESIGNATED_INITIALIZER;
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/// 从缓存文件名解析键摘要，文件名不是以 32 位十六进制摘要开头时返回 NO
++ (BOOL)getDigest:(unsigned char *)digest fromFileName:(nonnull NSString *)fileName;
+
+/// 缓存文件相对缓存目录的路径：`ab/cd/<文件名>`，`ab`、`cd` 为摘要前两个字节的十六进制
++ (nonnull NSString *)relativePathForFileName:(nonnull NSString *)fileName;
+
+/// 设置索引项的扩展名及相关标记位
++ (void)setExtension:(nullable NSString *)extension forEntry:(AUCDiskCacheIndexEntry *)entry;
+
+/// 查询索引项，`entry` 可为 NULL
+- (BOOL)getEntry:(nullable AUCDiskCacheIndexEntry *)entry forDigest:(const unsigned char *)digest;
+
+/// 按文件路径读取缓存文件属性并补充索引项（索引不完整时未命中使用），已有索引项时直接返回
+///
+/// - Parameters:
+///     - filePath: 缓存文件路径，文件名须为摘要
+///     - entry: 返回索引项，可为 NULL
+/// - Returns: 文件是否存在
+- (BOOL)addEntryForFilePath:(nonnull NSString *)filePath entry:(nullable AUCDiskCacheIndexEntry *)entry;
+
+/// 新增或覆盖索引项，并移动到淘汰链表尾部
+- (void)setEntry:(const AUCDiskCacheIndexEntry *)entry;
+
+/// 更新访问时间，按访问时间排序时同时移动到淘汰链表尾部
+- (void)touchDigest:(const unsigned char *)digest accessTime:(int64_t)accessTime;
+
+/// 为索引项添加标记位
+- (void)addFlags:(AUCDiskCacheIndexEntryFlags)flags forDigest:(const unsigned char *)digest;
+
+/// 删除索引项
+- (void)removeDigest:(const unsigned char *)digest;
+
+/// 仅当索引项的修改时间与 `modificationTime` 一致时删除，返回是否删除
+///
+/// - Note: 用于后台校验，避免删除校验期间被重新写入的数据
+- (BOOL)removeDigest:(const unsigned char *)digest modificationTime:(int64_t)modificationTime;
+
+/// 从淘汰链表头部开始复制最旧的至多 `maxCount` 个索引项，返回实际数量
+- (NSUInteger)getOldestEntries:(AUCDiskCacheIndexEntry *)entries maxCount:(NSUInteger)maxCount;
+
+/// 从槽位 `position` 开始按槽位顺序复制至多 `maxCount` 个索引项，并把 `position` 更新为下一个待读取的槽位，返回实际数量，返回 0 表示已到达末尾
+///
+/// - Note: 两次调用之间的删除可能把后面的索引项移到已读取的槽位，遍历结果是近似的
+- (NSUInteger)getEntries:(AUCDiskCacheIndexEntry *)entries maxCount:(NSUInteger)maxCount position:(NSUInteger *)position;
+
+/// 清空索引并重新创建索引文件（缓存目录被整体删除后调用）
+- (void)removeAllEntries;
+
+/// 丢弃当前索引，从缓存目录重建，会中止正在进行的增量对账
+- (void)rebuild;
+
+/// 与缓存目录对账，补齐未被索引的文件、删除文件已不存在的索引项并修正大小，返回校正的数量
+///
+/// - Note: 一次完成全部对账，等同于不限时间地调用 `recoverWithDeadline:report:`
+- (NSUInteger)reconcile;
+
+/// 增量与缓存目录对账，到达截止时间后返回，下次调用从中断处继续
+///
+/// 1. 逐个读取目录项（包括两级子目录）：补齐未被索引的文件、修正大小，删除崩溃遗留的临时文件
+/// 2. 逐个检查索引项：删除文件已不存在的索引项
+/// 3. 索引是重建的：按时间重新排列淘汰链表，并清除不完整标记
+///
+/// - Parameters:
+///     - deadline: 截止时间（`CFAbsoluteTimeGetCurrent()`）
+///     - report: 累计修复数量，可为 nil
+/// - Returns: 对账是否已完成
+/// - Note: 目录扫描期间不持有锁，可与读写并发执行；扫描开始后写入的数据不参与校正
+/// - Warning: 同一时间只能有一个线程调用
+- (BOOL)recoverWithDeadline:(CFAbsoluteTime)deadline report:(nullable AUCDiskCacheRecoveryReport *)report;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,878 @@
+//
+//  AUCDiskCacheIndex.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/14.
+//
+
+#import "AUCDiskCacheIndex.h"
+#import "AUCInternalMacros.h"
+#import "AUCDiskCacheRecoveryReport.h"
+#import <dirent.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+
+// 'AUCI'
+static const uint32_t AUC_DISK_CACHE_INDEX_MAGIC = 0x49435541;
+static const uint32_t AUC_DISK_CACHE_INDEX_VERSION = 3;
+static const uint64_t AUC_DISK_CACHE_INDEX_MIN_CAPACITY = 256;
+// 槽位已被占用，仅在索引内部使用
+static const uint32_t AUC_DISK_CACHE_INDEX_SLOT_USED = 1u << 31;
+// 链表空指针
+static const uint32_t AUC_DISK_CACHE_INDEX_NIL = UINT32_MAX;
+// 超过该时间（毫秒）仍未被重命名的临时文件视为崩溃遗留
+static const int64_t AUC_DISK_CACHE_INDEX_ORPHAN_AGE = 10 * 60 * 1000;
+// 对账检查索引项时每次持有锁处理的槽位数量
+static const uint64_t AUC_DISK_CACHE_INDEX_SWEEP_BATCH = 256;
+// 缓存文件所在子目录的层数，每层以摘要的一个字节命名
+#define AUC_DISK_CACHE_INDEX_FAN_OUT_DEPTH 2
+
+typedef NS_ENUM(NSUInteger, AUCDiskCacheIndexRecoveryPhase) {
+    AUCDiskCacheIndexRecoveryPhaseNone,
+    /// 逐个读取目录项
+    AUCDiskCacheIndexRecoveryPhaseScan,
+    /// 逐个检查索引项
+    AUCDiskCacheIndexRecoveryPhaseSweep,
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t count;
+    /// 所有索引项的文件大小之和
+    uint64_t totalSize;
+    uint32_t dirty;
+    /// 淘汰链表的头（最旧）、尾（最新）槽位
+    uint32_t head;
+    uint32_t tail;
+    /// 淘汰链表是否按访问时间排序
+    uint32_t orderByAccessTime;
+    /// 后台校验游标
+    uint32_t scrubPosition;
+    /// 索引正在从目录重建，重建完成前进程退出时下次启动重新开始
+    uint32_t recovering;
+    uint32_t reserved[2];
+} AUCDiskCacheIndexHeader;
+
+typedef struct {
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    uint64_t size;
+    int64_t creationTime;
+    int64_t modificationTime;
+    int64_t accessTime;
+    uint32_t flags;
+    /// 淘汰链表中前后槽位
+    uint32_t prev;
+    uint32_t next;
+    char extension[AUC_DISK_CACHE_INDEX_MAX_EXTENSION_LENGTH + 1];
+} AUCDiskCacheIndexSlot;
+
+_Static_assert(sizeof(AUCDiskCacheIndexHeader) == 64, "index header must be 64 bytes");
+_Static_assert(sizeof(AUCDiskCacheIndexSlot) == 96, "index slot must be 96 bytes");
+
+static inline uint64_t AUCDiskCacheIndexHash(const unsigned char *digest) {
+    // 摘要本身已均匀分布，直接取前 8 字节
+    uint64_t hash;
+    memcpy(&hash, digest, sizeof(hash));
+    return hash;
+}
+
+static inline int64_t AUCDiskCacheIndexCurrentTime(void) {
+    return (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+}
+
+static inline int64_t AUCDiskCacheIndexTimeFromTimespec(struct timespec ts) {
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline int AUCDiskCacheIndexHexValue(unichar c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/// 是否为两位十六进制的子目录名
+static inline BOOL AUCDiskCacheIndexIsPrefixDirectoryName(const char *name) {
+    return AUCDiskCacheIndexHexValue((unsigned char)name[0]) >= 0 && AUCDiskCacheIndexHexValue((unsigned char)name[1]) >= 0 && name[2] == '\0';
+}
+
+/// 重排淘汰链表时的排序项
+typedef struct {
+    int64_t time;
+    uint32_t index;
+} AUCDiskCacheIndexSortItem;
+
+/// 按时间升序，时间相同时按槽位顺序，结果与 `qsort` 的实现无关
+static int AUCDiskCacheIndexCompareSortItems(const void *a, const void *b) {
+    const AUCDiskCacheIndexSortItem *l = a, *r = b;
+    if (l->time != r->time) return l->time < r->time ? -1 : 1;
+    return (l->index > r->index) - (l->index < r->index);
+}
+
+/// 是否为缓存写入过程中产生的临时文件
+/// ```
+/// .<摘要>[.扩展名].link      `AUCDiskCache` 创建硬链接时的临时路径
+/// .dat.nosync*              `NSData` 原子写入的临时文件
+/// ```
+static BOOL AUCDiskCacheIndexIsTemporaryFileName(NSString *fileName) {
+    if ([fileName hasPrefix:@".dat.nosync"]) return YES;
+    NSString *suffix = @".link";
+    if (fileName.length <= 1 + suffix.length || ![fileName hasPrefix:@"."] || ![fileName hasSuffix:suffix]) return NO;
+    unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+    NSString *linkedFileName = [fileName substringWithRange:NSMakeRange(1, fileName.length - 1 - suffix.length)];
+    return [AUCDiskCacheIndex getDigest:digest fromFileName:linkedFileName];
+}
+
+static inline int64_t AUCDiskCacheIndexModificationTimeOfStat(const struct stat *st) {
+#if defined(__APPLE__)
+    return AUCDiskCacheIndexTimeFromTimespec(st->st_mtimespec);
+#else
+    return AUCDiskCacheIndexTimeFromTimespec(st->st_mtim);
+#endif
+}
+
+static inline void AUCDiskCacheIndexCopySlotToEntry(const AUCDiskCacheIndexSlot *slot, AUCDiskCacheIndexEntry *entry) {
+    memcpy(entry->digest, slot->digest, AUC_DISK_CACHE_DIGEST_LENGTH);
+    entry->size = slot->size;
+    entry->creationTime = slot->creationTime;
+    entry->modificationTime = slot->modificationTime;
+    entry->accessTime = slot->accessTime;
+    entry->flags = slot->flags & ~AUC_DISK_CACHE_INDEX_SLOT_USED;
+    memcpy(entry->extension, slot->extension, sizeof(entry->extension));
+}
+
+@interface AUCDiskCacheIndex ()
+
+@property (nonatomic, copy) NSString *directory;
+@property (nonatomic, copy) NSString *indexPath;
+@property (nonatomic, strong, nonnull) NSFileManager *fileManager;
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t lock;
+@property (nonatomic, assign) BOOL orderByAccessTime;
+
+@end
+
+@implementation AUCDiskCacheIndex {
+    void *_base;
+    size_t _length;
+    int _fd;
+    AUCDiskCacheIndexHeader *_header;
+    AUCDiskCacheIndexSlot *_slots;
+    BOOL _incomplete;
+    /// 增量对账状态，仅由调用 `recoverWithDeadline:report:` 的线程访问
+    AUCDiskCacheIndexRecoveryPhase _recoveryPhase;
+    /// 目录扫描栈：缓存目录与两级子目录
+    DIR *_scanDirectories[AUC_DISK_CACHE_INDEX_FAN_OUT_DEPTH + 1];
+    NSMutableArray<NSString *> *_scanPaths;
+    int64_t _scanStartTime;
+    NSMutableSet<NSData *> *_scanDigests;
+    /// 差量基准版本目录是否存在，不存在时扫描无需逐个查找基准版本
+    BOOL _scanDeltaBases;
+    uint64_t _sweepPosition;
+}
+
++ (NSString *)indexFileName {
+    return @".auc_index";
+}
+
++ (NSString *)layoutFileName {
+    return @".auc_layout";
+}
+
++ (NSString *)relativePathForFileName:(NSString *)fileName {
+    NSParameterAssert(fileName.length >= 4);
+    return [NSString stringWithFormat:@"%@/%@/%@", [fileName substringToIndex:2], [fileName substringWithRange:NSMakeRange(2, 2)], fileName];
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory fileManager:(NSFileManager *)fileManager orderByAccessTime:(BOOL)orderByAccessTime {
+    if (self = [super init]) {
+        _fd = -1;
+        _directory = [directory copy];
+        _indexPath = [directory stringByAppendingPathComponent:AUCDiskCacheIndex.indexFileName];
+        _fileManager = fileManager;
+        _lock = dispatch_semaphore_create(1);
+        _orderByAccessTime = orderByAccessTime;
+        if (![fileManager fileExistsAtPath:directory]) {
+            [fileManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+        }
+        if (![self _openExistingIndex]) {
+            // 不在初始化时扫描目录，避免缓存文件较多时拖慢启动，由增量对账重建
+            [self _resetStorageWithCapacity:AUC_DISK_CACHE_INDEX_MIN_CAPACITY];
+            _header->recovering = 1;
+            _header->dirty = 0;
+            _incomplete = YES;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self _closeScanDirectories];
+    [self _closeStorage];
+}
+
++ (BOOL)getDigest:(unsigned char *)digest fromFileName:(NSString *)fileName {
+    if (fileName.length < AUC_DISK_CACHE_DIGEST_LENGTH * 2) return NO;
+    if (fileName.length > AUC_DISK_CACHE_DIGEST_LENGTH * 2 && [fileName characterAtIndex:AUC_DISK_CACHE_DIGEST_LENGTH * 2] != '.') return NO;
+    for (NSUInteger i = 0; i < AUC_DISK_CACHE_DIGEST_LENGTH; i++) {
+        int high = AUCDiskCacheIndexHexValue([fileName characterAtIndex:i * 2]);
+        int low = AUCDiskCacheIndexHexValue([fileName characterAtIndex:i * 2 + 1]);
+        if (high < 0 || low < 0) return NO;
+        digest[i] = (unsigned char)((high << 4) | low);
+    }
+    return YES;
+}
+
++ (void)setExtension:(NSString *)extension forEntry:(AUCDiskCacheIndexEntry *)entry {
+    memset(entry->extension, 0, sizeof(entry->extension));
+    entry->flags &= ~(AUCDiskCacheIndexEntryFlagHasExtension | AUCDiskCacheIndexEntryFlagExtensionTruncated);
+    if (extension.length == 0) return;
+
+    entry->flags |= AUCDiskCacheIndexEntryFlagHasExtension;
+    const char *str = extension.UTF8String;
+    size_t length = str ? strlen(str) : 0;
+    if (length == 0 || length > AUC_DISK_CACHE_INDEX_MAX_EXTENSION_LENGTH) {
+        entry->flags |= AUCDiskCacheIndexEntryFlagExtensionTruncated;
+        return;
+    }
+    memcpy(entry->extension, str, length);
+}
+
+#pragma mark - Public
+- (NSUInteger)count {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger count = (NSUInteger)_header->count;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return count;
+}
+
+- (NSUInteger)totalSize {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger totalSize = (NSUInteger)_header->totalSize;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return totalSize;
+}
+
+- (BOOL)incomplete {
+    return _incomplete;
+}
+
+- (NSUInteger)scrubPosition {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger position = _header->scrubPosition;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return position;
+}
+
+- (void)setScrubPosition:(NSUInteger)scrubPosition {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _header->scrubPosition = (uint32_t)MIN(scrubPosition, (NSUInteger)_header->capacity);
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (BOOL)getEntry:(AUCDiskCacheIndexEntry *)entry forDigest:(const unsigned char *)digest {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:digest];
+    BOOL found = index != UINT64_MAX;
+    if (found && entry) {
+        AUCDiskCacheIndexCopySlotToEntry(&_slots[index], entry);
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return found;
+}
+
+- (BOOL)addEntryForFilePath:(NSString *)filePath entry:(AUCDiskCacheIndexEntry *)entry {
+    AUCDiskCacheIndexEntry fileEntry;
+    struct stat st;
+    if (lstat(filePath.fileSystemRepresentation, &st) != 0) return NO;
+    if (![self _getEntry:&fileEntry forFileName:filePath.lastPathComponent stat:&st]) return NO;
+    fileEntry.size += [self _deltaBaseSizeForFileName:filePath.lastPathComponent];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:fileEntry.digest];
+    if (index == UINT64_MAX) {
+        _header->dirty = 1;
+        [self _setEntry:&fileEntry];
+        _header->dirty = 0;
+        if (entry) *entry = fileEntry;
+    } else if (entry) {
+        AUCDiskCacheIndexCopySlotToEntry(&_slots[index], entry);
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return YES;
+}
+
+- (void)setEntry:(const AUCDiskCacheIndexEntry *)entry {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _header->dirty = 1;
+    [self _setEntry:entry];
+    _header->dirty = 0;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)touchDigest:(const unsigned char *)digest accessTime:(int64_t)accessTime {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:digest];
+    if (index != UINT64_MAX) {
+        // 与其他修改一致，写入槽位期间保持脏标记，中途退出时下次打开会重新对账
+        _header->dirty = 1;
+        _slots[index].accessTime = accessTime;
+        if (_header->orderByAccessTime) {
+            [self _listUnlink:(uint32_t)index];
+            [self _listAppend:(uint32_t)index];
+        }
+        _header->dirty = 0;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)addFlags:(AUCDiskCacheIndexEntryFlags)flags forDigest:(const unsigned char *)digest {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:digest];
+    if (index != UINT64_MAX) {
+        _header->dirty = 1;
+        _slots[index].flags |= (flags & ~AUC_DISK_CACHE_INDEX_SLOT_USED);
+        _header->dirty = 0;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeDigest:(const unsigned char *)digest {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:digest];
+    if (index != UINT64_MAX) {
+        _header->dirty = 1;
+        [self _removeSlotAtIndex:index];
+        _header->dirty = 0;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (BOOL)removeDigest:(const unsigned char *)digest modificationTime:(int64_t)modificationTime {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:digest];
+    BOOL removed = index != UINT64_MAX && _slots[index].modificationTime == modificationTime;
+    if (removed) {
+        _header->dirty = 1;
+        [self _removeSlotAtIndex:index];
+        _header->dirty = 0;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return removed;
+}
+
+- (NSUInteger)getOldestEntries:(AUCDiskCacheIndexEntry *)entries maxCount:(NSUInteger)maxCount {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger count = 0;
+    uint32_t index = _header->head;
+    while (index != AUC_DISK_CACHE_INDEX_NIL && count < maxCount) {
+        AUCDiskCacheIndexCopySlotToEntry(&_slots[index], &entries[count++]);
+        index = _slots[index].next;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return count;
+}
+
+- (NSUInteger)getEntries:(AUCDiskCacheIndexEntry *)entries maxCount:(NSUInteger)maxCount position:(NSUInteger *)position {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger count = 0;
+    uint64_t index = *position;
+    while (index < _header->capacity && count < maxCount) {
+        if (_slots[index].flags & AUC_DISK_CACHE_INDEX_SLOT_USED) {
+            AUCDiskCacheIndexCopySlotToEntry(&_slots[index], &entries[count++]);
+        }
+        index++;
+    }
+    *position = (NSUInteger)index;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return count;
+}
+
+- (void)removeAllEntries {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self _resetStorageWithCapacity:AUC_DISK_CACHE_INDEX_MIN_CAPACITY];
+    _header->dirty = 0;
+    _incomplete = NO;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)rebuild {
+    // 中止进行中的对账，以空索引重新开始，完成后按时间重新排列淘汰链表
+    [self _closeScanDirectories];
+    _scanDigests = nil;
+    _recoveryPhase = AUCDiskCacheIndexRecoveryPhaseNone;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self _resetStorageWithCapacity:AUC_DISK_CACHE_INDEX_MIN_CAPACITY];
+    _header->recovering = 1;
+    _header->dirty = 0;
+    _incomplete = YES;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    [self recoverWithDeadline:DBL_MAX report:nil];
+}
+
+- (NSUInteger)reconcile {
+    AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+    [self recoverWithDeadline:DBL_MAX report:report];
+    return report.repairedEntryCount;
+}
+
+- (BOOL)recoverWithDeadline:(CFAbsoluteTime)deadline report:(AUCDiskCacheRecoveryReport *)report {
+    if (_recoveryPhase == AUCDiskCacheIndexRecoveryPhaseNone) {
+        // 只校正开始扫描之前修改的索引项，扫描期间新写入的数据不受影响
+        _scanStartTime = AUCDiskCacheIndexCurrentTime();
+        _scanDigests = [NSMutableSet set];
+        _scanDeltaBases = self.deltaBaseDirectory && access(self.deltaBaseDirectory.fileSystemRepresentation, F_OK) == 0;
+        [self _pushScanDirectory:self.directory];
+        _sweepPosition = 0;
+        _recoveryPhase = AUCDiskCacheIndexRecoveryPhaseScan;
+    }
+    if (_recoveryPhase == AUCDiskCacheIndexRecoveryPhaseScan) {
+        if (![self _recoverScanWithDeadline:deadline report:report]) return NO;
+        _recoveryPhase = AUCDiskCacheIndexRecoveryPhaseSweep;
+    }
+    if (![self _recoverSweepWithDeadline:deadline report:report]) return NO;
+
+    // 3. 重建的索引按时间重新排列淘汰链表
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    if (_header->recovering) {
+        _header->dirty = 1;
+        [self _sortList];
+        _header->recovering = 0;
+        _header->dirty = 0;
+    }
+    _incomplete = NO;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    _scanDigests = nil;
+    _recoveryPhase = AUCDiskCacheIndexRecoveryPhaseNone;
+    return YES;
+}
+
+#pragma mark - Recovery
+/// 1. 深度优先逐个读取目录项，补齐未被索引的文件，修正大小不一致的索引项
+///
+/// ```
+/// 缓存目录
+///    ├── .auc_index、.auc_layout       跳过
+///    ├── <摘要>[.扩展名]                旧版本布局，等待迁移
+///    └── ab/
+///         └── cd/
+///              └── <摘要>[.扩展名]
+/// ```
+- (BOOL)_recoverScanWithDeadline:(CFAbsoluteTime)deadline report:(nullable AUCDiskCacheRecoveryReport *)report {
+    NSUInteger scanned = 0;
+    while (_scanPaths.count > 0) {
+        NSUInteger level = _scanPaths.count - 1;
+        struct dirent *dirent = readdir(_scanDirectories[level]);
+        if (!dirent) {
+            closedir(_scanDirectories[level]);
+            _scanDirectories[level] = NULL;
+            [_scanPaths removeLastObject];
+            continue;
+        }
+        const char *name = dirent->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+        @autoreleasepool {
+            NSString *fileName = [self.fileManager stringWithFileSystemRepresentation:name length:strlen(name)];
+            NSString *filePath = [_scanPaths[level] stringByAppendingPathComponent:fileName];
+            struct stat st;
+            if (lstat(filePath.fileSystemRepresentation, &st) == 0) {
+                if (S_ISDIR(st.st_mode)) {
+                    if (level < AUC_DISK_CACHE_INDEX_FAN_OUT_DEPTH && AUCDiskCacheIndexIsPrefixDirectoryName(name)) {
+                        [self _pushScanDirectory:filePath];
+                    }
+                } else if (S_ISREG(st.st_mode) && (level == 0 || level == AUC_DISK_CACHE_INDEX_FAN_OUT_DEPTH)) {
+                    [self _recoverFileName:fileName path:filePath stat:&st report:report];
+                }
+            }
+        }
+        if ((++scanned & 15) == 0 && CFAbsoluteTimeGetCurrent() >= deadline) return NO;
+    }
+    return YES;
+}
+
+- (void)_pushScanDirectory:(NSString *)path {
+    DIR *dir = opendir(path.fileSystemRepresentation);
+    if (!dir) return;
+    if (!_scanPaths) _scanPaths = [NSMutableArray array];
+    _scanDirectories[_scanPaths.count] = dir;
+    [_scanPaths addObject:path];
+}
+
+- (void)_closeScanDirectories {
+    for (NSUInteger i = 0; i < _scanPaths.count; i++) {
+        closedir(_scanDirectories[i]);
+        _scanDirectories[i] = NULL;
+    }
+    [_scanPaths removeAllObjects];
+}
+
+- (void)_recoverFileName:(NSString *)fileName path:(NSString *)filePath stat:(const struct stat *)st report:(nullable AUCDiskCacheRecoveryReport *)report {
+    if ([fileName isEqualToString:AUCDiskCacheIndex.indexFileName] || [fileName isEqualToString:AUCDiskCacheIndex.layoutFileName]) return;
+
+    AUCDiskCacheIndexEntry entry;
+    if ([fileName hasPrefix:@"."] || ![AUCDiskCacheIndex getDigest:entry.digest fromFileName:fileName]) {
+        // 缓存目录可能与其他文件共用，只删除本缓存写入时产生的临时文件
+        if (AUCDiskCacheIndexIsTemporaryFileName(fileName)) {
+            [self _removeOrphanFileAtPath:filePath stat:st report:report];
+        }
+        return;
+    }
+    if (![self _getEntry:&entry forFileName:fileName stat:st]) return;
+    if (_scanDeltaBases) entry.size += [self _deltaBaseSizeForFileName:fileName];
+    [_scanDigests addObject:[NSData dataWithBytes:entry.digest length:AUC_DISK_CACHE_DIGEST_LENGTH]];
+    if (entry.modificationTime >= _scanStartTime) return;
+
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t index = [self _indexOfDigest:entry.digest];
+    if (index == UINT64_MAX) {
+        _header->dirty = 1;
+        [self _setEntry:&entry];
+        _header->dirty = 0;
+        report.repairedEntryCount++;
+    } else if (_slots[index].size != entry.size && _slots[index].modificationTime < _scanStartTime) {
+        _header->dirty = 1;
+        _header->totalSize = _header->totalSize - _slots[index].size + entry.size;
+        _slots[index].size = entry.size;
+        _header->dirty = 0;
+        report.repairedEntryCount++;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+/// 同一摘要的差量基准版本大小，没有基准版本时返回 0
+///
+/// - Note: 写入差量时索引记录的大小包含基准版本（`AUCDiskCache`），对账时需要同样计入，否则会被校正为差量文件本身的大小
+- (uint64_t)_deltaBaseSizeForFileName:(NSString *)fileName {
+    NSString *directory = self.deltaBaseDirectory;
+    if (!directory) return 0;
+    NSString *basePath = [directory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName.stringByDeletingPathExtension]];
+    struct stat st;
+    return lstat(basePath.fileSystemRepresentation, &st) == 0 && S_ISREG(st.st_mode) ? (uint64_t)st.st_size : 0;
+}
+
+/// 删除崩溃遗留的临时文件，最近修改的文件可能仍在写入，暂不删除
+- (void)_removeOrphanFileAtPath:(NSString *)filePath stat:(const struct stat *)st report:(nullable AUCDiskCacheRecoveryReport *)report {
+    if (AUCDiskCacheIndexModificationTimeOfStat(st) >= _scanStartTime - AUC_DISK_CACHE_INDEX_ORPHAN_AGE) return;
+    if (unlink(filePath.fileSystemRepresentation) == 0) {
+        report.removedOrphanFileCount++;
+    }
+}
+
+/// 2. 逐个检查索引项，删除文件已不存在的索引项
+- (BOOL)_recoverSweepWithDeadline:(CFAbsoluteTime)deadline report:(nullable AUCDiskCacheRecoveryReport *)report {
+    while (YES) {
+        AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+        _header->dirty = 1;
+        uint64_t end = MIN(_sweepPosition + AUC_DISK_CACHE_INDEX_SWEEP_BATCH, _header->capacity);
+        while (_sweepPosition < end) {
+            AUCDiskCacheIndexSlot *slot = &_slots[_sweepPosition];
+            if ((slot->flags & AUC_DISK_CACHE_INDEX_SLOT_USED) && slot->modificationTime < _scanStartTime
+                && ![_scanDigests containsObject:[NSData dataWithBytesNoCopy:slot->digest length:AUC_DISK_CACHE_DIGEST_LENGTH freeWhenDone:NO]]) {
+                // 后移压缩可能把后面的槽位移到当前位置，因此不前进
+                [self _removeSlotAtIndex:_sweepPosition];
+                report.repairedEntryCount++;
+                continue;
+            }
+            _sweepPosition++;
+        }
+        BOOL finished = _sweepPosition >= _header->capacity;
+        _header->dirty = 0;
+        AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+        if (finished) return YES;
+        if (CFAbsoluteTimeGetCurrent() >= deadline) return NO;
+    }
+}
+
+#pragma mark - Storage（调用方需持有锁）
+- (void)_closeStorage {
+    if (_base) {
+        if (_fd >= 0) {
+            munmap(_base, _length);
+        } else {
+            free(_base);
+        }
+    }
+    if (_fd >= 0) close(_fd);
+    _base = NULL;
+    _length = 0;
+    _fd = -1;
+    _header = NULL;
+    _slots = NULL;
+}
+
+- (void)_attachBase:(void *)base length:(size_t)length fd:(int)fd {
+    _base = base;
+    _length = length;
+    _fd = fd;
+    _header = (AUCDiskCacheIndexHeader *)base;
+    _slots = (AUCDiskCacheIndexSlot *)((uint8_t *)base + sizeof(AUCDiskCacheIndexHeader));
+}
+
+/// 映射已有的索引文件并校验，任何一项不符合都视为损坏
+- (BOOL)_openExistingIndex {
+    int fd = open(self.indexPath.fileSystemRepresentation, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return NO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(AUCDiskCacheIndexHeader)) {
+        close(fd);
+        return NO;
+    }
+    size_t length = (size_t)st.st_size;
+    void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NO;
+    }
+
+    AUCDiskCacheIndexHeader *header = (AUCDiskCacheIndexHeader *)base;
+    uint64_t capacity = header->capacity;
+    BOOL valid = header->magic == AUC_DISK_CACHE_INDEX_MAGIC
+        && header->version == AUC_DISK_CACHE_INDEX_VERSION
+        && header->dirty == 0
+        && header->recovering == 0
+        && header->orderByAccessTime == (uint32_t)self.orderByAccessTime
+        && capacity >= AUC_DISK_CACHE_INDEX_MIN_CAPACITY
+        && capacity <= AUC_DISK_CACHE_INDEX_NIL
+        && (capacity & (capacity - 1)) == 0
+        && header->count < capacity
+        && (header->head == AUC_DISK_CACHE_INDEX_NIL || header->head < capacity)
+        && (header->tail == AUC_DISK_CACHE_INDEX_NIL || header->tail < capacity)
+        && length == sizeof(AUCDiskCacheIndexHeader) + capacity * sizeof(AUCDiskCacheIndexSlot);
+    if (!valid) {
+        munmap(base, length);
+        close(fd);
+        return NO;
+    }
+
+    [self _closeStorage];
+    [self _attachBase:base length:length fd:fd];
+    return YES;
+}
+
+/// 以指定容量重新创建空索引，返回时脏标记为 1，由调用方在填充完成后清除
+- (void)_resetStorageWithCapacity:(uint64_t)capacity {
+    [self _closeStorage];
+    size_t length = (size_t)(sizeof(AUCDiskCacheIndexHeader) + capacity * sizeof(AUCDiskCacheIndexSlot));
+
+    if (![self.fileManager fileExistsAtPath:self.directory]) {
+        [self.fileManager createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    }
+    int fd = open(self.indexPath.fileSystemRepresentation, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    void *base = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, (off_t)length) == 0) {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (base != MAP_FAILED) {
+        [self _attachBase:base length:length fd:fd];
+        // 索引文件可随时重建，无需备份
+        NSURL *indexURL = [NSURL fileURLWithPath:self.indexPath];
+        [indexURL setResourceValue:@YES forKey:NSURLIsExcludedFromBackupKey error:nil];
+    } else {
+        // 无法映射文件时退化为纯内存索引
+        if (fd >= 0) {
+            close(fd);
+            unlink(self.indexPath.fileSystemRepresentation);
+        }
+        [self _attachBase:calloc(1, length) length:length fd:-1];
+    }
+
+    _header->magic = AUC_DISK_CACHE_INDEX_MAGIC;
+    _header->version = AUC_DISK_CACHE_INDEX_VERSION;
+    _header->capacity = capacity;
+    _header->count = 0;
+    _header->totalSize = 0;
+    _header->head = AUC_DISK_CACHE_INDEX_NIL;
+    _header->tail = AUC_DISK_CACHE_INDEX_NIL;
+    _header->orderByAccessTime = self.orderByAccessTime;
+    _header->scrubPosition = 0;
+    _header->recovering = 0;
+    _header->dirty = 1;
+}
+
+/// 由缓存文件属性生成索引项，不访问索引，无需持有锁
+- (BOOL)_getEntry:(AUCDiskCacheIndexEntry *)entry forFileName:(NSString *)fileName stat:(const struct stat *)st {
+    memset(entry, 0, sizeof(AUCDiskCacheIndexEntry));
+    if (!S_ISREG(st->st_mode)) return NO;
+    if (![AUCDiskCacheIndex getDigest:entry->digest fromFileName:fileName]) return NO;
+
+    entry->size = (uint64_t)st->st_size;
+#if defined(__APPLE__)
+    entry->creationTime = AUCDiskCacheIndexTimeFromTimespec(st->st_birthtimespec);
+    entry->accessTime = AUCDiskCacheIndexTimeFromTimespec(st->st_atimespec);
+#else
+    entry->creationTime = AUCDiskCacheIndexTimeFromTimespec(st->st_ctim);
+    entry->accessTime = AUCDiskCacheIndexTimeFromTimespec(st->st_atim);
+#endif
+    entry->modificationTime = AUCDiskCacheIndexModificationTimeOfStat(st);
+    if (fileName.length > AUC_DISK_CACHE_DIGEST_LENGTH * 2) {
+        [AUCDiskCacheIndex setExtension:[fileName substringFromIndex:AUC_DISK_CACHE_DIGEST_LENGTH * 2 + 1] forEntry:entry];
+    }
+    return YES;
+}
+
+#pragma mark - 淘汰链表（调用方需持有锁）
+- (void)_listUnlink:(uint32_t)index {
+    AUCDiskCacheIndexSlot *slot = &_slots[index];
+    if (slot->prev != AUC_DISK_CACHE_INDEX_NIL) {
+        _slots[slot->prev].next = slot->next;
+    } else {
+        _header->head = slot->next;
+    }
+    if (slot->next != AUC_DISK_CACHE_INDEX_NIL) {
+        _slots[slot->next].prev = slot->prev;
+    } else {
+        _header->tail = slot->prev;
+    }
+    slot->prev = AUC_DISK_CACHE_INDEX_NIL;
+    slot->next = AUC_DISK_CACHE_INDEX_NIL;
+}
+
+/// 追加到链表尾部（最新）
+- (void)_listAppend:(uint32_t)index {
+    AUCDiskCacheIndexSlot *slot = &_slots[index];
+    slot->prev = _header->tail;
+    slot->next = AUC_DISK_CACHE_INDEX_NIL;
+    if (_header->tail != AUC_DISK_CACHE_INDEX_NIL) {
+        _slots[_header->tail].next = index;
+    } else {
+        _header->head = index;
+    }
+    _header->tail = index;
+}
+
+/// 按排序时间从旧到新重新串联所有槽位（增量重建的索引项按目录顺序插入）
+///
+/// - Note: 先复制排序时间再用 `qsort` 排序，不依赖 `qsort_b`/`qsort_r` 这类各平台签名不同的接口
+- (void)_sortList {
+    uint64_t count = _header->count;
+    AUCDiskCacheIndexSortItem *items = malloc(MAX(count, 1) * sizeof(AUCDiskCacheIndexSortItem));
+    BOOL orderByAccessTime = _header->orderByAccessTime != 0;
+    uint64_t n = 0;
+    for (uint64_t i = 0; i < _header->capacity && n < count; i++) {
+        if (!(_slots[i].flags & AUC_DISK_CACHE_INDEX_SLOT_USED)) continue;
+        items[n].time = orderByAccessTime ? _slots[i].accessTime : _slots[i].modificationTime;
+        items[n].index = (uint32_t)i;
+        n++;
+    }
+    qsort(items, (size_t)n, sizeof(AUCDiskCacheIndexSortItem), AUCDiskCacheIndexCompareSortItems);
+    _header->head = AUC_DISK_CACHE_INDEX_NIL;
+    _header->tail = AUC_DISK_CACHE_INDEX_NIL;
+    for (uint64_t i = 0; i < n; i++) {
+        [self _listAppend:items[i].index];
+    }
+    free(items);
+}
+
+/// 槽位在表内移动后，修正相邻节点指向它的指针
+- (void)_listRelocateFrom:(uint32_t)from to:(uint32_t)to {
+    AUCDiskCacheIndexSlot *slot = &_slots[to];
+    if (slot->prev != AUC_DISK_CACHE_INDEX_NIL) {
+        _slots[slot->prev].next = to;
+    } else if (_header->head == from) {
+        _header->head = to;
+    }
+    if (slot->next != AUC_DISK_CACHE_INDEX_NIL) {
+        _slots[slot->next].prev = to;
+    } else if (_header->tail == from) {
+        _header->tail = to;
+    }
+}
+
+#pragma mark - 开放寻址（线性探测，调用方需持有锁）
+- (uint64_t)_indexOfDigest:(const unsigned char *)digest {
+    uint64_t mask = _header->capacity - 1;
+    uint64_t i = AUCDiskCacheIndexHash(digest) & mask;
+    while (_slots[i].flags & AUC_DISK_CACHE_INDEX_SLOT_USED) {
+        if (memcmp(_slots[i].digest, digest, AUC_DISK_CACHE_DIGEST_LENGTH) == 0) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return UINT64_MAX;
+}
+
+/// 扩容时按链表顺序重新插入，保持淘汰顺序不变
+///
+/// - Note: 增量重建期间也会扩容，重建标记、校验游标与排序方式需要保留，否则重建完成时不会重新排序，重建中途退出时残缺的索引也会被当作完整索引打开
+- (void)_growTable {
+    uint64_t capacity = _header->capacity;
+    uint32_t head = _header->head;
+    uint32_t recovering = _header->recovering;
+    uint32_t scrubPosition = _header->scrubPosition;
+    uint32_t orderByAccessTime = _header->orderByAccessTime;
+    size_t slotsLength = (size_t)(capacity * sizeof(AUCDiskCacheIndexSlot));
+    AUCDiskCacheIndexSlot *oldSlots = malloc(slotsLength);
+    memcpy(oldSlots, _slots, slotsLength);
+
+    [self _resetStorageWithCapacity:capacity << 1];
+    _header->recovering = recovering;
+    _header->scrubPosition = scrubPosition;
+    _header->orderByAccessTime = orderByAccessTime;
+    uint64_t mask = _header->capacity - 1;
+    for (uint32_t i = head; i != AUC_DISK_CACHE_INDEX_NIL; i = oldSlots[i].next) {
+        uint64_t j = AUCDiskCacheIndexHash(oldSlots[i].digest) & mask;
+        while (_slots[j].flags & AUC_DISK_CACHE_INDEX_SLOT_USED) j = (j + 1) & mask;
+        _slots[j] = oldSlots[i];
+        [self _listAppend:(uint32_t)j];
+        _header->count++;
+        _header->totalSize += oldSlots[i].size;
+    }
+    free(oldSlots);
+}
+
+/// 新增或覆盖索引项，并移动到淘汰链表尾部
+- (void)_setEntry:(const AUCDiskCacheIndexEntry *)entry {
+    uint64_t index = [self _indexOfDigest:entry->digest];
+    if (index == UINT64_MAX) {
+        // 装载因子上限 0.75
+        if ((_header->count + 1) * 4 > _header->capacity * 3) {
+            [self _growTable];
+        }
+        uint64_t mask = _header->capacity - 1;
+        index = AUCDiskCacheIndexHash(entry->digest) & mask;
+        while (_slots[index].flags & AUC_DISK_CACHE_INDEX_SLOT_USED) index = (index + 1) & mask;
+        _header->count++;
+    } else {
+        _header->totalSize -= _slots[index].size;
+        [self _listUnlink:(uint32_t)index];
+    }
+    AUCDiskCacheIndexSlot *slot = &_slots[index];
+    memcpy(slot->digest, entry->digest, AUC_DISK_CACHE_DIGEST_LENGTH);
+    slot->size = entry->size;
+    slot->creationTime = entry->creationTime;
+    slot->modificationTime = entry->modificationTime;
+    slot->accessTime = entry->accessTime;
+    slot->flags = entry->flags | AUC_DISK_CACHE_INDEX_SLOT_USED;
+    memcpy(slot->extension, entry->extension, sizeof(slot->extension));
+    slot->extension[AUC_DISK_CACHE_INDEX_MAX_EXTENSION_LENGTH] = '\0';
+    _header->totalSize += entry->size;
+    [self _listAppend:(uint32_t)index];
+}
+
+/// 删除槽位并做后移压缩（backward shift），避免墓碑标记导致探测链越来越长
+- (void)_removeSlotAtIndex:(uint64_t)index {
+    uint64_t mask = _header->capacity - 1;
+    _header->totalSize -= _slots[index].size;
+    [self _listUnlink:(uint32_t)index];
+
+    uint64_t i = index;
+    uint64_t j = index;
+    while (YES) {
+        j = (j + 1) & mask;
+        if (!(_slots[j].flags & AUC_DISK_CACHE_INDEX_SLOT_USED)) break;
+        uint64_t k = AUCDiskCacheIndexHash(_slots[j].digest) & mask;
+        // 理想位置 k 循环地落在 (i, j] 区间内时无需移动
+        BOOL inRange = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (inRange) continue;
+        _slots[i] = _slots[j];
+        [self _listRelocateFrom:(uint32_t)j to:(uint32_t)i];
+        i = j;
+    }
+    memset(&_slots[i], 0, sizeof(AUCDiskCacheIndexSlot));
+    _header->count--;
+}
+
+@end
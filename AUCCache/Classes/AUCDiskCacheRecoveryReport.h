@@ -0,0 +1,43 @@
+//
+//  AUCDiskCacheRecoveryReport.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/23.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``磁盘缓存启动恢复报告``
+///
+/// 记录一次启动恢复（元数据与数据文件对账、截断残缺记录、删除孤立临时文件）的耗时与修复数量
+@interface AUCDiskCacheRecoveryReport : NSObject
+
+/// 恢复是否已完成
+@property (nonatomic, assign) BOOL finished;
+
+/// 恢复实际占用 IO 队列的累计时间，单位为【秒】
+@property (nonatomic, assign) NSTimeInterval duration;
+
+/// 从开始到完成经过的时间（包含时间片之间让出 IO 队列的时间），单位为【秒】
+@property (nonatomic, assign) NSTimeInterval elapsedTime;
+
+/// 恢复被拆分成的时间片数量
+@property (nonatomic, assign) NSUInteger sliceCount;
+
+/// 修复的元数据数量（补齐、修正或删除的索引项）
+@property (nonatomic, assign) NSUInteger repairedEntryCount;
+
+/// 删除的孤立文件数量（崩溃遗留的临时文件、未被引用的数据文件）
+@property (nonatomic, assign) NSUInteger removedOrphanFileCount;
+
+/// 清除的残缺尾部字节数
+@property (nonatomic, assign) uint64_t truncatedByteCount;
+
+/// 从旧版本目录布局迁移的文件数量
+@property (nonatomic, assign) NSUInteger migratedFileCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
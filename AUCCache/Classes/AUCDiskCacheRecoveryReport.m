@@ -0,0 +1,19 @@
+//
+//  AUCDiskCacheRecoveryReport.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/23.
+//
+
+#import "AUCDiskCacheRecoveryReport.h"
+
+@implementation AUCDiskCacheRecoveryReport
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p; finished = %d; duration = %.3fs; elapsed = %.3fs; slices = %lu; repaired = %lu; orphans = %lu; truncated = %llu bytes; migrated = %lu>",
+            NSStringFromClass(self.class), self, self.finished, self.duration, self.elapsedTime,
+            (unsigned long)self.sliceCount, (unsigned long)self.repairedEntryCount,
+            (unsigned long)self.removedOrphanFileCount, self.truncatedByteCount, (unsigned long)self.migratedFileCount];
+}
+
+@end
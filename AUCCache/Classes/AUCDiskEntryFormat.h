@@ -0,0 +1,118 @@
+//
+//  AUCDiskEntryFormat.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/22.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 缓存文件头部长度
+#define AUC_DISK_ENTRY_HEADER_LENGTH 24
+
+/// 扩展数据长度字段的长度
+#define AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH 4
+
+typedef NS_OPTIONS(uint16_t, AUCDiskEntryFlags) {
+    /// 数据之后内联保存扩展数据：4 字节长度 + 扩展数据
+    AUCDiskEntryFlagExtendedData = 1 << 0,
+    /// 数据是相对基准版本的差量（`AUCCacheDelta`），需要与基准版本一起还原
+    AUCDiskEntryFlagDelta = 1 << 1,
+};
+
+/// 缓存文件头部，所有字段均为小端序
+typedef struct {
+    /// 'AUCE'
+    uint32_t magic;
+    uint16_t version;
+    /// `AUCDiskEntryFlags`，其余位预留给后续格式（例如压缩）使用
+    uint16_t flags;
+    /// 数据长度，不含头部与扩展数据
+    uint64_t length;
+    /// 头部之后全部内容（数据与扩展数据）的 CRC32C
+    uint32_t checksum;
+    /// 头部前 20 字节的 CRC32C，用于区分带头部的文件与恰好以 magic 开头的早期文件
+    uint32_t headerChecksum;
+} AUCDiskEntryHeader;
+
+typedef NS_ENUM(NSInteger, AUCDiskEntryStatus) {
+    /// 带头部且长度一致（要求校验时校验和也一致）
+    AUCDiskEntryStatusValid,
+    /// 早期版本写入的无头部文件，整个文件即为数据，无法校验
+    AUCDiskEntryStatusLegacy,
+    /// 长度不一致或校验失败，文件已被截断或损坏
+    AUCDiskEntryStatusCorrupt,
+};
+
+/// ``磁盘缓存文件格式``
+///
+/// 每个缓存文件由固定长度的头部、数据与可选的扩展数据组成
+/// ```
+/// cacheFile
+///    ├── header           magic、版本、标记位、数据长度、校验和、头部校验和（24 字节）
+///    ├── payload          调用方写入的原始数据
+///    ├── extendedLength   扩展数据长度（4 字节），仅在设置了 `AUCDiskEntryFlagExtendedData` 时存在
+///    ├── extendedData     扩展数据
+/// ```
+///
+/// - Note: 写入时总是计算校验和，读取时是否校验由 `AUCCacheConfig.diskCacheChecksumMode` 决定
+/// - Note: 没有合法头部的文件按早期格式处理，整个文件即为数据
+/// - Note: 格式迁移：早期版本写入的无头部文件不做转换，读取时按早期格式返回（无法校验），后台校验跳过这些文件，文件被重新写入时才带上头部。
+///   降级到不认识头部的早期版本前需要先清空磁盘缓存，否则头部会被当作数据读出
+/// - Note: 扩展数据与数据在同一次写入中落盘，早期版本保存在扩展属性（xattr）中
+@interface AUCDiskEntryFormat : NSObject
+
+/// 在数据前拼接头部，生成待写入文件的内容
++ (nonnull NSData *)entryDataWithData:(nonnull NSData *)data;
+
+/// 拼接头部、数据与扩展数据，生成待写入文件的内容
+///
+/// - Parameters:
+///     - data: 数据
+///     - extendedData: 扩展数据，为 nil 时与 `entryDataWithData:` 相同
++ (nonnull NSData *)entryDataWithData:(nonnull NSData *)data extendedData:(nullable NSData *)extendedData;
+
+/// 拼接头部、数据与扩展数据，并在头部设置额外的标记位
+///
+/// - Parameter flags: 额外的标记位，`AUCDiskEntryFlagExtendedData` 由 `extendedData` 决定，无需设置
++ (nonnull NSData *)entryDataWithData:(nonnull NSData *)data extendedData:(nullable NSData *)extendedData flags:(AUCDiskEntryFlags)flags;
+
+/// 文件头部的标记位，没有合法头部时返回 0
++ (AUCDiskEntryFlags)flagsOfEntryData:(nonnull NSData *)entryData;
+
+/// 从文件内容中取出数据，不拷贝，返回的数据持有 `entryData`
+///
+/// - Parameters:
+///     - entryData: 文件内容，可以是内存映射数据
+///     - verify: 是否计算并比对校验和
+///     - status: 返回文件状态，可为 NULL
+/// - Returns: 数据，文件损坏时返回 nil
++ (nullable NSData *)payloadOfEntryData:(nonnull NSData *)entryData verify:(BOOL)verify status:(nullable AUCDiskEntryStatus *)status;
+
+/// 从文件内容中取出数据与扩展数据，均不拷贝
+///
+/// - Parameters:
+///     - entryData: 文件内容，可以是内存映射数据
+///     - extendedData: 返回扩展数据，没有内联扩展数据时为 nil，可为 NULL
+///     - verify: 是否计算并比对校验和
+///     - status: 返回文件状态，可为 NULL
+/// - Returns: 数据，文件损坏时返回 nil
++ (nullable NSData *)payloadOfEntryData:(nonnull NSData *)entryData extendedData:(NSData * _Nullable * _Nullable)extendedData verify:(BOOL)verify status:(nullable AUCDiskEntryStatus *)status;
+
+/// 只读取文件头部与扩展数据，不读取数据
+///
+/// - Parameters:
+///     - path: 文件路径
+///     - status: 返回文件状态，可为 NULL；文件无法打开时为 `AUCDiskEntryStatusCorrupt`
+/// - Returns: 扩展数据，没有内联扩展数据或文件损坏时返回 nil
+/// - Note: 不读取数据就无法计算校验和，只校验头部与长度
++ (nullable NSData *)extendedDataOfFileAtPath:(nonnull NSString *)path status:(nullable AUCDiskEntryStatus *)status;
+
+/// 分块读取并校验文件，不会把整个文件读入内存，文件无法打开时返回 `AUCDiskEntryStatusCorrupt`
++ (AUCDiskEntryStatus)verifyFileAtPath:(nonnull NSString *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
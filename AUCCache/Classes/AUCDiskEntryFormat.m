@@ -0,0 +1,217 @@
+//
+//  AUCDiskEntryFormat.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/22.
+//
+
+#import "AUCDiskEntryFormat.h"
+#import "AUCChecksum.h"
+#import "AUCIOAdvice.h"
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/stat.h>
+
+// 'AUCE'
+static const uint32_t AUC_DISK_ENTRY_MAGIC = 0x45435541;
+static const uint16_t AUC_DISK_ENTRY_VERSION = 1;
+// 校验文件时每次读取的长度
+static const size_t AUC_DISK_ENTRY_VERIFY_CHUNK = 64 * 1024;
+
+_Static_assert(sizeof(AUCDiskEntryHeader) == AUC_DISK_ENTRY_HEADER_LENGTH, "entry header must be 24 bytes");
+
+static inline uint32_t AUCDiskEntryHeaderChecksum(const AUCDiskEntryHeader *header) {
+    return AUCCRC32C(0, header, offsetof(AUCDiskEntryHeader, headerChecksum));
+}
+
+/// 解析头部，没有合法头部时返回 NO
+static BOOL AUCDiskEntryReadHeader(const void *bytes, uint64_t fileLength, AUCDiskEntryHeader *header) {
+    if (fileLength < AUC_DISK_ENTRY_HEADER_LENGTH) return NO;
+    memcpy(header, bytes, AUC_DISK_ENTRY_HEADER_LENGTH);
+    return header->magic == AUC_DISK_ENTRY_MAGIC && header->headerChecksum == AUCDiskEntryHeaderChecksum(header);
+}
+
+/// 扩展数据长度字段在文件中的偏移，文件长度不足以容纳数据与长度字段时返回 NO
+static BOOL AUCDiskEntryGetExtendedLengthOffset(const AUCDiskEntryHeader *header, uint64_t fileLength, uint64_t *offset) {
+    uint64_t bodyLength = fileLength - AUC_DISK_ENTRY_HEADER_LENGTH;
+    if (header->length > bodyLength || bodyLength - header->length < AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH) return NO;
+    *offset = AUC_DISK_ENTRY_HEADER_LENGTH + header->length;
+    return YES;
+}
+
+/// 不拷贝地截取一段数据，返回的数据持有原数据，映射数据也无需拷贝
+static NSData *AUCDiskEntrySubdata(NSData *data, uint64_t offset, uint64_t length) {
+    return [[NSData alloc] initWithBytesNoCopy:(uint8_t *)data.bytes + offset length:(NSUInteger)length deallocator:^(void *bytes, NSUInteger length) {
+        (void)data;
+    }];
+}
+
+@implementation AUCDiskEntryFormat
+
++ (NSData *)entryDataWithData:(NSData *)data {
+    return [self entryDataWithData:data extendedData:nil];
+}
+
++ (NSData *)entryDataWithData:(NSData *)data extendedData:(NSData *)extendedData {
+    return [self entryDataWithData:data extendedData:extendedData flags:0];
+}
+
++ (NSData *)entryDataWithData:(NSData *)data extendedData:(NSData *)extendedData flags:(AUCDiskEntryFlags)flags {
+    NSParameterAssert(extendedData.length <= UINT32_MAX);
+    AUCDiskEntryHeader header = {0};
+    header.magic = AUC_DISK_ENTRY_MAGIC;
+    header.version = AUC_DISK_ENTRY_VERSION;
+    header.flags = flags & ~AUCDiskEntryFlagExtendedData;
+    header.length = data.length;
+    header.checksum = AUCCRC32C(0, data.bytes, data.length);
+    uint32_t extendedLength = (uint32_t)extendedData.length;
+    if (extendedData) {
+        header.flags |= AUCDiskEntryFlagExtendedData;
+        header.checksum = AUCCRC32C(header.checksum, &extendedLength, AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH);
+        header.checksum = AUCCRC32C(header.checksum, extendedData.bytes, extendedLength);
+    }
+    header.headerChecksum = AUCDiskEntryHeaderChecksum(&header);
+
+    NSUInteger capacity = AUC_DISK_ENTRY_HEADER_LENGTH + data.length + (extendedData ? AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH + extendedLength : 0);
+    NSMutableData *entryData = [NSMutableData dataWithCapacity:capacity];
+    [entryData appendBytes:&header length:AUC_DISK_ENTRY_HEADER_LENGTH];
+    [entryData appendData:data];
+    if (extendedData) {
+        [entryData appendBytes:&extendedLength length:AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH];
+        [entryData appendData:extendedData];
+    }
+    return entryData;
+}
+
++ (AUCDiskEntryFlags)flagsOfEntryData:(NSData *)entryData {
+    AUCDiskEntryHeader header;
+    return AUCDiskEntryReadHeader(entryData.bytes, entryData.length, &header) ? header.flags : 0;
+}
+
++ (NSData *)payloadOfEntryData:(NSData *)entryData verify:(BOOL)verify status:(AUCDiskEntryStatus *)status {
+    return [self payloadOfEntryData:entryData extendedData:NULL verify:verify status:status];
+}
+
++ (NSData *)payloadOfEntryData:(NSData *)entryData extendedData:(NSData **)extendedData verify:(BOOL)verify status:(AUCDiskEntryStatus *)status {
+    if (extendedData) *extendedData = nil;
+    AUCDiskEntryHeader header;
+    if (!AUCDiskEntryReadHeader(entryData.bytes, entryData.length, &header)) {
+        if (status) *status = AUCDiskEntryStatusLegacy;
+        return entryData;
+    }
+    const uint8_t *bytes = entryData.bytes;
+    uint64_t extendedOffset = 0;
+    uint32_t extendedLength = 0;
+    BOOL valid;
+    if (header.flags & AUCDiskEntryFlagExtendedData) {
+        valid = AUCDiskEntryGetExtendedLengthOffset(&header, entryData.length, &extendedOffset);
+        if (valid) {
+            memcpy(&extendedLength, bytes + extendedOffset, AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH);
+            valid = entryData.length - extendedOffset - AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH == extendedLength;
+        }
+    } else {
+        valid = header.length == entryData.length - AUC_DISK_ENTRY_HEADER_LENGTH;
+    }
+    valid = valid && (!verify || header.checksum == AUCCRC32C(0, bytes + AUC_DISK_ENTRY_HEADER_LENGTH, entryData.length - AUC_DISK_ENTRY_HEADER_LENGTH));
+    if (!valid) {
+        if (status) *status = AUCDiskEntryStatusCorrupt;
+        return nil;
+    }
+    if (status) *status = AUCDiskEntryStatusValid;
+    if (extendedData && (header.flags & AUCDiskEntryFlagExtendedData)) {
+        *extendedData = AUCDiskEntrySubdata(entryData, extendedOffset + AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH, extendedLength);
+    }
+    return AUCDiskEntrySubdata(entryData, AUC_DISK_ENTRY_HEADER_LENGTH, header.length);
+}
+
++ (NSData *)extendedDataOfFileAtPath:(NSString *)path status:(AUCDiskEntryStatus *)status {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (status) *status = AUCDiskEntryStatusCorrupt;
+        return nil;
+    }
+    AUCDiskEntryStatus entryStatus = AUCDiskEntryStatusCorrupt;
+    NSData *extendedData = nil;
+    struct stat st;
+    uint8_t headerBytes[AUC_DISK_ENTRY_HEADER_LENGTH];
+    AUCDiskEntryHeader header;
+    uint64_t extendedOffset;
+    if (fstat(fd, &st) != 0) {
+        entryStatus = AUCDiskEntryStatusCorrupt;
+    } else if (pread(fd, headerBytes, AUC_DISK_ENTRY_HEADER_LENGTH, 0) != AUC_DISK_ENTRY_HEADER_LENGTH
+               || !AUCDiskEntryReadHeader(headerBytes, (uint64_t)st.st_size, &header)) {
+        entryStatus = AUCDiskEntryStatusLegacy;
+    } else if (!(header.flags & AUCDiskEntryFlagExtendedData)) {
+        if (header.length == (uint64_t)st.st_size - AUC_DISK_ENTRY_HEADER_LENGTH) {
+            entryStatus = AUCDiskEntryStatusValid;
+        }
+    } else if (AUCDiskEntryGetExtendedLengthOffset(&header, (uint64_t)st.st_size, &extendedOffset)) {
+        // 长度字段与扩展数据位于文件末尾，一次读出
+        NSMutableData *trailer = [NSMutableData dataWithLength:(NSUInteger)((uint64_t)st.st_size - extendedOffset)];
+        uint32_t extendedLength;
+        if (pread(fd, trailer.mutableBytes, trailer.length, (off_t)extendedOffset) == (ssize_t)trailer.length) {
+            memcpy(&extendedLength, trailer.bytes, AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH);
+            if (trailer.length - AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH == extendedLength) {
+                extendedData = AUCDiskEntrySubdata(trailer, AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH, extendedLength);
+                entryStatus = AUCDiskEntryStatusValid;
+            }
+        }
+    }
+    close(fd);
+    if (status) *status = entryStatus;
+    return extendedData;
+}
+
++ (AUCDiskEntryStatus)verifyFileAtPath:(NSString *)path {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return AUCDiskEntryStatusCorrupt;
+    // 校验读取的数据不会再次使用，不进入页缓存
+    AUCIOAdviseFile(fd, 0, 0, AUCIOAccessPatternNoReuse);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return AUCDiskEntryStatusCorrupt;
+    }
+    uint8_t headerBytes[AUC_DISK_ENTRY_HEADER_LENGTH];
+    AUCDiskEntryHeader header;
+    if (pread(fd, headerBytes, AUC_DISK_ENTRY_HEADER_LENGTH, 0) != AUC_DISK_ENTRY_HEADER_LENGTH
+        || !AUCDiskEntryReadHeader(headerBytes, (uint64_t)st.st_size, &header)) {
+        close(fd);
+        return AUCDiskEntryStatusLegacy;
+    }
+    BOOL lengthMatches;
+    if (header.flags & AUCDiskEntryFlagExtendedData) {
+        uint64_t extendedOffset;
+        uint32_t extendedLength;
+        lengthMatches = AUCDiskEntryGetExtendedLengthOffset(&header, (uint64_t)st.st_size, &extendedOffset)
+            && pread(fd, &extendedLength, AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH, (off_t)extendedOffset) == AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH
+            && (uint64_t)st.st_size - extendedOffset - AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH == extendedLength;
+    } else {
+        lengthMatches = header.length == (uint64_t)st.st_size - AUC_DISK_ENTRY_HEADER_LENGTH;
+    }
+    if (!lengthMatches) {
+        close(fd);
+        return AUCDiskEntryStatusCorrupt;
+    }
+
+    uint8_t *buffer = malloc(AUC_DISK_ENTRY_VERIFY_CHUNK);
+    uint32_t checksum = 0;
+    off_t offset = AUC_DISK_ENTRY_HEADER_LENGTH;
+    BOOL readFailed = NO;
+    while (offset < st.st_size) {
+        ssize_t n = pread(fd, buffer, AUC_DISK_ENTRY_VERIFY_CHUNK, offset);
+        if (n <= 0) {
+            readFailed = YES;
+            break;
+        }
+        checksum = AUCCRC32C(checksum, buffer, (size_t)n);
+        offset += n;
+    }
+    free(buffer);
+    AUCIOAdviseFileDone(fd, 0, 0);
+    close(fd);
+    return (!readFailed && checksum == header.checksum) ? AUCDiskEntryStatusValid : AUCDiskEntryStatusCorrupt;
+}
+
+@end
@@ -0,0 +1,75 @@
+//
+//  AUCDiskWriteBatcher.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/21.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCTypeDefines.h"
+
+@class AUCIOScheduler;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 将待写入对象编码为磁盘数据（包括按键选择压缩方式），编码失败返回 nil
+typedef NSData * _Nullable (^AUCDiskWriteEncodeBlock)(id object, NSString *key);
+/// 提交一批已编码的数据，在 IO 调度器的独占任务中调用
+typedef void (^AUCDiskWriteCommitBlock)(NSDictionary<NSString *, NSData *> *dataBatch);
+
+/// ``磁盘写入批处理器（组提交）``
+///
+/// 收集一个时间窗口内（或累计达到字节阈值前）的写入请求，窗口结束后以 IO 调度器的独占任务（write-back 优先级）统一提交
+/// ```
+/// addObject:forKey:  ──►  待写入表（同一个键只保留最后一次写入）
+///                              │ 时间窗口结束 / 超过字节阈值
+///                              ▼
+///                     并行编码 ──► 一次提交 ──► 依次回调每个调用方的 completion
+/// ```
+///
+/// - Note: 窗口内对同一个键的多次写入会合并为一次，所有调用方的 completion 都会在该次写入完成后回调
+/// - Note: 落盘前（包括编码与提交过程中）的数据可以通过 `pendingDataForKey:` 读取，保证写入后立即读取能读到最新数据
+@interface AUCDiskWriteBatcher : NSObject
+
+/// - Parameters:
+///     - scheduler: IO 调度器，编码后的提交总是作为其独占任务执行
+///     - interval: 收集窗口，单位为【秒】
+///     - byteLimit: 待写入数据的估算字节数达到该值时立即提交，0 表示不限制
+///     - encodeBlock: 编码方法，会在多个线程中并行调用
+///     - commitBlock: 提交方法
+- (nonnull instancetype)initWithScheduler:(nonnull AUCIOScheduler *)scheduler
+                                 interval:(NSTimeInterval)interval
+                                byteLimit:(NSUInteger)byteLimit
+                              encodeBlock:(nonnull AUCDiskWriteEncodeBlock)encodeBlock
+                              commitBlock:(nonnull AUCDiskWriteCommitBlock)commitBlock NS_DESIGNATED_INITIALIZER;
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/// 加入一次写入，可在任意线程调用
+///
+/// - Parameters:
+///     - object: 待写入的对象，提交时才会编码
+///     - key: 缓存键
+///     - bytes: 估算的字节数，用于判断是否达到字节阈值
+///     - completion: 写入完成（或被丢弃）后在完成的线程直接调用，不切换线程；回调队列由调用方决定（参考 `AUCCallbackExecutor`）
+- (void)addObject:(nonnull id)object forKey:(nonnull NSString *)key estimatedBytes:(NSUInteger)bytes completion:(nullable AUCVoidParamsBlock)completion;
+
+/// 键是否有尚未落盘的写入
+- (BOOL)hasPendingWriteForKey:(nonnull NSString *)key;
+
+/// 尚未提交的写入编码后的数据，编码结果会被保留，提交时不再重复编码
+- (nullable NSData *)pendingDataForKey:(nonnull NSString *)key;
+
+/// 丢弃键尚未落盘的写入（例如该键随后被删除或被同步写入覆盖），其 completion 仍会回调
+- (void)discardPendingWriteForKey:(nonnull NSString *)key;
+
+/// 丢弃所有尚未落盘的写入，其 completion 仍会回调
+- (void)discardAllPendingWrites;
+
+/// 立即提交所有待写入数据
+///
+/// - Warning: 必须在初始化时传入的 IO 调度器的屏障任务或独占任务中调用
+- (void)flush;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,215 @@
+//
+//  AUCDiskWriteBatcher.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/21.
+//
+
+#import "AUCDiskWriteBatcher.h"
+#import "AUCInternalMacros.h"
+#import "AUCIOScheduler.h"
+
+/// 待提交的写入
+@interface _AUCPendingWrite : NSObject
+
+@property (nonatomic, copy, nonnull) NSString *key;
+@property (nonatomic, strong, nonnull) id object;
+@property (nonatomic, assign) NSUInteger bytes;
+/// 编码结果，在读取或提交时生成
+@property (nonatomic, strong, nullable) NSData *encodedData;
+@property (nonatomic, assign) BOOL encoded;
+/// 提交前被丢弃，不再写入磁盘
+@property (nonatomic, assign) BOOL discarded;
+@property (nonatomic, strong, nonnull) NSMutableArray<AUCVoidParamsBlock> *completions;
+
+@end
+
+@implementation _AUCPendingWrite
+@end
+
+@interface AUCDiskWriteBatcher ()
+
+@property (nonatomic, strong, nonnull) AUCIOScheduler *scheduler;
+@property (nonatomic, assign) NSTimeInterval interval;
+@property (nonatomic, assign) NSUInteger byteLimit;
+@property (nonatomic, copy, nonnull) AUCDiskWriteEncodeBlock encodeBlock;
+@property (nonatomic, copy, nonnull) AUCDiskWriteCommitBlock commitBlock;
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t lock;
+/// 键 -> 待写入，按加入顺序提交
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSString *, _AUCPendingWrite *> *pendingWrites;
+@property (nonatomic, strong, nonnull) NSMutableArray<NSString *> *pendingKeys;
+@property (nonatomic, assign) NSUInteger pendingBytes;
+/// 键 -> 已取出、正在编码与提交的写入，提交完成前仍可读取
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSString *, _AUCPendingWrite *> *committingWrites;
+/// 已安排的提交，避免重复安排
+@property (nonatomic, assign) BOOL flushScheduled;
+
+@end
+
+@implementation AUCDiskWriteBatcher
+
+- (instancetype)initWithScheduler:(AUCIOScheduler *)scheduler
+                         interval:(NSTimeInterval)interval
+                        byteLimit:(NSUInteger)byteLimit
+                      encodeBlock:(AUCDiskWriteEncodeBlock)encodeBlock
+                      commitBlock:(AUCDiskWriteCommitBlock)commitBlock {
+    if (self = [super init]) {
+        _scheduler = scheduler;
+        _interval = interval;
+        _byteLimit = byteLimit;
+        _encodeBlock = [encodeBlock copy];
+        _commitBlock = [commitBlock copy];
+        _lock = dispatch_semaphore_create(1);
+        _pendingWrites = [NSMutableDictionary dictionary];
+        _pendingKeys = [NSMutableArray array];
+        _committingWrites = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)addObject:(id)object forKey:(NSString *)key estimatedBytes:(NSUInteger)bytes completion:(AUCVoidParamsBlock)completion {
+    BOOL flushNow = NO;
+    BOOL scheduleFlush = NO;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _AUCPendingWrite *previous = self.pendingWrites[key];
+    // 窗口内重复写入同一个键，只保留最后一次；替换而非修改原对象，避免与正在进行的编码竞争
+    _AUCPendingWrite *write = [_AUCPendingWrite new];
+    write.key = key;
+    write.object = object;
+    write.bytes = bytes;
+    write.completions = previous ? previous.completions : [NSMutableArray array];
+    if (previous) {
+        self.pendingBytes -= previous.bytes;
+    } else {
+        [self.pendingKeys addObject:key];
+    }
+    self.pendingWrites[key] = write;
+    if (completion) [write.completions addObject:[completion copy]];
+    self.pendingBytes += bytes;
+
+    if (self.byteLimit > 0 && self.pendingBytes >= self.byteLimit) {
+        flushNow = YES;
+    } else if (!self.flushScheduled) {
+        self.flushScheduled = YES;
+        scheduleFlush = YES;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+
+    // 一批写入涉及多个键，以独占任务提交；提交完成前数据仍可从 `committingWrites` 读取，不需要与读取严格排序
+    if (flushNow) {
+        [self.scheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityWriteBack block:^{
+            [self flush];
+        }];
+    } else if (scheduleFlush) {
+        [self.scheduler dispatchExclusiveAfter:dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.interval * NSEC_PER_SEC)) priority:AUCIOPriorityWriteBack block:^{
+            [self flush];
+        }];
+    }
+}
+
+- (BOOL)hasPendingWriteForKey:(NSString *)key {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    BOOL pending = self.pendingWrites[key] != nil || self.committingWrites[key] != nil;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return pending;
+}
+
+- (NSData *)pendingDataForKey:(NSString *)key {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _AUCPendingWrite *write = self.pendingWrites[key] ?: self.committingWrites[key];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    if (!write) return nil;
+    [self encodeWrite:write];
+    return write.encodedData;
+}
+
+- (void)discardPendingWriteForKey:(NSString *)key {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _AUCPendingWrite *write = self.pendingWrites[key];
+    if (write) {
+        self.pendingBytes -= write.bytes;
+        [self.pendingWrites removeObjectForKey:key];
+        [self.pendingKeys removeObject:key];
+    }
+    // 正在提交的写入不再落盘，其 completion 由提交方回调
+    self.committingWrites[key].discarded = YES;
+    [self.committingWrites removeObjectForKey:key];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    if (write) [self callCompletionsOfWrites:@[write]];
+}
+
+- (void)discardAllPendingWrites {
+    NSArray<_AUCPendingWrite *> *writes = [self takePendingWritesForCommit:NO];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    for (_AUCPendingWrite *write in self.committingWrites.allValues) {
+        write.discarded = YES;
+    }
+    [self.committingWrites removeAllObjects];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    [self callCompletionsOfWrites:writes];
+}
+
+- (void)flush {
+    NSArray<_AUCPendingWrite *> *writes = [self takePendingWritesForCommit:YES];
+    if (writes.count == 0) return;
+
+    // 并行编码，编码是纯 CPU 操作，与 IO 队列中的其他任务无关
+    dispatch_apply(writes.count, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(size_t i) {
+        @autoreleasepool {
+            [self encodeWrite:writes[i]];
+        }
+    });
+
+    NSMutableDictionary<NSString *, NSData *> *dataBatch = [NSMutableDictionary dictionaryWithCapacity:writes.count];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    for (_AUCPendingWrite *write in writes) {
+        if (write.encodedData && !write.discarded) dataBatch[write.key] = write.encodedData;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    if (dataBatch.count > 0) {
+        self.commitBlock(dataBatch);
+    }
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    for (_AUCPendingWrite *write in writes) {
+        if (self.committingWrites[write.key] == write) [self.committingWrites removeObjectForKey:write.key];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    [self callCompletionsOfWrites:writes];
+}
+
+#pragma mark - Private
+/// 取出所有待写入，`commit` 为 YES 时移入 `committingWrites`
+- (NSArray<_AUCPendingWrite *> *)takePendingWritesForCommit:(BOOL)commit {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSMutableArray<_AUCPendingWrite *> *writes = [NSMutableArray arrayWithCapacity:self.pendingKeys.count];
+    for (NSString *key in self.pendingKeys) {
+        _AUCPendingWrite *write = self.pendingWrites[key];
+        [writes addObject:write];
+        if (commit) self.committingWrites[key] = write;
+    }
+    [self.pendingWrites removeAllObjects];
+    [self.pendingKeys removeAllObjects];
+    self.pendingBytes = 0;
+    self.flushScheduled = NO;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return writes;
+}
+
+- (void)encodeWrite:(_AUCPendingWrite *)write {
+    @synchronized (write) {
+        if (write.encoded) return;
+        write.encodedData = self.encodeBlock(write.object, write.key);
+        write.encoded = YES;
+    }
+}
+
+/// 在当前线程依次回调，由调用方的执行器决定回调队列；主队列执行器会把一批回调合并为一次派发
+- (void)callCompletionsOfWrites:(NSArray<_AUCPendingWrite *> *)writes {
+    for (_AUCPendingWrite *write in writes) {
+        for (AUCVoidParamsBlock completion in write.completions) {
+            completion();
+        }
+    }
+}
+
+@end
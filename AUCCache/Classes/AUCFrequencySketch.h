@@ -0,0 +1,41 @@
+//
+//  AUCFrequencySketch.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/08.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``访问频率草图（Count-Min Sketch）``
+///
+/// 以 4 位计数器估算键的近期访问频率，用于 W-TinyLFU 准入判断
+/// 每个 64 位字包含 16 个计数器，每个键在 4 行中各占一个计数器，频率取 4 者最小值
+///
+/// - Note: 累计增加次数达到 `10 * 宽度` 后，所有计数器减半（老化），使频率偏向近期访问
+/// - Warning: 非线程安全，需由调用方加锁
+@interface AUCFrequencySketch : NSObject
+
+/// 根据预期容纳的数据量创建草图
+///
+/// - Parameter maximumSize: 预期容纳的最大数据量，决定计数器表宽度
+- (nonnull instancetype)initWithMaximumSize:(NSUInteger)maximumSize NS_DESIGNATED_INITIALIZER;
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/// 预期容量变化时调整表宽度，调整后历史频率会被清空
+- (void)ensureCapacity:(NSUInteger)maximumSize;
+
+/// 记录一次访问
+- (void)increment:(uint64_t)hash;
+
+/// 估算访问频率，取值范围 0 ~ 15
+- (NSUInteger)frequency:(uint64_t)hash;
+
+/// 清空所有计数
+- (void)clear;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,101 @@
+//
+//  AUCFrequencySketch.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/08.
+//
+
+#import "AUCFrequencySketch.h"
+
+// 每行使用不同的种子，使 4 个计数器位置相互独立
+static const uint64_t AUCFrequencySketchSeeds[4] = {
+    0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL
+};
+// 减半时清除每个 4 位计数器移入的最高位
+static const uint64_t AUCFrequencySketchResetMask = 0x7777777777777777ULL;
+// 表宽度上限（字数）
+static const NSUInteger AUCFrequencySketchMaxWidth = 1 << 22;
+
+@implementation AUCFrequencySketch {
+    uint64_t *_table;
+    NSUInteger _tableMask;
+    NSUInteger _sampleSize;
+    NSUInteger _size;
+}
+
+- (instancetype)initWithMaximumSize:(NSUInteger)maximumSize {
+    if (self = [super init]) {
+        [self ensureCapacity:maximumSize];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_table);
+}
+
+- (void)ensureCapacity:(NSUInteger)maximumSize {
+    NSUInteger width = 1;
+    NSUInteger target = MIN(MAX(maximumSize, 16), AUCFrequencySketchMaxWidth);
+    while (width < target) width <<= 1;
+    if (_table && width == _tableMask + 1) return;
+
+    free(_table);
+    _table = calloc(width, sizeof(uint64_t));
+    _tableMask = width - 1;
+    _sampleSize = 10 * width;
+    _size = 0;
+}
+
+static inline NSUInteger AUCFrequencySketchIndex(uint64_t hash, int row, NSUInteger mask) {
+    uint64_t h = (hash + AUCFrequencySketchSeeds[row]) * AUCFrequencySketchSeeds[row];
+    h += h >> 32;
+    return (NSUInteger)h & mask;
+}
+
+static inline int AUCFrequencySketchOffset(uint64_t hash, int row) {
+    // 取哈希不同的 4 位作为字内计数器序号，再乘以 4 得到位偏移
+    return (int)((hash >> (row << 3)) & 15) << 2;
+}
+
+- (void)increment:(uint64_t)hash {
+    BOOL added = NO;
+    for (int row = 0; row < 4; row++) {
+        NSUInteger index = AUCFrequencySketchIndex(hash, row, _tableMask);
+        int offset = AUCFrequencySketchOffset(hash, row);
+        uint64_t mask = 0xfULL << offset;
+        if ((_table[index] & mask) != mask) {
+            _table[index] += 1ULL << offset;
+            added = YES;
+        }
+    }
+    if (added && ++_size >= _sampleSize) {
+        [self reset];
+    }
+}
+
+- (NSUInteger)frequency:(uint64_t)hash {
+    NSUInteger frequency = 15;
+    for (int row = 0; row < 4; row++) {
+        NSUInteger index = AUCFrequencySketchIndex(hash, row, _tableMask);
+        int offset = AUCFrequencySketchOffset(hash, row);
+        NSUInteger count = (NSUInteger)((_table[index] >> offset) & 0xf);
+        frequency = MIN(frequency, count);
+    }
+    return frequency;
+}
+
+/// 老化：所有计数器减半
+- (void)reset {
+    for (NSUInteger i = 0; i <= _tableMask; i++) {
+        _table[i] = (_table[i] >> 1) & AUCFrequencySketchResetMask;
+    }
+    _size = _size / 2;
+}
+
+- (void)clear {
+    memset(_table, 0, (_tableMask + 1) * sizeof(uint64_t));
+    _size = 0;
+}
+
+@end
@@ -0,0 +1,55 @@
+//
+//  AUCIOAdvice.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/24.
+//
+
+#ifndef AUCIOAdvice_h
+#define AUCIOAdvice_h
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``磁盘访问模式``，用于向内核提示页缓存的使用方式
+///
+/// ```
+///                    Darwin                          其他平台
+/// WillNeed     F_RDADVISE 异步预读            POSIX_FADV_WILLNEED / MADV_WILLNEED
+/// Sequential   F_RDAHEAD + F_NOCACHE          POSIX_FADV_SEQUENTIAL，读完 POSIX_FADV_DONTNEED / MADV_SEQUENTIAL
+/// NoReuse      F_NOCACHE                      POSIX_FADV_NOREUSE，读完 POSIX_FADV_DONTNEED
+/// ```
+typedef NS_ENUM(NSInteger, AUCIOAccessPattern) {
+    /// 不提示
+    AUCIOAccessPatternNormal,
+    /// 即将读取（预热、批量读取），提前在后台顺序预读
+    AUCIOAccessPatternWillNeed,
+    /// 顺序读取一次后不再使用（大数据的一次性读取），读取后不保留在页缓存中
+    AUCIOAccessPatternSequential,
+    /// 扫描（校验、压缩整理），不进入页缓存，避免挤出应用反复使用的页
+    AUCIOAccessPatternNoReuse,
+};
+
+/// 为文件描述符的一段区域设置访问模式
+///
+/// - Parameters:
+///     - fd: 文件描述符
+///     - offset: 区域起始偏移
+///     - length: 区域长度，0 表示到文件末尾
+///     - pattern: 访问模式
+/// - Note: Darwin 的 `F_NOCACHE`、`F_RDAHEAD` 作用于整个文件描述符，而非指定区域
+FOUNDATION_EXTERN void AUCIOAdviseFile(int fd, uint64_t offset, uint64_t length, AUCIOAccessPattern pattern);
+
+/// 读取完成后释放区域在页缓存中的页（`AUCIOAccessPatternSequential`、`AUCIOAccessPatternNoReuse`），Darwin 上读取时已绕过页缓存，无需处理
+FOUNDATION_EXTERN void AUCIOAdviseFileDone(int fd, uint64_t offset, uint64_t length);
+
+/// 为内存映射区域设置访问模式，地址无需按页对齐
+FOUNDATION_EXTERN void AUCIOAdviseMemory(const void *address, size_t length, AUCIOAccessPattern pattern);
+
+/// 提示即将读取整个文件，在后台异步预读，不阻塞调用线程
+FOUNDATION_EXTERN void AUCIOPrefetchFile(NSString *path);
+
+NS_ASSUME_NONNULL_END
+
+#endif /* AUCIOAdvice_h */
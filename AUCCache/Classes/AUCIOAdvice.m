@@ -0,0 +1,93 @@
+//
+//  AUCIOAdvice.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/24.
+//
+
+#import "AUCIOAdvice.h"
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+
+void AUCIOAdviseFile(int fd, uint64_t offset, uint64_t length, AUCIOAccessPattern pattern) {
+    if (fd < 0) return;
+#if defined(__APPLE__)
+    switch (pattern) {
+        case AUCIOAccessPatternWillNeed: {
+            if (length == 0) {
+                struct stat st;
+                if (fstat(fd, &st) != 0 || (uint64_t)st.st_size <= offset) return;
+                length = (uint64_t)st.st_size - offset;
+            }
+            // `ra_count` 为 int，超出部分按 INT_MAX 预读
+            struct radvisory advisory = {
+                .ra_offset = (off_t)offset,
+                .ra_count = (int)MIN(length, (uint64_t)INT_MAX),
+            };
+            fcntl(fd, F_RDADVISE, &advisory);
+            break;
+        }
+        case AUCIOAccessPatternSequential:
+            fcntl(fd, F_RDAHEAD, 1);
+            fcntl(fd, F_NOCACHE, 1);
+            break;
+        case AUCIOAccessPatternNoReuse:
+            fcntl(fd, F_NOCACHE, 1);
+            break;
+        default:
+            break;
+    }
+#else
+    switch (pattern) {
+        case AUCIOAccessPatternWillNeed:
+            posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+            break;
+        case AUCIOAccessPatternSequential:
+            posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_SEQUENTIAL);
+            break;
+        case AUCIOAccessPatternNoReuse:
+            posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_NOREUSE);
+            break;
+        default:
+            break;
+    }
+#endif
+}
+
+void AUCIOAdviseFileDone(int fd, uint64_t offset, uint64_t length) {
+    if (fd < 0) return;
+#if !defined(__APPLE__)
+    posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_DONTNEED);
+#endif
+}
+
+void AUCIOAdviseMemory(const void *address, size_t length, AUCIOAccessPattern pattern) {
+    if (!address || length == 0) return;
+    int advice;
+    switch (pattern) {
+        case AUCIOAccessPatternWillNeed:
+            advice = MADV_WILLNEED;
+            break;
+        case AUCIOAccessPatternSequential:
+        case AUCIOAccessPatternNoReuse:
+            // 顺序访问时内核可以积极预读，并优先回收已经访问过的页
+            advice = MADV_SEQUENTIAL;
+            break;
+        default:
+            return;
+    }
+    // madvise 要求地址按页对齐
+    uintptr_t pageMask = (uintptr_t)getpagesize() - 1;
+    uintptr_t start = (uintptr_t)address & ~pageMask;
+    madvise((void *)start, length + ((uintptr_t)address - start), advice);
+}
+
+void AUCIOPrefetchFile(NSString *path) {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    // 预读请求提交后即可关闭，读入的页保留在页缓存中
+    AUCIOAdviseFile(fd, 0, 0, AUCIOAccessPatternWillNeed);
+    close(fd);
+}
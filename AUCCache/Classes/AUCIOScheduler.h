@@ -0,0 +1,75 @@
+//
+//  AUCIOScheduler.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/28.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCTypeDefines.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``磁盘 IO 调度器``
+///
+/// 按键的哈希把操作分配到固定数量的组上，不同组的操作并行执行；每组内按优先级分道，同一个键的操作始终按提交顺序执行
+/// ```
+/// dispatchAsyncForKey:priority:     ──►  stripes[key.hash % concurrency].lanes[priority]
+///                                         每次取有效优先级最高的道首：优先级 + 等待时间 / 100ms
+/// dispatchBarrierAsync:             ──►  之前提交的操作全部完成 ──► 执行屏障任务 ──► 之后提交的操作
+/// dispatchExclusiveAsyncWithPriority: ──► 与普通操作按有效优先级竞争，所有组让出后独占执行
+/// ```
+///
+/// - Note: 提交高优先级操作时，同一个键之前提交的低优先级操作会被提升到同一道，避免读到旧数据或写入顺序颠倒
+/// - Note: 等待时间越长有效优先级越高，写入洪峰中的后台任务不会被无限推迟
+/// - Note: 有序屏障用于清空、迁移等需要与前后操作严格排序的任务；独占任务用于过期清理、批量提交等只需与其他操作互斥的任务
+/// - Note: 每个优先级的道对应一个设置了 QoS 的队列，任务在所在道的队列中执行，写回与预取以 utility、维护任务以 background 执行
+/// - Warning: 同步方法不能在调度器自身执行的任务（包括屏障任务）中调用：Debug 下断言失败，Release 下不再等待而是直接在当前线程执行，避免死锁，但不再与其他操作排序
+@interface AUCIOScheduler : NSObject
+
+/// - Parameters:
+///     - label: 队列名称前缀
+///     - concurrency: 组数量，即最多同时执行的操作数，0 按 1 处理
+- (instancetype)initWithLabel:(NSString *)label concurrency:(NSUInteger)concurrency NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// 组数量
+@property (nonatomic, assign, readonly) NSUInteger concurrency;
+
+/// 当前线程是否正在执行本调度器的任务（包括屏障任务与独占任务）
+- (BOOL)isCurrentThreadRunningTask;
+
+/// 异步执行与 `key` 相关的操作，`key` 为 nil 时分配到第一组
+- (void)dispatchAsyncForKey:(nullable NSString *)key priority:(AUCIOPriority)priority block:(dispatch_block_t)block;
+
+/// 同步执行与 `key` 相关的操作，`key` 为 nil 时分配到第一组
+- (void)dispatchSyncForKey:(nullable NSString *)key priority:(AUCIOPriority)priority block:(dispatch_block_t)block;
+
+/// 异步执行有序屏障：之前提交的操作全部完成后执行，之后提交的操作在其完成后执行
+- (void)dispatchBarrierAsync:(dispatch_block_t)block;
+
+/// 同步执行有序屏障
+- (void)dispatchBarrierSync:(dispatch_block_t)block;
+
+/// 异步执行独占任务：不与其他操作排序，执行期间不执行其他操作
+- (void)dispatchExclusiveAsyncWithPriority:(AUCIOPriority)priority block:(dispatch_block_t)block;
+
+/// 延迟提交独占任务
+- (void)dispatchExclusiveAfter:(dispatch_time_t)when priority:(AUCIOPriority)priority block:(dispatch_block_t)block;
+
+/// 排队耗时的分位数，单位为秒，精度为 1/4 个数量级
+///
+/// - Parameters:
+///     - percentile: 0 ~ 1，如 0.99
+///     - priority: 按提交时的优先级统计，被提升的操作计入提升后的优先级
+- (NSTimeInterval)waitTimePercentile:(double)percentile priority:(AUCIOPriority)priority;
+
+/// 已统计的操作数量
+- (NSUInteger)waitCountForPriority:(AUCIOPriority)priority;
+
+/// 清空排队耗时统计
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
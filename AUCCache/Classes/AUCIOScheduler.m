@@ -0,0 +1,421 @@
+//
+//  AUCIOScheduler.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/28.
+//
+
+#import "AUCIOScheduler.h"
+#import "AUCInternalMacros.h"
+
+// 道队列的 specific 键，值为所属的调度器，用于识别当前线程是否在执行调度器的任务
+static void * AUCIOSchedulerQueueKey = &AUCIOSchedulerQueueKey;
+// 任务每等待一个周期，有效优先级提高一级
+static const NSTimeInterval AUC_IO_SCHEDULER_AGING_INTERVAL = 0.1; // 100ms
+// 排队耗时直方图：每个 2 的幂区间再分 4 个子区间，单位为微秒
+#define AUC_IO_WAIT_BUCKET_COUNT 160
+
+/// 排队中的任务
+@interface _AUCIOTask : NSObject
+
+@property (nonatomic, copy, nonnull) dispatch_block_t block;
+@property (nonatomic, strong, nullable) NSString *key;
+@property (nonatomic, assign) AUCIOPriority priority;
+/// 提交顺序
+@property (nonatomic, assign) uint64_t sequence;
+/// 提交时已提交的有序屏障数量，有序屏障的 `epoch` 为其自身的序号
+@property (nonatomic, assign) uint64_t epoch;
+@property (nonatomic, assign) CFAbsoluteTime enqueueTime;
+
+@end
+
+@implementation _AUCIOTask
+@end
+
+/// 一组按优先级分道的任务，同一时间最多一个线程执行
+@interface _AUCIOStripe : NSObject {
+@public
+    /// 每个优先级一道，道内按提交顺序排列
+    NSMutableArray<_AUCIOTask *> *_lanes[AUCIOPriorityCount];
+    /// 每道中的键，用于快速判断是否需要提升同一个键之前的任务
+    NSCountedSet<NSString *> *_laneKeys[AUCIOPriorityCount];
+    /// 已完成的有序屏障数量，只执行 `epoch` 与之相同的任务
+    uint64_t _epoch;
+    NSUInteger _taskCount;
+    BOOL _running;
+}
+@end
+
+@implementation _AUCIOStripe
+
+- (instancetype)init {
+    if (self = [super init]) {
+        for (NSUInteger i = 0; i < AUCIOPriorityCount; i++) {
+            _lanes[i] = [NSMutableArray array];
+            _laneKeys[i] = [NSCountedSet set];
+        }
+    }
+    return self;
+}
+
+@end
+
+static dispatch_qos_class_t AUCIOQoSClassForPriority(AUCIOPriority priority) {
+    switch (priority) {
+        case AUCIOPriorityInteractive: return QOS_CLASS_USER_INITIATED;
+        case AUCIOPriorityPrefetch:
+        case AUCIOPriorityWriteBack: return QOS_CLASS_UTILITY;
+        case AUCIOPriorityMaintenance:
+        default: return QOS_CLASS_BACKGROUND;
+    }
+}
+
+static inline double AUCIOTaskScore(_AUCIOTask *task, CFAbsoluteTime now) {
+    return task.priority + (now - task.enqueueTime) / AUC_IO_SCHEDULER_AGING_INTERVAL;
+}
+
+static NSUInteger AUCIOWaitBucket(uint64_t microseconds) {
+    if (microseconds < 4) return (NSUInteger)microseconds;
+    int log = 63 - __builtin_clzll(microseconds);
+    NSUInteger sub = (NSUInteger)(microseconds >> (log - 2)) & 3;
+    return MIN(4 * (NSUInteger)(log - 1) + sub, (NSUInteger)AUC_IO_WAIT_BUCKET_COUNT - 1);
+}
+
+/// 区间上界，单位为微秒
+static uint64_t AUCIOWaitBucketUpperBound(NSUInteger bucket) {
+    if (bucket < 4) return bucket + 1;
+    NSUInteger log = bucket / 4 + 1, sub = bucket % 4;
+    return (uint64_t)(5 + sub) << (log - 2);
+}
+
+@interface AUCIOScheduler () {
+    uint64_t _waitHistogram[AUCIOPriorityCount][AUC_IO_WAIT_BUCKET_COUNT];
+    uint64_t _waitCount[AUCIOPriorityCount];
+}
+
+@property (nonatomic, copy, nonnull) NSArray<_AUCIOStripe *> *stripes;
+/// 每个优先级一个并发队列，队列 QoS 与该道对应，任务在所在道的队列中执行
+@property (nonatomic, copy, nonnull) NSArray<dispatch_queue_t> *laneQueues;
+/// 保护所有调度状态
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t lock;
+@property (nonatomic, assign) uint64_t sequence;
+/// 已提交的有序屏障数量
+@property (nonatomic, assign) uint64_t epoch;
+/// 等待执行的有序屏障，按提交顺序排列
+@property (nonatomic, strong, nonnull) NSMutableArray<_AUCIOTask *> *barriers;
+/// 等待执行的独占任务
+@property (nonatomic, strong, nonnull) NSMutableArray<_AUCIOTask *> *exclusiveTasks;
+/// 正在执行屏障或独占任务
+@property (nonatomic, assign) BOOL barrierRunning;
+
+@end
+
+@implementation AUCIOScheduler
+
+- (instancetype)initWithLabel:(NSString *)label concurrency:(NSUInteger)concurrency {
+    if (self = [super init]) {
+        _concurrency = MAX(concurrency, (NSUInteger)1);
+        NSMutableArray<_AUCIOStripe *> *stripes = [NSMutableArray arrayWithCapacity:_concurrency];
+        for (NSUInteger i = 0; i < _concurrency; i++) {
+            [stripes addObject:[_AUCIOStripe new]];
+        }
+        _stripes = stripes;
+        NSMutableArray<dispatch_queue_t> *laneQueues = [NSMutableArray arrayWithCapacity:AUCIOPriorityCount];
+        for (NSUInteger i = 0; i < AUCIOPriorityCount; i++) {
+            NSString *queueLabel = [NSString stringWithFormat:@"%@.lane%lu", label, (unsigned long)i];
+            dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT, AUCIOQoSClassForPriority(i), 0);
+            dispatch_queue_t queue = dispatch_queue_create(queueLabel.UTF8String, attr);
+            dispatch_queue_set_specific(queue, AUCIOSchedulerQueueKey, (__bridge void *)self, NULL);
+            [laneQueues addObject:queue];
+        }
+        _laneQueues = laneQueues;
+        _lock = dispatch_semaphore_create(1);
+        _barriers = [NSMutableArray array];
+        _exclusiveTasks = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (_AUCIOStripe *)stripeForKey:(NSString *)key {
+    if (!key || _concurrency == 1) return _stripes[0];
+    // `AUCCacheKey` 缓存了哈希值
+    return _stripes[key.hash % _concurrency];
+}
+
+- (_AUCIOTask *)taskWithBlock:(dispatch_block_t)block key:(NSString *)key priority:(AUCIOPriority)priority {
+    _AUCIOTask *task = [_AUCIOTask new];
+    task.block = block;
+    task.key = key;
+    task.priority = MIN(priority, AUCIOPriorityInteractive);
+    task.enqueueTime = CFAbsoluteTimeGetCurrent();
+    return task;
+}
+
+#pragma mark - Dispatch
+- (void)dispatchAsyncForKey:(NSString *)key priority:(AUCIOPriority)priority block:(dispatch_block_t)block {
+    _AUCIOTask *task = [self taskWithBlock:block key:key priority:priority];
+    _AUCIOStripe *stripe = [self stripeForKey:key];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    task.sequence = ++self.sequence;
+    task.epoch = self.epoch;
+    [self _boostTasksForKey:key toPriority:task.priority inStripe:stripe];
+    [self _insertTask:task intoStripe:stripe];
+    [self _runStripeIfNeeded:stripe];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (BOOL)isCurrentThreadRunningTask {
+    return dispatch_get_specific(AUCIOSchedulerQueueKey) == (__bridge void *)self;
+}
+
+- (void)dispatchSyncForKey:(NSString *)key priority:(AUCIOPriority)priority block:(dispatch_block_t)block {
+    if ([self isCurrentThreadRunningTask]) {
+        NSAssert(NO, @"不能在调度器自身执行的任务（包括直接执行器的回调）中调用同步方法");
+        // 等待会占住当前组导致死锁，直接在当前线程执行
+        block();
+        return;
+    }
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [self dispatchAsyncForKey:key priority:priority block:^{
+        block();
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+}
+
+- (void)dispatchBarrierAsync:(dispatch_block_t)block {
+    _AUCIOTask *task = [self taskWithBlock:block key:nil priority:AUCIOPriorityInteractive];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    task.sequence = ++self.sequence;
+    task.epoch = ++self.epoch;
+    [self.barriers addObject:task];
+    [self _runBarrierIfReady];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)dispatchBarrierSync:(dispatch_block_t)block {
+    if ([self isCurrentThreadRunningTask]) {
+        NSAssert(NO, @"不能在调度器自身执行的任务（包括直接执行器的回调）中调用同步方法");
+        block();
+        return;
+    }
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [self dispatchBarrierAsync:^{
+        block();
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+}
+
+- (void)dispatchExclusiveAsyncWithPriority:(AUCIOPriority)priority block:(dispatch_block_t)block {
+    _AUCIOTask *task = [self taskWithBlock:block key:nil priority:priority];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    task.sequence = ++self.sequence;
+    [self.exclusiveTasks addObject:task];
+    [self _runBarrierIfReady];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)dispatchExclusiveAfter:(dispatch_time_t)when priority:(AUCIOPriority)priority block:(dispatch_block_t)block {
+    dispatch_after(when, dispatch_get_global_queue(AUCIOQoSClassForPriority(priority), 0), ^{
+        [self dispatchExclusiveAsyncWithPriority:priority block:block];
+    });
+}
+
+#pragma mark - Statistics
+- (NSTimeInterval)waitTimePercentile:(double)percentile priority:(AUCIOPriority)priority {
+    if (priority >= AUCIOPriorityCount) return 0;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    uint64_t total = _waitCount[priority];
+    uint64_t target = (uint64_t)ceil(MIN(MAX(percentile, 0), 1) * total);
+    uint64_t count = 0;
+    NSUInteger bucket = 0;
+    for (; total > 0 && bucket < AUC_IO_WAIT_BUCKET_COUNT; bucket++) {
+        count += _waitHistogram[priority][bucket];
+        if (count >= MAX(target, (uint64_t)1)) break;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    if (total == 0) return 0;
+    return AUCIOWaitBucketUpperBound(MIN(bucket, (NSUInteger)AUC_IO_WAIT_BUCKET_COUNT - 1)) / 1e6;
+}
+
+- (NSUInteger)waitCountForPriority:(AUCIOPriority)priority {
+    if (priority >= AUCIOPriorityCount) return 0;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger count = (NSUInteger)_waitCount[priority];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return count;
+}
+
+- (void)resetStatistics {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    memset(_waitHistogram, 0, sizeof(_waitHistogram));
+    memset(_waitCount, 0, sizeof(_waitCount));
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+#pragma mark - Private（以下方法均需持有锁）
+/// 按提交顺序插入对应优先级的道
+- (void)_insertTask:(_AUCIOTask *)task intoStripe:(_AUCIOStripe *)stripe {
+    NSMutableArray<_AUCIOTask *> *lane = stripe->_lanes[task.priority];
+    NSUInteger index = lane.count;
+    while (index > 0 && lane[index - 1].sequence > task.sequence) index--;
+    [lane insertObject:task atIndex:index];
+    if (task.key) [stripe->_laneKeys[task.priority] addObject:task.key];
+    stripe->_taskCount++;
+}
+
+/// 同一个键之前提交的低优先级任务提升到 `priority`，保证不会被之后的高优先级任务超过
+- (void)_boostTasksForKey:(NSString *)key toPriority:(AUCIOPriority)priority inStripe:(_AUCIOStripe *)stripe {
+    if (!key) return;
+    for (NSUInteger lower = 0; lower < priority; lower++) {
+        if ([stripe->_laneKeys[lower] countForObject:key] == 0) continue;
+        NSMutableArray<_AUCIOTask *> *lane = stripe->_lanes[lower];
+        NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
+        [lane enumerateObjectsUsingBlock:^(_AUCIOTask *task, NSUInteger index, BOOL *stop) {
+            if ([task.key isEqualToString:key]) [indexes addIndex:index];
+        }];
+        NSArray<_AUCIOTask *> *tasks = [lane objectsAtIndexes:indexes];
+        [lane removeObjectsAtIndexes:indexes];
+        for (_AUCIOTask *task in tasks) {
+            [stripe->_laneKeys[lower] removeObject:key];
+            stripe->_taskCount--;
+            task.priority = priority;
+            [self _insertTask:task intoStripe:stripe];
+        }
+    }
+}
+
+/// 当前可执行的、有效优先级最高的任务
+- (nullable _AUCIOTask *)_bestTaskInStripe:(_AUCIOStripe *)stripe now:(CFAbsoluteTime)now lane:(NSUInteger *)bestLane {
+    _AUCIOTask *bestTask = nil;
+    double bestScore = 0;
+    for (NSInteger lane = AUCIOPriorityCount - 1; lane >= 0; lane--) {
+        _AUCIOTask *task = stripe->_lanes[lane].firstObject;
+        // 道内按提交顺序排列，道首属于下一个有序屏障之后时整道都不可执行
+        if (!task || task.epoch != stripe->_epoch) continue;
+        double score = AUCIOTaskScore(task, now);
+        if (!bestTask || score > bestScore) {
+            bestTask = task;
+            bestScore = score;
+            *bestLane = (NSUInteger)lane;
+        }
+    }
+    return bestTask;
+}
+
+- (nullable _AUCIOTask *)_bestExclusiveTaskAt:(CFAbsoluteTime)now {
+    _AUCIOTask *bestTask = nil;
+    for (_AUCIOTask *task in self.exclusiveTasks) {
+        if (!bestTask || AUCIOTaskScore(task, now) > AUCIOTaskScore(bestTask, now)) bestTask = task;
+    }
+    return bestTask;
+}
+
+/// 取出该组下一个要执行的任务，需要等待屏障或让位于独占任务时返回 nil
+- (nullable _AUCIOTask *)_dequeueTaskFromStripe:(_AUCIOStripe *)stripe {
+    if (self.barrierRunning) return nil;
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    NSUInteger lane = 0;
+    _AUCIOTask *task = [self _bestTaskInStripe:stripe now:now lane:&lane];
+    if (!task) return nil;
+    _AUCIOTask *exclusiveTask = [self _bestExclusiveTaskAt:now];
+    if (exclusiveTask && AUCIOTaskScore(exclusiveTask, now) > AUCIOTaskScore(task, now)) return nil;
+
+    [stripe->_lanes[lane] removeObjectAtIndex:0];
+    if (task.key) [stripe->_laneKeys[lane] removeObject:task.key];
+    stripe->_taskCount--;
+    uint64_t microseconds = (uint64_t)(MAX(now - task.enqueueTime, 0) * 1e6);
+    _waitHistogram[task.priority][AUCIOWaitBucket(microseconds)]++;
+    _waitCount[task.priority]++;
+    return task;
+}
+
+- (void)_runStripeIfNeeded:(_AUCIOStripe *)stripe {
+    if (stripe->_running || stripe->_taskCount == 0 || self.barrierRunning) return;
+    _AUCIOTask *task = [self _dequeueTaskFromStripe:stripe];
+    if (!task) {
+        // 让位于独占任务
+        [self _runBarrierIfReady];
+        return;
+    }
+    stripe->_running = YES;
+    [self _executeTask:task inStripe:stripe];
+}
+
+/// 在任务所在道的队列中执行，线程 QoS 由队列决定
+- (void)_executeTask:(_AUCIOTask *)task inStripe:(_AUCIOStripe *)stripe {
+    dispatch_async(self.laneQueues[task.priority], ^{
+        [self drainStripe:stripe firstTask:task];
+    });
+}
+
+/// 所有组都已停下时执行屏障或独占任务：有序屏障优先，其次是有效优先级最高的独占任务
+- (void)_runBarrierIfReady {
+    if (self.barrierRunning) return;
+    _AUCIOTask *barrier = self.barriers.firstObject;
+    BOOL isOrdered = NO;
+    for (_AUCIOStripe *stripe in self.stripes) {
+        if (stripe->_running) return;
+    }
+    if (barrier) {
+        // 有序屏障之前提交的任务全部完成
+        isOrdered = YES;
+        for (_AUCIOStripe *stripe in self.stripes) {
+            if ([self _bestTaskInStripe:stripe now:0 lane:&(NSUInteger){0}]) {
+                isOrdered = NO;
+                break;
+            }
+        }
+    }
+    if (!isOrdered) barrier = [self _bestExclusiveTaskAt:CFAbsoluteTimeGetCurrent()];
+    if (!barrier) return;
+    if (isOrdered) {
+        [self.barriers removeObjectAtIndex:0];
+    } else {
+        [self.exclusiveTasks removeObjectIdenticalTo:barrier];
+    }
+    self.barrierRunning = YES;
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    uint64_t microseconds = (uint64_t)(MAX(now - barrier.enqueueTime, 0) * 1e6);
+    _waitHistogram[barrier.priority][AUCIOWaitBucket(microseconds)]++;
+    _waitCount[barrier.priority]++;
+
+    // `barrierRunning` 保证同一时间只执行一个屏障或独占任务
+    dispatch_async(self.laneQueues[barrier.priority], ^{
+        barrier.block();
+        AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+        self.barrierRunning = NO;
+        for (_AUCIOStripe *stripe in self.stripes) {
+            if (isOrdered) stripe->_epoch = barrier.epoch;
+            [self _runStripeIfNeeded:stripe];
+        }
+        [self _runBarrierIfReady];
+        AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    });
+}
+
+#pragma mark - Drain
+/// 依次执行该组的任务；下一个任务属于其他 QoS 的道时切换到对应的队列，后台任务不以前台读取的 QoS 执行
+- (void)drainStripe:(_AUCIOStripe *)stripe firstTask:(_AUCIOTask *)task {
+    AUCIOPriority priority = task.priority;
+    while (YES) {
+        task.block();
+        AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+        task = [self _dequeueTaskFromStripe:stripe];
+        if (!task) {
+            stripe->_running = NO;
+            [self _runBarrierIfReady];
+            AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+            return;
+        }
+        if (AUCIOQoSClassForPriority(task.priority) != AUCIOQoSClassForPriority(priority)) {
+            [self _executeTask:task inStripe:stripe];
+            AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+            return;
+        }
+        AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    }
+}
+
+@end
@@ -0,0 +1,37 @@
+//
+//  AUCJSONParser.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/12/02.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``基于结构索引的 JSON 解析器``
+///
+/// 先用 SIMD 一次扫描整个缓冲区，得到所有结构字符的位置（`AUCJSONBuildStructuralIndex`），再沿索引构建对象树，不逐字节判断字符串边界
+/// ```
+/// data
+///    ├── 阶段一  结构索引     { } [ ] : , 、字符串起始引号、数字与字面量的首字节（64 字节一块，位运算）
+///    └── 阶段二  构建对象     沿索引递归，校验每个值并生成 NSDictionary/NSArray/NSString/NSNumber/NSNull
+/// ```
+///
+/// - Note: 结果与 `NSJSONSerialization`（`NSJSONReadingFragmentsAllowed`）相同：不可变容器、`NSNumber` 布尔值、`NSNull`；整数在 `long long`/`unsigned long long` 范围内保存为整数，其余数字保存为 `double`
+/// - Note: 相同的字段名只生成一次字符串，接口响应中重复的键共享同一个对象
+/// - Note: 只支持 UTF-8；非 UTF-8 编码、非法 JSON、孤立的 UTF-16 代理项、嵌套超过 512 层等情况返回 nil，调用方应回退到 `NSJSONSerialization`
+@interface AUCJSONParser : NSObject
+
+/// 解析 JSON 数据
+///
+/// - Parameter data: UTF-8 编码的 JSON，允许顶层为字符串、数字等非容器值
+/// - Returns: 解析结果，无法解析时返回 nil
++ (nullable id)JSONObjectWithData:(NSData *)data;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,429 @@
+//
+//  AUCJSONParser.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/12/02.
+//
+
+#import "AUCJSONParser.h"
+#import "AUCJSONStructuralIndex.h"
+// strtod_l 等按 locale 转换的函数：Apple 平台声明在 <xlocale.h>，其余平台声明在 <stdlib.h>/<locale.h>
+#if defined(__APPLE__)
+#import <xlocale.h>
+#else
+#import <locale.h>
+#endif
+#import <stdlib.h>
+#import <errno.h>
+
+// 最大嵌套深度，避免异常数据导致栈溢出
+static const NSUInteger AUC_JSON_MAX_DEPTH = 512;
+// 不超过该长度且不含转义的键进入缓存
+static const NSUInteger AUC_JSON_KEY_CACHE_MAX_LENGTH = 32;
+// 数字转换的栈缓冲区长度，更长的数字在堆上拷贝
+#define AUC_JSON_NUMBER_BUFFER_LENGTH 64
+// 键缓存槽位数，直接映射
+#define AUC_JSON_KEY_CACHE_SIZE 256
+
+static inline BOOL AUCJSONIsWhitespace(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/// 标量之后允许出现的字符：空白、结构字符或数据末尾
+static inline BOOL AUCJSONIsScalarTerminator(const uint8_t *p, const uint8_t *end) {
+    if (p == end) return YES;
+    uint8_t c = *p;
+    return AUCJSONIsWhitespace(c) || c == ',' || c == ']' || c == '}' || c == ':' || c == '[' || c == '{';
+}
+
+/// 数字使用 C 区域设置转换，不受 `setlocale` 影响
+static locale_t AUCJSONCLocale(void) {
+    static locale_t locale;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        locale = newlocale(LC_NUMERIC_MASK, "C", NULL);
+    });
+    return locale;
+}
+
+static inline int AUCJSONHexValue(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/// 读取 `\u` 之后的 4 位十六进制
+static inline BOOL AUCJSONReadHex4(const uint8_t *p, const uint8_t *end, uint32_t *value) {
+    if (end - p < 4) return NO;
+    uint32_t result = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = AUCJSONHexValue(p[i]);
+        if (digit < 0) return NO;
+        result = result << 4 | (uint32_t)digit;
+    }
+    *value = result;
+    return YES;
+}
+
+static inline uint8_t *AUCJSONWriteUTF8(uint8_t *out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        *out++ = (uint8_t)codePoint;
+    } else if (codePoint < 0x800) {
+        *out++ = (uint8_t)(0xC0 | codePoint >> 6);
+        *out++ = (uint8_t)(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        *out++ = (uint8_t)(0xE0 | codePoint >> 12);
+        *out++ = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = (uint8_t)(0x80 | (codePoint & 0x3F));
+    } else {
+        *out++ = (uint8_t)(0xF0 | codePoint >> 18);
+        *out++ = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = (uint8_t)(0x80 | (codePoint & 0x3F));
+    }
+    return out;
+}
+
+@class AUCJSONParser;
+static id AUCJSONParseValue(__unsafe_unretained AUCJSONParser *parser, NSUInteger depth);
+static id AUCJSONParseArray(__unsafe_unretained AUCJSONParser *parser, NSUInteger depth);
+static id AUCJSONParseObject(__unsafe_unretained AUCJSONParser *parser, NSUInteger depth);
+static NSString *AUCJSONParseString(__unsafe_unretained AUCJSONParser *parser, uint32_t offset, BOOL isKey);
+static NSNumber *AUCJSONParseNumber(__unsafe_unretained AUCJSONParser *parser, const uint8_t *start);
+static BOOL AUCJSONMatchLiteral(__unsafe_unretained AUCJSONParser *parser, const uint8_t *p, const char *literal, NSUInteger length);
+
+@implementation AUCJSONParser {
+    const uint8_t *_bytes;
+    const uint8_t *_end;
+    const uint32_t *_indexes;
+    NSUInteger _count;
+    /// 下一个待读取的索引
+    NSUInteger _position;
+    /// 正在构建的容器元素，字典按 键、值 交替存放
+    NSMutableArray *_stack;
+    /// 构建字典时的键值缓冲区，元素由 `_stack` 持有
+    __unsafe_unretained id *_objects;
+    NSUInteger _objectsCapacity;
+    /// 反转义缓冲区
+    uint8_t *_scratch;
+    NSUInteger _scratchCapacity;
+    /// 键缓存：槽位 -> 键在数据中的位置与对应的字符串
+    NSString *_cachedKeys[AUC_JSON_KEY_CACHE_SIZE];
+    uint32_t _cachedKeyOffsets[AUC_JSON_KEY_CACHE_SIZE];
+    uint32_t _cachedKeyLengths[AUC_JSON_KEY_CACHE_SIZE];
+}
+
++ (id)JSONObjectWithData:(NSData *)data {
+    NSUInteger length = data.length;
+    if (length == 0 || length > UINT32_MAX) return nil;
+    const uint8_t *bytes = data.bytes;
+
+    // 首个非空白字符不可能开始一个 JSON 值时（例如按原样保存的图片），不扫描整个缓冲区
+    NSUInteger start = 0;
+    while (start < length && AUCJSONIsWhitespace(bytes[start])) start++;
+    if (start == length) return nil;
+    uint8_t first = bytes[start];
+    if (first != '{' && first != '[' && first != '"' && first != '-' && first != 't' && first != 'f' && first != 'n' && (first < '0' || first > '9')) return nil;
+
+    uint32_t *indexes = malloc((length + 1) * sizeof(uint32_t));
+    if (!indexes) return nil;
+    BOOL unclosedString = NO;
+    NSUInteger count = AUCJSONBuildStructuralIndex(bytes, length, indexes, &unclosedString);
+    id object = nil;
+    if (!unclosedString && count > 0) {
+        AUCJSONParser *parser = [[self alloc] initWithBytes:bytes length:length indexes:indexes count:count];
+        object = AUCJSONParseValue(parser, 0);
+        // 顶层值之后不能有其他内容
+        if (parser->_position != count) object = nil;
+    }
+    free(indexes);
+    return object;
+}
+
+- (instancetype)initWithBytes:(const uint8_t *)bytes length:(NSUInteger)length indexes:(const uint32_t *)indexes count:(NSUInteger)count {
+    if (self = [super init]) {
+        _bytes = bytes;
+        _end = bytes + length;
+        _indexes = indexes;
+        _count = count;
+        _stack = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_objects);
+    free(_scratch);
+}
+
+#pragma mark - Values
+static id AUCJSONParseValue(__unsafe_unretained AUCJSONParser *parser, NSUInteger depth) {
+    if (parser->_position >= parser->_count) return nil;
+    uint32_t offset = parser->_indexes[parser->_position++];
+    const uint8_t *p = parser->_bytes + offset;
+    switch (*p) {
+        case '{':
+            return AUCJSONParseObject(parser, depth + 1);
+        case '[':
+            return AUCJSONParseArray(parser, depth + 1);
+        case '"':
+            return AUCJSONParseString(parser, offset, NO);
+        case 't':
+            return AUCJSONMatchLiteral(parser, p, "true", 4) ? @YES : nil;
+        case 'f':
+            return AUCJSONMatchLiteral(parser, p, "false", 5) ? @NO : nil;
+        case 'n':
+            return AUCJSONMatchLiteral(parser, p, "null", 4) ? NSNull.null : nil;
+        default:
+            return AUCJSONParseNumber(parser, p);
+    }
+}
+
+static BOOL AUCJSONMatchLiteral(__unsafe_unretained AUCJSONParser *parser, const uint8_t *p, const char *literal, NSUInteger length) {
+    if ((NSUInteger)(parser->_end - p) < length || memcmp(p, literal, length) != 0) return NO;
+    return AUCJSONIsScalarTerminator(p + length, parser->_end);
+}
+
+/// 读取下一个结构字符，索引用尽时返回 0
+static inline uint8_t AUCJSONNextStructural(__unsafe_unretained AUCJSONParser *parser) {
+    if (parser->_position >= parser->_count) return 0;
+    return parser->_bytes[parser->_indexes[parser->_position++]];
+}
+
+static inline uint8_t AUCJSONPeekStructural(__unsafe_unretained AUCJSONParser *parser) {
+    if (parser->_position >= parser->_count) return 0;
+    return parser->_bytes[parser->_indexes[parser->_position]];
+}
+
+static id AUCJSONParseArray(__unsafe_unretained AUCJSONParser *parser, NSUInteger depth) {
+    if (depth > AUC_JSON_MAX_DEPTH) return nil;
+    if (AUCJSONPeekStructural(parser) == ']') {
+        parser->_position++;
+        return @[];
+    }
+    NSMutableArray *stack = parser->_stack;
+    NSUInteger base = stack.count;
+    while (YES) {
+        id value = AUCJSONParseValue(parser, depth);
+        if (!value) return nil;
+        [stack addObject:value];
+        uint8_t c = AUCJSONNextStructural(parser);
+        if (c == ']') break;
+        if (c != ',') return nil;
+    }
+    NSRange range = NSMakeRange(base, stack.count - base);
+    NSArray *array = [stack subarrayWithRange:range];
+    [stack removeObjectsInRange:range];
+    return array;
+}
+
+static id AUCJSONParseObject(__unsafe_unretained AUCJSONParser *parser, NSUInteger depth) {
+    if (depth > AUC_JSON_MAX_DEPTH) return nil;
+    if (AUCJSONPeekStructural(parser) == '}') {
+        parser->_position++;
+        return @{};
+    }
+    NSMutableArray *stack = parser->_stack;
+    NSUInteger base = stack.count;
+    while (YES) {
+        if (parser->_position >= parser->_count) return nil;
+        uint32_t offset = parser->_indexes[parser->_position++];
+        if (parser->_bytes[offset] != '"') return nil;
+        NSString *key = AUCJSONParseString(parser, offset, YES);
+        if (!key || AUCJSONNextStructural(parser) != ':') return nil;
+        id value = AUCJSONParseValue(parser, depth);
+        if (!value) return nil;
+        [stack addObject:key];
+        [stack addObject:value];
+        uint8_t c = AUCJSONNextStructural(parser);
+        if (c == '}') break;
+        if (c != ',') return nil;
+    }
+    NSUInteger count = (stack.count - base) / 2;
+    // [0, count) 键，[count, 2count) 值，[2count, 4count) 交替存放的键值
+    if (parser->_objectsCapacity < count * 4) {
+        NSUInteger capacity = MAX(count * 4, parser->_objectsCapacity * 2);
+        void *objects = realloc(parser->_objects, capacity * sizeof(id));
+        if (!objects) return nil;
+        parser->_objects = (__unsafe_unretained id *)objects;
+        parser->_objectsCapacity = capacity;
+    }
+    __unsafe_unretained id *keys = parser->_objects;
+    __unsafe_unretained id *values = keys + count;
+    __unsafe_unretained id *pairs = values + count;
+    NSRange range = NSMakeRange(base, count * 2);
+    [stack getObjects:pairs range:range];
+    for (NSUInteger i = 0; i < count; i++) {
+        keys[i] = pairs[i * 2];
+        values[i] = pairs[i * 2 + 1];
+    }
+    NSDictionary *dictionary = [NSDictionary dictionaryWithObjects:values forKeys:keys count:count];
+    [stack removeObjectsInRange:range];
+    return dictionary;
+}
+
+#pragma mark - Strings
+static inline uint32_t AUCJSONKeySlot(const uint8_t *p, NSUInteger length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (NSUInteger i = 0; i < length; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash & (AUC_JSON_KEY_CACHE_SIZE - 1);
+}
+
+/// 解析 offset 处引号开始的字符串，字符串中不允许出现未转义的控制字符
+static NSString *AUCJSONParseString(__unsafe_unretained AUCJSONParser *parser, uint32_t offset, BOOL isKey) {
+    const uint8_t *start = parser->_bytes + offset + 1;
+    const uint8_t *end = parser->_end;
+    const uint8_t *p = start;
+    while (p < end && *p != '"' && *p != '\\' && *p >= 0x20) p++;
+    if (p >= end || *p < 0x20) return nil;
+
+    if (*p == '"') {
+        NSUInteger length = (NSUInteger)(p - start);
+        if (!isKey || length > AUC_JSON_KEY_CACHE_MAX_LENGTH) {
+            return [[NSString alloc] initWithBytes:start length:length encoding:NSUTF8StringEncoding];
+        }
+        uint32_t slot = AUCJSONKeySlot(start, length);
+        NSString *cached = parser->_cachedKeys[slot];
+        if (cached && parser->_cachedKeyLengths[slot] == length && memcmp(parser->_bytes + parser->_cachedKeyOffsets[slot], start, length) == 0) {
+            return cached;
+        }
+        NSString *key = [[NSString alloc] initWithBytes:start length:length encoding:NSUTF8StringEncoding];
+        if (key) {
+            parser->_cachedKeys[slot] = key;
+            parser->_cachedKeyOffsets[slot] = (uint32_t)(start - parser->_bytes);
+            parser->_cachedKeyLengths[slot] = (uint32_t)length;
+        }
+        return key;
+    }
+
+    // 含转义：反转义后的长度不超过原长度（\uXXXX 最多生成 3 字节，代理对 12 字节生成 4 字节）
+    NSUInteger capacity = (NSUInteger)(end - start);
+    if (parser->_scratchCapacity < capacity) {
+        uint8_t *scratch = realloc(parser->_scratch, capacity);
+        if (!scratch) return nil;
+        parser->_scratch = scratch;
+        parser->_scratchCapacity = capacity;
+    }
+    uint8_t *out = parser->_scratch;
+    memcpy(out, start, (size_t)(p - start));
+    out += p - start;
+    while (YES) {
+        if (p >= end) return nil;
+        uint8_t c = *p;
+        if (c == '"') break;
+        if (c < 0x20) return nil;
+        if (c != '\\') {
+            *out++ = c;
+            p++;
+            continue;
+        }
+        if (end - p < 2) return nil;
+        c = p[1];
+        p += 2;
+        switch (c) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t codePoint;
+                if (!AUCJSONReadHex4(p, end, &codePoint)) return nil;
+                p += 4;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !AUCJSONReadHex4(p + 2, end, &low) || low < 0xDC00 || low > 0xDFFF) return nil;
+                    p += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    // 孤立的低位代理项无法以 UTF-8 表示
+                    return nil;
+                }
+                out = AUCJSONWriteUTF8(out, codePoint);
+                break;
+            }
+            default:
+                return nil;
+        }
+    }
+    return [[NSString alloc] initWithBytes:parser->_scratch length:(NSUInteger)(out - parser->_scratch) encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Numbers
+static NSNumber *AUCJSONParseNumber(__unsafe_unretained AUCJSONParser *parser, const uint8_t *start) {
+    const uint8_t *end = parser->_end;
+    const uint8_t *p = start;
+    BOOL negative = NO;
+    if (*p == '-') {
+        negative = YES;
+        p++;
+    }
+    const uint8_t *digits = p;
+    uint64_t integer = 0;
+    if (p < end && *p == '0') {
+        p++;
+    } else {
+        while (p < end && *p >= '0' && *p <= '9') {
+            integer = integer * 10 + (uint64_t)(*p - '0');
+            p++;
+        }
+    }
+    NSUInteger digitCount = (NSUInteger)(p - digits);
+    if (digitCount == 0) return nil;
+
+    BOOL isInteger = YES;
+    if (p < end && *p == '.') {
+        isInteger = NO;
+        const uint8_t *fraction = ++p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        if (p == fraction) return nil;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        isInteger = NO;
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        const uint8_t *exponent = p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        if (p == exponent) return nil;
+    }
+    if (!AUCJSONIsScalarTerminator(p, end)) return nil;
+
+    // 19 位以内的十进制整数不会溢出 uint64_t
+    if (isInteger && digitCount <= 19) {
+        if (!negative) {
+            return integer <= INT64_MAX ? @((long long)integer) : @((unsigned long long)integer);
+        }
+        if (integer <= (uint64_t)INT64_MAX + 1) {
+            return @((long long)(0 - integer));
+        }
+    }
+
+    NSUInteger length = (NSUInteger)(p - start);
+    char stackBuffer[AUC_JSON_NUMBER_BUFFER_LENGTH];
+    char *buffer = length < AUC_JSON_NUMBER_BUFFER_LENGTH ? stackBuffer : malloc(length + 1);
+    if (!buffer) return nil;
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    NSNumber *number = nil;
+    if (isInteger && !negative) {
+        errno = 0;
+        unsigned long long value = strtoull_l(buffer, NULL, 10, AUCJSONCLocale());
+        if (errno != ERANGE) number = @(value);
+    }
+    if (!number) {
+        double value = strtod_l(buffer, NULL, AUCJSONCLocale());
+        // 超出 double 范围的数字交给 NSJSONSerialization 处理
+        if (isfinite(value)) number = @(value);
+    }
+    if (buffer != stackBuffer) free(buffer);
+    return number;
+}
+
+@end
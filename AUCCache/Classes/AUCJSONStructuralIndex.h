@@ -0,0 +1,39 @@
+//
+//  AUCJSONStructuralIndex.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/12/02.
+//
+
+#ifndef AUCJSONStructuralIndex_h
+#define AUCJSONStructuralIndex_h
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 构建 JSON 结构索引：字符串之外的 `{ } [ ] : ,`、每个字符串的起始引号、每个数字与字面量（true/false/null）的首字节
+///
+/// 每次处理 64 字节，以 SIMD 比较得到反斜杠、引号、空白、结构字符的位图，再用位运算排除转义的引号与字符串内部的字符
+/// ```
+/// escaped   = 奇数个连续反斜杠之后的字符
+/// inString  = prefixXor(未转义的引号) ^ 上一块结束时是否在字符串中
+/// index     = (结构字符 | 标量首字节) & ~(字符串内部)
+/// ```
+///
+/// - Note: 运行时检测 CPU 特性，arm64 使用 NEON，x86_64 优先使用 AVX2，否则使用 SSE2；其他架构退化为逐字节处理，结果完全相同
+/// - Note: 只定位结构，不校验语法；数字、字面量、字符串内容与结构的合法性由调用方在遍历索引时校验
+/// - Parameters:
+///     - bytes: UTF-8 编码的 JSON
+///     - length: 长度，不超过 `UINT32_MAX`
+///     - indexes: 输出的字节偏移，按升序排列，容量至少为 `length + 1`
+///     - unclosedString: 返回末尾是否仍在字符串中（缺少结束引号），可为 NULL
+/// - Returns: 索引数量
+FOUNDATION_EXTERN size_t AUCJSONBuildStructuralIndex(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL * _Nullable unclosedString);
+
+/// 当前使用的实现名称：`neon`、`avx2`、`sse2` 或 `scalar`
+FOUNDATION_EXTERN const char *AUCJSONStructuralIndexImplementation(void);
+
+NS_ASSUME_NONNULL_END
+
+#endif /* AUCJSONStructuralIndex_h */
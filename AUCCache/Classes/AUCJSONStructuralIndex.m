@@ -0,0 +1,289 @@
+//
+//  AUCJSONStructuralIndex.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/12/02.
+//
+
+#import "AUCJSONStructuralIndex.h"
+#if defined(__APPLE__)
+#import <sys/sysctl.h>
+#endif
+#if defined(__aarch64__)
+#import <arm_neon.h>
+#elif defined(__x86_64__)
+#import <immintrin.h>
+#endif
+
+#define AUC_JSON_BLOCK_SIZE 64
+
+static const uint64_t AUC_JSON_EVEN_BITS = 0x5555555555555555ULL;
+
+/// 一个 64 字节块的字符分类位图，第 i 位对应块内第 i 个字节
+typedef struct {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t whitespace;
+    /// `{ } [ ] : ,`
+    uint64_t op;
+} AUCJSONBlockMasks;
+
+/// 跨块传递的扫描状态
+typedef struct {
+    /// 下一块的首字节是否被转义（上一块以奇数个反斜杠结尾）
+    uint64_t prevEscaped;
+    /// 上一块结束时在字符串中为全 1，否则为 0
+    uint64_t prevInString;
+    /// 上一块的末字节是否为非引号的标量字符
+    uint64_t prevScalar;
+} AUCJSONScanState;
+
+/// 逐位前缀异或：第 i 位为第 0..i 位的异或，引号之间（含起始引号、不含结束引号）为 1
+static inline uint64_t AUCJSONPrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/// 由分类位图计算结构索引并追加到 indexes，返回追加后的位置
+static inline __attribute__((always_inline)) uint32_t *AUCJSONIndexBlock(AUCJSONBlockMasks masks, AUCJSONScanState *state, uint32_t base, uint32_t *indexes) {
+    // 被转义的字符：奇数长度反斜杠序列之后的字符。用加法的进位消去从奇数位开始的序列，再按奇偶翻转
+    uint64_t backslash = masks.backslash & ~state->prevEscaped;
+    uint64_t followsEscape = backslash << 1 | state->prevEscaped;
+    uint64_t oddSequenceStarts = backslash & ~AUC_JSON_EVEN_BITS & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits;
+    state->prevEscaped = __builtin_add_overflow(oddSequenceStarts, backslash, &sequencesStartingOnEvenBits);
+    uint64_t escaped = (AUC_JSON_EVEN_BITS ^ (sequencesStartingOnEvenBits << 1)) & followsEscape;
+
+    uint64_t quote = masks.quote & ~escaped;
+    uint64_t inString = AUCJSONPrefixXor(quote) ^ state->prevInString;
+    state->prevInString = (uint64_t)((int64_t)inString >> 63);
+    // 字符串内部与结束引号，起始引号保留为索引
+    uint64_t stringTail = inString ^ quote;
+
+    uint64_t scalar = ~(masks.op | masks.whitespace);
+    uint64_t nonquoteScalar = scalar & ~quote;
+    uint64_t followsNonquoteScalar = nonquoteScalar << 1 | state->prevScalar;
+    state->prevScalar = nonquoteScalar >> 63;
+    uint64_t structurals = (masks.op | (scalar & ~followsNonquoteScalar)) & ~stringTail;
+
+    while (structurals) {
+        *indexes++ = base + (uint32_t)__builtin_ctzll(structurals);
+        structurals &= structurals - 1;
+    }
+    return indexes;
+}
+
+typedef AUCJSONBlockMasks (*AUCJSONClassifyFunction)(const uint8_t *block);
+
+/// 按块分类并生成索引，末尾不足 64 字节的部分以空格补齐，不会读取 length 之后的内存
+static inline __attribute__((always_inline)) size_t AUCJSONIndexBlocks(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString, AUCJSONClassifyFunction classify) {
+    AUCJSONScanState state = {0};
+    uint32_t *cursor = indexes;
+    size_t offset = 0;
+    for (; offset + AUC_JSON_BLOCK_SIZE <= length; offset += AUC_JSON_BLOCK_SIZE) {
+        cursor = AUCJSONIndexBlock(classify(bytes + offset), &state, (uint32_t)offset, cursor);
+    }
+    if (offset < length) {
+        uint8_t tail[AUC_JSON_BLOCK_SIZE];
+        memset(tail, ' ', AUC_JSON_BLOCK_SIZE);
+        memcpy(tail, bytes + offset, length - offset);
+        cursor = AUCJSONIndexBlock(classify(tail), &state, (uint32_t)offset, cursor);
+    }
+    if (unclosedString) *unclosedString = state.prevInString != 0;
+    return (size_t)(cursor - indexes);
+}
+
+#if !defined(__aarch64__) && !defined(__x86_64__)
+#pragma mark - Scalar
+enum {
+    AUCJSONCharBackslash = 1 << 0,
+    AUCJSONCharQuote = 1 << 1,
+    AUCJSONCharWhitespace = 1 << 2,
+    AUCJSONCharOp = 1 << 3,
+};
+
+static uint8_t AUCJSONCharClassTable[256];
+
+static void AUCJSONInitCharClassTable(void) {
+    AUCJSONCharClassTable['\\'] = AUCJSONCharBackslash;
+    AUCJSONCharClassTable['"'] = AUCJSONCharQuote;
+    AUCJSONCharClassTable[' '] = AUCJSONCharClassTable['\t'] = AUCJSONCharClassTable['\n'] = AUCJSONCharClassTable['\r'] = AUCJSONCharWhitespace;
+    AUCJSONCharClassTable['{'] = AUCJSONCharClassTable['}'] = AUCJSONCharClassTable['['] = AUCJSONCharClassTable[']'] = AUCJSONCharOp;
+    AUCJSONCharClassTable[':'] = AUCJSONCharClassTable[','] = AUCJSONCharOp;
+}
+
+static AUCJSONBlockMasks AUCJSONClassifyScalar(const uint8_t *block) {
+    AUCJSONBlockMasks masks = {0};
+    for (int i = 0; i < AUC_JSON_BLOCK_SIZE; i++) {
+        uint64_t bit = 1ULL << i;
+        uint8_t cls = AUCJSONCharClassTable[block[i]];
+        if (cls & AUCJSONCharBackslash) masks.backslash |= bit;
+        if (cls & AUCJSONCharQuote) masks.quote |= bit;
+        if (cls & AUCJSONCharWhitespace) masks.whitespace |= bit;
+        if (cls & AUCJSONCharOp) masks.op |= bit;
+    }
+    return masks;
+}
+
+static size_t AUCJSONStructuralIndexScalar(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString) {
+    return AUCJSONIndexBlocks(bytes, length, indexes, unclosedString, AUCJSONClassifyScalar);
+}
+
+#elif defined(__aarch64__)
+#pragma mark - NEON
+/// 4 个 16 字节比较结果（0x00/0xFF）合并为 64 位掩码
+static inline uint64_t AUCJSONNeonMovemask(uint8x16_t v0, uint8x16_t v1, uint8x16_t v2, uint8x16_t v3) {
+    const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(v0, bits), vandq_u8(v1, bits));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(v2, bits), vandq_u8(v3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+static inline void AUCJSONNeonClassify16(uint8x16_t v, uint8x16_t *backslash, uint8x16_t *quote, uint8x16_t *whitespace, uint8x16_t *op) {
+    // '[' ']' 与 '{' '}' 只相差 0x20
+    uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(0x20));
+    *backslash = vceqq_u8(v, vdupq_n_u8('\\'));
+    *quote = vceqq_u8(v, vdupq_n_u8('"'));
+    *whitespace = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+                           vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+    *op = vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+                   vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+}
+
+static inline AUCJSONBlockMasks AUCJSONClassifyNeon(const uint8_t *block) {
+    uint8x16_t backslash[4], quote[4], whitespace[4], op[4];
+    for (int i = 0; i < 4; i++) {
+        AUCJSONNeonClassify16(vld1q_u8(block + i * 16), &backslash[i], &quote[i], &whitespace[i], &op[i]);
+    }
+    AUCJSONBlockMasks masks;
+    masks.backslash = AUCJSONNeonMovemask(backslash[0], backslash[1], backslash[2], backslash[3]);
+    masks.quote = AUCJSONNeonMovemask(quote[0], quote[1], quote[2], quote[3]);
+    masks.whitespace = AUCJSONNeonMovemask(whitespace[0], whitespace[1], whitespace[2], whitespace[3]);
+    masks.op = AUCJSONNeonMovemask(op[0], op[1], op[2], op[3]);
+    return masks;
+}
+
+static size_t AUCJSONStructuralIndexNeon(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString) {
+    return AUCJSONIndexBlocks(bytes, length, indexes, unclosedString, AUCJSONClassifyNeon);
+}
+
+#elif defined(__x86_64__)
+#pragma mark - SSE2
+static inline uint64_t AUCJSONSSE2Classify16(__m128i v, uint64_t *backslash, uint64_t *quote, uint64_t *whitespace) {
+    __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    *backslash = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    *quote = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    *whitespace = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                                           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')))));
+    return (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+                                                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(',')))));
+}
+
+static inline AUCJSONBlockMasks AUCJSONClassifySSE2(const uint8_t *block) {
+    AUCJSONBlockMasks masks = {0};
+    for (int i = 0; i < 4; i++) {
+        uint64_t backslash, quote, whitespace;
+        uint64_t op = AUCJSONSSE2Classify16(_mm_loadu_si128((const __m128i *)(block + i * 16)), &backslash, &quote, &whitespace);
+        masks.backslash |= backslash << (i * 16);
+        masks.quote |= quote << (i * 16);
+        masks.whitespace |= whitespace << (i * 16);
+        masks.op |= op << (i * 16);
+    }
+    return masks;
+}
+
+static size_t AUCJSONStructuralIndexSSE2(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString) {
+    return AUCJSONIndexBlocks(bytes, length, indexes, unclosedString, AUCJSONClassifySSE2);
+}
+
+#pragma mark - AVX2
+__attribute__((target("avx2")))
+static inline uint64_t AUCJSONAVX2Classify32(__m256i v, uint64_t *backslash, uint64_t *quote, uint64_t *whitespace) {
+    __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    *backslash = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+    *quote = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+    *whitespace = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                                                 _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')))));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+                                                          _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')))));
+}
+
+__attribute__((target("avx2")))
+static inline AUCJSONBlockMasks AUCJSONClassifyAVX2(const uint8_t *block) {
+    uint64_t backslash0, quote0, whitespace0, backslash1, quote1, whitespace1;
+    uint64_t op0 = AUCJSONAVX2Classify32(_mm256_loadu_si256((const __m256i *)block), &backslash0, &quote0, &whitespace0);
+    uint64_t op1 = AUCJSONAVX2Classify32(_mm256_loadu_si256((const __m256i *)(block + 32)), &backslash1, &quote1, &whitespace1);
+    AUCJSONBlockMasks masks;
+    masks.backslash = backslash0 | backslash1 << 32;
+    masks.quote = quote0 | quote1 << 32;
+    masks.whitespace = whitespace0 | whitespace1 << 32;
+    masks.op = op0 | op1 << 32;
+    return masks;
+}
+
+__attribute__((target("avx2")))
+static size_t AUCJSONStructuralIndexAVX2(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString) {
+    return AUCJSONIndexBlocks(bytes, length, indexes, unclosedString, AUCJSONClassifyAVX2);
+}
+
+/// CPU 是否支持 AVX2：Apple 平台查询 sysctl，其余平台使用编译器内建的 CPUID 检测
+static BOOL AUCJSONCPUSupportsAVX2(void) {
+#if defined(__APPLE__)
+    int supported = 0;
+    size_t size = sizeof(supported);
+    return sysctlbyname("hw.optional.avx2_0", &supported, &size, NULL, 0) == 0 && supported;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+typedef size_t (*AUCJSONStructuralIndexFunction)(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString);
+
+static AUCJSONStructuralIndexFunction AUCJSONStructuralIndexSelected;
+static const char *AUCJSONStructuralIndexSelectedName;
+
+/// 运行时检测 CPU 特性；NEON 与 SSE2 分别是 arm64 与 x86_64 的基础指令集，无需检测
+static void AUCJSONStructuralIndexSelectFunction(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+#if defined(__aarch64__)
+        AUCJSONStructuralIndexSelected = AUCJSONStructuralIndexNeon;
+        AUCJSONStructuralIndexSelectedName = "neon";
+#elif defined(__x86_64__)
+        if (AUCJSONCPUSupportsAVX2()) {
+            AUCJSONStructuralIndexSelected = AUCJSONStructuralIndexAVX2;
+            AUCJSONStructuralIndexSelectedName = "avx2";
+        } else {
+            AUCJSONStructuralIndexSelected = AUCJSONStructuralIndexSSE2;
+            AUCJSONStructuralIndexSelectedName = "sse2";
+        }
+#else
+        AUCJSONInitCharClassTable();
+        AUCJSONStructuralIndexSelected = AUCJSONStructuralIndexScalar;
+        AUCJSONStructuralIndexSelectedName = "scalar";
+#endif
+    });
+}
+
+size_t AUCJSONBuildStructuralIndex(const uint8_t *bytes, size_t length, uint32_t *indexes, BOOL *unclosedString) {
+    AUCJSONStructuralIndexSelectFunction();
+    if (!bytes || length == 0 || length > UINT32_MAX) {
+        if (unclosedString) *unclosedString = NO;
+        return 0;
+    }
+    return AUCJSONStructuralIndexSelected(bytes, length, indexes, unclosedString);
+}
+
+const char *AUCJSONStructuralIndexImplementation(void) {
+    AUCJSONStructuralIndexSelectFunction();
+    return AUCJSONStructuralIndexSelectedName;
+}
@@ -0,0 +1,40 @@
+//
+//  AUCMappedData.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/20.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCIOAdvice.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// ``内存映射数据``
+///
+/// 返回由 `mmap` 映射区域支撑的 `NSData`，读取时不把文件内容拷贝到堆内存，映射随 `NSData` 释放而解除
+///
+/// - Note: 映射建立后文件被删除（`unlink`）或被原子写入替换都是安全的，映射仍指向原来的文件内容
+/// - Warning: 映射期间文件不能被原地截断，否则访问数据会触发 `SIGBUS`，因此只应对以原子方式写入或只追加的文件使用
+@interface AUCMappedData : NSObject
+
+/// 映射整个文件，文件不存在或映射失败时返回 nil
++ (nullable NSData *)dataWithContentsOfFile:(nonnull NSString *)path;
+
+/// 映射文件描述符中的一段区域，偏移无需按页对齐
+///
+/// - Parameters:
+///     - fd: 已打开的文件描述符，映射建立后可以立即关闭
+///     - offset: 区域起始偏移
+///     - length: 区域长度
++ (nullable NSData *)dataWithFileDescriptor:(int)fd offset:(uint64_t)offset length:(NSUInteger)length;
+
+/// 映射整个文件，并按 `pattern` 提示内核映射区域的访问方式
++ (nullable NSData *)dataWithContentsOfFile:(nonnull NSString *)path accessPattern:(AUCIOAccessPattern)pattern;
+
+/// 映射文件描述符中的一段区域，并按 `pattern` 提示内核映射区域的访问方式
++ (nullable NSData *)dataWithFileDescriptor:(int)fd offset:(uint64_t)offset length:(NSUInteger)length accessPattern:(AUCIOAccessPattern)pattern;
+
+@end
+
+NS_ASSUME_NONNULL_END
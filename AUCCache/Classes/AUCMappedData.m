@@ -0,0 +1,56 @@
+//
+//  AUCMappedData.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/20.
+//
+
+#import "AUCMappedData.h"
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+
+@implementation AUCMappedData
+
++ (NSData *)dataWithContentsOfFile:(NSString *)path {
+    return [self dataWithContentsOfFile:path accessPattern:AUCIOAccessPatternNormal];
+}
+
++ (NSData *)dataWithFileDescriptor:(int)fd offset:(uint64_t)offset length:(NSUInteger)length {
+    return [self dataWithFileDescriptor:fd offset:offset length:length accessPattern:AUCIOAccessPatternNormal];
+}
+
++ (NSData *)dataWithContentsOfFile:(NSString *)path accessPattern:(AUCIOAccessPattern)pattern {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nil;
+
+    NSData *data = nil;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        data = [self dataWithFileDescriptor:fd offset:0 length:(NSUInteger)st.st_size accessPattern:pattern];
+    }
+    // 映射不依赖文件描述符
+    close(fd);
+    return data;
+}
+
++ (NSData *)dataWithFileDescriptor:(int)fd offset:(uint64_t)offset length:(NSUInteger)length accessPattern:(AUCIOAccessPattern)pattern {
+    if (length == 0) return [NSData data];
+
+    // mmap 的偏移必须按页对齐
+    uint64_t pageSize = (uint64_t)getpagesize();
+    uint64_t alignedOffset = offset & ~(pageSize - 1);
+    size_t delta = (size_t)(offset - alignedOffset);
+    size_t mappedLength = length + delta;
+
+    void *base = mmap(NULL, mappedLength, PROT_READ, MAP_PRIVATE, fd, (off_t)alignedOffset);
+    if (base == MAP_FAILED) return nil;
+    AUCIOAdviseMemory((uint8_t *)base + delta, length, pattern);
+
+    return [[NSData alloc] initWithBytesNoCopy:(uint8_t *)base + delta length:length deallocator:^(void *bytes, NSUInteger len) {
+        munmap(base, mappedLength);
+    }];
+}
+
+@end
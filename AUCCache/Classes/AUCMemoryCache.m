@@ -10,6 +10,7 @@
 #import "AUCCacheConfig.h"
 #import "AUCCompat.h"
 #import "AUCInternalMacros.h"
+#import "AUCCacheCostEstimator.h"
 
 static void * AUCMemoryCacheContext = &AUCMemoryCacheContext;
 @interface AUCMemoryCache <KeyType, ObjectType> ()
@@ -102,7 +103,7 @@ static void * AUCMemoryCacheContext = &AUCMemoryCacheContext;
         AUC_DISPATCH_SEMAPHORE_UNLOCK(self.weakCacheLock);
         if (obj) {
             // 同步缓存
-            NSUInteger cost = 0;
+            NSUInteger cost = [self.config.memoryCostEstimator costForObject:obj];
             [super setObject:obj forKey:key cost:cost];
         }
     }
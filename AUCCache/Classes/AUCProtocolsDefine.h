@@ -12,6 +12,7 @@
 #import "AUCTypeDefines.h"
 
 @class AUCCacheConfig;
+@class AUCDiskCacheRecoveryReport;
 #pragma mark - 缓存
 /// ``提供缓存的基本功能协议``
 /// 如果基本功能无法满足具体需求，需要更高级的功能，可以实现此协议并提供给 `AUCNetwork、AUCCachesManager` 等类使用
@@ -142,7 +143,8 @@
 #pragma mark - 磁盘缓存协议 AUCDiskCacheProtocol
 @protocol AUCDiskCacheProtocol <NSObject>
 
-/// - Attention: 所有这些方法都从同一个全局队列中调用，以避免主队列阻塞和线程安全问题
+/// - Attention: 所有这些方法都从 `AUCCacheCombine` 的 IO 调度器中调用，以避免主队列阻塞；同一个键的操作总是串行执行
+/// - Note: `diskCacheIOConcurrency` 大于 1 时，不同键的操作可能在多个线程中同时调用，自定义磁盘缓存默认串行调用
 /// - Note: 也建议使用锁或其他方法确保线程安全
 @required
 /// 根据指定路径创建新磁盘缓存。可以检查磁盘缓存使用的 "maxDiskSize "和 "maxDiskAge"
@@ -233,6 +235,80 @@
 /// - Warning: 该方法可能会阻塞调用线程，直到文件读取完成
 - (NSUInteger)totalSize;
 
+@optional
+/// 在时间预算内分批删除过期数据
+///
+/// - Parameter timeBudget - 本次调用最多占用的时间，单位为【秒】，小于等于 0 表示不限制
+/// - Returns: 维护是否已全部完成，返回 NO 时调用方应稍后再次调用以继续
+/// - Note: 实现该方法后，`AUCCacheCombine` 会把过期清理拆分为多个时间片，时间片之间让出 IO 队列给其他读写操作
+- (BOOL)removeExpiredDataWithTimeBudget:(NSTimeInterval)timeBudget;
+
+/// 批量写入数据
+///
+/// - Parameter dataBatch - 键 -> 数据
+/// - Note: 实现该方法后，`AUCCacheCombine` 组提交的一批写入只需一次同步（例如一个事务），未实现时逐个调用 `setData:forKey:`
+- (void)setDataBatch:(nonnull NSDictionary<NSString *, NSData *> *)dataBatch;
+
+/// 在时间预算内增量执行启动恢复：元数据与数据文件对账、清除残缺尾部、删除崩溃遗留的孤立文件
+///
+/// - Parameters:
+///     - timeBudget: 本次调用最多占用的时间，单位为【秒】，小于等于 0 表示不限制
+///     - report: 累计修复数量
+/// - Returns: 恢复是否已全部完成，返回 NO 时调用方应稍后再次调用以继续
+/// - Note: 实现该方法后，`AUCCacheCombine` 初始化后会在 IO 队列中分片执行恢复，恢复期间仍可正常读写
+- (BOOL)recoverWithTimeBudget:(NSTimeInterval)timeBudget report:(nonnull AUCDiskCacheRecoveryReport *)report;
+
+/// 预读一批即将访问的缓存数据
+///
+/// - Parameter keys: 缓存键列表，不存在的键直接忽略
+/// - Note: 只向内核发出预读提示，不读取也不返回数据，调用后立即返回
+- (void)prefetchDataForKeys:(nonnull NSArray<NSString *> *)keys;
+
+/// 设置数据并同时设置扩展数据，两者写在同一条记录中
+///
+/// - Parameters:
+///     - data: 要存储在缓存中的数据
+///     - extendedData: 扩展数据，nil 表示不带扩展数据
+///     - key: 数据缓存键
+/// - Note: 与先后调用 `setData:forKey:`、`setExtendedData:forKey:` 相比只写入一次，中途崩溃不会留下没有扩展数据的值
+- (void)setData:(nonnull NSData *)data extendedData:(nullable NSData *)extendedData forKey:(nonnull NSString *)key;
+
+/// 批量读取扩展数据
+///
+/// - Parameter keys: 缓存键列表
+/// - Returns: 键 -> 扩展数据，不存在或没有扩展数据的键不包含在结果中
+/// - Note: 实现该方法后，一次加锁（或一次查询）完成整批读取，未实现时逐个调用 `extendedDataForKey:`
+- (nonnull NSDictionary<NSString *, NSData *> *)extendedDataForKeys:(nonnull NSArray<NSString *> *)keys;
+
+/// 校验一部分缓存数据，删除已损坏的数据
+///
+/// - Parameter byteLimit: 本次最多读取的字节数，0 表示校验全部
+/// - Returns: 删除的损坏数据数量
+/// - Note: 实现该方法且 `diskCacheChecksumMode` 不为 `AUCCacheDiskChecksumModeOff` 时，`AUCCacheCombine` 启动一段时间后会在 IO 队列中以维护优先级分片调用，调用期间没有其他读写
+- (NSUInteger)scrubDataWithByteLimit:(NSUInteger)byteLimit;
+
+@end
+
+#pragma mark - 磁盘数据编解码协议 AUCCacheCodecProtocol
+/// ``磁盘数据编解码协议``
+///
+/// 写入磁盘前把缓存对象编码为数据，读取时解码；编码结果带有 `codecTag`，读取时按标签选择解码器
+/// - Note: 编解码在 IO 调度器中调用，可能在多个线程中同时调用，实现需保证线程安全
+@protocol AUCCacheCodecProtocol <NSObject>
+
+@required
+/// 写入数据帧的标签，1 ~ 127 保留给内置编解码器，自定义编解码器使用 128 ~ 255
+@property (nonatomic, assign, readonly) uint8_t codecTag;
+
+/// 是否可以编码该对象，编码时按注册顺序选择第一个返回 YES 的编解码器
+- (BOOL)canEncodeObject:(nonnull id)object;
+
+/// 编码对象，失败时返回 nil
+- (nullable NSData *)encodedDataWithObject:(nonnull id)object;
+
+/// 解码数据，失败时返回 nil，按未命中处理
+- (nullable id)decodedObjectWithData:(nonnull NSData *)data;
+
 @end
 
 
@@ -0,0 +1,35 @@
+//
+//  AUCSQLiteDiskCache.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/18.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCProtocolsDefine.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class AUCCacheConfig;
+/// ``SQLite 混合磁盘缓存``
+///
+/// 元数据与小数据内联保存在 WAL 模式的 SQLite 数据库中，超过阈值的数据写入独立文件，数据库行中只记录文件名
+/// ```
+/// diskCachePath
+///    ├── manifest.sqlite    key、文件名、大小、内联数据、扩展数据、创建/修改/访问时间
+///    ├── manifest.sqlite-wal
+///    ├── manifest.sqlite-shm
+///    ├── data/              超过 `diskCacheInlineThreshold` 的数据文件
+/// ```
+///
+/// - Note: 通过 `AUCCacheConfig.diskCacheClass = AUCSQLiteDiskCache.class` 启用
+/// - Note: 扩展数据保存在 `extended_data` 列中，不再使用文件扩展属性
+/// - Note: 所有 SQL 语句均预编译并缓存复用；数据库无法打开时会删除后重建
+@interface AUCSQLiteDiskCache : NSObject <AUCDiskCacheProtocol>
+
+@property (nonatomic, strong, nonnull, readonly) AUCCacheConfig *config;
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,645 @@
+//
+//  AUCSQLiteDiskCache.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/18.
+//
+
+#import "AUCSQLiteDiskCache.h"
+#import "AUCCacheConfig.h"
+#import "AUCInternalMacros.h"
+#import "AUCMappedData.h"
+#import "AUCDiskCacheRecoveryReport.h"
+#import "AUCIOAdvice.h"
+#import "AUCCacheKey.h"
+#import <sqlite3.h>
+#import <dirent.h>
+#import <sys/stat.h>
+
+static NSString * const AUC_SQLITE_DB_FILE_NAME = @"manifest.sqlite";
+static NSString * const AUC_SQLITE_DB_WAL_FILE_NAME = @"manifest.sqlite-wal";
+static NSString * const AUC_SQLITE_DB_SHM_FILE_NAME = @"manifest.sqlite-shm";
+static NSString * const AUC_SQLITE_DATA_DIRECTORY_NAME = @"data";
+// 过期清理每批处理的行数
+static const int AUC_SQLITE_EVICTION_BATCH_COUNT = 32;
+
+static inline int64_t AUCSQLiteCurrentTime(void) {
+    return (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+}
+
+@interface AUCSQLiteDiskCache ()
+
+@property (nonatomic, copy) NSString *diskCachePath;
+@property (nonatomic, copy) NSString *dbPath;
+@property (nonatomic, copy) NSString *dataPath;
+@property (nonatomic, strong, nonnull) NSFileManager *fileManager;
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t lock;
+/// 正在按 `maxDiskSize` 清理，直到低于最大大小的一半
+@property (nonatomic, assign) BOOL trimmingToSize;
+
+@end
+
+@implementation AUCSQLiteDiskCache {
+    sqlite3 *_db;
+    /// SQL -> sqlite3_stmt
+    CFMutableDictionaryRef _stmtCache;
+    /// 启动恢复状态：正在扫描的数据目录、恢复开始时被引用的数据文件
+    DIR *_recoveryDirectory;
+    NSMutableSet<NSString *> *_referencedFileNames;
+    int64_t _recoveryStartTime;
+}
+
+- (instancetype)init {
+    NSAssert(NO, @"请使用 `initWithCachePath:` 用磁盘缓存路径创建实例对象");
+    return nil;
+}
+
+#pragma mark - AUCDiskCacheProtocol
+- (instancetype)initWithCachePath:(NSString *)cachePath config:(nonnull AUCCacheConfig *)config {
+    if (self = [super init]) {
+        _diskCachePath = cachePath;
+        _config = config;
+        [self commonInit];
+    }
+    return self;
+}
+
+- (void)commonInit {
+    if (self.config.fileManager) {
+        self.fileManager = self.config.fileManager;
+    } else {
+        self.fileManager = [NSFileManager new];
+    }
+    self.lock = dispatch_semaphore_create(1);
+    self.dbPath = [self.diskCachePath stringByAppendingPathComponent:AUC_SQLITE_DB_FILE_NAME];
+    self.dataPath = [self.diskCachePath stringByAppendingPathComponent:AUC_SQLITE_DATA_DIRECTORY_NAME];
+
+    if (![self dbOpen] || ![self dbInitialize]) {
+        // 数据库损坏，删除后重建
+        [self dbClose];
+        [self resetDirectory];
+        if (![self dbOpen] || ![self dbInitialize]) {
+            [self dbClose];
+        }
+    }
+}
+
+- (void)dealloc {
+    if (_recoveryDirectory) closedir(_recoveryDirectory);
+    [self dbClose];
+}
+
+- (BOOL)containsDataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return NO;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    BOOL exists = NO;
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"select 1 from manifest where key = ?1;"];
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+        exists = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_reset(stmt);
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return exists;
+}
+
+- (NSData *)dataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return nil;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSData *data = nil;
+    NSString *fileName = nil;
+    NSUInteger size = 0;
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"select filename, inline_data, size from manifest where key = ?1;"];
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *name = (const char *)sqlite3_column_text(stmt, 0);
+            if (name) {
+                fileName = [NSString stringWithUTF8String:name];
+                size = (NSUInteger)sqlite3_column_int64(stmt, 2);
+            } else {
+                const void *bytes = sqlite3_column_blob(stmt, 1);
+                int length = sqlite3_column_bytes(stmt, 1);
+                data = [NSData dataWithBytes:bytes length:length];
+            }
+        }
+        sqlite3_reset(stmt);
+    }
+    if (fileName) {
+        NSString *filePath = [self.dataPath stringByAppendingPathComponent:fileName];
+        if ([self shouldMapDataOfLength:size]) {
+            data = [AUCMappedData dataWithContentsOfFile:filePath accessPattern:AUCIOAccessPatternSequential];
+        }
+        if (!data) {
+            data = [NSData dataWithContentsOfFile:filePath options:[self readingOptionsForLength:size] error:nil];
+        }
+        if (!data) {
+            // 数据文件已丢失，删除无效的行
+            [self dbDeleteRowForKey:key];
+        }
+    }
+    if (data) {
+        [self dbUpdateAccessTimeForKey:key];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return data;
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key {
+    NSParameterAssert(data);
+    NSParameterAssert(key);
+    if (!data || !key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self _setData:data forKey:key];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)prefetchDataForKeys:(NSArray<NSString *> *)keys {
+    // 内联数据位于数据库页中，只预读独立保存的数据文件
+    NSMutableArray<NSString *> *filePaths = [NSMutableArray array];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    for (NSString *key in keys) {
+        NSString *fileName = [self dbFileNameForKey:key];
+        if (fileName) [filePaths addObject:[self.dataPath stringByAppendingPathComponent:fileName]];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    for (NSString *filePath in filePaths) {
+        AUCIOPrefetchFile(filePath);
+    }
+}
+
+- (void)setDataBatch:(NSDictionary<NSString *, NSData *> *)dataBatch {
+    if (dataBatch.count == 0) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    // 整批写入放在一个事务中，只在提交时同步一次 WAL
+    BOOL inTransaction = [self dbExecute:@"begin immediate transaction;"];
+    [dataBatch enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSData *data, BOOL *stop) {
+        [self _setData:data forKey:key];
+    }];
+    if (inTransaction) [self dbExecute:@"commit transaction;"];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)setData:(NSData *)data extendedData:(NSData *)extendedData forKey:(NSString *)key {
+    NSParameterAssert(data);
+    NSParameterAssert(key);
+    if (!data || !key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    // 数据与扩展数据在同一个事务中提交
+    BOOL inTransaction = [self dbExecute:@"begin immediate transaction;"];
+    [self _setData:data forKey:key];
+    [self _setExtendedData:extendedData forKey:key];
+    if (inTransaction) [self dbExecute:@"commit transaction;"];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (NSData *)extendedDataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return nil;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSData *extendedData = [self _extendedDataForKey:key];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return extendedData;
+}
+
+- (NSDictionary<NSString *, NSData *> *)extendedDataForKeys:(NSArray<NSString *> *)keys {
+    NSMutableDictionary<NSString *, NSData *> *extendedDataMap = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    if (keys.count == 0) return extendedDataMap;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    // 整批查询在一个读事务中完成，复用同一条预编译语句
+    BOOL inTransaction = [self dbExecute:@"begin transaction;"];
+    for (NSString *key in keys) {
+        NSData *extendedData = [self _extendedDataForKey:key];
+        if (extendedData) extendedDataMap[key] = extendedData;
+    }
+    if (inTransaction) [self dbExecute:@"commit transaction;"];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return extendedDataMap;
+}
+
+- (void)setExtendedData:(NSData *)extendedData forKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self _setExtendedData:extendedData forKey:key];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeCacheForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSString *fileName = [self dbFileNameForKey:key];
+    // 先删除行再删除文件
+    if ([self dbDeleteRowForKey:key] && fileName) {
+        [self removeDataFile:fileName];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeAllData {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self dbClose];
+    [self resetDirectory];
+    if (![self dbOpen] || ![self dbInitialize]) {
+        [self dbClose];
+    }
+    self.trimmingToSize = NO;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeExpiredData {
+    [self removeExpiredDataWithTimeBudget:0];
+}
+
+- (BOOL)removeExpiredDataWithTimeBudget:(NSTimeInterval)timeBudget {
+    CFAbsoluteTime deadline = timeBudget > 0 ? CFAbsoluteTimeGetCurrent() + timeBudget : DBL_MAX;
+    NSString *column = [self expireTimeColumn];
+    BOOL finished = YES;
+
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    // 1. 删除过期数据，按时间索引从旧到新分批删除
+    if (self.config.maxDiskAge >= 0) {
+        int64_t expirationTime = AUCSQLiteCurrentTime() - (int64_t)(self.config.maxDiskAge * 1000);
+        NSString *sql = [NSString stringWithFormat:@"select key, filename from manifest where %@ <= ?1 order by %@ asc limit ?2;", column, column];
+        while (finished) {
+            sqlite3_stmt *stmt = [self dbPrepareStmt:sql];
+            if (!stmt) break;
+            sqlite3_bind_int64(stmt, 1, expirationTime);
+            sqlite3_bind_int(stmt, 2, AUC_SQLITE_EVICTION_BATCH_COUNT);
+            NSUInteger removed = [self dbRemoveRowsFromStmt:stmt];
+            if (removed < AUC_SQLITE_EVICTION_BATCH_COUNT) break;
+            if (CFAbsoluteTimeGetCurrent() >= deadline) finished = NO;
+        }
+    }
+
+    // 2. 超过最大大小时从旧到新删除，直到低于最大大小的一半，清理状态跨时间片保留
+    NSUInteger maxDiskSize = self.config.maxDiskSize;
+    if (finished && maxDiskSize > 0) {
+        if ([self dbTotalSize] > maxDiskSize) {
+            self.trimmingToSize = YES;
+        }
+        NSString *sql = [NSString stringWithFormat:@"select key, filename from manifest order by %@ asc limit ?1;", column];
+        while (self.trimmingToSize) {
+            if ([self dbTotalSize] < maxDiskSize / 2) {
+                self.trimmingToSize = NO;
+                break;
+            }
+            sqlite3_stmt *stmt = [self dbPrepareStmt:sql];
+            if (!stmt) break;
+            sqlite3_bind_int(stmt, 1, AUC_SQLITE_EVICTION_BATCH_COUNT);
+            if ([self dbRemoveRowsFromStmt:stmt] == 0) {
+                self.trimmingToSize = NO;
+                break;
+            }
+            if (CFAbsoluteTimeGetCurrent() >= deadline) {
+                finished = NO;
+                break;
+            }
+        }
+    }
+
+    if (finished && _db) {
+        // 维护结束后把 WAL 合并回主数据库
+        sqlite3_wal_checkpoint(_db, NULL);
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return finished;
+}
+
+- (nullable NSString *)cachePathForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return nil;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    // 内联保存的数据没有独立路径
+    NSString *fileName = [self dbFileNameForKey:key];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return fileName ? [self.dataPath stringByAppendingPathComponent:fileName] : nil;
+}
+
+- (NSUInteger)totalCount {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger count = 0;
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"select count(*) from manifest;"];
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        count = (NSUInteger)sqlite3_column_int64(stmt, 0);
+        sqlite3_reset(stmt);
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return count;
+}
+
+- (NSUInteger)totalSize {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger size = [self dbTotalSize];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return size;
+}
+
+- (BOOL)recoverWithTimeBudget:(NSTimeInterval)timeBudget report:(AUCDiskCacheRecoveryReport *)report {
+    CFAbsoluteTime deadline = timeBudget > 0 ? CFAbsoluteTimeGetCurrent() + timeBudget : DBL_MAX;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    if (!_referencedFileNames) {
+        // 数据库自身由 WAL 保证一致，只需清理先写文件、再写行之间崩溃遗留的数据文件
+        _recoveryStartTime = AUCSQLiteCurrentTime();
+        _referencedFileNames = [NSMutableSet set];
+        sqlite3_stmt *stmt = [self dbPrepareStmt:@"select filename from manifest where filename is not null;"];
+        while (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *fileName = (const char *)sqlite3_column_text(stmt, 0);
+            if (fileName) [_referencedFileNames addObject:[NSString stringWithUTF8String:fileName]];
+        }
+        if (stmt) sqlite3_reset(stmt);
+        _recoveryDirectory = opendir(self.dataPath.fileSystemRepresentation);
+    }
+
+    BOOL finished = YES;
+    NSUInteger scanned = 0;
+    struct dirent *dirent;
+    while (_recoveryDirectory && (dirent = readdir(_recoveryDirectory))) {
+        if (strcmp(dirent->d_name, ".") != 0 && strcmp(dirent->d_name, "..") != 0) {
+            @autoreleasepool {
+                [self removeDataFileIfOrphaned:[NSString stringWithUTF8String:dirent->d_name] report:report];
+            }
+        }
+        if ((++scanned & 15) == 0 && CFAbsoluteTimeGetCurrent() >= deadline) {
+            finished = NO;
+            break;
+        }
+    }
+    if (finished) {
+        if (_recoveryDirectory) closedir(_recoveryDirectory);
+        _recoveryDirectory = NULL;
+        _referencedFileNames = nil;
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return finished;
+}
+
+#pragma mark - Write（调用方需持有锁）
+- (void)_setData:(NSData *)data forKey:(NSString *)key {
+    NSString *oldFileName = [self dbFileNameForKey:key];
+    NSString *fileName = nil;
+    if (data.length > self.config.diskCacheInlineThreshold) {
+        // 大数据写入独立文件，先写文件再写行，中途崩溃最多留下一个孤立文件
+        fileName = AUCSQLiteFileNameForKey(key);
+        if (![self writeData:data fileName:fileName]) return;
+    }
+    BOOL saved = [self dbSaveKey:key data:data fileName:fileName];
+    if (oldFileName && (!saved || !fileName)) {
+        // 原先以文件保存，现在改为内联保存，或写入行失败
+        [self removeDataFile:oldFileName];
+    }
+}
+
+- (nullable NSData *)_extendedDataForKey:(NSString *)key {
+    NSData *extendedData = nil;
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"select extended_data from manifest where key = ?1;"];
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+            const void *bytes = sqlite3_column_blob(stmt, 0);
+            int length = sqlite3_column_bytes(stmt, 0);
+            extendedData = [NSData dataWithBytes:bytes length:length];
+        }
+        sqlite3_reset(stmt);
+    }
+    return extendedData;
+}
+
+- (void)_setExtendedData:(nullable NSData *)extendedData forKey:(NSString *)key {
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"update manifest set extended_data = ?1 where key = ?2;"];
+    if (stmt) {
+        if (extendedData) {
+            sqlite3_bind_blob(stmt, 1, extendedData.bytes, (int)extendedData.length, NULL);
+        } else {
+            sqlite3_bind_null(stmt, 1);
+        }
+        sqlite3_bind_text(stmt, 2, key.UTF8String, -1, NULL);
+        sqlite3_step(stmt);
+    }
+}
+
+#pragma mark - Files（调用方需持有锁）
+- (void)resetDirectory {
+    [self.fileManager removeItemAtPath:self.dbPath error:nil];
+    [self.fileManager removeItemAtPath:[self.diskCachePath stringByAppendingPathComponent:AUC_SQLITE_DB_WAL_FILE_NAME] error:nil];
+    [self.fileManager removeItemAtPath:[self.diskCachePath stringByAppendingPathComponent:AUC_SQLITE_DB_SHM_FILE_NAME] error:nil];
+    [self.fileManager removeItemAtPath:self.dataPath error:nil];
+}
+
+- (BOOL)writeData:(NSData *)data fileName:(NSString *)fileName {
+    if (![self.fileManager fileExistsAtPath:self.dataPath]) {
+        [self.fileManager createDirectoryAtPath:self.dataPath withIntermediateDirectories:YES attributes:nil error:NULL];
+    }
+    NSURL *fileURL = [NSURL fileURLWithPath:[self.dataPath stringByAppendingPathComponent:fileName]];
+    return [data writeToURL:fileURL options:self.config.diskCacheWritingOptions error:nil];
+}
+
+/// 删除恢复开始前写入、但没有被任何行引用的数据文件（包括原子写入遗留的临时文件）
+- (void)removeDataFileIfOrphaned:(NSString *)fileName report:(AUCDiskCacheRecoveryReport *)report {
+    if ([_referencedFileNames containsObject:fileName]) return;
+    NSString *filePath = [self.dataPath stringByAppendingPathComponent:fileName];
+    struct stat st;
+    if (lstat(filePath.fileSystemRepresentation, &st) != 0 || !S_ISREG(st.st_mode)) return;
+    // 恢复开始后写入的文件所对应的行同样在恢复开始后插入，不在引用集合中
+#if defined(__APPLE__)
+    int64_t modificationTime = (int64_t)st.st_mtimespec.tv_sec * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#else
+    int64_t modificationTime = (int64_t)st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+    if (modificationTime >= _recoveryStartTime) return;
+    if (unlink(filePath.fileSystemRepresentation) == 0) {
+        report.removedOrphanFileCount++;
+    }
+}
+
+- (void)removeDataFile:(NSString *)fileName {
+    [self.fileManager removeItemAtPath:[self.dataPath stringByAppendingPathComponent:fileName] error:nil];
+}
+
+/// 大数据使用内存映射读取，只有原子写入时映射才不会因文件被原地截断而失效
+- (BOOL)shouldMapDataOfLength:(NSUInteger)length {
+    NSUInteger threshold = self.config.diskCacheMappingThreshold;
+    if (threshold == 0 || length < threshold) return NO;
+    return AUC_OPTIONS_CONTAINS(self.config.diskCacheWritingOptions, NSDataWritingAtomic);
+}
+
+/// 无法映射的大数据读取时绕过页缓存，避免一次性读取挤出应用反复使用的页
+- (NSDataReadingOptions)readingOptionsForLength:(NSUInteger)length {
+    NSDataReadingOptions options = self.config.diskCacheReadingOptions;
+    NSUInteger threshold = self.config.diskCacheMappingThreshold;
+    if (threshold > 0 && length >= threshold) {
+        options |= NSDataReadingUncached;
+    }
+    return options;
+}
+
+- (NSString *)expireTimeColumn {
+    switch (self.config.diskCacheExpireType) {
+        case AUCCacheConfigExpireTypeAccessDate:
+            return @"access_time";
+        case AUCCacheConfigExpireTypeCreationDate:
+            return @"creation_time";
+        default:
+            return @"modification_time";
+    }
+}
+
+#pragma mark - Database（调用方需持有锁）
+- (BOOL)dbOpen {
+    if (_db) return YES;
+    if (![self.fileManager fileExistsAtPath:self.diskCachePath]) {
+        [self.fileManager createDirectoryAtPath:self.diskCachePath withIntermediateDirectories:YES attributes:nil error:NULL];
+        // 禁用 `iCloud` 备份，数据库与数据文件都位于该目录下，只需设置一次
+        if (self.config.shouldDisableICloud) {
+            NSURL *directoryURL = [NSURL fileURLWithPath:self.diskCachePath isDirectory:YES];
+            [directoryURL setResourceValue:@YES forKey:NSURLIsExcludedFromBackupKey error:nil];
+        }
+    }
+    int result = sqlite3_open_v2(self.dbPath.fileSystemRepresentation, &_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+    if (result != SQLITE_OK) {
+        if (_db) sqlite3_close(_db);
+        _db = NULL;
+        return NO;
+    }
+    CFDictionaryKeyCallBacks keyCallbacks = kCFCopyStringDictionaryKeyCallBacks;
+    CFDictionaryValueCallBacks valueCallbacks = {0};
+    _stmtCache = CFDictionaryCreateMutable(CFAllocatorGetDefault(), 0, &keyCallbacks, &valueCallbacks);
+    return YES;
+}
+
+static void AUCSQLiteFinalizeStmt(const void *key, const void *value, void *context) {
+    sqlite3_finalize((sqlite3_stmt *)value);
+}
+
+- (void)dbClose {
+    if (_stmtCache) {
+        CFDictionaryApplyFunction(_stmtCache, AUCSQLiteFinalizeStmt, NULL);
+        CFRelease(_stmtCache);
+        _stmtCache = NULL;
+    }
+    if (_db) {
+        sqlite3_close(_db);
+        _db = NULL;
+    }
+}
+
+- (BOOL)dbInitialize {
+    NSString *sql = @"pragma journal_mode = wal; pragma synchronous = normal; "
+    "create table if not exists manifest (key text primary key, filename text, size integer, inline_data blob, extended_data blob, "
+    "creation_time integer, modification_time integer, access_time integer); "
+    "create index if not exists manifest_modification_time_idx on manifest(modification_time); "
+    "create index if not exists manifest_access_time_idx on manifest(access_time); "
+    "create index if not exists manifest_creation_time_idx on manifest(creation_time);";
+    return [self dbExecute:sql];
+}
+
+- (BOOL)dbExecute:(NSString *)sql {
+    if (!_db) return NO;
+    return sqlite3_exec(_db, sql.UTF8String, NULL, NULL, NULL) == SQLITE_OK;
+}
+
+/// 返回缓存的预编译语句，已重置并清除绑定
+- (nullable sqlite3_stmt *)dbPrepareStmt:(NSString *)sql {
+    if (!_db || !_stmtCache) return NULL;
+    sqlite3_stmt *stmt = (sqlite3_stmt *)CFDictionaryGetValue(_stmtCache, (__bridge const void *)sql);
+    if (!stmt) {
+        if (sqlite3_prepare_v2(_db, sql.UTF8String, -1, &stmt, NULL) != SQLITE_OK) return NULL;
+        CFDictionarySetValue(_stmtCache, (__bridge const void *)sql, stmt);
+    } else {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    return stmt;
+}
+
+- (BOOL)dbSaveKey:(NSString *)key data:(NSData *)data fileName:(nullable NSString *)fileName {
+    // 系统 SQLite 版本不一定支持 upsert，先更新（保留创建时间），不存在时再插入
+    NSString *updateSQL = @"update manifest set filename = ?2, size = ?3, inline_data = ?4, modification_time = ?5, access_time = ?5 where key = ?1;";
+    NSString *insertSQL = @"insert into manifest (key, filename, size, inline_data, creation_time, modification_time, access_time) values (?1, ?2, ?3, ?4, ?5, ?5, ?5);";
+    int64_t now = AUCSQLiteCurrentTime();
+    for (NSString *sql in @[updateSQL, insertSQL]) {
+        sqlite3_stmt *stmt = [self dbPrepareStmt:sql];
+        if (!stmt) return NO;
+        sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+        if (fileName) {
+            sqlite3_bind_text(stmt, 2, fileName.UTF8String, -1, NULL);
+            sqlite3_bind_null(stmt, 4);
+        } else {
+            sqlite3_bind_null(stmt, 2);
+            sqlite3_bind_blob(stmt, 4, data.bytes, (int)data.length, NULL);
+        }
+        sqlite3_bind_int64(stmt, 3, (int64_t)data.length);
+        sqlite3_bind_int64(stmt, 5, now);
+        if (sqlite3_step(stmt) != SQLITE_DONE) return NO;
+        if (sqlite3_changes(_db) > 0) return YES;
+    }
+    return NO;
+}
+
+- (nullable NSString *)dbFileNameForKey:(NSString *)key {
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"select filename from manifest where key = ?1;"];
+    if (!stmt) return nil;
+    sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return nil;
+    const char *name = (const char *)sqlite3_column_text(stmt, 0);
+    NSString *fileName = name ? [NSString stringWithUTF8String:name] : nil;
+    // 及时结束读事务，避免阻塞 WAL 检查点
+    sqlite3_reset(stmt);
+    return fileName;
+}
+
+- (BOOL)dbDeleteRowForKey:(NSString *)key {
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"delete from manifest where key = ?1;"];
+    if (!stmt) return NO;
+    sqlite3_bind_text(stmt, 1, key.UTF8String, -1, NULL);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+- (void)dbUpdateAccessTimeForKey:(NSString *)key {
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"update manifest set access_time = ?1 where key = ?2;"];
+    if (!stmt) return;
+    sqlite3_bind_int64(stmt, 1, AUCSQLiteCurrentTime());
+    sqlite3_bind_text(stmt, 2, key.UTF8String, -1, NULL);
+    sqlite3_step(stmt);
+}
+
+- (NSUInteger)dbTotalSize {
+    sqlite3_stmt *stmt = [self dbPrepareStmt:@"select sum(size) from manifest;"];
+    if (!stmt || sqlite3_step(stmt) != SQLITE_ROW) return 0;
+    NSUInteger size = (NSUInteger)sqlite3_column_int64(stmt, 0);
+    sqlite3_reset(stmt);
+    return size;
+}
+
+/// 删除查询语句返回的所有行 `(key, filename)` 及其数据文件，返回删除的行数
+- (NSUInteger)dbRemoveRowsFromStmt:(sqlite3_stmt *)stmt {
+    NSMutableArray<NSString *> *keys = [NSMutableArray array];
+    NSMutableArray<NSString *> *fileNames = [NSMutableArray array];
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *key = (const char *)sqlite3_column_text(stmt, 0);
+        const char *fileName = (const char *)sqlite3_column_text(stmt, 1);
+        if (key) [keys addObject:[NSString stringWithUTF8String:key]];
+        if (fileName) [fileNames addObject:[NSString stringWithUTF8String:fileName]];
+    }
+    if (keys.count == 0) return 0;
+
+    [self dbExecute:@"begin immediate transaction;"];
+    for (NSString *key in keys) {
+        [self dbDeleteRowForKey:key];
+    }
+    [self dbExecute:@"commit transaction;"];
+    for (NSString *fileName in fileNames) {
+        [self removeDataFile:fileName];
+    }
+    return keys.count;
+}
+
+#pragma mark - Hash
+static inline NSString * _Nonnull AUCSQLiteFileNameForKey(NSString * _Nonnull key) {
+    return AUCCacheKeyFileNameForDigest([AUCCacheKey keyWithString:key].digest, nil);
+}
+
+@end
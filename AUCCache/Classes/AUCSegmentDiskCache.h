@@ -0,0 +1,39 @@
+//
+//  AUCSegmentDiskCache.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/12.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCProtocolsDefine.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class AUCCacheConfig;
+/// ``日志结构分段磁盘缓存``
+///
+/// 所有写入以记录的形式顺序追加到预分配的分段文件中，内存中维护 `key -> (分段, 偏移, 长度)` 索引，读取时使用 `pread` 直接定位
+/// 相比 `AUCDiskCache` 一键一文件的方式，小数据写入不再产生临时文件、重命名和 inode 开销
+/// ```
+/// 记录格式（小端）
+///    ├── header    magic、版本、标记位、键长、值长、扩展数据长、记录头校验和、写入时间（32 字节）
+///    ├── key       UTF-8 键
+///    ├── value     数据
+///    ├── extended  扩展数据
+///    ├── checksum  CRC32C(header + key + value + extended)
+/// ```
+///
+/// - Note: 通过 `AUCCacheConfig.diskCacheClass = AUCSegmentDiskCache.class` 启用
+/// - Note: 删除与过期淘汰都写入墓碑记录；`removeExpiredData` 会淘汰过期数据、按 `maxDiskSize` 整段淘汰最旧分段，并按有效比例从低到高压缩有效数据不足一半的分段
+/// - Note: 启动时顺序扫描所有分段重建索引，数据校验失败的记录被跳过；记录头无法识别或校验失败时向后查找下一条记录，之后全部为 0 时视为该分段的末尾
+/// - Note: 读取只在查找索引时持有锁，数据在锁外读取；读取期间分段被固定，压缩会跳过该分段，分段被删除时文件描述符在读取结束后才关闭
+/// - Note: 只会清零最后一个（追加写入的）分段末尾残缺的记录，已封存的分段从不改写
+@interface AUCSegmentDiskCache : NSObject <AUCDiskCacheProtocol>
+
+@property (nonatomic, strong, nonnull, readonly) AUCCacheConfig *config;
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,856 @@
+//
+//  AUCSegmentDiskCache.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/12.
+//
+
+#import "AUCSegmentDiskCache.h"
+#import "AUCCacheConfig.h"
+#import "AUCChecksum.h"
+#import "AUCMappedData.h"
+#import "AUCInternalMacros.h"
+#import "AUCDiskCacheRecoveryReport.h"
+#import "AUCIOAdvice.h"
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/stat.h>
+#import <stdatomic.h>
+
+// 'AUCR'
+static const uint32_t AUC_SEGMENT_RECORD_MAGIC = 0x52435541;
+/// 版本 2 起记录头带有自身的校验和；版本 1 的记录仍可读取
+static const uint16_t AUC_SEGMENT_RECORD_VERSION = 2;
+static const uint16_t AUC_SEGMENT_RECORD_VERSION_LEGACY = 1;
+static NSString * const AUC_SEGMENT_FILE_EXTENSION = @"segment";
+
+typedef NS_OPTIONS(uint16_t, AUCSegmentRecordFlags) {
+    /// 墓碑记录，表示该键已被删除
+    AUCSegmentRecordFlagTombstone = 1 << 0,
+};
+
+/// 记录头，固定 32 字节
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t keyLength;
+    uint32_t valueLength;
+    uint32_t extendedLength;
+    // 记录头的 CRC32C，计算时该字段为 0；版本 1 中为保留字段
+    uint32_t headerChecksum;
+    // 写入时间，单位毫秒
+    int64_t timestamp;
+} AUCSegmentRecordHeader;
+
+typedef NS_ENUM(NSInteger, AUCSegmentRecordCheck) {
+    /// 记录完整有效
+    AUCSegmentRecordCheckValid,
+    /// 记录头校验通过，长度可信，但数据损坏，可以按长度跳过
+    AUCSegmentRecordCheckCorruptPayload,
+    /// 无法识别或记录头损坏，长度不可信，需要重新寻找下一条记录
+    AUCSegmentRecordCheckInvalid,
+};
+
+#define AUC_SEGMENT_RECORD_LENGTH(keyLength, valueLength, extendedLength) \
+    ((uint64_t)sizeof(AUCSegmentRecordHeader) + (keyLength) + (valueLength) + (extendedLength) + sizeof(uint32_t))
+
+#pragma mark - Segment
+/// 分段文件
+@interface _AUCSegment : NSObject
+
+@property (nonatomic, assign) uint32_t segmentID;
+@property (nonatomic, copy, nonnull) NSString *path;
+@property (nonatomic, assign) int fd;
+/// 有效数据末尾，新记录从这里追加
+@property (nonatomic, assign) uint64_t writeOffset;
+/// 预分配的文件大小
+@property (nonatomic, assign) uint64_t capacity;
+/// 仍被索引引用的记录字节数
+@property (nonatomic, assign) uint64_t liveBytes;
+/// 分段中墓碑记录的键，压缩时用于保留仍需覆盖更旧分段的墓碑
+@property (nonatomic, strong, nullable) NSMutableSet<NSString *> *tombstoneKeys;
+/// 墓碑记录字节数，存在更旧的分段时压缩也需要保留
+@property (nonatomic, assign) uint64_t tombstoneBytes;
+/// 正在锁外读取该分段的数量
+@property (nonatomic, assign, readonly) NSInteger pinCount;
+
+/// 锁外读取前固定分段：压缩跳过被固定的分段；分段被删除时，读取方持有的引用保证文件描述符直到读取结束才关闭
+- (void)pin;
+- (void)unpin;
+
+@end
+
+@implementation _AUCSegment {
+    atomic_long _pinCount;
+}
+
+- (NSInteger)pinCount {
+    return (NSInteger)atomic_load_explicit(&_pinCount, memory_order_acquire);
+}
+
+- (void)pin {
+    atomic_fetch_add_explicit(&_pinCount, 1, memory_order_acq_rel);
+}
+
+- (void)unpin {
+    atomic_fetch_sub_explicit(&_pinCount, 1, memory_order_acq_rel);
+}
+
+- (void)dealloc {
+    if (_fd >= 0) close(_fd);
+}
+
+@end
+
+#pragma mark - Entry
+/// 索引项
+@interface _AUCSegmentEntry : NSObject
+
+@property (nonatomic, assign) uint32_t segmentID;
+/// 记录在分段中的起始偏移
+@property (nonatomic, assign) uint64_t offset;
+@property (nonatomic, assign) uint32_t keyLength;
+@property (nonatomic, assign) uint32_t valueLength;
+@property (nonatomic, assign) uint32_t extendedLength;
+@property (nonatomic, assign) int64_t timestamp;
+/// 最近访问时间，仅保存在内存中，启动时初始化为写入时间
+@property (nonatomic, assign) int64_t accessTimestamp;
+
+@property (nonatomic, assign, readonly) uint64_t recordLength;
+@property (nonatomic, assign, readonly) uint64_t valueOffset;
+@property (nonatomic, assign, readonly) uint64_t extendedOffset;
+
+@end
+
+@implementation _AUCSegmentEntry
+
+- (uint64_t)recordLength {
+    return AUC_SEGMENT_RECORD_LENGTH(_keyLength, _valueLength, _extendedLength);
+}
+
+- (uint64_t)valueOffset {
+    return _offset + sizeof(AUCSegmentRecordHeader) + _keyLength;
+}
+
+- (uint64_t)extendedOffset {
+    return self.valueOffset + _valueLength;
+}
+
+@end
+
+#pragma mark - AUCSegmentDiskCache
+static inline int64_t AUCSegmentCurrentTimestamp(void) {
+    return (int64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+}
+
+/// 预分配分段空间，文件大小即为容量，未写入的部分全部为 0
+static BOOL AUCSegmentPreallocate(int fd, off_t length) {
+#if defined(__APPLE__)
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, length, 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        fcntl(fd, F_PREALLOCATE, &store);
+    }
+    return ftruncate(fd, length) == 0;
+#else
+    return posix_fallocate(fd, 0, length) == 0;
+#endif
+}
+
+static BOOL AUCSegmentWriteFully(int fd, const void *bytes, size_t length, off_t offset) {
+    const uint8_t *p = bytes;
+    while (length > 0) {
+        ssize_t written = pwrite(fd, p, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return NO;
+        }
+        p += written;
+        offset += written;
+        length -= (size_t)written;
+    }
+    return YES;
+}
+
+static BOOL AUCSegmentReadFully(int fd, void *bytes, size_t length, off_t offset) {
+    uint8_t *p = bytes;
+    while (length > 0) {
+        ssize_t read = pread(fd, p, length, offset);
+        if (read < 0) {
+            if (errno == EINTR) continue;
+            return NO;
+        }
+        if (read == 0) return NO;
+        p += read;
+        offset += read;
+        length -= (size_t)read;
+    }
+    return YES;
+}
+
+static uint32_t AUCSegmentHeaderChecksum(const AUCSegmentRecordHeader *header) {
+    AUCSegmentRecordHeader copy = *header;
+    copy.headerChecksum = 0;
+    return AUCCRC32C(0, &copy, sizeof(copy));
+}
+
+/// 检查 `offset` 处的记录
+///
+/// 记录头校验通过前不使用其中的长度：长度字段中的位翻转会让扫描跳进数据中间
+static AUCSegmentRecordCheck AUCSegmentCheckRecord(const uint8_t *bytes, uint64_t length, uint64_t offset, AUCSegmentRecordHeader *header, uint64_t *recordLength) {
+    memcpy(header, bytes + offset, sizeof(*header));
+    if (header->magic != AUC_SEGMENT_RECORD_MAGIC) return AUCSegmentRecordCheckInvalid;
+    BOOL legacy = header->version == AUC_SEGMENT_RECORD_VERSION_LEGACY;
+    if (!legacy && header->version != AUC_SEGMENT_RECORD_VERSION) return AUCSegmentRecordCheckInvalid;
+    if (!legacy && AUCSegmentHeaderChecksum(header) != header->headerChecksum) return AUCSegmentRecordCheckInvalid;
+
+    *recordLength = AUC_SEGMENT_RECORD_LENGTH(header->keyLength, header->valueLength, header->extendedLength);
+    if (*recordLength > length - offset) return AUCSegmentRecordCheckInvalid;
+
+    uint32_t storedChecksum;
+    memcpy(&storedChecksum, bytes + offset + *recordLength - sizeof(uint32_t), sizeof(uint32_t));
+    if (AUCCRC32C(0, bytes + offset, (size_t)(*recordLength - sizeof(uint32_t))) == storedChecksum) {
+        return AUCSegmentRecordCheckValid;
+    }
+    // 版本 1 的记录头没有校验和，整条记录校验失败时无法判断是否是长度损坏
+    return legacy ? AUCSegmentRecordCheckInvalid : AUCSegmentRecordCheckCorruptPayload;
+}
+
+/// 从 `offset` 起查找下一个记录魔数，未找到时返回 `UINT64_MAX`
+static uint64_t AUCSegmentFindMagic(const uint8_t *bytes, uint64_t length, uint64_t offset) {
+    const uint32_t magic = AUC_SEGMENT_RECORD_MAGIC;
+    const uint8_t first = (uint8_t)(magic & 0xff);
+    while (offset + sizeof(magic) <= length) {
+        const uint8_t *candidate = memchr(bytes + offset, first, (size_t)(length - offset - sizeof(magic) + 1));
+        if (!candidate) break;
+        if (memcmp(candidate, &magic, sizeof(magic)) == 0) return (uint64_t)(candidate - bytes);
+        offset = (uint64_t)(candidate - bytes) + 1;
+    }
+    return UINT64_MAX;
+}
+
+/// 从分段中读取数据，不访问缓存的其他状态，可在锁外调用
+static NSData *AUCSegmentReadData(_AUCSegment *segment, uint64_t offset, uint32_t length) {
+    if (!segment) return nil;
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    if (length > 0 && !AUCSegmentReadFully(segment.fd, data.mutableBytes, length, (off_t)offset)) {
+        return nil;
+    }
+    return data;
+}
+
+static BOOL AUCSegmentIsZero(const uint8_t *bytes, uint64_t length) {
+    for (uint64_t i = 0; i < length; i++) {
+        if (bytes[i] != 0) return NO;
+    }
+    return YES;
+}
+
+@interface AUCSegmentDiskCache ()
+
+@property (nonatomic, copy) NSString *diskCachePath;
+@property (nonatomic, strong, nonnull) NSFileManager *fileManager;
+@property (nonatomic, strong, nonnull) dispatch_semaphore_t lock;
+/// 键 -> 索引项
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSString *, _AUCSegmentEntry *> *index;
+/// 分段 ID -> 分段
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSNumber *, _AUCSegment *> *segments;
+/// 当前追加写入的分段
+@property (nonatomic, strong, nullable) _AUCSegment *activeSegment;
+@property (nonatomic, assign) uint32_t nextSegmentID;
+/// 启动扫描时清除的残缺尾部字节数，尚未报告给 `recoverWithTimeBudget:report:`
+@property (nonatomic, assign) uint64_t truncatedByteCount;
+/// 启动扫描时跳过的校验失败的记录数，尚未报告给 `recoverWithTimeBudget:report:`
+@property (nonatomic, assign) NSUInteger skippedRecordCount;
+
+@end
+
+@implementation AUCSegmentDiskCache
+- (instancetype)init {
+    NSAssert(NO, @"请使用 `initWithCachePath:` 用磁盘缓存路径创建实例对象");
+    return nil;
+}
+
+#pragma mark - AUCDiskCacheProtocol
+- (instancetype)initWithCachePath:(NSString *)cachePath config:(nonnull AUCCacheConfig *)config {
+    if (self = [super init]) {
+        _diskCachePath = cachePath;
+        _config = config;
+        [self commonInit];
+    }
+    return self;
+}
+
+- (void)commonInit {
+    if (self.config.fileManager) {
+        self.fileManager = self.config.fileManager;
+    } else {
+        self.fileManager = [NSFileManager new];
+    }
+    self.lock = dispatch_semaphore_create(1);
+    self.index = [NSMutableDictionary dictionary];
+    self.segments = [NSMutableDictionary dictionary];
+    [self loadSegments];
+}
+
+- (BOOL)containsDataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return NO;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    BOOL exists = self.index[key] != nil;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return exists;
+}
+
+- (NSData *)dataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return nil;
+    // 只在查找索引时持有锁，数据在锁外读取，不同键的读取可以并行
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _AUCSegmentEntry *entry = self.index[key];
+    _AUCSegment *segment = [self _pinSegmentForEntry:entry];
+    if (segment) entry.accessTimestamp = AUCSegmentCurrentTimestamp();
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    if (!segment) return nil;
+    NSData *data = [self _readValueOfEntry:entry fromSegment:segment];
+    [segment unpin];
+    return data;
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key {
+    NSParameterAssert(data);
+    NSParameterAssert(key);
+    if (!data || !key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self _appendRecordForKey:key value:data extendedData:nil flags:0 timestamp:AUCSegmentCurrentTimestamp()];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)prefetchDataForKeys:(NSArray<NSString *> *)keys {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    for (NSString *key in keys) {
+        _AUCSegmentEntry *entry = self.index[key];
+        _AUCSegment *segment = entry ? self.segments[@(entry.segmentID)] : nil;
+        if (segment) {
+            AUCIOAdviseFile(segment.fd, entry.valueOffset, entry.valueLength, AUCIOAccessPatternWillNeed);
+        }
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)setDataBatch:(NSDictionary<NSString *, NSData *> *)dataBatch {
+    if (dataBatch.count == 0) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    int64_t timestamp = AUCSegmentCurrentTimestamp();
+    [dataBatch enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSData *data, BOOL *stop) {
+        [self _appendRecordForKey:key value:data extendedData:nil flags:0 timestamp:timestamp];
+    }];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (NSData *)extendedDataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return nil;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _AUCSegmentEntry *entry = self.index[key];
+    _AUCSegment *segment = entry.extendedLength > 0 ? [self _pinSegmentForEntry:entry] : nil;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    if (!segment) return nil;
+    NSData *extendedData = AUCSegmentReadData(segment, entry.extendedOffset, entry.extendedLength);
+    [segment unpin];
+    return extendedData;
+}
+
+- (NSDictionary<NSString *, NSData *> *)extendedDataForKeys:(NSArray<NSString *> *)keys {
+    NSMutableDictionary<NSString *, NSData *> *extendedDataMap = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    NSMutableArray<NSString *> *hitKeys = [NSMutableArray arrayWithCapacity:keys.count];
+    NSMutableDictionary<NSString *, _AUCSegmentEntry *> *entries = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    NSMutableArray<_AUCSegment *> *pinnedSegments = [NSMutableArray arrayWithCapacity:keys.count];
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    for (NSString *key in keys) {
+        _AUCSegmentEntry *entry = self.index[key];
+        if (entry.extendedLength == 0 || entries[key]) continue;
+        _AUCSegment *segment = [self _pinSegmentForEntry:entry];
+        if (!segment) continue;
+        [pinnedSegments addObject:segment];
+        entries[key] = entry;
+        [hitKeys addObject:key];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+
+    // 按分段与偏移排序后读取，同一分段内的读取顺序向前推进
+    [hitKeys sortUsingComparator:^NSComparisonResult(NSString *key1, NSString *key2) {
+        _AUCSegmentEntry *entry1 = entries[key1];
+        _AUCSegmentEntry *entry2 = entries[key2];
+        if (entry1.segmentID != entry2.segmentID) return entry1.segmentID < entry2.segmentID ? NSOrderedAscending : NSOrderedDescending;
+        if (entry1.extendedOffset != entry2.extendedOffset) return entry1.extendedOffset < entry2.extendedOffset ? NSOrderedAscending : NSOrderedDescending;
+        return NSOrderedSame;
+    }];
+    NSMutableDictionary<NSNumber *, _AUCSegment *> *segmentsByID = [NSMutableDictionary dictionary];
+    for (_AUCSegment *segment in pinnedSegments) {
+        segmentsByID[@(segment.segmentID)] = segment;
+    }
+    for (NSString *key in hitKeys) {
+        _AUCSegmentEntry *entry = entries[key];
+        NSData *extendedData = AUCSegmentReadData(segmentsByID[@(entry.segmentID)], entry.extendedOffset, entry.extendedLength);
+        if (extendedData) extendedDataMap[key] = extendedData;
+    }
+    for (_AUCSegment *segment in pinnedSegments) {
+        [segment unpin];
+    }
+    return extendedDataMap;
+}
+
+- (void)setData:(NSData *)data extendedData:(NSData *)extendedData forKey:(NSString *)key {
+    NSParameterAssert(data);
+    NSParameterAssert(key);
+    if (!data || !key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self _appendRecordForKey:key value:data extendedData:extendedData flags:0 timestamp:AUCSegmentCurrentTimestamp()];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)setExtendedData:(NSData *)extendedData forKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    _AUCSegmentEntry *entry = self.index[key];
+    NSData *value = entry ? [self _readLength:entry.valueLength atOffset:entry.valueOffset segmentID:entry.segmentID] : nil;
+    if (value) {
+        // 扩展数据与值写在同一条记录中，重写整条记录以保证原子性
+        [self _appendRecordForKey:key value:value extendedData:extendedData flags:0 timestamp:entry.timestamp];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeCacheForKey:(NSString *)key {
+    NSParameterAssert(key);
+    if (!key) return;
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    if (self.index[key]) {
+        [self _appendRecordForKey:key value:nil extendedData:nil flags:AUCSegmentRecordFlagTombstone timestamp:AUCSegmentCurrentTimestamp()];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeAllData {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    [self.index removeAllObjects];
+    [self.segments removeAllObjects];
+    self.activeSegment = nil;
+    self.nextSegmentID = 0;
+    [self.fileManager removeItemAtPath:self.diskCachePath error:nil];
+    [self createCacheDirectoryIfNeeded];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (void)removeExpiredData {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    // 1. 删除过期数据，只需从索引中移除，所在分段会在后续的压缩或淘汰中回收
+    if (self.config.maxDiskAge >= 0) {
+        int64_t expiration = AUCSegmentCurrentTimestamp() - (int64_t)(self.config.maxDiskAge * 1000);
+        BOOL useAccessDate = self.config.diskCacheExpireType == AUCCacheConfigExpireTypeAccessDate;
+        NSMutableArray<NSString *> *expiredKeys = [NSMutableArray array];
+        [self.index enumerateKeysAndObjectsUsingBlock:^(NSString *key, _AUCSegmentEntry *entry, BOOL *stop) {
+            int64_t date = useAccessDate ? entry.accessTimestamp : entry.timestamp;
+            if (date <= expiration) [expiredKeys addObject:key];
+        }];
+        // 写入墓碑而不只是移出索引，否则重启扫描分段时过期数据会重新出现
+        int64_t timestamp = AUCSegmentCurrentTimestamp();
+        for (NSString *key in expiredKeys) {
+            if (![self _appendRecordForKey:key value:nil extendedData:nil flags:AUCSegmentRecordFlagTombstone timestamp:timestamp]) {
+                [self _dropIndexEntryForKey:key];
+            }
+        }
+    }
+
+    // 2. 超出最大磁盘大小时，整段淘汰最旧的分段，直到低于最大大小的一半
+    NSUInteger maxDiskSize = self.config.maxDiskSize;
+    if (maxDiskSize > 0 && [self _totalSize] > maxDiskSize) {
+        const NSUInteger desiredCacheSize = maxDiskSize / 2;
+        for (NSNumber *segmentID in [self _sortedSegmentIDs]) {
+            if ([self _totalSize] < desiredCacheSize) break;
+            _AUCSegment *segment = self.segments[segmentID];
+            if (segment == self.activeSegment) break;
+            [self _dropSegment:segment];
+        }
+    }
+
+    // 3. 压缩有效数据不足一半的分段，有效比例最低的优先
+    // 压缩较新的分段时保留其中的墓碑记录（`_compactSegment:`），被覆盖的更旧数据不会复活
+    // 保留的字节数计入墓碑，每次压缩都严格减少总大小，墓碑较多时也不会反复压缩
+    while (YES) {
+        uint32_t oldestID = [self _sortedSegmentIDs].firstObject.unsignedIntValue;
+        _AUCSegment *candidate = nil;
+        uint64_t candidateRetainedBytes = 0;
+        for (_AUCSegment *segment in self.segments.allValues) {
+            // 正在锁外读取的分段留到下次再压缩
+            if (segment == self.activeSegment || segment.pinCount > 0) continue;
+            uint64_t retainedBytes = segment.liveBytes + (segment.segmentID == oldestID ? 0 : segment.tombstoneBytes);
+            if (!candidate || retainedBytes * candidate.writeOffset < candidateRetainedBytes * segment.writeOffset) {
+                candidate = segment;
+                candidateRetainedBytes = retainedBytes;
+            }
+        }
+        if (!candidate || candidateRetainedBytes * 2 >= candidate.writeOffset) break;
+        [self _compactSegment:candidate];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+}
+
+- (BOOL)recoverWithTimeBudget:(NSTimeInterval)timeBudget report:(AUCDiskCacheRecoveryReport *)report {
+    // 分段在初始化时已全部扫描（内存索引必须完整后才能提供服务），这里只报告清除的残缺尾部与跳过的损坏记录
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    report.truncatedByteCount += self.truncatedByteCount;
+    report.repairedEntryCount += self.skippedRecordCount;
+    self.truncatedByteCount = 0;
+    self.skippedRecordCount = 0;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return YES;
+}
+
+- (nullable NSString *)cachePathForKey:(NSString *)key {
+    // 数据存储在分段文件中，键无法关联到独立的路径
+    return nil;
+}
+
+- (NSUInteger)totalCount {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger count = self.index.count;
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return count;
+}
+
+- (NSUInteger)totalSize {
+    AUC_DISPATCH_SEMAPHORE_LOCK(self.lock);
+    NSUInteger size = [self _totalSize];
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(self.lock);
+    return size;
+}
+
+#pragma mark - Segments（调用方需持有锁）
+- (void)createCacheDirectoryIfNeeded {
+    if (![self.fileManager fileExistsAtPath:self.diskCachePath]) {
+        [self.fileManager createDirectoryAtPath:self.diskCachePath withIntermediateDirectories:YES attributes:nil error:NULL];
+        // 禁用 `iCloud` 备份，只需对目录设置一次
+        if (self.config.shouldDisableICloud) {
+            NSURL *directoryURL = [NSURL fileURLWithPath:self.diskCachePath isDirectory:YES];
+            [directoryURL setResourceValue:@YES forKey:NSURLIsExcludedFromBackupKey error:nil];
+        }
+    }
+}
+
+- (NSString *)pathForSegmentID:(uint32_t)segmentID {
+    NSString *fileName = [NSString stringWithFormat:@"%010u.%@", segmentID, AUC_SEGMENT_FILE_EXTENSION];
+    return [self.diskCachePath stringByAppendingPathComponent:fileName];
+}
+
+- (NSArray<NSNumber *> *)_sortedSegmentIDs {
+    return [self.segments.allKeys sortedArrayUsingSelector:@selector(compare:)];
+}
+
+/// 已写入的字节数，不含分段预分配但尚未写入的空间，避免刚创建的分段就触发按大小淘汰
+- (NSUInteger)_totalSize {
+    uint64_t size = 0;
+    for (_AUCSegment *segment in self.segments.allValues) {
+        size += segment.writeOffset;
+    }
+    return (NSUInteger)size;
+}
+
+/// 启动时按分段 ID 顺序扫描所有分段并重建索引
+- (void)loadSegments {
+    [self createCacheDirectoryIfNeeded];
+    NSArray<NSString *> *fileNames = [self.fileManager contentsOfDirectoryAtPath:self.diskCachePath error:nil];
+    NSMutableArray<NSNumber *> *segmentIDs = [NSMutableArray array];
+    for (NSString *fileName in fileNames) {
+        if (![fileName.pathExtension isEqualToString:AUC_SEGMENT_FILE_EXTENSION]) continue;
+        [segmentIDs addObject:@((uint32_t)fileName.stringByDeletingPathExtension.longLongValue)];
+    }
+    [segmentIDs sortUsingSelector:@selector(compare:)];
+
+    for (NSNumber *segmentID in segmentIDs) {
+        _AUCSegment *segment = [self openSegmentWithID:segmentID.unsignedIntValue create:NO capacity:0];
+        if (!segment) continue;
+        self.segments[segmentID] = segment;
+        // 只有最后一个分段会继续追加写入，只清除它的残缺尾部；已封存的分段从不改写
+        [self scanSegment:segment truncateTail:[segmentID isEqualToNumber:segmentIDs.lastObject]];
+        self.nextSegmentID = segment.segmentID + 1;
+    }
+
+    // 最后一个分段继续作为追加写入的分段
+    _AUCSegment *last = self.segments[segmentIDs.lastObject];
+    if (last && last.writeOffset < last.capacity) {
+        self.activeSegment = last;
+    }
+}
+
+- (nullable _AUCSegment *)openSegmentWithID:(uint32_t)segmentID create:(BOOL)create capacity:(uint64_t)capacity {
+    NSString *path = [self pathForSegmentID:segmentID];
+    int flags = O_RDWR | O_CLOEXEC | (create ? (O_CREAT | O_EXCL) : 0);
+    int fd = open(path.fileSystemRepresentation, flags, 0644);
+    if (fd < 0) return nil;
+
+    if (create) {
+        if (!AUCSegmentPreallocate(fd, (off_t)capacity)) {
+            close(fd);
+            unlink(path.fileSystemRepresentation);
+            return nil;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return nil;
+        }
+        capacity = (uint64_t)st.st_size;
+    }
+
+    _AUCSegment *segment = [_AUCSegment new];
+    segment.segmentID = segmentID;
+    segment.path = path;
+    segment.fd = fd;
+    segment.capacity = capacity;
+    return segment;
+}
+
+/// 顺序解析分段中的记录
+///
+/// 数据损坏但记录头完整的记录按长度跳过；记录头无法识别或校验失败时向后查找下一个魔数重新同步，不会因为一条损坏的记录丢弃之后的所有记录。
+/// 最后一条有效记录的末尾作为该分段的写入末尾
+- (void)scanSegment:(_AUCSegment *)segment truncateTail:(BOOL)truncateTail {
+    NSData *content = [NSData dataWithContentsOfFile:segment.path options:NSDataReadingMappedIfSafe error:nil];
+    const uint8_t *bytes = content.bytes;
+    uint64_t length = content.length;
+    uint64_t offset = 0;
+    uint64_t dataEnd = 0;
+    BOOL resyncing = NO;
+    // 启动时顺序扫描整个分段
+    AUCIOAdviseMemory(bytes, (size_t)length, AUCIOAccessPatternSequential);
+
+    while (offset + sizeof(AUCSegmentRecordHeader) <= length) {
+        AUCSegmentRecordHeader header;
+        uint64_t recordLength = 0;
+        AUCSegmentRecordCheck check = AUCSegmentCheckRecord(bytes, length, offset, &header, &recordLength);
+        if (check == AUCSegmentRecordCheckInvalid) {
+            // 之后全部为 0 即已到写入末尾
+            if (AUCSegmentIsZero(bytes + offset, length - offset)) break;
+            uint64_t next = AUCSegmentFindMagic(bytes, length, offset + 1);
+            if (next == UINT64_MAX) break;
+            resyncing = YES;
+            offset = next;
+            continue;
+        }
+        // 重新同步后找到有效的记录，跳过的区域计为一条损坏的记录
+        if (resyncing) {
+            self.skippedRecordCount++;
+            resyncing = NO;
+        }
+        if (check == AUCSegmentRecordCheckCorruptPayload) {
+            self.skippedRecordCount++;
+            offset += recordLength;
+            dataEnd = offset;
+            continue;
+        }
+
+        NSString *key = [[NSString alloc] initWithBytes:bytes + offset + sizeof(header) length:header.keyLength encoding:NSUTF8StringEncoding];
+        if (key) {
+            if (header.flags & AUCSegmentRecordFlagTombstone) {
+                [self _dropIndexEntryForKey:key];
+                [self _addTombstoneKey:key length:recordLength toSegment:segment];
+            } else {
+                _AUCSegmentEntry *entry = [_AUCSegmentEntry new];
+                entry.segmentID = segment.segmentID;
+                entry.offset = offset;
+                entry.keyLength = header.keyLength;
+                entry.valueLength = header.valueLength;
+                entry.extendedLength = header.extendedLength;
+                entry.timestamp = header.timestamp;
+                entry.accessTimestamp = header.timestamp;
+                [self _setIndexEntry:entry forKey:key];
+            }
+        }
+        offset += recordLength;
+        dataEnd = offset;
+    }
+    segment.writeOffset = dataEnd;
+
+    // 写入末尾之后应当全部为 0，否则是崩溃时写了一半的记录
+    if (truncateTail) {
+        [self _truncateTornTailOfSegment:segment bytes:bytes length:length];
+    }
+}
+
+/// 把残缺记录清零，避免之后追加的较短记录后面残留可被误解析的字节
+- (void)_truncateTornTailOfSegment:(_AUCSegment *)segment bytes:(const uint8_t *)bytes length:(uint64_t)length {
+    uint64_t offset = segment.writeOffset;
+    uint64_t end = length;
+    while (end > offset && bytes[end - 1] == 0) end--;
+    if (end <= offset) return;
+
+    static const uint8_t zeros[4096] = {0};
+    for (uint64_t position = offset; position < end; position += sizeof(zeros)) {
+        size_t chunk = (size_t)MIN((uint64_t)sizeof(zeros), end - position);
+        if (!AUCSegmentWriteFully(segment.fd, zeros, chunk, (off_t)position)) return;
+    }
+    self.truncatedByteCount += end - offset;
+}
+
+/// 返回可容纳 `length` 字节记录的分段，当前分段已满时封存并新建分段
+- (nullable _AUCSegment *)_segmentForRecordLength:(uint64_t)length {
+    _AUCSegment *active = self.activeSegment;
+    if (active && active.writeOffset + length <= active.capacity) {
+        return active;
+    }
+
+    [self createCacheDirectoryIfNeeded];
+    uint64_t capacity = MAX((uint64_t)self.config.diskSegmentSize, length);
+    _AUCSegment *segment = [self openSegmentWithID:self.nextSegmentID create:YES capacity:capacity];
+    if (!segment) return nil;
+    self.nextSegmentID = segment.segmentID + 1;
+    self.segments[@(segment.segmentID)] = segment;
+    self.activeSegment = segment;
+    return segment;
+}
+
+/// 追加一条记录并更新索引
+- (BOOL)_appendRecordForKey:(NSString *)key value:(nullable NSData *)value extendedData:(nullable NSData *)extendedData flags:(uint16_t)flags timestamp:(int64_t)timestamp {
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    if (!keyData) return NO;
+
+    AUCSegmentRecordHeader header = {0};
+    header.magic = AUC_SEGMENT_RECORD_MAGIC;
+    header.version = AUC_SEGMENT_RECORD_VERSION;
+    header.flags = flags;
+    header.keyLength = (uint32_t)keyData.length;
+    header.valueLength = (uint32_t)value.length;
+    header.extendedLength = (uint32_t)extendedData.length;
+    header.timestamp = timestamp;
+    header.headerChecksum = AUCSegmentHeaderChecksum(&header);
+
+    uint64_t recordLength = AUC_SEGMENT_RECORD_LENGTH(header.keyLength, header.valueLength, header.extendedLength);
+    NSMutableData *record = [NSMutableData dataWithCapacity:(NSUInteger)recordLength];
+    [record appendBytes:&header length:sizeof(header)];
+    [record appendData:keyData];
+    if (value) [record appendData:value];
+    if (extendedData) [record appendData:extendedData];
+    uint32_t checksum = AUCCRC32C(0, record.bytes, record.length);
+    [record appendBytes:&checksum length:sizeof(checksum)];
+
+    _AUCSegment *segment = [self _segmentForRecordLength:recordLength];
+    if (!segment) return NO;
+    uint64_t offset = segment.writeOffset;
+    if (!AUCSegmentWriteFully(segment.fd, record.bytes, record.length, (off_t)offset)) return NO;
+    segment.writeOffset = offset + recordLength;
+
+    if (flags & AUCSegmentRecordFlagTombstone) {
+        [self _dropIndexEntryForKey:key];
+        [self _addTombstoneKey:key length:recordLength toSegment:segment];
+    } else {
+        _AUCSegmentEntry *entry = [_AUCSegmentEntry new];
+        entry.segmentID = segment.segmentID;
+        entry.offset = offset;
+        entry.keyLength = header.keyLength;
+        entry.valueLength = header.valueLength;
+        entry.extendedLength = header.extendedLength;
+        entry.timestamp = timestamp;
+        entry.accessTimestamp = AUCSegmentCurrentTimestamp();
+        [self _setIndexEntry:entry forKey:key];
+    }
+    return YES;
+}
+
+- (void)_setIndexEntry:(_AUCSegmentEntry *)entry forKey:(NSString *)key {
+    [self _dropIndexEntryForKey:key];
+    self.index[key] = entry;
+    self.segments[@(entry.segmentID)].liveBytes += entry.recordLength;
+}
+
+- (void)_addTombstoneKey:(NSString *)key length:(uint64_t)length toSegment:(_AUCSegment *)segment {
+    if (!segment.tombstoneKeys) segment.tombstoneKeys = [NSMutableSet set];
+    [segment.tombstoneKeys addObject:key];
+    segment.tombstoneBytes += length;
+}
+
+- (void)_dropIndexEntryForKey:(NSString *)key {
+    _AUCSegmentEntry *entry = self.index[key];
+    if (!entry) return;
+    _AUCSegment *segment = self.segments[@(entry.segmentID)];
+    segment.liveBytes -= MIN(segment.liveBytes, entry.recordLength);
+    [self.index removeObjectForKey:key];
+}
+
+- (nullable NSData *)_readLength:(uint32_t)length atOffset:(uint64_t)offset segmentID:(uint32_t)segmentID {
+    return AUCSegmentReadData(self.segments[@(segmentID)], offset, length);
+}
+
+/// 固定索引项所在的分段，返回的分段需要在读取结束后调用 `unpin`
+- (nullable _AUCSegment *)_pinSegmentForEntry:(nullable _AUCSegmentEntry *)entry {
+    if (!entry) return nil;
+    _AUCSegment *segment = self.segments[@(entry.segmentID)];
+    [segment pin];
+    return segment;
+}
+
+/// 在锁外读取值，分段已由调用方固定
+- (nullable NSData *)_readValueOfEntry:(_AUCSegmentEntry *)entry fromSegment:(_AUCSegment *)segment {
+    // 记录写入后不再修改，分段也不会被截断，大数据可以直接映射，分段被删除后映射仍然有效
+    NSUInteger threshold = self.config.diskCacheMappingThreshold;
+    if (threshold > 0 && entry.valueLength >= threshold) {
+        NSData *data = [AUCMappedData dataWithFileDescriptor:segment.fd offset:entry.valueOffset length:entry.valueLength accessPattern:AUCIOAccessPatternSequential];
+        if (data) return data;
+    }
+    return AUCSegmentReadData(segment, entry.valueOffset, entry.valueLength);
+}
+
+- (NSArray<NSString *> *)_keysInSegment:(_AUCSegment *)segment {
+    NSMutableArray<NSString *> *keys = [NSMutableArray array];
+    uint32_t segmentID = segment.segmentID;
+    [self.index enumerateKeysAndObjectsUsingBlock:^(NSString *key, _AUCSegmentEntry *entry, BOOL *stop) {
+        if (entry.segmentID == segmentID) [keys addObject:key];
+    }];
+    return keys;
+}
+
+/// 删除整个分段及其中仍有效的数据
+- (void)_dropSegment:(_AUCSegment *)segment {
+    for (NSString *key in [self _keysInSegment:segment]) {
+        [self.index removeObjectForKey:key];
+    }
+    if (segment == self.activeSegment) self.activeSegment = nil;
+    [self.segments removeObjectForKey:@(segment.segmentID)];
+    unlink(segment.path.fileSystemRepresentation);
+}
+
+/// 将分段中仍有效的记录重新追加到当前分段，然后删除该分段
+///
+/// - Note: 存在更旧的分段时，其中可能仍有被本分段墓碑覆盖的记录，没有重新写入的键的墓碑需要一并追加，否则重启后这些记录会复活
+- (void)_compactSegment:(_AUCSegment *)segment {
+    BOOL hasOlderSegment = [self _sortedSegmentIDs].firstObject.unsignedIntValue < segment.segmentID;
+    // 整理后分段即被删除，读取的数据不进入页缓存
+    AUCIOAdviseFile(segment.fd, 0, 0, AUCIOAccessPatternNoReuse);
+    for (NSString *key in [self _keysInSegment:segment]) {
+        _AUCSegmentEntry *entry = self.index[key];
+        NSData *value = [self _readLength:entry.valueLength atOffset:entry.valueOffset segmentID:entry.segmentID];
+        NSData *extendedData = entry.extendedLength > 0 ? [self _readLength:entry.extendedLength atOffset:entry.extendedOffset segmentID:entry.segmentID] : nil;
+        int64_t accessTimestamp = entry.accessTimestamp;
+        if (value && [self _appendRecordForKey:key value:value extendedData:extendedData flags:0 timestamp:entry.timestamp]) {
+            self.index[key].accessTimestamp = accessTimestamp;
+        } else {
+            [self.index removeObjectForKey:key];
+        }
+    }
+    if (hasOlderSegment) {
+        int64_t timestamp = AUCSegmentCurrentTimestamp();
+        for (NSString *key in segment.tombstoneKeys) {
+            // 之后重新写入的键由更新的记录覆盖，墓碑已无作用
+            if (self.index[key]) continue;
+            [self _appendRecordForKey:key value:nil extendedData:nil flags:AUCSegmentRecordFlagTombstone timestamp:timestamp];
+        }
+    }
+    [self.segments removeObjectForKey:@(segment.segmentID)];
+    unlink(segment.path.fileSystemRepresentation);
+}
+
+@end
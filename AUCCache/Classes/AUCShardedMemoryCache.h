@@ -0,0 +1,45 @@
+//
+//  AUCShardedMemoryCache.h
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/04.
+//
+
+#import <Foundation/Foundation.h>
+#import "AUCProtocolsDefine.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class AUCCacheConfig;
+/// ``分片内存缓存``
+///
+/// 按键的哈希值将键空间划分为 N 个分片，每个分片持有独立的锁、开放寻址索引表以及侵入式 LRU 链表
+/// 不同分片之间的读写互不阻塞，多线程并发查询时吞吐量可随核心数扩展
+/// ```
+/// AUCShardedMemoryCache
+///    ├── shard[0]    锁 + 开放寻址索引 + LRU 链表 + 弱引用表
+///    ├── shard[1]
+///    ├── ...
+///    ├── shard[N-1]
+/// ```
+///
+/// - Note: 通过 `AUCCacheConfig.memoryCacheClass = AUCShardedMemoryCache.class` 启用
+/// - Note: `maxMemoryCost`、`maxMemoryCount` 是全局限制，所有分片共享原子计数的总用量；超出时先按 `memoryCacheEvictionPolicy` 淘汰写入分片中的数据，直到该分片回到平均份额以内，仍超出时再轮流淘汰其他分片。单个数据的成本只要不超过全局限制就能被缓存
+/// - Note: 设置了 `maxMemoryCount` 时，分片数量会减少到每个分片的平均份额不低于 64，避免 TinyLFU 的窗口区、保护区过小；分片数量在初始化时确定，之后修改限制不会改变分片数量
+/// - Note: `AUCCacheMemoryEvictionPolicyTinyLFU` 策略下，每个分片额外维护窗口区、试用区、保护区三个链表以及一个频率草图；频率只在读取（命中或未命中）时计入，写入不计数
+@interface AUCShardedMemoryCache : NSObject <AUCMemoryCacheProtocol>
+
+@property (nonatomic, strong, nonnull, readonly) AUCCacheConfig *config;
+
+/// 分片数量，总是 2 的整数次幂，可能小于 `memoryCacheShardCount`
+@property (nonatomic, assign, readonly) NSUInteger shardCount;
+
+/// 当前缓存的数据总数（不包含弱引用表）
+@property (nonatomic, assign, readonly) NSUInteger totalCount;
+
+/// 当前缓存数据的总成本
+@property (nonatomic, assign, readonly) NSUInteger totalCost;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,694 @@
+//
+//  AUCShardedMemoryCache.m
+//  AUOptimize
+//
+//  Created by aaron lee on 2024/11/04.
+//
+
+#import "AUCShardedMemoryCache.h"
+#import "AUCCacheConfig.h"
+#import "AUCCompat.h"
+#import "AUCInternalMacros.h"
+#import "AUCCacheCostEstimator.h"
+#import "AUCFrequencySketch.h"
+#import <stdatomic.h>
+#if AU_UIKIT
+#import <UIKit/UIKit.h>
+#endif
+
+static void * AUCShardedMemoryCacheContext = &AUCShardedMemoryCacheContext;
+// 单个分片索引表的初始容量（2 的整数次幂）
+static const NSUInteger AUC_SHARD_INITIAL_CAPACITY = 16;
+// 分片数量上限
+static const NSUInteger AUC_SHARD_MAX_COUNT = 64;
+// 设置了数量限制时，每个分片至少分到的数量，过小时 TinyLFU 的窗口区、保护区失去意义
+static const NSUInteger AUC_SHARD_MIN_COUNT_SHARE = 64;
+// 未设置数量限制时，TinyLFU 频率草图的默认宽度
+static const NSUInteger AUC_SHARD_DEFAULT_SKETCH_SIZE = 1024;
+
+/// 对 `-hash` 做一次 64 位混淆，`NSString` 的 `-hash` 只取首尾部分字符，URL 前缀相同的键分布很差
+/// - Note: `AUCCacheKey` 的 `-hash` 创建时已计算，这里只读取缓存值
+static inline uint64_t AUCMemoryCacheMixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+#pragma mark - Node
+/// 缓存节点所在区域
+typedef NS_ENUM(uint8_t, AUCMemoryCacheRegion) {
+    /// LRU 策略下的唯一链表，TinyLFU 策略下的窗口区
+    AUCMemoryCacheRegionWindow = 0,
+    /// TinyLFU 主区 - 试用区
+    AUCMemoryCacheRegionProbation,
+    /// TinyLFU 主区 - 保护区
+    AUCMemoryCacheRegionProtected,
+    AUCMemoryCacheRegionCount
+};
+
+/// 缓存节点，同时作为索引表的元素和 LRU 链表的节点
+@interface _AUCMemoryCacheNode : NSObject {
+    @package
+    __unsafe_unretained _AUCMemoryCacheNode *_prev;
+    __unsafe_unretained _AUCMemoryCacheNode *_next;
+    id _key;
+    id _value;
+    uint64_t _hash;
+    NSUInteger _cost;
+    AUCMemoryCacheRegion _region;
+}
+@end
+
+@implementation _AUCMemoryCacheNode
+@end
+
+/// 侵入式双向链表，head 为最近使用，tail 为最久未使用
+typedef struct {
+    __unsafe_unretained _AUCMemoryCacheNode *head;
+    __unsafe_unretained _AUCMemoryCacheNode *tail;
+    NSUInteger count;
+    NSUInteger cost;
+} AUCMemoryCacheList;
+
+static inline void AUCMemoryCacheListInsertHead(AUCMemoryCacheList *list, _AUCMemoryCacheNode *node) {
+    node->_prev = nil;
+    node->_next = list->head;
+    if (list->head) list->head->_prev = node;
+    list->head = node;
+    if (!list->tail) list->tail = node;
+    list->count++;
+    list->cost += node->_cost;
+}
+
+static inline void AUCMemoryCacheListUnlink(AUCMemoryCacheList *list, _AUCMemoryCacheNode *node) {
+    if (node->_prev) node->_prev->_next = node->_next;
+    if (node->_next) node->_next->_prev = node->_prev;
+    if (list->head == node) list->head = node->_next;
+    if (list->tail == node) list->tail = node->_prev;
+    node->_prev = nil;
+    node->_next = nil;
+    list->count--;
+    list->cost -= node->_cost;
+}
+
+/// 是否超出限制，0 表示不限制
+static inline BOOL AUCMemoryCacheExceedsLimits(NSUInteger count, NSUInteger cost, NSUInteger countLimit, NSUInteger costLimit) {
+    return (countLimit > 0 && count > countLimit) || (costLimit > 0 && cost > costLimit);
+}
+
+#pragma mark - Budget
+/// 所有分片共享的总用量与全局限制，0 表示不限制
+///
+/// - Note: 分片在持有自身锁时原子地更新用量，不需要其他锁
+@interface _AUCMemoryCacheBudget : NSObject {
+    @package
+    _Atomic(NSUInteger) _count;
+    _Atomic(NSUInteger) _cost;
+    _Atomic(NSUInteger) _countLimit;
+    _Atomic(NSUInteger) _costLimit;
+}
+@end
+
+@implementation _AUCMemoryCacheBudget
+@end
+
+static inline BOOL AUCMemoryCacheBudgetExceeded(_AUCMemoryCacheBudget *budget) {
+    return AUCMemoryCacheExceedsLimits(atomic_load_explicit(&budget->_count, memory_order_relaxed),
+                                       atomic_load_explicit(&budget->_cost, memory_order_relaxed),
+                                       atomic_load_explicit(&budget->_countLimit, memory_order_relaxed),
+                                       atomic_load_explicit(&budget->_costLimit, memory_order_relaxed));
+}
+
+static inline BOOL AUCMemoryCacheNodeMatches(_AUCMemoryCacheNode *node, id key, uint64_t hash) {
+    return key && node->_hash == hash && (node->_key == key || [node->_key isEqual:key]);
+}
+
+#pragma mark - Shard
+/// 分片，所有方法内部自行加锁
+///
+/// - Note: 节点的生命周期由索引表槽位持有（CFBridgingRetain），LRU 链表只做弱引用串联
+@interface _AUCMemoryCacheShard : NSObject {
+    @package
+    dispatch_semaphore_t _lock;
+    void **_slots;
+    NSUInteger _capacity;
+    NSUInteger _count;
+    NSUInteger _totalCost;
+    // 全局限制的平均份额，用于判断本分片是否溢出以及划分 TinyLFU 各区
+    NSUInteger _costShare;
+    NSUInteger _countShare;
+    _AUCMemoryCacheBudget *_budget;
+    AUCMemoryCacheList _lists[AUCMemoryCacheRegionCount];
+    AUCCacheMemoryEvictionPolicy _policy;
+    // 以下仅 TinyLFU 策略使用
+    AUCFrequencySketch *_sketch;
+    NSUInteger _windowCountLimit;
+    NSUInteger _windowCostLimit;
+    NSUInteger _protectedCountLimit;
+    NSUInteger _protectedCostLimit;
+#if AU_UIKIT
+    NSMapTable *_weakCache;
+#endif
+}
+
+- (instancetype)initWithPolicy:(AUCCacheMemoryEvictionPolicy)policy budget:(_AUCMemoryCacheBudget *)budget;
+- (id)objectForKey:(id)key hash:(uint64_t)hash useWeakCache:(BOOL)useWeakCache fromWeakCache:(BOOL *)fromWeakCache;
+- (void)setObject:(id)object forKey:(id)key hash:(uint64_t)hash cost:(NSUInteger)cost useWeakCache:(BOOL)useWeakCache;
+- (void)removeObjectForKey:(id)key hash:(uint64_t)hash useWeakCache:(BOOL)useWeakCache;
+- (void)removeAllObjectsIncludingWeakCache:(BOOL)includingWeakCache;
+- (void)setCostShare:(NSUInteger)costShare countShare:(NSUInteger)countShare;
+- (NSUInteger)evictOverBudgetProtectingKey:(id)key hash:(uint64_t)hash aboveShareOnly:(BOOL)aboveShareOnly limit:(NSUInteger)limit;
+
+@end
+
+@implementation _AUCMemoryCacheShard
+- (instancetype)initWithPolicy:(AUCCacheMemoryEvictionPolicy)policy budget:(_AUCMemoryCacheBudget *)budget {
+    if (self = [super init]) {
+        _lock = dispatch_semaphore_create(1);
+        _budget = budget;
+        _capacity = AUC_SHARD_INITIAL_CAPACITY;
+        _slots = calloc(_capacity, sizeof(void *));
+        _policy = policy;
+        if (policy == AUCCacheMemoryEvictionPolicyTinyLFU) {
+            _sketch = [[AUCFrequencySketch alloc] initWithMaximumSize:AUC_SHARD_DEFAULT_SKETCH_SIZE];
+        }
+#if AU_UIKIT
+        _weakCache = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory valueOptions:NSPointerFunctionsWeakMemory capacity:0];
+#endif
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (NSUInteger i = 0; i < _capacity; i++) {
+        if (_slots[i]) CFRelease(_slots[i]);
+    }
+    free(_slots);
+}
+
+#pragma mark 开放寻址索引（线性探测，调用方需持有锁）
+- (NSUInteger)_indexOfKey:(id)key hash:(uint64_t)hash {
+    NSUInteger mask = _capacity - 1;
+    NSUInteger i = (NSUInteger)hash & mask;
+    while (_slots[i]) {
+        _AUCMemoryCacheNode *node = (__bridge _AUCMemoryCacheNode *)_slots[i];
+        if (node->_hash == hash && (node->_key == key || [node->_key isEqual:key])) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return NSNotFound;
+}
+
+- (void)_growTable {
+    NSUInteger newCapacity = _capacity << 1;
+    NSUInteger mask = newCapacity - 1;
+    void **newSlots = calloc(newCapacity, sizeof(void *));
+    for (NSUInteger i = 0; i < _capacity; i++) {
+        void *slot = _slots[i];
+        if (!slot) continue;
+        NSUInteger j = (NSUInteger)((__bridge _AUCMemoryCacheNode *)slot)->_hash & mask;
+        while (newSlots[j]) j = (j + 1) & mask;
+        newSlots[j] = slot;
+    }
+    free(_slots);
+    _slots = newSlots;
+    _capacity = newCapacity;
+}
+
+/// 新节点总是进入窗口区（LRU 策略下即唯一链表）的头部
+- (void)_insertNode:(_AUCMemoryCacheNode *)node {
+    // 装载因子上限 0.75
+    if ((_count + 1) * 4 > _capacity * 3) {
+        [self _growTable];
+    }
+    NSUInteger mask = _capacity - 1;
+    NSUInteger i = (NSUInteger)node->_hash & mask;
+    while (_slots[i]) i = (i + 1) & mask;
+    _slots[i] = (void *)CFBridgingRetain(node);
+    _count++;
+    _totalCost += node->_cost;
+    atomic_fetch_add_explicit(&_budget->_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_budget->_cost, node->_cost, memory_order_relaxed);
+    node->_region = AUCMemoryCacheRegionWindow;
+    AUCMemoryCacheListInsertHead(&_lists[AUCMemoryCacheRegionWindow], node);
+}
+
+/// 删除槽位并做后移压缩（backward shift），避免墓碑标记导致探测链越来越长
+- (_AUCMemoryCacheNode *)_removeNodeAtIndex:(NSUInteger)index {
+    NSUInteger mask = _capacity - 1;
+    _AUCMemoryCacheNode *node = (__bridge_transfer _AUCMemoryCacheNode *)_slots[index];
+    _slots[index] = NULL;
+
+    NSUInteger i = index;
+    NSUInteger j = index;
+    while (YES) {
+        j = (j + 1) & mask;
+        if (!_slots[j]) break;
+        NSUInteger k = (NSUInteger)((__bridge _AUCMemoryCacheNode *)_slots[j])->_hash & mask;
+        // 理想位置 k 循环地落在 (i, j] 区间内时无需移动
+        BOOL inRange = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (inRange) continue;
+        _slots[i] = _slots[j];
+        _slots[j] = NULL;
+        i = j;
+    }
+
+    AUCMemoryCacheListUnlink(&_lists[node->_region], node);
+    _count--;
+    _totalCost -= node->_cost;
+    atomic_fetch_sub_explicit(&_budget->_count, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&_budget->_cost, node->_cost, memory_order_relaxed);
+    return node;
+}
+
+- (void)_evictNode:(_AUCMemoryCacheNode *)node holder:(NSMutableArray *)holder {
+    NSUInteger index = [self _indexOfKey:node->_key hash:node->_hash];
+    if (index == NSNotFound) return;
+    [holder addObject:[self _removeNodeAtIndex:index]];
+}
+
+- (void)_moveNode:(_AUCMemoryCacheNode *)node toRegion:(AUCMemoryCacheRegion)region {
+    AUCMemoryCacheListUnlink(&_lists[node->_region], node);
+    node->_region = region;
+    AUCMemoryCacheListInsertHead(&_lists[region], node);
+}
+
+- (void)_updateCost:(NSUInteger)cost ofNode:(_AUCMemoryCacheNode *)node {
+    AUCMemoryCacheList *list = &_lists[node->_region];
+    list->cost = list->cost - node->_cost + cost;
+    _totalCost = _totalCost - node->_cost + cost;
+    if (cost >= node->_cost) {
+        atomic_fetch_add_explicit(&_budget->_cost, cost - node->_cost, memory_order_relaxed);
+    } else {
+        atomic_fetch_sub_explicit(&_budget->_cost, node->_cost - cost, memory_order_relaxed);
+    }
+    node->_cost = cost;
+}
+
+#pragma mark 淘汰策略（调用方需持有锁）
+/// 命中时调整节点位置
+///
+/// - Parameter countFrequency: 是否计入频率。频率只在读取时计入，写入不再计数，避免“读未命中 + 回填写入”被记为两次访问
+- (void)_recordAccessOfNode:(_AUCMemoryCacheNode *)node countFrequency:(BOOL)countFrequency {
+    if (_policy != AUCCacheMemoryEvictionPolicyTinyLFU) {
+        [self _moveNode:node toRegion:AUCMemoryCacheRegionWindow];
+        return;
+    }
+
+    if (countFrequency) [_sketch increment:node->_hash];
+    switch (node->_region) {
+        case AUCMemoryCacheRegionProbation: {
+            // 试用区再次命中，晋升到保护区
+            [self _moveNode:node toRegion:AUCMemoryCacheRegionProtected];
+            [self _demoteProtectedOverflow];
+        }
+            break;
+        default: {
+            [self _moveNode:node toRegion:node->_region];
+        }
+            break;
+    }
+}
+
+/// 保护区溢出的数据降级回试用区头部
+- (void)_demoteProtectedOverflow {
+    AUCMemoryCacheList *protectedList = &_lists[AUCMemoryCacheRegionProtected];
+    while (protectedList->tail && AUCMemoryCacheExceedsLimits(protectedList->count, protectedList->cost, _protectedCountLimit, _protectedCostLimit)) {
+        [self _moveNode:protectedList->tail toRegion:AUCMemoryCacheRegionProbation];
+    }
+}
+
+/// TinyLFU 策略下，窗口区溢出的数据移入试用区头部，作为准入候选
+- (void)_demoteWindowOverflow {
+    if (_policy != AUCCacheMemoryEvictionPolicyTinyLFU) return;
+    AUCMemoryCacheList *window = &_lists[AUCMemoryCacheRegionWindow];
+    while (window->tail && AUCMemoryCacheExceedsLimits(window->count, window->cost, _windowCountLimit, _windowCostLimit)) {
+        [self _moveNode:window->tail toRegion:AUCMemoryCacheRegionProbation];
+    }
+}
+
+/// 从链表尾部（或头部）取第一个不是 `key` 的节点
+static inline _AUCMemoryCacheNode *AUCMemoryCacheListPick(AUCMemoryCacheList *list, BOOL fromHead, id key, uint64_t hash) {
+    _AUCMemoryCacheNode *node = fromHead ? list->head : list->tail;
+    if (node && AUCMemoryCacheNodeMatches(node, key, hash)) node = fromHead ? node->_next : node->_prev;
+    return node;
+}
+
+/// 选择下一个被淘汰的节点，`key` 对应的节点不参与选择
+///
+/// LRU 策略淘汰链表尾部；W-TinyLFU 策略比较候选（试用区头部）与受害者（试用区尾部）的访问频率，频率更低者被淘汰，
+/// 试用区为空时依次从保护区、窗口区淘汰
+- (_AUCMemoryCacheNode *)_victimProtectingKey:(id)key hash:(uint64_t)hash {
+    if (_policy != AUCCacheMemoryEvictionPolicyTinyLFU) {
+        return AUCMemoryCacheListPick(&_lists[AUCMemoryCacheRegionWindow], NO, key, hash);
+    }
+
+    AUCMemoryCacheList *probation = &_lists[AUCMemoryCacheRegionProbation];
+    _AUCMemoryCacheNode *victim = AUCMemoryCacheListPick(probation, NO, key, hash);
+    if (victim) {
+        _AUCMemoryCacheNode *candidate = AUCMemoryCacheListPick(probation, YES, key, hash);
+        if (candidate && candidate != victim && [_sketch frequency:candidate->_hash] <= [_sketch frequency:victim->_hash]) {
+            return candidate;
+        }
+        return victim;
+    }
+    return AUCMemoryCacheListPick(&_lists[AUCMemoryCacheRegionProtected], NO, key, hash) ?: AUCMemoryCacheListPick(&_lists[AUCMemoryCacheRegionWindow], NO, key, hash);
+}
+
+/// 全局用量超出限制时淘汰本分片的数据，`key` 对应的数据（刚写入的数据）不会被淘汰
+///
+/// - Parameters:
+///     - aboveShareOnly: YES 时只在本分片超出平均份额时淘汰
+///     - limit: 最多淘汰的数量
+/// - Returns: 实际淘汰的数量
+- (NSUInteger)evictOverBudgetProtectingKey:(id)key hash:(uint64_t)hash aboveShareOnly:(BOOL)aboveShareOnly limit:(NSUInteger)limit {
+    NSMutableArray *holder = [NSMutableArray array];
+    AUC_DISPATCH_SEMAPHORE_LOCK(_lock);
+    while (holder.count < limit && AUCMemoryCacheBudgetExceeded(_budget)) {
+        if (aboveShareOnly && !AUCMemoryCacheExceedsLimits(_count, _totalCost, _countShare, _costShare)) break;
+        _AUCMemoryCacheNode *victim = [self _victimProtectingKey:key hash:hash];
+        if (!victim) break;
+        [self _evictNode:victim holder:holder];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(_lock);
+    // 被淘汰的节点在解锁后释放
+    return holder.count;
+}
+
+#pragma mark 对外访问
+/// 弱引用表命中时 `fromWeakCache` 置为 YES，由调用方在锁外计算成本后写回强缓存
+- (id)objectForKey:(id)key hash:(uint64_t)hash useWeakCache:(BOOL)useWeakCache fromWeakCache:(BOOL *)fromWeakCache {
+    id object = nil;
+    AUC_DISPATCH_SEMAPHORE_LOCK(_lock);
+    NSUInteger index = [self _indexOfKey:key hash:hash];
+    if (index != NSNotFound) {
+        _AUCMemoryCacheNode *node = (__bridge _AUCMemoryCacheNode *)_slots[index];
+        [self _recordAccessOfNode:node countFrequency:YES];
+        object = node->_value;
+    } else {
+        // 未命中同样计入频率，使反复被请求的数据更容易被接纳；随后的回填写入不再重复计数
+        [_sketch increment:hash];
+#if AU_UIKIT
+        if (useWeakCache) {
+            // 检查弱引用缓存
+            object = [_weakCache objectForKey:key];
+            if (object && fromWeakCache) *fromWeakCache = YES;
+        }
+#endif
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(_lock);
+    return object;
+}
+
+- (void)setObject:(id)object forKey:(id)key hash:(uint64_t)hash cost:(NSUInteger)cost useWeakCache:(BOOL)useWeakCache {
+    NSMutableArray *holder = [NSMutableArray array];
+    AUC_DISPATCH_SEMAPHORE_LOCK(_lock);
+    NSUInteger index = [self _indexOfKey:key hash:hash];
+    if (index != NSNotFound) {
+        _AUCMemoryCacheNode *node = (__bridge _AUCMemoryCacheNode *)_slots[index];
+        // 旧值延迟到解锁后释放
+        if (node->_value) [holder addObject:node->_value];
+        node->_value = object;
+        [self _updateCost:cost ofNode:node];
+        [self _recordAccessOfNode:node countFrequency:NO];
+    } else {
+        _AUCMemoryCacheNode *node = [_AUCMemoryCacheNode new];
+        node->_key = key;
+        node->_value = object;
+        node->_hash = hash;
+        node->_cost = cost;
+        [self _insertNode:node];
+    }
+    [self _demoteWindowOverflow];
+#if AU_UIKIT
+    if (useWeakCache) {
+        [_weakCache setObject:object forKey:key];
+    }
+#endif
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(_lock);
+    holder = nil;
+}
+
+- (void)removeObjectForKey:(id)key hash:(uint64_t)hash useWeakCache:(BOOL)useWeakCache {
+    _AUCMemoryCacheNode *removed = nil;
+    AUC_DISPATCH_SEMAPHORE_LOCK(_lock);
+    NSUInteger index = [self _indexOfKey:key hash:hash];
+    if (index != NSNotFound) {
+        removed = [self _removeNodeAtIndex:index];
+    }
+#if AU_UIKIT
+    if (useWeakCache) {
+        [_weakCache removeObjectForKey:key];
+    }
+#endif
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(_lock);
+    removed = nil;
+}
+
+- (void)removeAllObjectsIncludingWeakCache:(BOOL)includingWeakCache {
+    AUC_DISPATCH_SEMAPHORE_LOCK(_lock);
+    void **oldSlots = _slots;
+    NSUInteger oldCapacity = _capacity;
+    _capacity = AUC_SHARD_INITIAL_CAPACITY;
+    _slots = calloc(_capacity, sizeof(void *));
+    atomic_fetch_sub_explicit(&_budget->_count, _count, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&_budget->_cost, _totalCost, memory_order_relaxed);
+    _count = 0;
+    _totalCost = 0;
+    memset(_lists, 0, sizeof(_lists));
+#if AU_UIKIT
+    if (includingWeakCache) {
+        [_weakCache removeAllObjects];
+    }
+#endif
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(_lock);
+
+    // 在锁外释放节点，避免缓存对象的 dealloc 回调重入导致死锁
+    for (NSUInteger i = 0; i < oldCapacity; i++) {
+        if (oldSlots[i]) CFRelease(oldSlots[i]);
+    }
+    free(oldSlots);
+}
+
+- (void)setCostShare:(NSUInteger)costShare countShare:(NSUInteger)countShare {
+    AUC_DISPATCH_SEMAPHORE_LOCK(_lock);
+    _costShare = costShare;
+    _countShare = countShare;
+    if (_policy == AUCCacheMemoryEvictionPolicyTinyLFU) {
+        // 窗口区占 1%，主区 99% 中保护区占 80%
+        _windowCountLimit = countShare > 0 ? MAX(countShare / 100, 1) : 0;
+        _windowCostLimit = costShare > 0 ? MAX(costShare / 100, 1) : 0;
+        _protectedCountLimit = countShare > 0 ? MAX((countShare - _windowCountLimit) * 4 / 5, 1) : 0;
+        _protectedCostLimit = costShare > 0 ? MAX((costShare - _windowCostLimit) * 4 / 5, 1) : 0;
+        [_sketch ensureCapacity:countShare > 0 ? countShare : AUC_SHARD_DEFAULT_SKETCH_SIZE];
+        [self _demoteWindowOverflow];
+        [self _demoteProtectedOverflow];
+    }
+    AUC_DISPATCH_SEMAPHORE_UNLOCK(_lock);
+}
+
+@end
+
+#pragma mark - AUCShardedMemoryCache
+@interface AUCShardedMemoryCache () {
+    NSArray<_AUCMemoryCacheShard *> *_shards;
+    NSUInteger _shardMask;
+    _AUCMemoryCacheBudget *_budget;
+    // 轮流淘汰时的起始分片
+    _Atomic(NSUInteger) _evictionCursor;
+}
+
+@property (nonatomic, strong, nullable) AUCCacheConfig *config;
+
+@end
+
+@implementation AUCShardedMemoryCache
+- (void)dealloc {
+    [_config removeObserver:self forKeyPath:NSStringFromSelector(@selector(maxMemoryCost)) context:AUCShardedMemoryCacheContext];
+    [_config removeObserver:self forKeyPath:NSStringFromSelector(@selector(maxMemoryCount)) context:AUCShardedMemoryCacheContext];
+#if AU_UIKIT
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+#endif
+}
+
+- (instancetype)init {
+    return [self initWithConfig:[[AUCCacheConfig alloc] init]];
+}
+
+- (instancetype)initWithConfig:(AUCCacheConfig *)config {
+    self = [super init];
+    if (self) {
+        _config = config;
+        [self commonInit];
+    }
+    return self;
+}
+
+- (void)commonInit {
+    AUCCacheConfig *config = self.config;
+
+    // 分片数量取 2 的整数次幂，便于用掩码选择分片
+    NSUInteger count = config.memoryCacheShardCount;
+    if (count == 0) {
+        count = NSProcessInfo.processInfo.activeProcessorCount * 4;
+    }
+    count = MIN(MAX(count, 1), AUC_SHARD_MAX_COUNT);
+    NSUInteger shardCount = 1;
+    while (shardCount < count) shardCount <<= 1;
+    // 数量限制较小时减少分片，保证每个分片的份额不低于 AUC_SHARD_MIN_COUNT_SHARE
+    NSUInteger maxCount = config.maxMemoryCount;
+    while (shardCount > 1 && maxCount > 0 && maxCount / shardCount < AUC_SHARD_MIN_COUNT_SHARE) shardCount >>= 1;
+
+    _budget = [_AUCMemoryCacheBudget new];
+    NSMutableArray<_AUCMemoryCacheShard *> *shards = [NSMutableArray arrayWithCapacity:shardCount];
+    for (NSUInteger i = 0; i < shardCount; i++) {
+        [shards addObject:[[_AUCMemoryCacheShard alloc] initWithPolicy:config.memoryCacheEvictionPolicy budget:_budget]];
+    }
+    _shards = [shards copy];
+    _shardCount = shardCount;
+    _shardMask = shardCount - 1;
+    [self updateShardLimits];
+
+    [config addObserver:self forKeyPath:NSStringFromSelector(@selector(maxMemoryCost)) options:0 context:AUCShardedMemoryCacheContext];
+    [config addObserver:self forKeyPath:NSStringFromSelector(@selector(maxMemoryCount)) options:0 context:AUCShardedMemoryCacheContext];
+
+#if AU_UIKIT
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(didReceiveMemoryWarning:)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+#endif
+}
+
+/// 更新全局限制及每个分片的平均份额，0 表示不限制
+- (void)updateShardLimits {
+    NSUInteger n = _shardCount;
+    NSUInteger maxCost = self.config.maxMemoryCost;
+    NSUInteger maxCount = self.config.maxMemoryCount;
+    atomic_store_explicit(&_budget->_costLimit, maxCost, memory_order_relaxed);
+    atomic_store_explicit(&_budget->_countLimit, maxCount, memory_order_relaxed);
+    NSUInteger costShare = maxCost > 0 ? (maxCost + n - 1) / n : 0;
+    NSUInteger countShare = maxCount > 0 ? (maxCount + n - 1) / n : 0;
+    for (_AUCMemoryCacheShard *shard in _shards) {
+        [shard setCostShare:costShare countShare:countShare];
+    }
+    [self trimToBudgetFromShard:nil key:nil hash:0];
+}
+
+/// 淘汰直到总用量满足全局限制
+///
+/// 1. 先从写入的分片淘汰，直到该分片回到平均份额以内
+/// 2. 仍超限时从各分片轮流淘汰，每轮每个分片淘汰一个
+/// 3. 只剩刚写入的数据且它本身超出全局限制时，最后淘汰它
+- (void)trimToBudgetFromShard:(nullable _AUCMemoryCacheShard *)shard key:(nullable id)key hash:(uint64_t)hash {
+    if (!AUCMemoryCacheBudgetExceeded(_budget)) return;
+    [shard evictOverBudgetProtectingKey:key hash:hash aboveShareOnly:YES limit:NSUIntegerMax];
+
+    NSUInteger cursor = atomic_fetch_add_explicit(&_evictionCursor, 1, memory_order_relaxed);
+    while (AUCMemoryCacheBudgetExceeded(_budget)) {
+        NSUInteger evicted = 0;
+        for (NSUInteger i = 0; i < _shardCount && AUCMemoryCacheBudgetExceeded(_budget); i++) {
+            evicted += [_shards[(cursor + i) & _shardMask] evictOverBudgetProtectingKey:key hash:hash aboveShareOnly:NO limit:1];
+        }
+        if (evicted == 0) {
+            if (!key) break;
+            key = nil;
+        }
+    }
+}
+
+static inline uint64_t AUCShardedMemoryCacheHash(id key) {
+    return AUCMemoryCacheMixHash((uint64_t)[key hash]);
+}
+
+/// 高 32 位选择分片，低位用于分片内的索引表，两者互不相关
+- (_AUCMemoryCacheShard *)shardForHash:(uint64_t)hash {
+    return _shards[(NSUInteger)(hash >> 32) & _shardMask];
+}
+
+- (BOOL)shouldUseWeakMemoryCache {
+#if AU_UIKIT
+    return self.config.shouldUseWeakMemoryCache;
+#else
+    return NO;
+#endif
+}
+
+#if AU_UIKIT
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+    // 只删除缓存，但保留弱缓存
+    for (_AUCMemoryCacheShard *shard in _shards) {
+        [shard removeAllObjectsIncludingWeakCache:NO];
+    }
+}
+#endif
+
+#pragma mark - AUCMemoryCacheProtocol
+- (id)objectForKey:(id)key {
+    if (!key) return nil;
+    uint64_t hash = AUCShardedMemoryCacheHash(key);
+    _AUCMemoryCacheShard *shard = [self shardForHash:hash];
+    BOOL useWeakCache = [self shouldUseWeakMemoryCache];
+    BOOL fromWeakCache = NO;
+    id object = [shard objectForKey:key hash:hash useWeakCache:useWeakCache fromWeakCache:&fromWeakCache];
+    if (fromWeakCache) {
+        // 同步缓存
+        NSUInteger cost = [self.config.memoryCostEstimator costForObject:object];
+        [shard setObject:object forKey:key hash:hash cost:cost useWeakCache:useWeakCache];
+        [self trimToBudgetFromShard:shard key:key hash:hash];
+    }
+    return object;
+}
+
+- (void)setObject:(id)object forKey:(id)key {
+    [self setObject:object forKey:key cost:0];
+}
+
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost {
+    if (!key) return;
+    if (!object) {
+        [self removeObjectForKey:key];
+        return;
+    }
+    uint64_t hash = AUCShardedMemoryCacheHash(key);
+    _AUCMemoryCacheShard *shard = [self shardForHash:hash];
+    [shard setObject:object forKey:key hash:hash cost:cost useWeakCache:[self shouldUseWeakMemoryCache]];
+    [self trimToBudgetFromShard:shard key:key hash:hash];
+}
+
+- (void)removeObjectForKey:(id)key {
+    if (!key) return;
+    uint64_t hash = AUCShardedMemoryCacheHash(key);
+    [[self shardForHash:hash] removeObjectForKey:key hash:hash useWeakCache:[self shouldUseWeakMemoryCache]];
+}
+
+- (void)removeAllObjects {
+    // 手动删除也应该删除弱引用缓存
+    for (_AUCMemoryCacheShard *shard in _shards) {
+        [shard removeAllObjectsIncludingWeakCache:YES];
+    }
+}
+
+#pragma mark - Info
+- (NSUInteger)totalCount {
+    return atomic_load_explicit(&_budget->_count, memory_order_relaxed);
+}
+
+- (NSUInteger)totalCost {
+    return atomic_load_explicit(&_budget->_cost, memory_order_relaxed);
+}
+
+#pragma mark - KVO
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary<NSKeyValueChangeKey,id> *)change context:(void *)context {
+    if (context == AUCShardedMemoryCacheContext) {
+        [self updateShardLimits];
+    } else {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+    }
+}
+
+@end
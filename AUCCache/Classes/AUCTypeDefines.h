@@ -32,6 +32,57 @@ typedef NS_ENUM(NSUInteger, AUCCacheConfigExpireType) {
 };
 
 
+#pragma mark - 内存缓存淘汰策略
+/// ``内存缓存淘汰策略``
+typedef NS_ENUM(NSUInteger, AUCCacheMemoryEvictionPolicy) {
+    /// 最近最少使用（默认）
+    AUCCacheMemoryEvictionPolicyLRU,
+    /// W-TinyLFU：窗口 LRU + 频率草图准入 + 分段 LRU 主区（试用区 / 保护区）
+    /// 新数据先进入窗口区，溢出后只有访问频率高于主区淘汰候选时才会被接纳，避免一次性扫描冲刷热点数据
+    AUCCacheMemoryEvictionPolicyTinyLFU,
+};
+
+
+#pragma mark - 磁盘缓存校验方式
+/// ``磁盘缓存读取时的校验方式``
+typedef NS_ENUM(NSUInteger, AUCCacheDiskChecksumMode) {
+    /// 读取时不校验，也不在后台校验
+    AUCCacheDiskChecksumModeOff,
+    /// 每个缓存文件写入后第一次读取时校验，校验通过后不再重复校验（默认）
+    AUCCacheDiskChecksumModeLazy,
+    /// 每次读取都校验
+    AUCCacheDiskChecksumModeOnRead,
+};
+
+
+#pragma mark - 磁盘 IO 优先级
+/// ``磁盘 IO 优先级``
+///
+/// 同一组内严格按优先级执行，等待时间越长有效优先级越高，低优先级不会被无限推迟
+typedef NS_ENUM(NSUInteger, AUCIOPriority) {
+    /// 过期清理、启动恢复等维护任务
+    AUCIOPriorityMaintenance,
+    /// 异步写入、删除
+    AUCIOPriorityWriteBack,
+    /// 预取
+    AUCIOPriorityPrefetch,
+    /// 用户正在等待结果的读取（默认）
+    AUCIOPriorityInteractive,
+    /// 优先级数量
+    AUCIOPriorityCount
+};
+
+/// ``异步操作完成回调的执行位置``
+typedef NS_ENUM(NSUInteger, AUCCallbackTarget) {
+    /// 主队列，合并同一轮主队列循环之前完成的回调（默认）
+    AUCCallbackTargetMainQueue,
+    /// 调用方提供的队列
+    AUCCallbackTargetQueue,
+    /// 在完成操作的线程直接执行
+    AUCCallbackTargetInline
+};
+
+
 #pragma mark - 缓存操作策略
 /// ``缓存操作策略``
 typedef NS_ENUM(NSUInteger, AUCCachesManagerOperationPolicy) {
@@ -130,6 +181,17 @@ typedef void(^AUCCacheCalculateSizeBlock)(NSUInteger fileCount, NSUInteger total
 typedef void(^AUCCacheQueryCompletionBlock)(id _Nullable data, AUCCacheType cacheType);
 typedef void(^AUCCacheContainsCompletionBlock)(AUCCacheType containsCacheType);
 
+/// 批量查询扩展数据完成回调
+///
+/// - Parameter extendedDataMap: 键 -> 扩展数据，不存在或没有扩展数据的键不包含在内
+typedef void(^AUCCacheExtendedDataCompletionBlock)(NSDictionary<NSString *, NSData *> * _Nonnull extendedDataMap);
+
+@class AUCDiskCacheRecoveryReport;
+/// 磁盘缓存启动恢复完成回调
+///
+/// - Parameter report: 恢复报告
+typedef void(^AUCCacheRecoveryCompletionBlock)(AUCDiskCacheRecoveryReport * _Nonnull report);
+
 
 #pragma mark - 其他
 typedef NSString *AUCacheContextOption NS_EXTENSIBLE_STRING_ENUM;
@@ -0,0 +1,198 @@
+//
+//  AUCCacheCodecSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCCacheCodec.h>
+
+/// 自定义编解码器：把 `NSDate` 保存为 8 字节时间戳
+@interface AUCCodecSpecDateCodec : NSObject <AUCCacheCodecProtocol>
+@end
+
+@implementation AUCCodecSpecDateCodec
+
+- (uint8_t)codecTag {
+    return 200;
+}
+
+- (BOOL)canEncodeObject:(id)object {
+    return [object isKindOfClass:NSDate.class];
+}
+
+- (NSData *)encodedDataWithObject:(id)object {
+    NSTimeInterval interval = [(NSDate *)object timeIntervalSince1970];
+    return [NSData dataWithBytes:&interval length:sizeof(interval)];
+}
+
+- (id)decodedObjectWithData:(NSData *)data {
+    if (data.length != sizeof(NSTimeInterval)) return nil;
+    NSTimeInterval interval;
+    memcpy(&interval, data.bytes, sizeof(interval));
+    return [NSDate dateWithTimeIntervalSince1970:interval];
+}
+
+@end
+
+/// 覆盖各种 JSON 值类型的对象树
+static NSDictionary *AUCCodecSpecObject(void) {
+    return @{
+        @"id": @(-42),
+        @"big": @(9007199254740993LL),
+        @"ratio": @(0.125),
+        @"flag": @YES,
+        @"off": @NO,
+        @"none": NSNull.null,
+        @"name": @"缓存 ✓ \"quoted\"\n",
+        @"empty": @{},
+        @"list": @[@1, @"two", @[], @{@"nested": @[@3, @{@"deep": @"value"}]}],
+    };
+}
+
+SpecBegin(AUCCacheCodec)
+
+describe(@"registry", ^{
+    it(@"stores data and strings as is", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] init];
+        NSData *data = [@"raw bytes" dataUsingEncoding:NSUTF8StringEncoding];
+        expect([registry encodedDataForObject:data]).to.equal(data);
+        expect([registry encodedDataForObject:@"raw bytes"]).to.equal(data);
+        expect([AUCCacheCodecRegistry codecTagOfData:data]).to.equal(0);
+        expect([registry payloadOfData:data]).to.equal(data);
+    });
+
+    it(@"round-trips JSON objects through a tagged frame", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] init];
+        NSData *encoded = [registry encodedDataForObject:AUCCodecSpecObject()];
+        expect([AUCCacheCodecRegistry codecTagOfData:encoded]).to.equal(AUCCacheCodecTagJSON);
+        expect([registry decodedObjectForData:encoded]).to.equal(AUCCodecSpecObject());
+
+        // 去掉帧头后即为紧凑的 JSON
+        NSData *payload = [registry payloadOfData:encoded];
+        expect(payload.length).to.equal(encoded.length - 8);
+        expect([NSJSONSerialization JSONObjectWithData:payload options:0 error:nil]).to.equal(AUCCodecSpecObject());
+        expect([registry externalDataOfData:encoded]).to.equal(payload);
+    });
+
+    it(@"decodes headerless data with the legacy rules", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] init];
+        NSData *json = [NSJSONSerialization dataWithJSONObject:@{@"a": @1} options:0 error:nil];
+        expect([registry decodedObjectForData:json]).to.equal(@{@"a": @1});
+        NSData *raw = [NSData dataWithBytes:"\x00\x01\x02" length:3];
+        expect([registry decodedObjectForData:raw]).to.equal(raw);
+    });
+
+    it(@"decodes each hit exactly once", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] init];
+        NSData *encoded = [registry encodedDataForObject:AUCCodecSpecObject()];
+        [registry resetStatistics];
+        [registry decodedObjectForData:encoded];
+        expect(registry.decodeCount).to.equal(1);
+        expect(registry.decodedBytes).to.equal(encoded.length);
+    });
+
+    it(@"gives the same result with the structural index parser", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] init];
+        NSData *encoded = [registry encodedDataForObject:AUCCodecSpecObject()];
+        registry.JSONCodec.usesStructuralIndexParser = YES;
+        expect([registry decodedObjectForData:encoded]).to.equal(AUCCodecSpecObject());
+    });
+
+    it(@"selects custom codecs first and misses when the codec is gone", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] initWithCodecs:@[[AUCCodecSpecDateCodec new]]];
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:1733200000.5];
+        NSData *encoded = [registry encodedDataForObject:date];
+        expect([AUCCacheCodecRegistry codecTagOfData:encoded]).to.equal(200);
+        expect([registry decodedObjectForData:encoded]).to.equal(date);
+
+        AUCCacheCodecRegistry *withoutCodec = [[AUCCacheCodecRegistry alloc] init];
+        expect([withoutCodec encodedDataForObject:date]).to.beNil();
+        expect([withoutCodec decodedObjectForData:encoded]).to.beNil();
+    });
+});
+
+describe(@"binary format", ^{
+    it(@"round-trips JSON objects as lazy containers", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] initWithCodecs:nil binaryFormat:YES];
+        NSData *encoded = [registry encodedDataForObject:AUCCodecSpecObject()];
+        expect([AUCCacheCodecRegistry codecTagOfData:encoded]).to.equal(AUCCacheCodecTagBinary);
+
+        NSDictionary *decoded = [registry decodedObjectForData:encoded];
+        expect(decoded).to.equal(AUCCodecSpecObject());
+        expect(decoded[@"list"][3][@"nested"][1][@"deep"]).to.equal(@"value");
+        expect(decoded[@"missing"]).to.beNil();
+        expect([AUCCacheBinaryCodec bufferLengthOfLazyObject:decoded]).to.equal(encoded.length - 8);
+        expect([AUCCacheBinaryCodec bufferLengthOfLazyObject:decoded[@"list"]]).to.equal(encoded.length - 8);
+        expect([AUCCacheBinaryCodec bufferLengthOfLazyObject:@{}]).to.equal(0);
+    });
+
+    it(@"keeps full 64-bit integers", ^{
+        AUCCacheBinaryCodec *codec = [AUCCacheBinaryCodec new];
+        NSArray *numbers = @[@(UINT64_MAX), @(INT64_MIN), @(INT64_MAX), @(-1), @(1e300)];
+        NSArray *decoded = [codec decodedObjectWithData:[codec encodedDataWithObject:numbers]];
+        expect([decoded[0] unsignedLongLongValue]).to.equal(UINT64_MAX);
+        expect([decoded[1] longLongValue]).to.equal(INT64_MIN);
+        expect([decoded[2] longLongValue]).to.equal(INT64_MAX);
+        expect([decoded[3] longLongValue]).to.equal(-1);
+        expect([decoded[4] doubleValue]).to.equal(1e300);
+    });
+
+    it(@"returns fully mutable copies", ^{
+        AUCCacheBinaryCodec *codec = [AUCCacheBinaryCodec new];
+        NSDictionary *decoded = [codec decodedObjectWithData:[codec encodedDataWithObject:AUCCodecSpecObject()]];
+        expect([decoded copy]).to.beIdenticalTo(decoded);
+
+        NSMutableDictionary *copy = [decoded mutableCopy];
+        expect(copy).to.equal(AUCCodecSpecObject());
+        expect([AUCCacheBinaryCodec bufferLengthOfLazyObject:copy]).to.equal(0);
+        NSMutableArray *list = copy[@"list"];
+        expect([AUCCacheBinaryCodec bufferLengthOfLazyObject:list]).to.equal(0);
+        [list addObject:@"appended"];
+        copy[@"list"][3][@"nested"][1][@"deep"] = @"changed";
+        expect(copy[@"list"][3][@"nested"][1][@"deep"]).to.equal(@"changed");
+    });
+
+    it(@"hands callers the JSON form of binary data", ^{
+        AUCCacheCodecRegistry *registry = [[AUCCacheCodecRegistry alloc] initWithCodecs:nil binaryFormat:YES];
+        NSData *encoded = [registry encodedDataForObject:AUCCodecSpecObject()];
+        NSData *external = [registry externalDataOfData:encoded];
+        expect([NSJSONSerialization JSONObjectWithData:external options:0 error:nil]).to.equal(AUCCodecSpecObject());
+        // 关闭二进制格式后，已有的二进制数据仍可读取
+        AUCCacheCodecRegistry *JSONRegistry = [[AUCCacheCodecRegistry alloc] init];
+        expect([JSONRegistry decodedObjectForData:encoded]).to.equal(AUCCodecSpecObject());
+    });
+
+    it(@"rejects corrupt headers and offsets without reading out of bounds", ^{
+        AUCCacheBinaryCodec *codec = [AUCCacheBinaryCodec new];
+        NSData *encoded = [codec encodedDataWithObject:@[@"a", @{@"k": @"v"}]];
+        expect([codec decodedObjectWithData:encoded]).to.equal((@[@"a", @{@"k": @"v"}]));
+
+        // 头部：magic(4) 版本(2) 预留(2) 根节点偏移(4) 长度(4)
+        uint32_t root;
+        [encoded getBytes:&root range:NSMakeRange(8, 4)];
+        uint32_t invalid = UINT32_MAX;
+
+        expect([codec decodedObjectWithData:[encoded subdataWithRange:NSMakeRange(0, encoded.length - 1)]]).to.beNil();
+        NSMutableData *badRoot = [encoded mutableCopy];
+        [badRoot replaceBytesInRange:NSMakeRange(8, 4) withBytes:&invalid];
+        expect([codec decodedObjectWithData:badRoot]).to.beNil();
+
+        // 数组数量超出数据长度
+        NSMutableData *badCount = [encoded mutableCopy];
+        [badCount replaceBytesInRange:NSMakeRange(root + 1, 4) withBytes:&invalid];
+        expect([codec decodedObjectWithData:badCount]).to.beNil();
+
+        // 元素偏移越界：数组中以 NSNull 代替
+        NSMutableData *badElement = [encoded mutableCopy];
+        [badElement replaceBytesInRange:NSMakeRange(root + 5, 4) withBytes:&invalid];
+        NSArray *array = [codec decodedObjectWithData:badElement];
+        expect(array.count).to.equal(2);
+        expect(array[0]).to.equal(NSNull.null);
+        expect(array[1]).to.equal(@{@"k": @"v"});
+
+        expect([codec decodedObjectWithData:[NSData data]]).to.beNil();
+    });
+});
+
+SpecEnd
@@ -0,0 +1,182 @@
+//
+//  AUCCacheCompressorSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCCacheCompressor.h>
+
+static NSString * const AUCCompressorSpecPrefix = @"https://api.example.com/feed";
+
+/// 模拟接口响应：字段名与枚举值大量重复，数值各不相同
+static NSData *AUCCompressorSpecResponse(NSUInteger seed, NSUInteger itemCount) {
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:itemCount];
+    for (NSUInteger i = 0; i < itemCount; i++) {
+        NSUInteger value = seed * 7919 + i * 104729;
+        [items addObject:@{
+            @"id": @(value),
+            @"title": [NSString stringWithFormat:@"item %lu", (unsigned long)(value % 100003)],
+            @"status": (value % 3 == 0) ? @"published" : @"draft",
+            @"author": @{@"uid": @(value % 997), @"nickname": [NSString stringWithFormat:@"user%lu", (unsigned long)(value % 997)]},
+            @"cover_url": [NSString stringWithFormat:@"https://img.example.com/cover/%lu.jpg", (unsigned long)value],
+        }];
+    }
+    return [NSJSONSerialization dataWithJSONObject:@{@"code": @0, @"message": @"success", @"data": @{@"items": items, @"has_more": @YES}}
+                                           options:0
+                                             error:nil];
+}
+
+/// 不可压缩的伪随机数据
+static NSData *AUCCompressorSpecRandomData(NSUInteger length) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint32_t seed = 1;
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bytes[i] = (uint8_t)(seed >> 16);
+    }
+    return data;
+}
+
+/// 训练字典使用的样本
+static NSArray<NSData *> *AUCCompressorSpecSamples(void) {
+    NSMutableArray<NSData *> *samples = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 40; i++) {
+        [samples addObject:AUCCompressorSpecResponse(1000 + i, 3)];
+    }
+    return samples;
+}
+
+SpecBegin(AUCCacheCompressor)
+
+describe(@"codec selection", ^{
+    it(@"keeps data below the threshold and with compression disabled as is", ^{
+        NSData *response = AUCCompressorSpecResponse(1, 20);
+        AUCCacheCompressor *compressor = [[AUCCacheCompressor alloc] initWithThreshold:response.length + 1 maxRatio:0.9 dictionaries:nil];
+        expect([compressor compressedDataForData:response key:nil]).to.equal(response);
+
+        compressor = [[AUCCacheCompressor alloc] initWithThreshold:0 maxRatio:0.9 dictionaries:nil];
+        expect([compressor compressedDataForData:response key:nil]).to.equal(response);
+        expect(compressor.compressedCount).to.equal(0);
+        expect(compressor.compressionRatio).to.equal(1);
+    });
+
+    it(@"compresses repetitive JSON and restores it", ^{
+        NSData *response = AUCCompressorSpecResponse(1, 50);
+        AUCCacheCompressor *compressor = [[AUCCacheCompressor alloc] initWithThreshold:256 maxRatio:0.9 dictionaries:nil];
+        NSData *compressed = [compressor compressedDataForData:response key:nil];
+        expect([AUCCacheCompressor isCompressedData:compressed]).to.beTruthy();
+        expect(compressed.length).to.beLessThan(response.length / 2);
+        expect([compressor decompressedDataForData:compressed]).to.equal(response);
+
+        expect(compressor.compressedCount).to.equal(1);
+        expect(compressor.uncompressedBytes).to.equal(response.length);
+        expect(compressor.compressedBytes).to.equal(compressed.length);
+        expect(compressor.decodedBytes).to.equal(response.length);
+        [compressor resetStatistics];
+        expect(compressor.compressedCount).to.equal(0);
+        expect(compressor.decodedBytes).to.equal(0);
+    });
+
+    it(@"stores incompressible data as is, including large data rejected by the probe", ^{
+        AUCCacheCompressor *compressor = [[AUCCacheCompressor alloc] initWithThreshold:256 maxRatio:0.9 dictionaries:nil];
+        for (NSNumber *length in @[@1000, @(256 * 1024)]) {
+            NSData *random = AUCCompressorSpecRandomData(length.unsignedIntegerValue);
+            NSData *stored = [compressor compressedDataForData:random key:nil];
+            expect([AUCCacheCompressor isCompressedData:stored]).to.beFalsy();
+            expect(stored).to.equal(random);
+        }
+        expect(compressor.compressedCount).to.equal(0);
+    });
+
+    it(@"returns data without a frame header unchanged and rejects truncated frames", ^{
+        AUCCacheCompressor *compressor = [[AUCCacheCompressor alloc] initWithThreshold:256 maxRatio:0.9 dictionaries:nil];
+        NSData *plain = [@"{\"legacy\":true}" dataUsingEncoding:NSUTF8StringEncoding];
+        expect([compressor decompressedDataForData:plain]).to.equal(plain);
+        expect([compressor decompressedDataForData:[NSData data]]).to.equal([NSData data]);
+
+        NSData *truncated = [[compressor compressedDataForData:AUCCompressorSpecResponse(3, 50) key:nil] subdataWithRange:NSMakeRange(0, 30)];
+        expect([compressor decompressedDataForData:truncated]).to.beNil();
+    });
+});
+
+describe(@"preset dictionaries", ^{
+    __block NSData *dictionary;
+
+    beforeEach(^{
+        dictionary = [AUCCacheCompressor trainDictionaryWithSamples:AUCCompressorSpecSamples() maxLength:4096];
+    });
+
+    it(@"trains a dictionary from repeated fragments within the length limit", ^{
+        expect(dictionary.length).to.beGreaterThan(0);
+        expect(dictionary.length).to.beLessThanOrEqualTo(4096);
+        NSString *string = [[NSString alloc] initWithData:dictionary encoding:NSUTF8StringEncoding];
+        expect(string).to.contain(@"\"nickname\":");
+        expect([AUCCacheCompressor trainDictionaryWithSamples:@[] maxLength:4096].length).to.equal(0);
+    });
+
+    it(@"uses the dictionary of the longest matching prefix for small responses", ^{
+        NSDictionary *dictionaries = @{
+            @"https://api.example.com": [NSData dataWithBytes:"unrelated" length:9],
+            AUCCompressorSpecPrefix: dictionary,
+        };
+        AUCCacheCompressor *compressor = [[AUCCacheCompressor alloc] initWithThreshold:64 maxRatio:0.9 dictionaries:dictionaries];
+        AUCCacheCompressor *plainCompressor = [[AUCCacheCompressor alloc] initWithThreshold:64 maxRatio:1 dictionaries:nil];
+        NSData *response = AUCCompressorSpecResponse(5000, 2);
+        NSString *key = [AUCCompressorSpecPrefix stringByAppendingString:@"/list?page=2"];
+
+        NSData *withDictionary = [compressor compressedDataForData:response key:key];
+        NSData *withoutDictionary = [plainCompressor compressedDataForData:response key:key];
+        expect([AUCCacheCompressor isCompressedData:withDictionary]).to.beTruthy();
+        expect(withDictionary.length).to.beLessThan(withoutDictionary.length);
+        expect([compressor decompressedDataForData:withDictionary]).to.equal(response);
+
+        // 没有写入时使用的字典无法解压，按未命中处理
+        expect([plainCompressor decompressedDataForData:withDictionary]).to.beNil();
+        // 不匹配任何前缀的键不使用字典
+        NSData *other = [compressor compressedDataForData:response key:@"https://other.example.com/list"];
+        expect([plainCompressor decompressedDataForData:other]).to.equal(response);
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"reports compression ratio and decode throughput", ^{
+        NSData *dictionary = [AUCCacheCompressor trainDictionaryWithSamples:AUCCompressorSpecSamples() maxLength:16 * 1024];
+        AUCCacheCompressor *plainCompressor = [[AUCCacheCompressor alloc] initWithThreshold:64 maxRatio:0.9 dictionaries:nil];
+        AUCCacheCompressor *dictionaryCompressor = [[AUCCacheCompressor alloc] initWithThreshold:64 maxRatio:0.9 dictionaries:@{AUCCompressorSpecPrefix: dictionary}];
+        NSString *key = [AUCCompressorSpecPrefix stringByAppendingString:@"/list"];
+
+        for (NSNumber *itemCount in @[@2, @20, @500]) {
+            NSMutableArray<NSData *> *responses = [NSMutableArray array];
+            for (NSUInteger i = 0; i < 100; i++) {
+                [responses addObject:AUCCompressorSpecResponse(i, itemCount.unsignedIntegerValue)];
+            }
+            for (AUCCacheCompressor *compressor in @[plainCompressor, dictionaryCompressor]) {
+                [compressor resetStatistics];
+                NSMutableArray<NSData *> *compressed = [NSMutableArray array];
+                for (NSData *response in responses) {
+                    [compressed addObject:[compressor compressedDataForData:response key:key]];
+                }
+                for (NSUInteger i = 0; i < compressed.count; i++) {
+                    expect([compressor decompressedDataForData:compressed[i]]).to.equal(responses[i]);
+                }
+                // 按 50MB/s 的低速闪存估算读取耗时：读取压缩数据 + 解压 与 读取原始数据
+                double flashSpeed = 50.0 * 1024 * 1024;
+                double compressedReadTime = compressor.compressedBytes / flashSpeed + compressor.decodeTime;
+                double plainReadTime = compressor.uncompressedBytes / flashSpeed;
+                NSLog(@"[AUCCacheCompressor] %lu items, %@: ratio %.3f, decode %.1fMB/s, read on 50MB/s flash %.2fms vs %.2fms uncompressed",
+                      (unsigned long)itemCount.unsignedIntegerValue, compressor == plainCompressor ? @"no dictionary" : @"dictionary",
+                      compressor.compressionRatio, compressor.decodeThroughput / 1024 / 1024, compressedReadTime * 1000, plainReadTime * 1000);
+
+                // 很小的响应只有借助字典才值得压缩
+                if (compressor == dictionaryCompressor || itemCount.unsignedIntegerValue >= 20) {
+                    expect(compressor.compressionRatio).to.beLessThan(0.9);
+                    expect(compressedReadTime).to.beLessThan(plainReadTime);
+                }
+            }
+        }
+    });
+});
+
+SpecEnd
@@ -0,0 +1,150 @@
+//
+//  AUCCacheCostEstimatorSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCCacheCostEstimator.h>
+#import <objc/runtime.h>
+
+@interface AUCCostSpecObject : NSObject
+@end
+
+@implementation AUCCostSpecObject
+@end
+
+@interface AUCCostSpecSubObject : AUCCostSpecObject
+@end
+
+@implementation AUCCostSpecSubObject
+@end
+
+/// 可复现的伪随机数
+static uint32_t AUCCostSpecNext(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 16;
+}
+
+/// 长度在 [20, 120) 之间的 ASCII 字符串
+static NSString *AUCCostSpecString(uint32_t *seed) {
+    NSUInteger length = 20 + AUCCostSpecNext(seed) % 100;
+    return [@"" stringByPaddingToLength:length withString:@"abcdefgh" startingAtIndex:0];
+}
+
+static double AUCCostSpecRelativeError(NSUInteger estimated, NSUInteger exact) {
+    return fabs((double)estimated - (double)exact) / (double)exact;
+}
+
+SpecBegin(AUCCacheCostEstimator)
+
+describe(@"leaf objects", ^{
+    __block AUCCacheCostEstimator *estimator;
+
+    beforeEach(^{
+        estimator = [AUCCacheCostEstimator new];
+    });
+
+    it(@"counts the object header plus the 16-byte aligned data length", ^{
+        expect([estimator costForObject:[NSMutableData dataWithLength:100]]).to.equal(16 + 112);
+        expect([estimator costForObject:[NSData data]]).to.equal(16);
+        expect([estimator costForObject:nil]).to.equal(0);
+        expect([estimator costForObject:NSNull.null]).to.equal(0);
+        expect([estimator costForObject:@(42)]).to.equal(16);
+    });
+
+    it(@"counts one byte per character for 8-bit strings and two for UTF-16 strings", ^{
+        NSString *ascii = [@"" stringByPaddingToLength:40 withString:@"a" startingAtIndex:0];
+        expect([estimator costForObject:ascii]).to.equal(16 + 48);
+        NSString *chinese = [@"" stringByPaddingToLength:40 withString:@"中" startingAtIndex:0];
+        expect([estimator costForObject:chinese]).to.equal(16 + 80);
+        // 解析 JSON 得到的字符串同样按存储编码区分
+        NSArray<NSString *> *parsed = [NSJSONSerialization JSONObjectWithData:[[NSString stringWithFormat:@"[\"%@\",\"%@\"]", ascii, chinese] dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
+        expect([estimator costForObject:parsed[0]]).to.equal(16 + 48);
+        expect([estimator costForObject:parsed[1]]).to.equal(16 + 80);
+    });
+
+    it(@"falls back to the instance size for unknown classes", ^{
+        NSUInteger size = class_getInstanceSize(AUCCostSpecObject.class);
+        expect([estimator costForObject:[AUCCostSpecObject new]]).to.equal((size + 15) & ~(NSUInteger)15);
+    });
+});
+
+describe(@"containers", ^{
+    __block AUCCacheCostEstimator *estimator;
+
+    beforeEach(^{
+        estimator = [AUCCacheCostEstimator new];
+    });
+
+    it(@"walks a nested JSON tree", ^{
+        NSDictionary *tree = [NSJSONSerialization JSONObjectWithData:[@"{\"k\":[1,2]}" dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
+        // 字典 16 + 1.5 * 2 * 8 → 32，键 "k" 32，数组 16 + 16，两个数字 32
+        expect([estimator costForObject:tree]).to.equal(32 + 32 + 32 + 32);
+        expect([estimator costForObject:@[]]).to.equal(16);
+        expect([estimator costForObject:@{}]).to.equal(16);
+    });
+
+    it(@"stops descending at the maximum depth", ^{
+        estimator.maxDepth = 2;
+        id tree = @[@[@[@[[NSMutableData dataWithLength:1000]]]]];
+        // 第 3 层及以下只计算容器本身
+        expect([estimator costForObject:tree]).to.equal(32 * 3);
+    });
+
+    it(@"stays within a bounded error of the exact walk when sampling large containers", ^{
+        uint32_t seed = 1;
+        NSMutableArray *array = [NSMutableArray array];
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+        for (NSUInteger i = 0; i < 2000; i++) {
+            [array addObject:@{@"name": AUCCostSpecString(&seed), @"id": @(i)}];
+            dictionary[[NSString stringWithFormat:@"key-%lu", (unsigned long)i]] = AUCCostSpecString(&seed);
+        }
+
+        AUCCacheCostEstimator *exact = [AUCCacheCostEstimator new];
+        exact.samplingThreshold = 0;
+        NSUInteger exactArrayCost = [exact costForObject:array];
+        NSUInteger exactDictionaryCost = [exact costForObject:dictionary];
+
+        expect(AUCCostSpecRelativeError([estimator costForObject:array], exactArrayCost)).to.beLessThan(0.15);
+        expect(AUCCostSpecRelativeError([estimator costForObject:dictionary], exactDictionaryCost)).to.beLessThan(0.15);
+        // 阈值以内的容器总是完整遍历
+        NSArray *small = [array subarrayWithRange:NSMakeRange(0, 512)];
+        expect([estimator costForObject:small]).to.equal([exact costForObject:small]);
+    });
+});
+
+describe(@"cost blocks", ^{
+    it(@"override the default estimate for a class and its subclasses", ^{
+        AUCCacheCostEstimator *estimator = [AUCCacheCostEstimator new];
+        [estimator setCostBlock:^NSUInteger(id object) {
+            return 100;
+        } forClass:AUCCostSpecObject.class];
+        expect([estimator costForObject:[AUCCostSpecObject new]]).to.equal(100);
+        expect([estimator costForObject:[AUCCostSpecSubObject new]]).to.equal(100);
+        // 容器内的对象同样使用回调
+        expect([estimator costForObject:@[[AUCCostSpecSubObject new]]]).to.equal(32 + 100);
+
+        // 最接近的注册类型优先
+        [estimator setCostBlock:^NSUInteger(id object) {
+            return 5;
+        } forClass:AUCCostSpecSubObject.class];
+        expect([estimator costForObject:[AUCCostSpecSubObject new]]).to.equal(5);
+        expect([estimator costForObject:[AUCCostSpecObject new]]).to.equal(100);
+
+        [estimator setCostBlock:nil forClass:AUCCostSpecObject.class];
+        [estimator setCostBlock:nil forClass:AUCCostSpecSubObject.class];
+        NSUInteger size = class_getInstanceSize(AUCCostSpecObject.class);
+        expect([estimator costForObject:[AUCCostSpecObject new]]).to.equal((size + 15) & ~(NSUInteger)15);
+    });
+
+    it(@"can override built-in types", ^{
+        AUCCacheCostEstimator *estimator = [AUCCacheCostEstimator new];
+        [estimator setCostBlock:^NSUInteger(NSData *data) {
+            return data.length * 2;
+        } forClass:NSData.class];
+        expect([estimator costForObject:[NSMutableData dataWithLength:100]]).to.equal(200);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,248 @@
+//
+//  AUCCacheDeltaSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCCacheDelta.h>
+#import <AUCCache/AUCDiskCache.h>
+#import <AUCCache/AUCDiskCacheIndex.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+#import <AUCCache/AUCDiskEntryFormat.h>
+#import <sys/time.h>
+
+/// 模拟重新请求的分页列表：第 `version` 次请求只有少量计数字段变化
+static NSData *AUCDeltaSpecResponse(NSUInteger version, NSUInteger itemCount) {
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:itemCount];
+    for (NSUInteger i = 0; i < itemCount; i++) {
+        NSUInteger value = i * 104729 + 7919;
+        [items addObject:@{
+            @"id": @(value),
+            @"title": [NSString stringWithFormat:@"item %lu", (unsigned long)(value % 100003)],
+            @"like_count": @(value % 1000 + (i % 10 == 0 ? version : 0)),
+            @"cover_url": [NSString stringWithFormat:@"https://img.example.com/cover/%lu.jpg", (unsigned long)value],
+        }];
+    }
+    return [NSJSONSerialization dataWithJSONObject:@{@"code": @0, @"data": @{@"items": items, @"version": @(version)}}
+                                           options:NSJSONWritingSortedKeys
+                                             error:nil];
+}
+
+/// 第 i 个测试文件名：32 位十六进制摘要，前缀打散到不同的子目录
+static NSString *AUCDeltaSpecFileName(NSUInteger i) {
+    return [NSString stringWithFormat:@"%08x%024lx", (uint32_t)(i * 2654435761u), (unsigned long)i];
+}
+
+/// 按两级子目录布局写入缓存文件，并把修改时间设为 `age` 秒之前
+static NSString *AUCDeltaSpecWriteFile(NSString *directory, NSUInteger i, NSUInteger length, NSTimeInterval age) {
+    NSString *fileName = AUCDeltaSpecFileName(i);
+    NSString *path = [directory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName]];
+    [NSFileManager.defaultManager createDirectoryAtPath:path.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSMutableData dataWithLength:length] writeToFile:path atomically:NO];
+    struct timeval times[2];
+    times[0].tv_sec = times[1].tv_sec = (time_t)(time(NULL) - age);
+    times[0].tv_usec = times[1].tv_usec = 0;
+    utimes(path.fileSystemRepresentation, times);
+    return path;
+}
+
+/// 文件大小，不存在时返回 0
+static NSUInteger AUCDeltaSpecFileSize(NSString *path) {
+    return (NSUInteger)[[NSFileManager.defaultManager attributesOfItemAtPath:path error:NULL] fileSize];
+}
+
+SpecBegin(AUCCacheDelta)
+
+describe(@"encoding", ^{
+    it(@"restores the new version from the base", ^{
+        NSData *base = AUCDeltaSpecResponse(1, 50);
+        NSData *data = AUCDeltaSpecResponse(2, 50);
+        NSData *delta = [AUCCacheDelta deltaFromData:base toData:data revision:3 maxLength:0];
+        expect(delta).notTo.beNil();
+        expect(delta.length).to.beLessThan(data.length / 4);
+        expect([AUCCacheDelta revisionOfDelta:delta]).to.equal(3);
+        expect([AUCCacheDelta dataByApplyingDelta:delta toData:base]).to.equal(data);
+
+        // 与基准版本完全无关的新版本只能整体插入
+        NSData *empty = [NSData data];
+        NSData *insertOnly = [AUCCacheDelta deltaFromData:empty toData:data revision:1 maxLength:0];
+        expect([AUCCacheDelta dataByApplyingDelta:insertOnly toData:empty]).to.equal(data);
+        expect([AUCCacheDelta dataByApplyingDelta:[AUCCacheDelta deltaFromData:data toData:empty revision:1 maxLength:0] toData:data]).to.equal(empty);
+    });
+
+    it(@"gives up when the delta exceeds the length limit", ^{
+        NSData *base = AUCDeltaSpecResponse(1, 50);
+        NSData *data = AUCDeltaSpecResponse(2, 50);
+        expect([AUCCacheDelta deltaFromData:base toData:data revision:1 maxLength:16]).to.beNil();
+        expect([AUCCacheDelta deltaFromData:base toData:data revision:1 maxLength:data.length]).notTo.beNil();
+    });
+
+    it(@"rejects a base that does not match and data that is not a delta", ^{
+        NSData *base = AUCDeltaSpecResponse(1, 50);
+        NSData *data = AUCDeltaSpecResponse(2, 50);
+        NSData *delta = [AUCCacheDelta deltaFromData:base toData:data revision:1 maxLength:0];
+        expect([AUCCacheDelta dataByApplyingDelta:delta toData:AUCDeltaSpecResponse(3, 50)]).to.beNil();
+        expect([AUCCacheDelta dataByApplyingDelta:delta toData:[base subdataWithRange:NSMakeRange(0, base.length - 1)]]).to.beNil();
+        expect([AUCCacheDelta dataByApplyingDelta:[delta subdataWithRange:NSMakeRange(0, 20)] toData:base]).to.beNil();
+        expect([AUCCacheDelta revisionOfDelta:data]).to.equal(0);
+        expect([AUCCacheDelta dataByApplyingDelta:data toData:base]).to.beNil();
+    });
+});
+
+describe(@"disk cache", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+    __block AUCDiskCache *cache;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        config.diskCacheDeltaThreshold = 1024;
+        config.diskCacheDeltaMaxRevisions = 2;
+        cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+    });
+
+    afterEach(^{
+        cache = nil;
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"stores a small change as a delta against the previous full version", ^{
+        NSString *path = [cache cachePathForKey:@"feed"];
+        NSString *basePath = [[directory stringByAppendingPathComponent:@".auc_deltas"] stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:path.lastPathComponent]];
+        NSData *v1 = AUCDeltaSpecResponse(1, 50);
+        NSData *v2 = AUCDeltaSpecResponse(2, 50);
+        [cache setData:v1 forKey:@"feed"];
+        NSUInteger fullSize = AUCDeltaSpecFileSize(path);
+        expect([NSFileManager.defaultManager fileExistsAtPath:basePath]).to.beFalsy();
+
+        [cache setData:v2 forKey:@"feed"];
+        NSData *entryData = [NSData dataWithContentsOfFile:path];
+        expect([AUCDiskEntryFormat flagsOfEntryData:entryData] & AUCDiskEntryFlagDelta).to.beTruthy();
+        expect(entryData.length).to.beLessThan(fullSize / 4);
+        // 上一个完整版本原样移入基准版本目录
+        expect(AUCDeltaSpecFileSize(basePath)).to.equal(fullSize);
+        expect([cache dataForKey:@"feed"]).to.equal(v2);
+        // 差量与基准版本都计入大小
+        expect(cache.totalSize).to.equal(entryData.length + fullSize);
+    });
+
+    it(@"rewrites a full version after the maximum number of revisions", ^{
+        NSString *path = [cache cachePathForKey:@"feed"];
+        NSString *basePath = [[directory stringByAppendingPathComponent:@".auc_deltas"] stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:path.lastPathComponent]];
+        for (NSUInteger version = 1; version <= 3; version++) {
+            [cache setData:AUCDeltaSpecResponse(version, 50) forKey:@"feed"];
+        }
+        NSData *entryData = [NSData dataWithContentsOfFile:path];
+        expect([AUCCacheDelta revisionOfDelta:[AUCDiskEntryFormat payloadOfEntryData:entryData verify:NO status:NULL]]).to.equal(2);
+        expect([cache dataForKey:@"feed"]).to.equal(AUCDeltaSpecResponse(3, 50));
+
+        [cache setData:AUCDeltaSpecResponse(4, 50) forKey:@"feed"];
+        entryData = [NSData dataWithContentsOfFile:path];
+        expect([AUCDiskEntryFormat flagsOfEntryData:entryData] & AUCDiskEntryFlagDelta).to.beFalsy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:basePath]).to.beFalsy();
+        expect([cache dataForKey:@"feed"]).to.equal(AUCDeltaSpecResponse(4, 50));
+        expect(cache.totalSize).to.equal(entryData.length);
+
+        // 新的完整版本重新作为基准
+        [cache setData:AUCDeltaSpecResponse(5, 50) forKey:@"feed"];
+        expect([NSFileManager.defaultManager fileExistsAtPath:basePath]).to.beTruthy();
+        expect([cache dataForKey:@"feed"]).to.equal(AUCDeltaSpecResponse(5, 50));
+    });
+
+    it(@"writes full versions below the threshold and for large changes", ^{
+        NSString *basePath = [directory stringByAppendingPathComponent:@".auc_deltas"];
+        [cache setData:[@"{\"count\":1}" dataUsingEncoding:NSUTF8StringEncoding] forKey:@"small"];
+        [cache setData:[@"{\"count\":2}" dataUsingEncoding:NSUTF8StringEncoding] forKey:@"small"];
+        expect([cache dataForKey:@"small"]).to.equal([@"{\"count\":2}" dataUsingEncoding:NSUTF8StringEncoding]);
+
+        [cache setData:AUCDeltaSpecResponse(1, 50) forKey:@"feed"];
+        // 与上一个版本没有相同片段，差量超过 `diskCacheDeltaMaxRatio`
+        NSMutableData *unrelated = [NSMutableData dataWithLength:6000];
+        for (NSUInteger i = 0; i < unrelated.length; i++) {
+            ((uint8_t *)unrelated.mutableBytes)[i] = (uint8_t)(i * 131 + (i >> 8) * 17);
+        }
+        [cache setData:unrelated forKey:@"feed"];
+        expect([NSFileManager.defaultManager fileExistsAtPath:basePath]).to.beFalsy();
+        expect([cache dataForKey:@"feed"]).to.equal(unrelated);
+    });
+
+    it(@"counts delta bases in rebuilt entry sizes", ^{
+        NSString *indexDirectory = [directory stringByAppendingPathComponent:@"index"];
+        NSString *baseDirectory = [indexDirectory stringByAppendingPathComponent:@".auc_deltas"];
+        AUCDeltaSpecWriteFile(indexDirectory, 0, 16, 3600);
+        AUCDeltaSpecWriteFile(indexDirectory, 1, 16, 3600);
+        // 第 0 项是差量，基准版本按摘要（不带扩展名）保存在基准版本目录
+        AUCDeltaSpecWriteFile(baseDirectory, 0, 100, 3600);
+
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:indexDirectory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        index.deltaBaseDirectory = baseDirectory;
+        expect([index recoverWithDeadline:DBL_MAX report:nil]).to.beTruthy();
+        expect(index.count).to.equal(2);
+        expect(index.totalSize).to.equal(16 + 100 + 16);
+
+        AUCDiskCacheIndexEntry entry;
+        unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+        [AUCDiskCacheIndex getDigest:digest fromFileName:AUCDeltaSpecFileName(0)];
+        expect([index getEntry:&entry forDigest:digest]).to.beTruthy();
+        expect(entry.size).to.equal(116);
+        // 再次对账不会把大小校正为差量文件本身的大小
+        expect([index reconcile]).to.equal(0);
+        expect(index.totalSize).to.equal(16 + 100 + 16);
+
+        // 基准版本被删除后，对账把大小校正为差量文件本身的大小
+        unlink([baseDirectory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:AUCDeltaSpecFileName(0)]].fileSystemRepresentation);
+        expect([index reconcile]).to.equal(1);
+        expect(index.totalSize).to.equal(16 + 16);
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"reports bytes written saved against read latency on an update trace", ^{
+        NSUInteger revisions = 50;
+        NSUInteger keyCount = 20;
+        NSMutableArray<NSData *> *trace = [NSMutableArray arrayWithCapacity:revisions];
+        for (NSUInteger version = 0; version < revisions; version++) {
+            [trace addObject:AUCDeltaSpecResponse(version, 200)];
+        }
+
+        NSUInteger writtenBytes[2] = {0};
+        CFAbsoluteTime readTime[2] = {0};
+        for (NSUInteger mode = 0; mode < 2; mode++) {
+            NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+            AUCCacheConfig *config = [[AUCCacheConfig alloc] init];
+            config.diskCacheDeltaThreshold = mode == 0 ? 0 : 1024;
+            AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+            [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+
+            for (NSUInteger version = 0; version < revisions; version++) {
+                for (NSUInteger i = 0; i < keyCount; i++) {
+                    NSString *key = [NSString stringWithFormat:@"https://api.example.com/feed?page=%lu", (unsigned long)i];
+                    [cache setData:trace[version] forKey:key];
+                    // 基准版本由重命名得到，写入量只有缓存文件本身
+                    writtenBytes[mode] += AUCDeltaSpecFileSize([cache cachePathForKey:key]);
+                }
+            }
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            for (NSUInteger round = 0; round < 10; round++) {
+                for (NSUInteger i = 0; i < keyCount; i++) {
+                    NSString *key = [NSString stringWithFormat:@"https://api.example.com/feed?page=%lu", (unsigned long)i];
+                    expect([cache dataForKey:key].length).to.equal(trace.lastObject.length);
+                }
+            }
+            readTime[mode] = (CFAbsoluteTimeGetCurrent() - start) / (10 * keyCount);
+            cache = nil;
+            [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+        }
+
+        NSLog(@"[AUCCacheDelta] %lu revisions x %lu keys: written %luKB full vs %luKB delta (%.0f%% saved), read %.3fms full vs %.3fms delta",
+              (unsigned long)revisions, (unsigned long)keyCount, (unsigned long)(writtenBytes[0] >> 10), (unsigned long)(writtenBytes[1] >> 10),
+              (1 - (double)writtenBytes[1] / writtenBytes[0]) * 100, readTime[0] * 1000, readTime[1] * 1000);
+        expect(writtenBytes[1]).to.beLessThan(writtenBytes[0] / 2);
+    });
+});
+
+SpecEnd
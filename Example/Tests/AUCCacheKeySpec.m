@@ -0,0 +1,176 @@
+//
+//  AUCCacheKeySpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCCacheKey.h>
+#import <CommonCrypto/CommonDigest.h>
+
+/// 逐字节格式化的十六进制编码，作为对照
+static NSString *AUCCacheKeySpecHex(const uint8_t *bytes, size_t length) {
+    NSMutableString *hex = [NSMutableString stringWithCapacity:length * 2];
+    for (size_t i = 0; i < length; i++) {
+        [hex appendFormat:@"%02x", bytes[i]];
+    }
+    return hex;
+}
+
+/// 引入缓存键之前每次操作计算文件名的方式
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+static NSString *AUCCacheKeySpecLegacyFileName(NSString *key) {
+    const char *str = key.UTF8String;
+    unsigned char r[CC_MD5_DIGEST_LENGTH];
+    CC_MD5(str, (CC_LONG)strlen(str), r);
+    NSURL *keyURL = [NSURL URLWithString:key];
+    NSString *ext = keyURL ? keyURL.pathExtension : key.pathExtension;
+    return [NSString stringWithFormat:@"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%@",
+            r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8], r[9], r[10],
+            r[11], r[12], r[13], r[14], r[15], ext.length == 0 ? @"" : [NSString stringWithFormat:@".%@", ext]];
+}
+#pragma clang diagnostic pop
+
+SpecBegin(AUCCacheKey)
+
+describe(@"AUCHexEncode", ^{
+    it(@"matches byte-by-byte formatting for every length and alignment", ^{
+        uint8_t bytes[80];
+        for (NSUInteger i = 0; i < sizeof(bytes); i++) {
+            bytes[i] = (uint8_t)(i * 37 + 11);
+        }
+        char hex[160];
+        for (size_t start = 0; start < 4; start++) {
+            for (size_t length = 0; length + start <= 70; length++) {
+                AUCHexEncode(bytes + start, length, hex);
+                NSString *encoded = [[NSString alloc] initWithBytes:hex length:length * 2 encoding:NSASCIIStringEncoding];
+                expect(encoded).to.equal(AUCCacheKeySpecHex(bytes + start, length));
+            }
+        }
+    });
+});
+
+describe(@"derived values", ^{
+    it(@"computes the MD5 digest of the UTF-8 key", ^{
+        AUCCacheKey *key = [AUCCacheKey keyWithString:@"abc"];
+        expect(AUCCacheKeySpecHex(key.digest, AUC_CACHE_KEY_DIGEST_LENGTH)).to.equal(@"900150983cd24fb0d6963f7d28e17f72");
+        key = [AUCCacheKey keyWithString:@""];
+        expect(AUCCacheKeySpecHex(key.digest, AUC_CACHE_KEY_DIGEST_LENGTH)).to.equal(@"d41d8cd98f00b204e9800998ecf8427e");
+    });
+
+    it(@"produces the same file names as the per-operation computation", ^{
+        NSArray<NSString *> *strings = @[
+            @"abc",
+            @"https://example.com/api/list.json?page=1",
+            @"https://example.com/api/list",
+            @"local/path/image.png",
+            @"中文键.txt",
+            @"https://example.com/a b.json",
+        ];
+        for (NSString *string in strings) {
+            expect([AUCCacheKey keyWithString:string].fileName).to.equal(AUCCacheKeySpecLegacyFileName(string));
+        }
+        expect([AUCCacheKey keyWithString:@"https://example.com/api/list"].fileName.length).to.equal(32);
+    });
+
+    it(@"drops extensions too long for a file name", ^{
+        NSString *extension = [@"" stringByPaddingToLength:300 withString:@"x" startingAtIndex:0];
+        AUCCacheKey *key = [AUCCacheKey keyWithString:[@"file." stringByAppendingString:extension]];
+        expect(key.fileName.length).to.equal(32);
+        expect(AUCCacheKeyFileNameForDigest(key.digest, @"json")).to.equal([key.fileName stringByAppendingString:@".json"]);
+    });
+});
+
+describe(@"string behaviour", ^{
+    it(@"is interchangeable with an equal NSString", ^{
+        NSString *string = [NSString stringWithFormat:@"key-%d", 1];
+        AUCCacheKey *key = [AUCCacheKey keyWithString:string];
+        expect(key.string).to.equal(string);
+        expect(key.hash).to.equal(string.hash);
+        expect([key isEqual:string]).to.beTruthy();
+        expect([string isEqual:key]).to.beTruthy();
+        expect([key isEqualToString:string]).to.beTruthy();
+        expect([key isEqual:@"key-2"]).to.beFalsy();
+
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+        dictionary[key] = @1;
+        expect(dictionary[string]).to.equal(@1);
+        NSCache *cache = [NSCache new];
+        [cache setObject:@2 forKey:string];
+        expect([cache objectForKey:key]).to.equal(@2);
+    });
+
+    it(@"reuses instances for repeated keys", ^{
+        NSString *string = [NSString stringWithFormat:@"reused-%d", 1];
+        AUCCacheKey *key = [AUCCacheKey keyWithString:string];
+        expect([AUCCacheKey keyWithString:[string mutableCopy]]).to.beIdenticalTo(key);
+        expect([AUCCacheKey keyWithString:key]).to.beIdenticalTo(key);
+        expect([key copy]).to.beIdenticalTo(key);
+        expect([AUCCacheKey keyWithString:nil]).to.beNil();
+    });
+
+    it(@"keeps the whitelist verdict only for the generation it was made in", ^{
+        AUCCacheKey *key = [AUCCacheKey keyWithString:[NSString stringWithFormat:@"whitelist-%@", NSUUID.UUID.UUIDString]];
+        BOOL contained = NO;
+        expect([key getWhitelistVerdict:&contained generation:1]).to.beFalsy();
+
+        [key setWhitelistVerdict:YES generation:1];
+        expect([key getWhitelistVerdict:&contained generation:1]).to.beTruthy();
+        expect(contained).to.beTruthy();
+        expect([key getWhitelistVerdict:&contained generation:2]).to.beFalsy();
+
+        [key setWhitelistVerdict:NO generation:2];
+        expect([key getWhitelistVerdict:&contained generation:2]).to.beTruthy();
+        expect(contained).to.beFalsy();
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"measures the per-operation cost before and after caching the derived values", ^{
+        NSUInteger keyCount = 100;
+        NSUInteger rounds = 100;
+        NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:keyCount];
+        for (NSUInteger i = 0; i < keyCount; i++) {
+            [strings addObject:[NSString stringWithFormat:@"https://example.com/api/v1/feed/%lu.json?uid=42&page=%lu", (unsigned long)i, (unsigned long)(i % 7)]];
+        }
+
+        NSUInteger checksum = 0;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger round = 0; round < rounds; round++) {
+            for (NSString *string in strings) {
+                @autoreleasepool {
+                    checksum += AUCCacheKeySpecLegacyFileName(string).length;
+                }
+            }
+        }
+        CFAbsoluteTime legacyTime = (CFAbsoluteTimeGetCurrent() - start) / (keyCount * rounds);
+
+        start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger round = 0; round < rounds; round++) {
+            for (NSString *string in strings) {
+                @autoreleasepool {
+                    checksum += [AUCCacheKey keyWithString:string].fileName.length;
+                }
+            }
+        }
+        CFAbsoluteTime keyTime = (CFAbsoluteTimeGetCurrent() - start) / (keyCount * rounds);
+
+        uint8_t digest[AUC_CACHE_KEY_DIGEST_LENGTH] = {0};
+        start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < keyCount * rounds; i++) {
+            @autoreleasepool {
+                digest[0] = (uint8_t)i;
+                checksum += AUCCacheKeyFileNameForDigest(digest, nil).length;
+            }
+        }
+        CFAbsoluteTime encodeTime = (CFAbsoluteTimeGetCurrent() - start) / (keyCount * rounds);
+
+        NSLog(@"[AUCCacheKey] per operation: MD5 + NSURL + format %.0fns, cached key %.0fns, file name from digest %.0fns (checksum %lu)",
+              legacyTime * 1e9, keyTime * 1e9, encodeTime * 1e9, (unsigned long)checksum);
+        expect(keyTime).to.beLessThan(legacyTime);
+        expect(encodeTime).to.beLessThan(legacyTime);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,117 @@
+//
+//  AUCCallbackExecutorSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCCallbackExecutor.h>
+
+SpecBegin(AUCCallbackExecutor)
+
+describe(@"mainQueueExecutor", ^{
+    __block AUCCallbackExecutor *executor;
+
+    beforeEach(^{
+        executor = AUCCallbackExecutor.mainQueueExecutor;
+        // 先执行完其他用例遗留的回调
+        waitUntil(^(DoneCallback done) {
+            [executor executeBlock:^{
+                done();
+            }];
+        });
+        [executor resetStatistics];
+    });
+
+    it(@"coalesces callbacks completed before the main queue runs", ^{
+        NSMutableArray<NSNumber *> *events = [NSMutableArray array];
+        // 用例本身占用主线程，后台线程完成的回调全部进入同一次派发
+        dispatch_group_t group = dispatch_group_create();
+        dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            for (NSUInteger i = 0; i < 100; i++) {
+                [executor executeBlock:^{
+                    expect(NSThread.isMainThread).to.beTruthy();
+                    [events addObject:@(i)];
+                }];
+            }
+        });
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        expect(events.count).to.equal(0);
+        expect(executor.dispatchCount).to.equal(1);
+
+        waitUntil(^(DoneCallback done) {
+            [executor executeBlock:^{
+                done();
+            }];
+        });
+        expect(events.count).to.equal(100);
+        for (NSUInteger i = 0; i < 100; i++) {
+            expect(events[i]).to.equal(@(i));
+        }
+        expect(executor.callbackCount).to.equal(101);
+        expect(executor.dispatchCount).to.beLessThan(executor.callbackCount);
+    });
+
+    it(@"runs asynchronously even when called on the main thread", ^{
+        __block BOOL executed = NO;
+        [executor executeBlock:^{
+            executed = YES;
+        }];
+        expect(executed).to.beFalsy();
+        expect(executed).will.beTruthy();
+    });
+
+    it(@"is returned for the main queue", ^{
+        expect([AUCCallbackExecutor executorWithQueue:dispatch_get_main_queue()]).to.beIdenticalTo(executor);
+        expect(executor.target).to.equal(AUCCallbackTargetMainQueue);
+    });
+});
+
+describe(@"queue executor", ^{
+    it(@"dispatches each callback to the queue in order", ^{
+        dispatch_queue_t queue = dispatch_queue_create("com.vantage.AUCCache.tests", DISPATCH_QUEUE_SERIAL);
+        AUCCallbackExecutor *executor = [AUCCallbackExecutor executorWithQueue:queue];
+        expect(executor.target).to.equal(AUCCallbackTargetQueue);
+        expect(executor.queue).to.equal(queue);
+
+        NSMutableArray<NSNumber *> *events = [NSMutableArray array];
+        dispatch_queue_set_specific(queue, (__bridge void *)queue, (__bridge void *)queue, NULL);
+        for (NSUInteger i = 0; i < 50; i++) {
+            [executor executeBlock:^{
+                if (dispatch_get_specific((__bridge void *)queue)) [events addObject:@(i)];
+            }];
+        }
+        dispatch_sync(queue, ^{});
+
+        expect(events.count).to.equal(50);
+        expect(events.firstObject).to.equal(@0);
+        expect(events.lastObject).to.equal(@49);
+        expect(executor.callbackCount).to.equal(50);
+        expect(executor.dispatchCount).to.equal(50);
+
+        [executor resetStatistics];
+        expect(executor.callbackCount).to.equal(0);
+        expect(executor.dispatchCount).to.equal(0);
+        expect(executor.callbackTime).to.equal(0);
+    });
+});
+
+describe(@"inlineExecutor", ^{
+    it(@"runs the callback synchronously on the calling thread", ^{
+        AUCCallbackExecutor *executor = AUCCallbackExecutor.inlineExecutor;
+        expect(executor.target).to.equal(AUCCallbackTargetInline);
+        expect(executor.queue).to.beNil();
+
+        NSUInteger callbackCount = executor.callbackCount;
+        NSUInteger dispatchCount = executor.dispatchCount;
+        __block NSThread *thread = nil;
+        [executor executeBlock:^{
+            thread = NSThread.currentThread;
+        }];
+        expect(thread).to.beIdenticalTo(NSThread.currentThread);
+        expect(executor.callbackCount).to.equal(callbackCount + 1);
+        expect(executor.dispatchCount).to.equal(dispatchCount);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,180 @@
+//
+//  AUCChecksumSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCChecksum.h>
+#import <AUCCache/AUCDiskEntryFormat.h>
+#import <AUCCache/AUCDiskCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+#import <AUCCache/AUCFileAttributeHelper.h>
+
+/// 可复现的伪随机数据
+static NSData *AUCChecksumSpecData(NSUInteger length, uint32_t seed) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bytes[i] = (uint8_t)(seed >> 16);
+    }
+    return data;
+}
+
+/// 把文件 `offset` 处的一个字节取反
+static void AUCChecksumSpecFlipByte(NSString *path, unsigned long long offset) {
+    NSFileHandle *handle = [NSFileHandle fileHandleForUpdatingAtPath:path];
+    [handle seekToFileOffset:offset];
+    uint8_t byte = ((const uint8_t *)[handle readDataOfLength:1].bytes)[0];
+    byte = ~byte;
+    [handle seekToFileOffset:offset];
+    [handle writeData:[NSData dataWithBytes:&byte length:1]];
+    [handle closeFile];
+}
+
+SpecBegin(AUCChecksum)
+
+describe(@"AUCCRC32C", ^{
+    it(@"matches the standard check value", ^{
+        expect(AUCCRC32C(0, "123456789", 9)).to.equal(0xe3069283);
+        expect(AUCCRC32C(0, NULL, 0)).to.equal(0);
+    });
+
+    it(@"gives the same result when computed in pieces from unaligned addresses", ^{
+        NSData *data = AUCChecksumSpecData(4099, 1);
+        const uint8_t *bytes = data.bytes;
+        for (NSUInteger start = 0; start < 9; start++) {
+            size_t length = data.length - start;
+            uint32_t whole = AUCCRC32C(0, bytes + start, length);
+            for (size_t split = 0; split <= length; split += 97) {
+                uint32_t crc = AUCCRC32C(0, bytes + start, split);
+                crc = AUCCRC32C(crc, bytes + start + split, length - split);
+                expect(crc).to.equal(whole);
+            }
+        }
+    });
+});
+
+describe(@"AUCDiskEntryFormat", ^{
+    it(@"round-trips data and extended data", ^{
+        NSData *data = AUCChecksumSpecData(1000, 2);
+        NSData *extendedData = AUCChecksumSpecData(30, 3);
+        NSData *entryData = [AUCDiskEntryFormat entryDataWithData:data extendedData:extendedData];
+        expect(entryData.length).to.equal(AUC_DISK_ENTRY_HEADER_LENGTH + 1000 + AUC_DISK_ENTRY_EXTENDED_LENGTH_LENGTH + 30);
+
+        NSData *readExtendedData = nil;
+        AUCDiskEntryStatus status;
+        NSData *payload = [AUCDiskEntryFormat payloadOfEntryData:entryData extendedData:&readExtendedData verify:YES status:&status];
+        expect(status).to.equal(AUCDiskEntryStatusValid);
+        expect(payload).to.equal(data);
+        expect(readExtendedData).to.equal(extendedData);
+    });
+
+    it(@"reports a flipped payload byte only when verifying", ^{
+        NSMutableData *entryData = [[AUCDiskEntryFormat entryDataWithData:AUCChecksumSpecData(1000, 4)] mutableCopy];
+        ((uint8_t *)entryData.mutableBytes)[AUC_DISK_ENTRY_HEADER_LENGTH + 500] ^= 0x01;
+
+        AUCDiskEntryStatus status;
+        expect([AUCDiskEntryFormat payloadOfEntryData:entryData verify:YES status:&status]).to.beNil();
+        expect(status).to.equal(AUCDiskEntryStatusCorrupt);
+        // 不校验时只检查长度
+        expect([AUCDiskEntryFormat payloadOfEntryData:entryData verify:NO status:&status]).notTo.beNil();
+        expect(status).to.equal(AUCDiskEntryStatusValid);
+    });
+
+    it(@"reports a truncated file as corrupt and a headerless file as legacy", ^{
+        NSData *entryData = [AUCDiskEntryFormat entryDataWithData:AUCChecksumSpecData(1000, 5)];
+        AUCDiskEntryStatus status;
+        expect([AUCDiskEntryFormat payloadOfEntryData:[entryData subdataWithRange:NSMakeRange(0, 600)] verify:NO status:&status]).to.beNil();
+        expect(status).to.equal(AUCDiskEntryStatusCorrupt);
+
+        NSData *legacy = AUCChecksumSpecData(100, 6);
+        expect([AUCDiskEntryFormat payloadOfEntryData:legacy verify:YES status:&status]).to.equal(legacy);
+        expect(status).to.equal(AUCDiskEntryStatusLegacy);
+    });
+});
+
+describe(@"AUCDiskCache", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"treats a corrupt file as a miss and removes it when verifying on read", ^{
+        config.diskCacheChecksumMode = AUCCacheDiskChecksumModeOnRead;
+        AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+        NSData *data = AUCChecksumSpecData(2000, 7);
+        [cache setData:data forKey:@"a"];
+        expect([cache dataForKey:@"a"]).to.equal(data);
+
+        NSString *path = [cache cachePathForKey:@"a"];
+        AUCChecksumSpecFlipByte(path, AUC_DISK_ENTRY_HEADER_LENGTH + 1500);
+        expect([cache dataForKey:@"a"]).to.beNil();
+        expect([cache containsDataForKey:@"a"]).to.beFalsy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:path]).to.beFalsy();
+    });
+
+    it(@"scrubs corrupt files before they are read", ^{
+        config.diskCacheChecksumMode = AUCCacheDiskChecksumModeLazy;
+        AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+        NSData *data = AUCChecksumSpecData(2000, 8);
+        [cache setData:data forKey:@"a"];
+        [cache setData:data forKey:@"b"];
+        AUCChecksumSpecFlipByte([cache cachePathForKey:@"a"], AUC_DISK_ENTRY_HEADER_LENGTH);
+
+        expect([cache scrubDataWithByteLimit:0]).to.equal(1);
+        expect([cache containsDataForKey:@"a"]).to.beFalsy();
+        expect([cache dataForKey:@"b"]).to.equal(data);
+        // 再次校验从头开始，不会重复删除
+        expect([cache scrubDataWithByteLimit:0]).to.equal(0);
+    });
+
+    it(@"reads headerless files written by earlier versions and adds the header on rewrite", ^{
+        config.diskCacheChecksumMode = AUCCacheDiskChecksumModeLazy;
+        // 早期版本的布局：缓存目录下直接存放无头部的文件，扩展数据保存在扩展属性中
+        NSString *scratch = [directory stringByAppendingString:@"-scratch"];
+        NSString *fileName = [[[AUCDiskCache alloc] initWithCachePath:scratch config:config] cachePathForKey:@"a"].lastPathComponent;
+        [NSFileManager.defaultManager removeItemAtPath:scratch error:NULL];
+        [NSFileManager.defaultManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+        NSString *legacyPath = [directory stringByAppendingPathComponent:fileName];
+        NSData *data = AUCChecksumSpecData(2000, 9);
+        NSData *extendedData = AUCChecksumSpecData(16, 10);
+        [data writeToFile:legacyPath atomically:YES];
+        [AUCFileAttributeHelper setExtendedAttribute:@"com.vantage.AUCCache" value:extendedData atPath:legacyPath traverseLink:NO overwrite:YES error:nil];
+
+        AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        expect([cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]]).to.beTruthy();
+        expect([cache dataForKey:@"a"]).to.equal(data);
+        expect([cache extendedDataForKey:@"a"]).to.equal(extendedData);
+        // 无法校验的文件不会被后台校验删除
+        expect([cache scrubDataWithByteLimit:0]).to.equal(0);
+        expect([cache dataForKey:@"a"]).to.equal(data);
+
+        [cache setData:data forKey:@"a"];
+        NSData *entryData = [NSData dataWithContentsOfFile:[cache cachePathForKey:@"a"]];
+        AUCDiskEntryStatus status;
+        expect([AUCDiskEntryFormat payloadOfEntryData:entryData verify:YES status:&status]).to.equal(data);
+        expect(status).to.equal(AUCDiskEntryStatusValid);
+    });
+
+    it(@"treats an early file that happens to start with the magic as headerless", ^{
+        NSMutableData *legacy = [[[AUCDiskEntryFormat entryDataWithData:AUCChecksumSpecData(100, 11)] subdataWithRange:NSMakeRange(0, 4)] mutableCopy];
+        [legacy appendData:AUCChecksumSpecData(200, 12)];
+        AUCDiskEntryStatus status;
+        expect([AUCDiskEntryFormat payloadOfEntryData:legacy verify:YES status:&status]).to.equal(legacy);
+        expect(status).to.equal(AUCDiskEntryStatusLegacy);
+    });
+});
+
+SpecEnd
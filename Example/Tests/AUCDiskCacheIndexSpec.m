@@ -0,0 +1,193 @@
+//
+//  AUCDiskCacheIndexSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCDiskCacheIndex.h>
+#import <sys/time.h>
+
+/// 第 i 个测试文件名：32 位十六进制摘要，前缀打散到不同的子目录
+static NSString *AUCIndexSpecFileName(NSUInteger i) {
+    return [NSString stringWithFormat:@"%08x%024lx", (uint32_t)(i * 2654435761u), (unsigned long)i];
+}
+
+/// 按两级子目录布局写入缓存文件，并把修改时间设为 `age` 秒之前
+static NSString *AUCIndexSpecWriteFile(NSString *directory, NSUInteger i, NSUInteger length, NSTimeInterval age) {
+    NSString *fileName = AUCIndexSpecFileName(i);
+    NSString *path = [directory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName]];
+    [NSFileManager.defaultManager createDirectoryAtPath:path.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSMutableData dataWithLength:length] writeToFile:path atomically:NO];
+    struct timeval times[2];
+    times[0].tv_sec = times[1].tv_sec = (time_t)(time(NULL) - age);
+    times[0].tv_usec = times[1].tv_usec = 0;
+    utimes(path.fileSystemRepresentation, times);
+    return path;
+}
+
+SpecBegin(AUCDiskCacheIndex)
+
+describe(@"persistence", ^{
+    __block NSString *directory;
+    __block NSUInteger count;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        count = 50;
+        for (NSUInteger i = 0; i < count; i++) {
+            AUCIndexSpecWriteFile(directory, i, 16 + i, 3600 + i * 10);
+        }
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        [index recoverWithDeadline:DBL_MAX report:nil];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"reopens a cleanly closed index without rebuilding", ^{
+        // 删除缓存文件后，索引仍然完整可用，说明没有从目录重建
+        [NSFileManager.defaultManager removeItemAtPath:[directory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:AUCIndexSpecFileName(0)]] error:NULL];
+
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect(index.incomplete).to.beFalsy();
+        expect(index.count).to.equal(count);
+        expect(index.totalSize).to.equal(count * 16 + count * (count - 1) / 2);
+
+        unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+        [AUCDiskCacheIndex getDigest:digest fromFileName:AUCIndexSpecFileName(0)];
+        AUCDiskCacheIndexEntry entry;
+        expect([index getEntry:&entry forDigest:digest]).to.beTruthy();
+        expect(entry.size).to.equal(16);
+    });
+
+    it(@"keeps edits made before a clean close", ^{
+        unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+        [AUCDiskCacheIndex getDigest:digest fromFileName:AUCIndexSpecFileName(1)];
+        @autoreleasepool {
+            AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+            [index removeDigest:digest];
+        }
+
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect(index.incomplete).to.beFalsy();
+        expect(index.count).to.equal(count - 1);
+        expect([index getEntry:NULL forDigest:digest]).to.beFalsy();
+    });
+
+    it(@"treats an index left dirty by a crash as incomplete and rebuilds it", ^{
+        // 脏标记位于索引头部偏移 32 处，模拟修改中途进程被终止
+        NSString *indexPath = [directory stringByAppendingPathComponent:AUCDiskCacheIndex.indexFileName];
+        NSFileHandle *handle = [NSFileHandle fileHandleForUpdatingAtPath:indexPath];
+        [handle seekToFileOffset:32];
+        uint32_t dirty = 1;
+        [handle writeData:[NSData dataWithBytes:&dirty length:sizeof(dirty)]];
+        [handle closeFile];
+
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect(index.incomplete).to.beTruthy();
+        expect([index recoverWithDeadline:DBL_MAX report:nil]).to.beTruthy();
+        expect(index.incomplete).to.beFalsy();
+        expect(index.count).to.equal(count);
+    });
+
+    it(@"rebuilds when the eviction order changes", ^{
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:YES];
+        expect(index.incomplete).to.beTruthy();
+        expect([index recoverWithDeadline:DBL_MAX report:nil]).to.beTruthy();
+        expect(index.count).to.equal(count);
+    });
+});
+
+describe(@"accounting", ^{
+    __block NSString *directory;
+    __block AUCDiskCacheIndex *index;
+    __block NSUInteger count;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        count = 2000;
+        for (NSUInteger i = 0; i < count; i++) {
+            AUCIndexSpecWriteFile(directory, i, 100, 3600);
+        }
+        index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        [index recoverWithDeadline:DBL_MAX report:nil];
+    });
+
+    afterEach(^{
+        index = nil;
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"updates the running counters on every set and remove", ^{
+        expect(index.count).to.equal(count);
+        expect(index.totalSize).to.equal(count * 100);
+
+        unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+        [AUCDiskCacheIndex getDigest:digest fromFileName:AUCIndexSpecFileName(0)];
+        AUCDiskCacheIndexEntry entry;
+        [index getEntry:&entry forDigest:digest];
+        // 覆盖写入只替换大小
+        entry.size = 300;
+        [index setEntry:&entry];
+        expect(index.count).to.equal(count);
+        expect(index.totalSize).to.equal(count * 100 + 200);
+
+        [index removeDigest:digest];
+        expect(index.count).to.equal(count - 1);
+        expect(index.totalSize).to.equal((count - 1) * 100);
+        [index removeDigest:digest];
+        expect(index.count).to.equal(count - 1);
+    });
+
+    it(@"corrects drift between the counters and the directory when reconciling", ^{
+        // 绕过索引删除一个文件、改变一个文件的大小、新增一个文件
+        [NSFileManager.defaultManager removeItemAtPath:[directory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:AUCIndexSpecFileName(0)]] error:NULL];
+        AUCIndexSpecWriteFile(directory, 1, 250, 3600);
+        AUCIndexSpecWriteFile(directory, count, 70, 3600);
+
+        expect([index reconcile]).to.equal(3);
+        expect(index.count).to.equal(count);
+        expect(index.totalSize).to.equal((count - 2) * 100 + 250 + 70);
+        // 没有漂移时不做任何修改
+        expect([index reconcile]).to.equal(0);
+    });
+
+    it(@"answers size and count queries without scanning the directory", ^{
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        unsigned long long scannedSize = 0;
+        NSUInteger scannedCount = 0;
+        NSDirectoryEnumerator *enumerator = [NSFileManager.defaultManager enumeratorAtURL:[NSURL fileURLWithPath:directory]
+                                                               includingPropertiesForKeys:@[NSURLIsRegularFileKey, NSURLTotalFileAllocatedSizeKey, NSURLFileSizeKey]
+                                                                                  options:0
+                                                                             errorHandler:nil];
+        for (NSURL *url in enumerator) {
+            NSNumber *isRegularFile = nil;
+            [url getResourceValue:&isRegularFile forKey:NSURLIsRegularFileKey error:NULL];
+            if (!isRegularFile.boolValue || [url.lastPathComponent hasPrefix:@"."]) continue;
+            NSNumber *size = nil;
+            [url getResourceValue:&size forKey:NSURLFileSizeKey error:NULL];
+            scannedSize += size.unsignedLongLongValue;
+            scannedCount++;
+        }
+        CFAbsoluteTime scanTime = CFAbsoluteTimeGetCurrent() - start;
+
+        start = CFAbsoluteTimeGetCurrent();
+        NSUInteger indexedSize = 0;
+        NSUInteger indexedCount = 0;
+        for (NSUInteger i = 0; i < 1000; i++) {
+            indexedSize = index.totalSize;
+            indexedCount = index.count;
+        }
+        CFAbsoluteTime counterTime = (CFAbsoluteTimeGetCurrent() - start) / 1000;
+        NSLog(@"[AUCDiskCacheIndex] %lu files: directory scan %.3fms, running counters %.6fms",
+              (unsigned long)count, scanTime * 1000, counterTime * 1000);
+
+        expect(indexedCount).to.equal(scannedCount);
+        expect(indexedSize).to.equal(scannedSize);
+        expect(counterTime * 100).to.beLessThan(scanTime);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,252 @@
+//
+//  AUCDiskCacheRecoverySpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCDiskCacheIndex.h>
+#import <AUCCache/AUCDiskCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+#import <sys/time.h>
+
+/// 第 i 个测试文件名：32 位十六进制摘要，前缀打散到不同的子目录
+static NSString *AUCRecoverySpecFileName(NSUInteger i) {
+    return [NSString stringWithFormat:@"%08x%024lx", (uint32_t)(i * 2654435761u), (unsigned long)i];
+}
+
+/// 把文件的修改时间设为 `age` 秒之前
+static void AUCRecoverySpecSetAge(NSString *path, NSTimeInterval age) {
+    struct timeval times[2];
+    times[0].tv_sec = times[1].tv_sec = (time_t)(time(NULL) - age);
+    times[0].tv_usec = times[1].tv_usec = 0;
+    utimes(path.fileSystemRepresentation, times);
+}
+
+/// 按两级子目录布局写入缓存文件，并把修改时间设为 `age` 秒之前
+static NSString *AUCRecoverySpecWriteFile(NSString *directory, NSUInteger i, NSUInteger length, NSTimeInterval age) {
+    NSString *fileName = AUCRecoverySpecFileName(i);
+    NSString *path = [directory stringByAppendingPathComponent:[AUCDiskCacheIndex relativePathForFileName:fileName]];
+    [NSFileManager.defaultManager createDirectoryAtPath:path.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL];
+    [[NSMutableData dataWithLength:length] writeToFile:path atomically:NO];
+    AUCRecoverySpecSetAge(path, age);
+    return path;
+}
+
+/// 长度为 `length` 的数据，内容随 `seed` 变化
+static NSData *AUCRecoverySpecData(NSUInteger length, uint8_t seed) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    memset(data.mutableBytes, seed, length);
+    return data;
+}
+
+SpecBegin(AUCDiskCacheRecovery)
+
+describe(@"index recovery", ^{
+    __block NSString *directory;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"sorts the eviction list when the table grows during recovery", ^{
+        // 超过初始容量（256）的装载上限，扫描过程中会扩容；文件序号越大越旧，与目录顺序无关
+        NSUInteger count = 600;
+        for (NSUInteger i = 0; i < count; i++) {
+            AUCRecoverySpecWriteFile(directory, i, 16, 3600 + i * 10);
+        }
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect(index.incomplete).to.beTruthy();
+        expect([index recoverWithDeadline:DBL_MAX report:nil]).to.beTruthy();
+        expect(index.incomplete).to.beFalsy();
+        expect(index.count).to.equal(count);
+        expect(index.totalSize).to.equal(count * 16);
+
+        AUCDiskCacheIndexEntry *entries = calloc(count, sizeof(AUCDiskCacheIndexEntry));
+        expect([index getOldestEntries:entries maxCount:count]).to.equal(count);
+        for (NSUInteger i = 0; i < count; i++) {
+            unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+            [AUCDiskCacheIndex getDigest:digest fromFileName:AUCRecoverySpecFileName(count - 1 - i)];
+            expect(memcmp(entries[i].digest, digest, AUC_DISK_CACHE_DIGEST_LENGTH)).to.equal(0);
+        }
+        free(entries);
+    });
+
+    it(@"reopens as incomplete when the process exits after growing mid-recovery", ^{
+        NSUInteger count = 400;
+        NSMutableArray<NSString *> *paths = [NSMutableArray array];
+        for (NSUInteger i = 0; i < count; i++) {
+            [paths addObject:AUCRecoverySpecWriteFile(directory, i, 16, 3600 + i * 10)];
+        }
+        @autoreleasepool {
+            AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+            expect(index.incomplete).to.beTruthy();
+            index.scrubPosition = 100;
+            // 重建期间读取未命中时逐个补充索引项，补充的数量足以触发扩容
+            for (NSUInteger i = 0; i < count / 2; i++) {
+                expect([index addEntryForFilePath:paths[i] entry:NULL]).to.beTruthy();
+            }
+            expect(index.count).to.equal(count / 2);
+            expect(index.scrubPosition).to.equal(100);
+            // 不调用 recoverWithDeadline:report: 即释放，相当于重建中途进程退出
+        }
+
+        AUCDiskCacheIndex *reopened = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect(reopened.incomplete).to.beTruthy();
+        expect([reopened recoverWithDeadline:DBL_MAX report:nil]).to.beTruthy();
+        expect(reopened.count).to.equal(count);
+
+        AUCDiskCacheIndexEntry oldest;
+        expect([reopened getOldestEntries:&oldest maxCount:1]).to.equal(1);
+        unsigned char digest[AUC_DISK_CACHE_DIGEST_LENGTH];
+        [AUCDiskCacheIndex getDigest:digest fromFileName:AUCRecoverySpecFileName(count - 1)];
+        expect(memcmp(oldest.digest, digest, AUC_DISK_CACHE_DIGEST_LENGTH)).to.equal(0);
+    });
+
+    it(@"removes only temporary files it recognizes", ^{
+        NSString *cachePath = AUCRecoverySpecWriteFile(directory, 0, 16, 3600);
+        NSString *linkPath = [cachePath.stringByDeletingLastPathComponent stringByAppendingPathComponent:[NSString stringWithFormat:@".%@.link", cachePath.lastPathComponent]];
+        NSString *atomicPath = [cachePath.stringByDeletingLastPathComponent stringByAppendingPathComponent:@".dat.nosync1a2b.XyZ123"];
+        NSString *foreignPath = [directory stringByAppendingPathComponent:@"notes.txt"];
+        NSString *hiddenPath = [directory stringByAppendingPathComponent:@".DS_Store"];
+        for (NSString *path in @[linkPath, atomicPath, foreignPath, hiddenPath]) {
+            [[NSData dataWithBytes:"x" length:1] writeToFile:path atomically:NO];
+            AUCRecoverySpecSetAge(path, 3600);
+        }
+
+        AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect([index recoverWithDeadline:DBL_MAX report:report]).to.beTruthy();
+        expect(index.count).to.equal(1);
+        expect(report.removedOrphanFileCount).to.equal(2);
+        expect([NSFileManager.defaultManager fileExistsAtPath:linkPath]).to.beFalsy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:atomicPath]).to.beFalsy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:foreignPath]).to.beTruthy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:hiddenPath]).to.beTruthy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:cachePath]).to.beTruthy();
+    });
+
+    it(@"keeps temporary files that may still be written", ^{
+        NSString *cachePath = AUCRecoverySpecWriteFile(directory, 0, 16, 3600);
+        NSString *linkPath = [cachePath.stringByDeletingLastPathComponent stringByAppendingPathComponent:[NSString stringWithFormat:@".%@.link", cachePath.lastPathComponent]];
+        [[NSData dataWithBytes:"x" length:1] writeToFile:linkPath atomically:NO];
+
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        expect([index recoverWithDeadline:DBL_MAX report:nil]).to.beTruthy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:linkPath]).to.beTruthy();
+    });
+
+    it(@"rebuilds incrementally within the deadline and reports the repairs", ^{
+        NSUInteger count = 2000;
+        for (NSUInteger i = 0; i < count; i++) {
+            AUCRecoverySpecWriteFile(directory, i, 16, 3600 + i);
+        }
+        AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+        AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+        NSTimeInterval budget = 0.002;
+        NSTimeInterval longestSlice = 0;
+        NSUInteger slices = 0;
+        BOOL finished = NO;
+        while (!finished) {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            finished = [index recoverWithDeadline:start + budget report:report];
+            longestSlice = MAX(longestSlice, CFAbsoluteTimeGetCurrent() - start);
+            slices++;
+            // 重建完成前保持不完整标记，读取未命中时回退到文件系统
+            if (!finished) expect(index.incomplete).to.beTruthy();
+        }
+        NSLog(@"[AUCDiskCacheIndex] rebuilt %lu entries in %lu slices, longest slice %.2fms (budget %.1fms)",
+              (unsigned long)count, (unsigned long)slices, longestSlice * 1000, budget * 1000);
+
+        expect(slices).to.beGreaterThan(1);
+        expect(longestSlice).to.beLessThan(budget + 0.05);
+        expect(index.incomplete).to.beFalsy();
+        expect(index.count).to.equal(count);
+        expect(report.repairedEntryCount).to.equal(count);
+    });
+});
+
+describe(@"disk cache recovery", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        @autoreleasepool {
+            AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+            [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+            for (NSUInteger i = 0; i < 100; i++) {
+                [cache setData:AUCRecoverySpecData(100, (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+            }
+        }
+        // 缓存文件均早于下一次对账开始的时间
+        NSDirectoryEnumerator *enumerator = [NSFileManager.defaultManager enumeratorAtPath:directory];
+        for (NSString *relativePath in enumerator) {
+            if ([enumerator.fileAttributes.fileType isEqualToString:NSFileTypeRegular]) {
+                AUCRecoverySpecSetAge([directory stringByAppendingPathComponent:relativePath], 3600);
+            }
+        }
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"answers reads before a lost index is rebuilt", ^{
+        [NSFileManager.defaultManager removeItemAtPath:[directory stringByAppendingPathComponent:AUCDiskCacheIndex.indexFileName] error:NULL];
+
+        AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        NSData *data = [cache dataForKey:@"key42"];
+        CFAbsoluteTime firstReadTime = CFAbsoluteTimeGetCurrent() - start;
+        expect(data).to.equal(AUCRecoverySpecData(100, 42));
+        expect([cache containsDataForKey:@"missing"]).to.beFalsy();
+
+        AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+        start = CFAbsoluteTimeGetCurrent();
+        expect([cache recoverWithTimeBudget:10 report:report]).to.beTruthy();
+        CFAbsoluteTime recoveryTime = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"[AUCDiskCache] first read before recovery %.3fms, recovery of 100 entries %.2fms",
+              firstReadTime * 1000, recoveryTime * 1000);
+        expect(cache.totalCount).to.equal(100);
+        // 读取时补充的索引项不需要修复
+        expect(report.repairedEntryCount).to.equal(99);
+        expect([cache dataForKey:@"key7"]).to.equal(AUCRecoverySpecData(100, 7));
+    });
+
+    it(@"corrects the size of a file torn behind the index and reads it as a miss", ^{
+        NSString *path = nil;
+        NSUInteger totalSize = 0;
+        @autoreleasepool {
+            AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+            path = [cache cachePathForKey:@"key7"];
+            totalSize = cache.totalSize;
+        }
+        // 写入中途被终止，文件只剩前半部分
+        NSUInteger entrySize = [[NSFileManager.defaultManager attributesOfItemAtPath:path error:NULL] fileSize];
+        truncate(path.fileSystemRepresentation, 50);
+        AUCRecoverySpecSetAge(path, 3600);
+
+        @autoreleasepool {
+            AUCDiskCacheIndex *index = [[AUCDiskCacheIndex alloc] initWithDirectory:directory fileManager:NSFileManager.defaultManager orderByAccessTime:NO];
+            expect([index reconcile]).to.equal(1);
+            expect(index.totalSize).to.equal(totalSize - entrySize + 50);
+        }
+
+        AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        expect([cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]]).to.beTruthy();
+        expect([cache dataForKey:@"key7"]).to.beNil();
+        expect([cache containsDataForKey:@"key7"]).to.beFalsy();
+        expect(cache.totalCount).to.equal(99);
+        expect([NSFileManager.defaultManager fileExistsAtPath:path]).to.beFalsy();
+        expect([cache dataForKey:@"key8"]).to.equal(AUCRecoverySpecData(100, 8));
+    });
+});
+
+SpecEnd
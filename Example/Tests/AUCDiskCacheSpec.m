@@ -0,0 +1,465 @@
+//
+//  AUCDiskCacheSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCDiskCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+#import <AUCCache/AUCDiskEntryFormat.h>
+#import <AUCCache/AUCFileAttributeHelper.h>
+#import <sys/stat.h>
+
+/// 长度为 `length` 的数据，内容随 `seed` 变化
+static NSData *AUCDiskCacheSpecData(NSUInteger length, uint8_t seed) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    memset(data.mutableBytes, seed, length);
+    return data;
+}
+
+/// 打开缓存并完成对账
+static AUCDiskCache *AUCDiskCacheSpecOpen(NSString *directory, AUCCacheConfig *config) {
+    AUCDiskCache *cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+    [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+    return cache;
+}
+
+/// 共享数据目录中的文件数量
+static NSUInteger AUCDiskCacheSpecBlobCount(NSString *directory) {
+    NSString *blobDirectory = [directory stringByAppendingPathComponent:@".auc_blobs"];
+    NSUInteger count = 0;
+    for (NSString *relativePath in [NSFileManager.defaultManager enumeratorAtPath:blobDirectory]) {
+        struct stat st;
+        if (lstat([blobDirectory stringByAppendingPathComponent:relativePath].fileSystemRepresentation, &st) == 0 && S_ISREG(st.st_mode)) count++;
+    }
+    return count;
+}
+
+/// 文件的 inode 与链接数
+static struct stat AUCDiskCacheSpecStat(NSString *path) {
+    struct stat st = {0};
+    lstat(path.fileSystemRepresentation, &st);
+    return st;
+}
+
+SpecBegin(AUCDiskCache)
+
+describe(@"accounting", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"keeps the running counters in step with set, overwrite and remove", ^{
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        expect(cache.totalCount).to.equal(0);
+        expect(cache.totalSize).to.equal(0);
+
+        [cache setData:AUCDiskCacheSpecData(100, 1) forKey:@"a"];
+        NSUInteger sizeOfA = cache.totalSize;
+        expect(cache.totalCount).to.equal(1);
+        expect(sizeOfA).to.beGreaterThanOrEqualTo(100);
+
+        [cache setData:AUCDiskCacheSpecData(100, 2) forKey:@"b"];
+        expect(cache.totalCount).to.equal(2);
+        expect(cache.totalSize).to.equal(sizeOfA * 2);
+
+        // 覆盖写入不增加数量，大小按差值变化
+        [cache setData:AUCDiskCacheSpecData(300, 3) forKey:@"a"];
+        expect(cache.totalCount).to.equal(2);
+        expect(cache.totalSize).to.equal(sizeOfA * 2 + 200);
+
+        [cache removeCacheForKey:@"a"];
+        expect(cache.totalCount).to.equal(1);
+        expect(cache.totalSize).to.equal(sizeOfA);
+        [cache removeCacheForKey:@"a"];
+        expect(cache.totalCount).to.equal(1);
+
+        [cache removeAllData];
+        expect(cache.totalCount).to.equal(0);
+        expect(cache.totalSize).to.equal(0);
+    });
+
+    it(@"persists the counters with the index", ^{
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        for (NSUInteger i = 0; i < 20; i++) {
+            [cache setData:AUCDiskCacheSpecData(50 + i, (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        NSUInteger totalSize = cache.totalSize;
+        cache = nil;
+
+        AUCDiskCache *reopened = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        expect(reopened.totalCount).to.equal(20);
+        expect(reopened.totalSize).to.equal(totalSize);
+    });
+
+    it(@"matches the size of the files on disk", ^{
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        for (NSUInteger i = 0; i < 20; i++) {
+            [cache setData:AUCDiskCacheSpecData(100 * (i + 1), (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        unsigned long long fileSize = 0;
+        for (NSUInteger i = 0; i < 20; i++) {
+            NSString *path = [cache cachePathForKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+            fileSize += [NSFileManager.defaultManager attributesOfItemAtPath:path error:NULL].fileSize;
+        }
+        expect(cache.totalSize).to.equal(fileSize);
+    });
+});
+
+describe(@"eviction", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"removes expired entries oldest first and stops at the first fresh one", ^{
+        config.maxDiskAge = 0.2;
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        [cache setData:AUCDiskCacheSpecData(10, 1) forKey:@"a"];
+        [cache setData:AUCDiskCacheSpecData(10, 2) forKey:@"b"];
+        [NSThread sleepForTimeInterval:0.3];
+        [cache setData:AUCDiskCacheSpecData(10, 3) forKey:@"c"];
+
+        expect([cache removeExpiredDataWithTimeBudget:0]).to.beTruthy();
+        expect([cache containsDataForKey:@"a"]).to.beFalsy();
+        expect([cache containsDataForKey:@"b"]).to.beFalsy();
+        expect([cache containsDataForKey:@"c"]).to.beTruthy();
+        expect(cache.totalCount).to.equal(1);
+    });
+
+    it(@"orders by access time when expiring by access date", ^{
+        config.maxDiskAge = 0.2;
+        config.diskCacheExpireType = AUCCacheConfigExpireTypeAccessDate;
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        [cache setData:AUCDiskCacheSpecData(10, 1) forKey:@"a"];
+        [cache setData:AUCDiskCacheSpecData(10, 2) forKey:@"b"];
+        [NSThread sleepForTimeInterval:0.3];
+        // 读取把 a 移到淘汰链表末尾
+        expect([cache dataForKey:@"a"]).notTo.beNil();
+
+        [cache removeExpiredData];
+        expect([cache containsDataForKey:@"a"]).to.beTruthy();
+        expect([cache containsDataForKey:@"b"]).to.beFalsy();
+    });
+
+    it(@"trims to half of the size limit from the oldest entry", ^{
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        for (NSUInteger i = 0; i < 10; i++) {
+            [cache setData:AUCDiskCacheSpecData(1000, (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        NSUInteger entrySize = cache.totalSize / 10;
+        config.maxDiskSize = entrySize * 8;
+
+        expect([cache removeExpiredDataWithTimeBudget:0]).to.beTruthy();
+        expect(cache.totalSize).to.beLessThan(config.maxDiskSize / 2);
+        // 删除到低于一半为止：剩下最新的 3 个
+        expect(cache.totalCount).to.equal(3);
+        for (NSUInteger i = 0; i < 10; i++) {
+            expect([cache containsDataForKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]]).to.equal(i >= 7);
+        }
+    });
+
+    it(@"stops when the time budget runs out and resumes on the next call", ^{
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        for (NSUInteger i = 0; i < 10; i++) {
+            [cache setData:AUCDiskCacheSpecData(1000, (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        config.maxDiskSize = cache.totalSize / 10 * 8;
+
+        // 时间片极短时每次只删除一个
+        NSUInteger calls = 0;
+        while (![cache removeExpiredDataWithTimeBudget:1e-9]) {
+            calls++;
+            expect(cache.totalCount).to.equal(10 - calls);
+            expect([cache containsDataForKey:[NSString stringWithFormat:@"key%lu", (unsigned long)(calls - 1)]]).to.beFalsy();
+            expect([cache containsDataForKey:[NSString stringWithFormat:@"key%lu", (unsigned long)calls]]).to.beTruthy();
+        }
+        // 大小清理状态跨时间片保留，最终同样降到一半以下
+        expect(cache.totalCount).to.equal(3);
+    });
+
+    it(@"keeps each slice within the time budget on a large cache", ^{
+        config.maxDiskAge = 0.2;
+        AUCDiskCache *cache = AUCDiskCacheSpecOpen(directory, config);
+        NSUInteger count = 2000;
+        for (NSUInteger i = 0; i < count; i++) {
+            [cache setData:AUCDiskCacheSpecData(64, (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        [NSThread sleepForTimeInterval:0.3];
+
+        NSTimeInterval budget = 0.005;
+        NSTimeInterval longestSlice = 0;
+        NSUInteger slices = 0;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        BOOL finished = NO;
+        while (!finished) {
+            CFAbsoluteTime sliceStart = CFAbsoluteTimeGetCurrent();
+            finished = [cache removeExpiredDataWithTimeBudget:budget];
+            longestSlice = MAX(longestSlice, CFAbsoluteTimeGetCurrent() - sliceStart);
+            slices++;
+        }
+        CFAbsoluteTime total = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"[AUCDiskCache] evicted %lu entries in %lu slices, total %.1fms, longest slice %.2fms (budget %.1fms)",
+              (unsigned long)count, (unsigned long)slices, total * 1000, longestSlice * 1000, budget * 1000);
+
+        expect(cache.totalCount).to.equal(0);
+        // 超出时间片的部分只有最后一个文件的删除耗时
+        expect(longestSlice).to.beLessThan(budget + 0.05);
+    });
+});
+
+describe(@"extended data", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+    __block AUCDiskCache *cache;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        cache = AUCDiskCacheSpecOpen(directory, config);
+    });
+
+    afterEach(^{
+        cache = nil;
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"writes extended data into the same file as the data", ^{
+        NSData *data = AUCDiskCacheSpecData(100, 1);
+        NSData *extendedData = AUCDiskCacheSpecData(20, 2);
+        [cache setData:data extendedData:extendedData forKey:@"a"];
+
+        NSString *path = [cache cachePathForKey:@"a"];
+        AUCDiskEntryStatus status;
+        expect([AUCDiskEntryFormat extendedDataOfFileAtPath:path status:&status]).to.equal(extendedData);
+        expect([AUCFileAttributeHelper hasExtendedAttribute:@"com.vantage.AUCCache" atPath:path traverseLink:NO error:nil]).to.beFalsy();
+        expect([cache dataForKey:@"a"]).to.equal(data);
+        expect([cache extendedDataForKey:@"a"]).to.equal(extendedData);
+    });
+
+    it(@"replaces and clears extended data without touching the data", ^{
+        NSData *data = AUCDiskCacheSpecData(100, 1);
+        [cache setData:data forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.beNil();
+
+        [cache setExtendedData:AUCDiskCacheSpecData(20, 2) forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.equal(AUCDiskCacheSpecData(20, 2));
+        [cache setExtendedData:AUCDiskCacheSpecData(30, 3) forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.equal(AUCDiskCacheSpecData(30, 3));
+        expect([cache dataForKey:@"a"]).to.equal(data);
+
+        [cache setExtendedData:nil forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.beNil();
+        expect([cache dataForKey:@"a"]).to.equal(data);
+
+        // 不存在的键不会被创建
+        [cache setExtendedData:AUCDiskCacheSpecData(20, 2) forKey:@"missing"];
+        expect([cache containsDataForKey:@"missing"]).to.beFalsy();
+    });
+
+    it(@"keeps the data when a plain write replaces an entry with extended data", ^{
+        [cache setData:AUCDiskCacheSpecData(100, 1) extendedData:AUCDiskCacheSpecData(20, 2) forKey:@"a"];
+        [cache setData:AUCDiskCacheSpecData(50, 3) forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.beNil();
+        expect([cache dataForKey:@"a"]).to.equal(AUCDiskCacheSpecData(50, 3));
+    });
+
+    it(@"returns the extended data of many keys in one call", ^{
+        NSMutableArray<NSString *> *keys = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 10; i++) {
+            NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)i];
+            [keys addObject:key];
+            if (i % 3 == 0) {
+                [cache setData:AUCDiskCacheSpecData(100, (uint8_t)i) forKey:key];
+            } else {
+                [cache setData:AUCDiskCacheSpecData(100, (uint8_t)i) extendedData:AUCDiskCacheSpecData(i, (uint8_t)i) forKey:key];
+            }
+        }
+        [keys addObject:@"missing"];
+
+        NSDictionary<NSString *, NSData *> *extendedDataMap = [cache extendedDataForKeys:keys];
+        expect(extendedDataMap.count).to.equal(6);
+        for (NSUInteger i = 0; i < 10; i++) {
+            NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)i];
+            if (i % 3 == 0) {
+                expect(extendedDataMap[key]).to.beNil();
+            } else {
+                expect(extendedDataMap[key]).to.equal(AUCDiskCacheSpecData(i, (uint8_t)i));
+            }
+        }
+        expect([cache extendedDataForKeys:@[]]).to.equal(@{});
+    });
+
+    it(@"measures bulk reads against per-file extended attributes", ^{
+        NSUInteger count = 500;
+        NSString *legacyDirectory = [directory stringByAppendingPathComponent:@"legacy"];
+        [NSFileManager.defaultManager createDirectoryAtPath:legacyDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+        NSMutableArray<NSString *> *keys = [NSMutableArray array];
+        NSMutableArray<NSString *> *legacyPaths = [NSMutableArray array];
+        for (NSUInteger i = 0; i < count; i++) {
+            NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)i];
+            [keys addObject:key];
+            [cache setData:AUCDiskCacheSpecData(2048, (uint8_t)i) extendedData:AUCDiskCacheSpecData(64, (uint8_t)i) forKey:key];
+            // 早期版本：数据写入文件后再单独设置扩展属性
+            NSString *legacyPath = [legacyDirectory stringByAppendingPathComponent:key];
+            [AUCDiskCacheSpecData(2048, (uint8_t)i) writeToFile:legacyPath atomically:YES];
+            [AUCFileAttributeHelper setExtendedAttribute:@"com.vantage.AUCCache" value:AUCDiskCacheSpecData(64, (uint8_t)i) atPath:legacyPath traverseLink:NO overwrite:YES error:nil];
+            [legacyPaths addObject:legacyPath];
+        }
+
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        NSUInteger legacyCount = 0;
+        for (NSString *legacyPath in legacyPaths) {
+            if ([AUCFileAttributeHelper extendedAttribute:@"com.vantage.AUCCache" atPath:legacyPath traverseLink:NO error:nil]) legacyCount++;
+        }
+        CFAbsoluteTime legacyTime = CFAbsoluteTimeGetCurrent() - start;
+
+        start = CFAbsoluteTimeGetCurrent();
+        NSDictionary<NSString *, NSData *> *extendedDataMap = [cache extendedDataForKeys:keys];
+        CFAbsoluteTime bulkTime = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"[AUCDiskCache] extended data of %lu keys: xattr %.2fms, inline bulk %.2fms",
+              (unsigned long)count, legacyTime * 1000, bulkTime * 1000);
+
+        expect(legacyCount).to.equal(count);
+        expect(extendedDataMap.count).to.equal(count);
+    });
+});
+
+describe(@"deduplication", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+    __block AUCDiskCache *cache;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        config.shouldDeduplicateDiskData = YES;
+        cache = AUCDiskCacheSpecOpen(directory, config);
+    });
+
+    afterEach(^{
+        cache = nil;
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"links keys with identical bodies to one shared blob", ^{
+        NSData *body = AUCDiskCacheSpecData(4096, 1);
+        [cache setData:body forKey:@"https://example.com/list?a=1"];
+        [cache setData:body forKey:@"https://example.com/list?a=2"];
+        [cache setData:AUCDiskCacheSpecData(4096, 2) forKey:@"https://example.com/list?a=3"];
+
+        struct stat first = AUCDiskCacheSpecStat([cache cachePathForKey:@"https://example.com/list?a=1"]);
+        struct stat second = AUCDiskCacheSpecStat([cache cachePathForKey:@"https://example.com/list?a=2"]);
+        struct stat third = AUCDiskCacheSpecStat([cache cachePathForKey:@"https://example.com/list?a=3"]);
+        expect(first.st_ino).to.equal(second.st_ino);
+        expect(first.st_ino).notTo.equal(third.st_ino);
+        // 两个键 + 共享数据
+        expect(first.st_nlink).to.equal(3);
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(2);
+        expect([cache deduplicatedSize]).to.equal(first.st_size);
+
+        expect([cache dataForKey:@"https://example.com/list?a=1"]).to.equal(body);
+        expect([cache dataForKey:@"https://example.com/list?a=2"]).to.equal(body);
+        // 大小仍按每个键统计
+        expect(cache.totalSize).to.equal(first.st_size * 3);
+    });
+
+    it(@"drops a blob when its last key is removed", ^{
+        NSData *body = AUCDiskCacheSpecData(4096, 1);
+        [cache setData:body forKey:@"a"];
+        [cache setData:body forKey:@"b"];
+
+        [cache removeCacheForKey:@"a"];
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(1);
+        expect(AUCDiskCacheSpecStat([cache cachePathForKey:@"b"]).st_nlink).to.equal(2);
+        expect([cache deduplicatedSize]).to.equal(0);
+        expect([cache dataForKey:@"b"]).to.equal(body);
+
+        [cache removeCacheForKey:@"b"];
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(0);
+    });
+
+    it(@"releases the old blob when a key is overwritten with a different body", ^{
+        [cache setData:AUCDiskCacheSpecData(4096, 1) forKey:@"a"];
+        [cache setData:AUCDiskCacheSpecData(4096, 1) forKey:@"a"];
+        expect(AUCDiskCacheSpecStat([cache cachePathForKey:@"a"]).st_nlink).to.equal(2);
+
+        [cache setData:AUCDiskCacheSpecData(4096, 2) forKey:@"a"];
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(1);
+        expect([cache dataForKey:@"a"]).to.equal(AUCDiskCacheSpecData(4096, 2));
+    });
+
+    it(@"drops blobs whose keys are all evicted", ^{
+        for (NSUInteger i = 0; i < 10; i++) {
+            // 每两个键共享一份数据
+            [cache setData:AUCDiskCacheSpecData(1000, (uint8_t)(i / 2)) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(5);
+        config.maxDiskSize = cache.totalSize / 10 * 8;
+
+        [cache removeExpiredData];
+        // 剩下最新的 3 个键：key7 与 key8、key9 分别引用两份数据
+        expect(cache.totalCount).to.equal(3);
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(2);
+        expect([cache dataForKey:@"key7"]).to.equal(AUCDiskCacheSpecData(1000, 3));
+    });
+
+    it(@"reports the bytes saved on a replayed trace", ^{
+        // 200 个键只有查询参数不同，响应来自 20 种内容，部分键被多次写入
+        NSUInteger bodyCount = 20;
+        NSMutableArray<NSData *> *bodies = [NSMutableArray array];
+        for (NSUInteger i = 0; i < bodyCount; i++) {
+            [bodies addObject:AUCDiskCacheSpecData(8 * 1024 + i, (uint8_t)i)];
+        }
+        NSMutableDictionary<NSString *, NSData *> *expected = [NSMutableDictionary dictionary];
+        uint32_t seed = 7;
+        for (NSUInteger i = 0; i < 500; i++) {
+            seed = seed * 1103515245u + 12345u;
+            NSString *key = [NSString stringWithFormat:@"https://example.com/feed?uid=%u", (seed >> 8) % 200];
+            NSData *body = bodies[(seed >> 16) % bodyCount];
+            [cache setData:body forKey:key];
+            expected[key] = body;
+        }
+
+        uint64_t savedSize = [cache deduplicatedSize];
+        NSUInteger distinctBodies = [NSSet setWithArray:expected.allValues].count;
+        NSLog(@"[AUCDiskCache] replayed 500 writes over %lu keys: logical %luKB, saved %lluKB, %lu shared blobs",
+              (unsigned long)expected.count, (unsigned long)(cache.totalSize >> 10), savedSize >> 10, (unsigned long)AUCDiskCacheSpecBlobCount(directory));
+
+        expect(AUCDiskCacheSpecBlobCount(directory)).to.equal(distinctBodies);
+        expect(cache.totalCount).to.equal(expected.count);
+        // 节省的空间为除每种内容的第一份之外的全部
+        NSUInteger entryOverhead = cache.totalSize;
+        for (NSData *body in expected.allValues) {
+            entryOverhead -= body.length;
+        }
+        entryOverhead /= expected.count;
+        uint64_t uniqueSize = 0;
+        for (NSData *body in [NSSet setWithArray:expected.allValues]) {
+            uniqueSize += body.length + entryOverhead;
+        }
+        expect(savedSize).to.equal(cache.totalSize - uniqueSize);
+        [expected enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSData *body, BOOL *stop) {
+            expect([cache dataForKey:key]).to.equal(body);
+        }];
+    });
+});
+
+SpecEnd
@@ -0,0 +1,135 @@
+//
+//  AUCDiskWriteBatcherSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCDiskWriteBatcher.h>
+#import <AUCCache/AUCIOScheduler.h>
+
+SpecBegin(AUCDiskWriteBatcher)
+
+describe(@"group commit", ^{
+    __block AUCIOScheduler *scheduler;
+    __block NSMutableArray<NSDictionary<NSString *, NSData *> *> *batches;
+    __block NSMutableArray<NSString *> *encodedKeys;
+    __block AUCDiskWriteBatcher *(^makeBatcher)(NSTimeInterval interval, NSUInteger byteLimit);
+
+    beforeEach(^{
+        scheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:2];
+        batches = [NSMutableArray array];
+        encodedKeys = [NSMutableArray array];
+        makeBatcher = ^AUCDiskWriteBatcher *(NSTimeInterval interval, NSUInteger byteLimit) {
+            return [[AUCDiskWriteBatcher alloc] initWithScheduler:scheduler interval:interval byteLimit:byteLimit encodeBlock:^NSData *(id object, NSString *key) {
+                @synchronized (encodedKeys) {
+                    [encodedKeys addObject:key];
+                }
+                return [object dataUsingEncoding:NSUTF8StringEncoding];
+            } commitBlock:^(NSDictionary<NSString *, NSData *> *dataBatch) {
+                @synchronized (batches) {
+                    [batches addObject:dataBatch];
+                }
+            }];
+        };
+    });
+
+    it(@"coalesces overwrites of the same key within the window", ^{
+        AUCDiskWriteBatcher *batcher = makeBatcher(0.1, 0);
+        __block NSUInteger completions = 0;
+        waitUntil(^(DoneCallback done) {
+            for (NSUInteger i = 1; i <= 3; i++) {
+                [batcher addObject:[NSString stringWithFormat:@"v%lu", (unsigned long)i] forKey:@"key" estimatedBytes:2 completion:^{
+                    @synchronized (batches) {
+                        if (++completions == 4) done();
+                    }
+                }];
+            }
+            [batcher addObject:@"other" forKey:@"other" estimatedBytes:5 completion:^{
+                @synchronized (batches) {
+                    if (++completions == 4) done();
+                }
+            }];
+        });
+
+        expect(batches.count).to.equal(1);
+        expect(batches.firstObject.count).to.equal(2);
+        expect(batches.firstObject[@"key"]).to.equal([@"v3" dataUsingEncoding:NSUTF8StringEncoding]);
+        // 被覆盖的写入不会编码
+        expect(encodedKeys.count).to.equal(2);
+        expect([batcher hasPendingWriteForKey:@"key"]).to.beFalsy();
+    });
+
+    it(@"calls completions after the commit, in the order the writes were added", ^{
+        AUCDiskWriteBatcher *batcher = makeBatcher(0.05, 0);
+        NSMutableArray<NSString *> *events = [NSMutableArray array];
+        NSArray<NSString *> *keys = @[@"a", @"b", @"a", @"c"];
+        waitUntil(^(DoneCallback done) {
+            for (NSUInteger i = 0; i < keys.count; i++) {
+                [batcher addObject:keys[i] forKey:keys[i] estimatedBytes:1 completion:^{
+                    // 回调时数据已经提交
+                    expect(batches.count).to.equal(1);
+                    [events addObject:[NSString stringWithFormat:@"%@%lu", keys[i], (unsigned long)i]];
+                    if (events.count == keys.count) done();
+                }];
+            }
+        });
+        // 同一个键的回调按加入顺序连续执行，不同键按首次加入的顺序
+        expect(events).to.equal((@[@"a0", @"a2", @"b1", @"c3"]));
+    });
+
+    it(@"flushes as soon as the pending bytes reach the threshold", ^{
+        // 窗口远长于用例的等待时间，只有字节阈值能触发提交
+        AUCDiskWriteBatcher *batcher = makeBatcher(60, 100);
+        __block NSUInteger completions = 0;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        waitUntil(^(DoneCallback done) {
+            for (NSUInteger i = 0; i < 3; i++) {
+                [batcher addObject:@"x" forKey:@(i).stringValue estimatedBytes:40 completion:^{
+                    @synchronized (batches) {
+                        if (++completions == 3) done();
+                    }
+                }];
+            }
+        });
+        expect(CFAbsoluteTimeGetCurrent() - start).to.beLessThan(5);
+        expect(batches.count).to.equal(1);
+        expect(batches.firstObject.count).to.equal(3);
+
+        // 阈值以下的写入继续等待窗口结束
+        [batcher addObject:@"y" forKey:@"pending" estimatedBytes:40 completion:nil];
+        [scheduler dispatchBarrierSync:^{}];
+        expect([batcher hasPendingWriteForKey:@"pending"]).to.beTruthy();
+        expect(batches.count).to.equal(1);
+    });
+
+    it(@"serves pending data before the commit without encoding it twice", ^{
+        AUCDiskWriteBatcher *batcher = makeBatcher(0.05, 0);
+        waitUntil(^(DoneCallback done) {
+            [batcher addObject:@"value" forKey:@"key" estimatedBytes:5 completion:^{
+                done();
+            }];
+            expect([batcher pendingDataForKey:@"key"]).to.equal([@"value" dataUsingEncoding:NSUTF8StringEncoding]);
+        });
+        expect(batches.firstObject[@"key"]).to.equal([@"value" dataUsingEncoding:NSUTF8StringEncoding]);
+        expect(encodedKeys).to.equal(@[@"key"]);
+        expect([batcher pendingDataForKey:@"key"]).to.beNil();
+    });
+
+    it(@"still calls the completion of a discarded write", ^{
+        AUCDiskWriteBatcher *batcher = makeBatcher(0.05, 0);
+        __block BOOL completed = NO;
+        [batcher addObject:@"value" forKey:@"key" estimatedBytes:5 completion:^{
+            completed = YES;
+        }];
+        [batcher discardPendingWriteForKey:@"key"];
+        expect(completed).to.beTruthy();
+        expect([batcher hasPendingWriteForKey:@"key"]).to.beFalsy();
+        // 窗口结束后没有可提交的数据
+        [NSThread sleepForTimeInterval:0.1];
+        [scheduler dispatchBarrierSync:^{}];
+        expect(batches.count).to.equal(0);
+    });
+});
+
+SpecEnd
@@ -0,0 +1,175 @@
+//
+//  AUCIOAdviceSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCIOAdvice.h>
+#import <AUCCache/AUCMappedData.h>
+#import <mach/mach.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/mman.h>
+
+/// 可复现的伪随机数据
+static NSData *AUCIOAdviceSpecData(NSUInteger length, uint32_t seed) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bytes[i] = (uint8_t)(seed >> 16);
+    }
+    return data;
+}
+
+/// 按访问模式打开文件并完整读取
+static NSData *AUCIOAdviceSpecRead(NSString *path, AUCIOAccessPattern pattern) {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    if (fd < 0) return nil;
+    AUCIOAdviseFile(fd, 0, 0, pattern);
+    NSMutableData *data = [NSMutableData data];
+    uint8_t buffer[16 * 1024];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        [data appendBytes:buffer length:(NSUInteger)length];
+    }
+    AUCIOAdviseFileDone(fd, 0, 0);
+    close(fd);
+    return data;
+}
+
+/// 文件在页缓存中的页所占比例
+static double AUCIOAdviceSpecResidentRatio(NSString *path) {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    if (fd < 0) return 0;
+    off_t size = lseek(fd, 0, SEEK_END);
+    void *base = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return 0;
+    size_t pageSize = (size_t)getpagesize();
+    size_t pageCount = ((size_t)size + pageSize - 1) / pageSize;
+    char *vector = malloc(pageCount);
+    size_t resident = 0;
+    if (mincore(base, (size_t)size, vector) == 0) {
+        for (size_t i = 0; i < pageCount; i++) {
+            if (vector[i] & 1) resident++;
+        }
+    }
+    free(vector);
+    munmap(base, (size_t)size);
+    return pageCount ? (double)resident / pageCount : 0;
+}
+
+/// 进程的物理内存占用
+static uint64_t AUCIOAdviceSpecFootprint(void) {
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+    return info.phys_footprint;
+}
+
+SpecBegin(AUCIOAdvice)
+
+describe(@"hints", ^{
+    __block NSString *directory;
+    __block NSString *path;
+    __block NSData *expected;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        [NSFileManager.defaultManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+        path = [directory stringByAppendingPathComponent:@"a"];
+        expected = AUCIOAdviceSpecData(300 * 1024 + 7, 1);
+        [expected writeToFile:path atomically:YES];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"does not change what is read under any access pattern", ^{
+        NSArray<NSNumber *> *patterns = @[@(AUCIOAccessPatternNormal), @(AUCIOAccessPatternWillNeed), @(AUCIOAccessPatternSequential), @(AUCIOAccessPatternNoReuse)];
+        for (NSNumber *pattern in patterns) {
+            expect(AUCIOAdviceSpecRead(path, pattern.integerValue)).to.equal(expected);
+            expect([AUCMappedData dataWithContentsOfFile:path accessPattern:pattern.integerValue]).to.equal(expected);
+        }
+    });
+
+    it(@"accepts regions and addresses that are not page aligned", ^{
+        int fd = open(path.fileSystemRepresentation, O_RDONLY);
+        AUCIOAdviseFile(fd, 4097, 10000, AUCIOAccessPatternWillNeed);
+        AUCIOAdviseFile(fd, expected.length + 4096, 0, AUCIOAccessPatternWillNeed);
+        NSData *region = [AUCMappedData dataWithFileDescriptor:fd offset:4097 length:10000 accessPattern:AUCIOAccessPatternSequential];
+        close(fd);
+        expect(region).to.equal([expected subdataWithRange:NSMakeRange(4097, 10000)]);
+
+        AUCIOAdviseMemory((const uint8_t *)region.bytes + 1, 100, AUCIOAccessPatternWillNeed);
+        AUCIOAdviseMemory((const uint8_t *)region.bytes + 1, 100, AUCIOAccessPatternNoReuse);
+        expect(region).to.equal([expected subdataWithRange:NSMakeRange(4097, 10000)]);
+    });
+
+    it(@"ignores invalid descriptors, empty regions and missing files", ^{
+        AUCIOAdviseFile(-1, 0, 0, AUCIOAccessPatternWillNeed);
+        AUCIOAdviseFileDone(-1, 0, 0);
+        AUCIOAdviseMemory(NULL, 100, AUCIOAccessPatternSequential);
+        AUCIOAdviseMemory(expected.bytes, 0, AUCIOAccessPatternSequential);
+        AUCIOPrefetchFile([directory stringByAppendingPathComponent:@"missing"]);
+        expect(AUCIOAdviceSpecRead(path, AUCIOAccessPatternNormal)).to.equal(expected);
+    });
+
+    it(@"leaves the file readable while it is being prefetched", ^{
+        AUCIOPrefetchFile(path);
+        expect(AUCIOAdviceSpecRead(path, AUCIOAccessPatternNormal)).to.equal(expected);
+        expect(AUCIOAdviceSpecResidentRatio(path)).to.beGreaterThan(0);
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"measures how a one-off scan affects a co-running hot set", ^{
+        NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        [NSFileManager.defaultManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+        // 反复读取的热数据与只读取一次的大文件
+        NSMutableArray<NSString *> *hotPaths = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 32; i++) {
+            NSString *hotPath = [directory stringByAppendingPathComponent:[NSString stringWithFormat:@"hot%lu", (unsigned long)i]];
+            [AUCIOAdviceSpecData(64 * 1024, (uint32_t)i) writeToFile:hotPath atomically:YES];
+            [hotPaths addObject:hotPath];
+        }
+        NSMutableArray<NSString *> *scanPaths = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 4; i++) {
+            NSString *scanPath = [directory stringByAppendingPathComponent:[NSString stringWithFormat:@"scan%lu", (unsigned long)i]];
+            [AUCIOAdviceSpecData(8 * 1024 * 1024, (uint32_t)(100 + i)) writeToFile:scanPath atomically:YES];
+            [scanPaths addObject:scanPath];
+        }
+
+        NSArray<NSNumber *> *patterns = @[@(AUCIOAccessPatternNormal), @(AUCIOAccessPatternNoReuse)];
+        for (NSNumber *pattern in patterns) {
+            uint64_t footprint = AUCIOAdviceSpecFootprint();
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            for (NSString *scanPath in scanPaths) {
+                // 扫描与热数据读取交替进行
+                expect(AUCIOAdviceSpecRead(scanPath, pattern.integerValue).length).to.equal(8 * 1024 * 1024);
+                for (NSString *hotPath in hotPaths) {
+                    AUCIOAdviceSpecRead(hotPath, AUCIOAccessPatternNormal);
+                }
+            }
+            CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+            double hotResident = 0;
+            for (NSString *hotPath in hotPaths) {
+                hotResident += AUCIOAdviceSpecResidentRatio(hotPath);
+            }
+            double scanResident = 0;
+            for (NSString *scanPath in scanPaths) {
+                scanResident += AUCIOAdviceSpecResidentRatio(scanPath);
+            }
+            NSLog(@"[AUCIOAdvice] scan pattern %ld: %.1fms, hot set resident %.0f%%, scanned files resident %.0f%%, footprint %+lldKB",
+                  (long)pattern.integerValue, elapsed * 1000, hotResident / hotPaths.count * 100,
+                  scanResident / scanPaths.count * 100, ((int64_t)AUCIOAdviceSpecFootprint() - (int64_t)footprint) / 1024);
+        }
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+});
+
+SpecEnd
@@ -0,0 +1,293 @@
+//
+//  AUCIOSchedulerSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCIOScheduler.h>
+#import <stdatomic.h>
+
+SpecBegin(AUCIOScheduler)
+
+describe(@"ordering", ^{
+    __block AUCIOScheduler *scheduler;
+    __block NSMutableArray *events;
+
+    beforeEach(^{
+        scheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:4];
+        events = [NSMutableArray array];
+    });
+
+    it(@"runs operations on the same key in submission order", ^{
+        for (NSUInteger i = 0; i < 200; i++) {
+            AUCIOPriority priority = (i % 3 == 0) ? AUCIOPriorityWriteBack : AUCIOPriorityInteractive;
+            [scheduler dispatchAsyncForKey:@"key" priority:priority block:^{
+                @synchronized (events) {
+                    [events addObject:@(i)];
+                }
+            }];
+        }
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect(events.count).to.equal(200);
+        for (NSUInteger i = 0; i < 200; i++) {
+            expect(events[i]).to.equal(@(i));
+        }
+    });
+
+    it(@"keeps a promoted write ahead of a later read of the same key", ^{
+        // 先让写入排队等待，再提交同一个键的高优先级读取
+        dispatch_semaphore_t gate = dispatch_semaphore_create(0);
+        [scheduler dispatchAsyncForKey:@"key" priority:AUCIOPriorityInteractive block:^{
+            dispatch_semaphore_wait(gate, DISPATCH_TIME_FOREVER);
+        }];
+        [scheduler dispatchAsyncForKey:@"key" priority:AUCIOPriorityMaintenance block:^{
+            @synchronized (events) {
+                [events addObject:@"write"];
+            }
+        }];
+        [scheduler dispatchAsyncForKey:@"key" priority:AUCIOPriorityInteractive block:^{
+            @synchronized (events) {
+                [events addObject:@"read"];
+            }
+        }];
+        dispatch_semaphore_signal(gate);
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect(events).to.equal((@[@"write", @"read"]));
+    });
+
+    it(@"runs a barrier after earlier operations and before later ones", ^{
+        __block atomic_uint finished = 0;
+        __block NSUInteger finishedAtBarrier = NSNotFound;
+        __block NSUInteger finishedAfterBarrier = 0;
+        for (NSUInteger i = 0; i < 100; i++) {
+            [scheduler dispatchAsyncForKey:[NSString stringWithFormat:@"key-%lu", (unsigned long)i] priority:AUCIOPriorityWriteBack block:^{
+                [NSThread sleepForTimeInterval:0.001];
+                atomic_fetch_add(&finished, 1);
+            }];
+        }
+        [scheduler dispatchBarrierAsync:^{
+            finishedAtBarrier = atomic_load(&finished);
+        }];
+        for (NSUInteger i = 0; i < 100; i++) {
+            [scheduler dispatchAsyncForKey:[NSString stringWithFormat:@"key-%lu", (unsigned long)i] priority:AUCIOPriorityInteractive block:^{
+                // 屏障之后的操作只能看到屏障之前的 100 个操作
+                if (finishedAtBarrier == 100) atomic_fetch_add(&finished, 1);
+            }];
+        }
+        [scheduler dispatchBarrierSync:^{
+            finishedAfterBarrier = atomic_load(&finished);
+        }];
+
+        expect(finishedAtBarrier).to.equal(100);
+        expect(finishedAfterBarrier).to.equal(200);
+    });
+
+    it(@"runs exclusive tasks without any other operation in flight", ^{
+        __block atomic_int running = 0;
+        __block atomic_bool exclusiveRunning = false;
+        __block atomic_int overlaps = 0;
+        __block atomic_int exclusiveCount = 0;
+        for (NSUInteger i = 0; i < 200; i++) {
+            if (i % 20 == 0) {
+                [scheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+                    atomic_store(&exclusiveRunning, true);
+                    if (atomic_load(&running) != 0) atomic_fetch_add(&overlaps, 1);
+                    [NSThread sleepForTimeInterval:0.002];
+                    atomic_store(&exclusiveRunning, false);
+                    atomic_fetch_add(&exclusiveCount, 1);
+                }];
+            }
+            [scheduler dispatchAsyncForKey:[NSString stringWithFormat:@"key-%lu", (unsigned long)i] priority:AUCIOPriorityInteractive block:^{
+                atomic_fetch_add(&running, 1);
+                if (atomic_load(&exclusiveRunning)) atomic_fetch_add(&overlaps, 1);
+                [NSThread sleepForTimeInterval:0.0005];
+                atomic_fetch_sub(&running, 1);
+            }];
+        }
+        // 独占任务不参与排序，等待它们全部执行
+        waitUntil(^(DoneCallback done) {
+            dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+                while (atomic_load(&exclusiveCount) < 10) {
+                    [NSThread sleepForTimeInterval:0.001];
+                }
+                done();
+            });
+        });
+
+        expect(atomic_load(&overlaps)).to.equal(0);
+    });
+
+    it(@"accepts a nil key and clamps the concurrency to one", ^{
+        [scheduler dispatchSyncForKey:nil priority:AUCIOPriorityInteractive block:^{
+            [events addObject:@"nil"];
+        }];
+        expect(events).to.equal(@[@"nil"]);
+        expect(scheduler.concurrency).to.equal(4);
+        expect([[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:0].concurrency).to.equal(1);
+    });
+});
+
+describe(@"priority lanes", ^{
+    __block AUCIOScheduler *scheduler;
+    __block NSMutableArray *events;
+    __block dispatch_semaphore_t gate;
+
+    beforeEach(^{
+        // 只有一组，所有键在同一组内按优先级竞争
+        scheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:1];
+        events = [NSMutableArray array];
+        gate = dispatch_semaphore_create(0);
+        [scheduler dispatchAsyncForKey:@"gate" priority:AUCIOPriorityInteractive block:^{
+            dispatch_semaphore_wait(gate, DISPATCH_TIME_FOREVER);
+        }];
+    });
+
+    it(@"runs queued operations from the highest priority down", ^{
+        NSArray<NSNumber *> *priorities = @[@(AUCIOPriorityMaintenance), @(AUCIOPriorityWriteBack), @(AUCIOPriorityPrefetch), @(AUCIOPriorityInteractive)];
+        for (NSNumber *priority in priorities) {
+            [scheduler dispatchAsyncForKey:priority.stringValue priority:priority.unsignedIntegerValue block:^{
+                [events addObject:priority];
+            }];
+        }
+        dispatch_semaphore_signal(gate);
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect(events).to.equal(priorities.reverseObjectEnumerator.allObjects);
+    });
+
+    it(@"ages a waiting background operation ahead of a fresh read", ^{
+        [scheduler dispatchAsyncForKey:@"maintenance" priority:AUCIOPriorityMaintenance block:^{
+            [events addObject:@"maintenance"];
+        }];
+        // 等待 400ms 后维护任务的有效优先级（0 + 4）高于刚提交的读取（3）
+        [NSThread sleepForTimeInterval:0.4];
+        [scheduler dispatchAsyncForKey:@"read" priority:AUCIOPriorityInteractive block:^{
+            [events addObject:@"read"];
+        }];
+        dispatch_semaphore_signal(gate);
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect(events).to.equal((@[@"maintenance", @"read"]));
+    });
+
+    it(@"lets a read submitted during a maintenance slice run before the next slice", ^{
+        // 与过期清理相同：每个时间片结束后重新提交独占任务
+        __block NSUInteger slice = 0;
+        __block void (^runSlice)(void);
+        runSlice = ^{
+            [events addObject:[NSString stringWithFormat:@"slice%lu", (unsigned long)slice]];
+            if (slice == 0) {
+                [scheduler dispatchAsyncForKey:@"read" priority:AUCIOPriorityInteractive block:^{
+                    [events addObject:@"read"];
+                }];
+            }
+            if (++slice < 3) {
+                [scheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:runSlice];
+            }
+        };
+        [scheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:runSlice];
+        dispatch_semaphore_signal(gate);
+
+        expect(events.count).will.equal(4);
+        expect(events).to.equal((@[@"slice0", @"read", @"slice1", @"slice2"]));
+        // 打破 block 对自身的引用
+        runSlice = nil;
+    });
+
+    it(@"records wait times per priority", ^{
+        [scheduler resetStatistics];
+        for (NSUInteger i = 0; i < 10; i++) {
+            [scheduler dispatchAsyncForKey:@(i).stringValue priority:AUCIOPriorityPrefetch block:^{}];
+        }
+        [NSThread sleepForTimeInterval:0.05];
+        dispatch_semaphore_signal(gate);
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect([scheduler waitCountForPriority:AUCIOPriorityPrefetch]).to.equal(10);
+        expect([scheduler waitTimePercentile:0.5 priority:AUCIOPriorityPrefetch]).to.beGreaterThanOrEqualTo(0.01);
+        [scheduler resetStatistics];
+        expect([scheduler waitCountForPriority:AUCIOPriorityPrefetch]).to.equal(0);
+    });
+});
+
+describe(@"write flood", ^{
+    it(@"keeps interactive reads ahead of a write-back backlog", ^{
+        AUCIOScheduler *scheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:2];
+        // 每组积压约 250ms 的写回任务
+        for (NSUInteger i = 0; i < 1000; i++) {
+            [scheduler dispatchAsyncForKey:[NSString stringWithFormat:@"write-%lu", (unsigned long)i] priority:AUCIOPriorityWriteBack block:^{
+                [NSThread sleepForTimeInterval:0.0005];
+            }];
+        }
+        // 读取在积压形成后的 100ms 内提交，只需等待正在执行的写回任务
+        for (NSUInteger i = 0; i < 50; i++) {
+            [NSThread sleepForTimeInterval:0.002];
+            [scheduler dispatchAsyncForKey:[NSString stringWithFormat:@"read-%lu", (unsigned long)i] priority:AUCIOPriorityInteractive block:^{}];
+        }
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect([scheduler waitCountForPriority:AUCIOPriorityInteractive]).to.equal(50);
+        NSTimeInterval readP99 = [scheduler waitTimePercentile:0.99 priority:AUCIOPriorityInteractive];
+        NSTimeInterval writeP50 = [scheduler waitTimePercentile:0.5 priority:AUCIOPriorityWriteBack];
+        expect(readP99).to.beLessThan(0.02);
+        expect(writeP50).to.beGreaterThan(0.05);
+        expect(readP99).to.beLessThan(writeP50);
+    });
+
+    it(@"runs each lane at its own QoS", ^{
+        AUCIOScheduler *scheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:1];
+        __block qos_class_t readQoS = QOS_CLASS_UNSPECIFIED;
+        __block qos_class_t writeQoS = QOS_CLASS_UNSPECIFIED;
+        __block qos_class_t maintenanceQoS = QOS_CLASS_UNSPECIFIED;
+        // 同一组内依次执行不同道的任务
+        [scheduler dispatchAsyncForKey:@"a" priority:AUCIOPriorityInteractive block:^{
+            readQoS = qos_class_self();
+        }];
+        [scheduler dispatchAsyncForKey:@"b" priority:AUCIOPriorityWriteBack block:^{
+            writeQoS = qos_class_self();
+        }];
+        [scheduler dispatchAsyncForKey:@"c" priority:AUCIOPriorityMaintenance block:^{
+            maintenanceQoS = qos_class_self();
+        }];
+        [scheduler dispatchBarrierSync:^{}];
+
+        expect(readQoS).to.equal(QOS_CLASS_USER_INITIATED);
+        expect(writeQoS).to.equal(QOS_CLASS_UTILITY);
+        expect(maintenanceQoS).to.equal(QOS_CLASS_BACKGROUND);
+    });
+});
+
+describe(@"re-entrancy", ^{
+    it(@"reports whether the current thread is running one of its tasks", ^{
+        AUCIOScheduler *scheduler = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests" concurrency:2];
+        AUCIOScheduler *other = [[AUCIOScheduler alloc] initWithLabel:@"com.vantage.AUCCache.tests.other" concurrency:1];
+        expect([scheduler isCurrentThreadRunningTask]).to.beFalsy();
+
+        __block BOOL inTask = NO;
+        __block BOOL inOtherScheduler = YES;
+        __block BOOL inBarrier = NO;
+        __block BOOL inExclusive = NO;
+        [scheduler dispatchSyncForKey:@"key" priority:AUCIOPriorityWriteBack block:^{
+            inTask = [scheduler isCurrentThreadRunningTask];
+            inOtherScheduler = [other isCurrentThreadRunningTask];
+        }];
+        [scheduler dispatchBarrierSync:^{
+            inBarrier = [scheduler isCurrentThreadRunningTask];
+        }];
+        waitUntil(^(DoneCallback done) {
+            [scheduler dispatchExclusiveAsyncWithPriority:AUCIOPriorityMaintenance block:^{
+                inExclusive = [scheduler isCurrentThreadRunningTask];
+                done();
+            }];
+        });
+        expect(inTask).to.beTruthy();
+        expect(inOtherScheduler).to.beFalsy();
+        expect(inBarrier).to.beTruthy();
+        expect(inExclusive).to.beTruthy();
+    });
+});
+
+SpecEnd
@@ -0,0 +1,154 @@
+//
+//  AUCJSONParserSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCJSONParser.h>
+#import <AUCCache/AUCJSONStructuralIndex.h>
+
+static NSData *AUCJSONSpecData(NSString *string) {
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static id AUCJSONSpecReference(NSData *data) {
+    return [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingFragmentsAllowed error:nil];
+}
+
+/// 结构索引的全部偏移
+static NSArray<NSNumber *> *AUCJSONSpecIndexes(NSString *string, BOOL *unclosedString) {
+    NSData *data = AUCJSONSpecData(string);
+    uint32_t *indexes = malloc((data.length + 1) * sizeof(uint32_t));
+    size_t count = AUCJSONBuildStructuralIndex(data.bytes, data.length, indexes, unclosedString);
+    NSMutableArray<NSNumber *> *result = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        [result addObject:@(indexes[i])];
+    }
+    free(indexes);
+    return result;
+}
+
+SpecBegin(AUCJSONParser)
+
+describe(@"structural index", ^{
+    it(@"reports the implementation in use", ^{
+        NSString *name = @(AUCJSONStructuralIndexImplementation());
+        expect(@[@"neon", @"avx2", @"sse2", @"scalar"]).to.contain(name);
+    });
+
+    it(@"indexes structural characters, string starts and scalar starts", ^{
+        BOOL unclosed = YES;
+        NSArray *indexes = AUCJSONSpecIndexes(@"{\"a\":[1,true,null]}", &unclosed);
+        expect(indexes).to.equal((@[@0, @1, @4, @5, @6, @7, @8, @12, @13, @17, @18]));
+        expect(unclosed).to.beFalsy();
+    });
+
+    it(@"ignores structural characters inside strings and after escaped quotes", ^{
+        NSArray *indexes = AUCJSONSpecIndexes(@"[\"a,\\\"]{\",2]", NULL);
+        // [ 0、字符串 1、逗号 9、数字 10、] 11
+        expect(indexes).to.equal((@[@0, @1, @9, @10, @11]));
+    });
+
+    it(@"reports a string left open at the end", ^{
+        BOOL unclosed = NO;
+        AUCJSONSpecIndexes(@"[\"abc", &unclosed);
+        expect(unclosed).to.beTruthy();
+    });
+});
+
+describe(@"parser", ^{
+    it(@"matches NSJSONSerialization on mixed documents", ^{
+        NSArray<NSString *> *documents = @[
+            @"{}",
+            @"[]",
+            @"  {\"a\" : [ 1 , 2 ,3 ] ,\n\t\"b\":{\"c\":null}}  ",
+            @"{\"int\":-42,\"zero\":0,\"max\":9223372036854775807,\"min\":-9223372036854775808}",
+            @"{\"half\":0.5,\"neg\":-2.25,\"exp\":1e10,\"small\":6.103515625e-05,\"upper\":2E3}",
+            @"[true,false,null,[[[]]],{\"x\":{}}]",
+            @"{\"escapes\":\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t\"}",
+            @"{\"unicode\":\"\\u00e9\\u4e2d\\ud83d\\ude00 é中😀\"}",
+            @"\"top-level string\"",
+            @"12345",
+        ];
+        for (NSString *document in documents) {
+            NSData *data = AUCJSONSpecData(document);
+            id expected = AUCJSONSpecReference(data);
+            expect(expected).notTo.beNil();
+            expect([AUCJSONParser JSONObjectWithData:data]).to.equal(expected);
+        }
+    });
+
+    it(@"keeps unsigned integers above INT64_MAX", ^{
+        NSArray<NSNumber *> *array = [AUCJSONParser JSONObjectWithData:AUCJSONSpecData(@"[18446744073709551615,9223372036854775808]")];
+        expect(array[0].unsignedLongLongValue).to.equal(UINT64_MAX);
+        expect(array[1].unsignedLongLongValue).to.equal((unsigned long long)INT64_MAX + 1);
+    });
+
+    it(@"handles backslash runs of every parity across 64-byte block boundaries", ^{
+        for (NSUInteger padding = 50; padding < 140; padding++) {
+            for (NSUInteger run = 1; run <= 6; run++) {
+                for (NSUInteger trailing = 0; trailing < 2; trailing++) {
+                    NSMutableString *document = [NSMutableString stringWithString:@"[\""];
+                    [document appendString:[@"" stringByPaddingToLength:padding withString:@"a" startingAtIndex:0]];
+                    [document appendString:[@"" stringByPaddingToLength:run withString:@"\\" startingAtIndex:0]];
+                    // 奇数个反斜杠转义随后的引号，偶数个反斜杠之后的引号结束字符串
+                    if (run % 2 == 1) [document appendString:@"\""];
+                    if (trailing) [document appendString:@"b"];
+                    [document appendString:@"\",{\"k\":[1,\"]\"]}]"];
+
+                    NSData *data = AUCJSONSpecData(document);
+                    id expected = AUCJSONSpecReference(data);
+                    expect(expected).notTo.beNil();
+                    expect([AUCJSONParser JSONObjectWithData:data]).to.equal(expected);
+                }
+            }
+        }
+    });
+
+    it(@"matches NSJSONSerialization on a large generated document", ^{
+        NSMutableArray *items = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 500; i++) {
+            [items addObject:@{
+                @"id": @(i),
+                @"title": [NSString stringWithFormat:@"item \"%lu\" \\ %@", (unsigned long)i, i % 3 ? @"中文" : @"😀"],
+                @"score": @(i * 0.25),
+                @"tags": @[@"a", @"b,c", @"{d}"],
+                @"active": @(i % 2 == 0),
+                @"parent": i > 0 ? @(i - 1) : NSNull.null,
+            }];
+        }
+        NSData *data = [NSJSONSerialization dataWithJSONObject:@{@"items": items} options:0 error:nil];
+        expect([AUCJSONParser JSONObjectWithData:data]).to.equal(AUCJSONSpecReference(data));
+    });
+
+    it(@"shares repeated keys", ^{
+        NSArray<NSDictionary *> *array = [AUCJSONParser JSONObjectWithData:AUCJSONSpecData(@"[{\"key\":1},{\"key\":2}]")];
+        expect(array[0].allKeys.firstObject).to.beIdenticalTo(array[1].allKeys.firstObject);
+    });
+
+    it(@"returns nil for input it cannot parse", ^{
+        NSArray<NSString *> *documents = @[
+            @"",
+            @"{\"a\":}",
+            @"[1,]",
+            @"[1] x",
+            @"tru",
+            @"[\"\\ud800\"]",
+            @"[\"\\x\"]",
+            @"{\"a\" 1}",
+            @"[01]",
+            @"[\"abc",
+        ];
+        for (NSString *document in documents) {
+            expect([AUCJSONParser JSONObjectWithData:AUCJSONSpecData(document)]).to.beNil();
+        }
+        // 非 UTF-8 字节
+        expect([AUCJSONParser JSONObjectWithData:[NSData dataWithBytes:"[\"\xff\"]" length:5]]).to.beNil();
+        // 嵌套过深
+        NSString *deep = [[@"" stringByPaddingToLength:600 withString:@"[" startingAtIndex:0] stringByAppendingString:[@"" stringByPaddingToLength:600 withString:@"]" startingAtIndex:0]];
+        expect([AUCJSONParser JSONObjectWithData:AUCJSONSpecData(deep)]).to.beNil();
+    });
+});
+
+SpecEnd
@@ -0,0 +1,218 @@
+//
+//  AUCMappedDataSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCMappedData.h>
+#import <AUCCache/AUCDiskCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+#import <mach/mach.h>
+#import <fcntl.h>
+
+/// 可复现的伪随机数据
+static NSData *AUCMappedSpecData(NSUInteger length, uint32_t seed) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bytes[i] = (uint8_t)(seed >> 16);
+    }
+    return data;
+}
+
+/// 进程的物理内存占用（不包括可以随时丢弃的干净文件页）
+static uint64_t AUCMappedSpecFootprint(void) {
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+    return info.phys_footprint;
+}
+
+/// 逐页读取一个字节，模拟解析时访问全部数据
+static uint64_t AUCMappedSpecTouch(NSData *data) {
+    const uint8_t *bytes = data.bytes;
+    uint64_t sum = 0;
+    for (NSUInteger i = 0; i < data.length; i += 4096) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+SpecBegin(AUCMappedData)
+
+describe(@"mapping", ^{
+    __block NSString *directory;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        [NSFileManager.defaultManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"maps the whole file", ^{
+        NSString *path = [directory stringByAppendingPathComponent:@"a"];
+        NSData *expected = AUCMappedSpecData(100000, 1);
+        [expected writeToFile:path atomically:YES];
+
+        expect([AUCMappedData dataWithContentsOfFile:path]).to.equal(expected);
+        expect([AUCMappedData dataWithContentsOfFile:path accessPattern:AUCIOAccessPatternSequential]).to.equal(expected);
+        expect([AUCMappedData dataWithContentsOfFile:[directory stringByAppendingPathComponent:@"missing"]]).to.beNil();
+        // 目录不能映射
+        expect([AUCMappedData dataWithContentsOfFile:directory]).to.beNil();
+    });
+
+    it(@"maps regions at offsets that are not page aligned", ^{
+        NSString *path = [directory stringByAppendingPathComponent:@"a"];
+        NSData *expected = AUCMappedSpecData(20000, 2);
+        [expected writeToFile:path atomically:YES];
+
+        int fd = open(path.fileSystemRepresentation, O_RDONLY);
+        NSArray<NSNumber *> *offsets = @[@0, @1, @4095, @4096, @4097, @12345];
+        NSMutableArray<NSData *> *regions = [NSMutableArray array];
+        for (NSNumber *offset in offsets) {
+            [regions addObject:[AUCMappedData dataWithFileDescriptor:fd offset:offset.unsignedLongLongValue length:1000]];
+        }
+        // 映射建立后可以关闭文件描述符
+        close(fd);
+        for (NSUInteger i = 0; i < offsets.count; i++) {
+            expect(regions[i]).to.equal([expected subdataWithRange:NSMakeRange(offsets[i].unsignedIntegerValue, 1000)]);
+        }
+        expect([AUCMappedData dataWithFileDescriptor:fd offset:0 length:0]).to.equal([NSData data]);
+    });
+
+    it(@"keeps the contents when the file is unlinked or replaced while mapped", ^{
+        NSString *path = [directory stringByAppendingPathComponent:@"a"];
+        NSData *original = AUCMappedSpecData(100000, 3);
+        [original writeToFile:path atomically:YES];
+
+        NSData *unlinked = [AUCMappedData dataWithContentsOfFile:path];
+        [NSFileManager.defaultManager removeItemAtPath:path error:NULL];
+        expect(unlinked).to.equal(original);
+
+        [original writeToFile:path atomically:YES];
+        NSData *replaced = [AUCMappedData dataWithContentsOfFile:path];
+        [AUCMappedSpecData(100000, 4) writeToFile:path atomically:YES];
+        expect(replaced).to.equal(original);
+    });
+});
+
+describe(@"disk cache reads", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+    __block AUCDiskCache *cache;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        config.diskCacheMappingThreshold = 64 * 1024;
+        cache = [[AUCDiskCache alloc] initWithCachePath:directory config:config];
+        [cache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+    });
+
+    afterEach(^{
+        cache = nil;
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"returns the same data on both sides of the threshold", ^{
+        NSData *small = AUCMappedSpecData(1000, 5);
+        NSData *large = AUCMappedSpecData(200 * 1024, 6);
+        [cache setData:small forKey:@"small"];
+        [cache setData:large forKey:@"large"];
+        expect([cache dataForKey:@"small"]).to.equal(small);
+        expect([cache dataForKey:@"large"]).to.equal(large);
+    });
+
+    it(@"keeps data read through a mapping valid after the entry is evicted or overwritten", ^{
+        NSData *large = AUCMappedSpecData(200 * 1024, 7);
+        [cache setData:large forKey:@"a"];
+        NSData *evicted = [cache dataForKey:@"a"];
+        [cache removeCacheForKey:@"a"];
+        expect([cache dataForKey:@"a"]).to.beNil();
+        expect(evicted).to.equal(large);
+
+        [cache setData:large forKey:@"b"];
+        NSData *overwritten = [cache dataForKey:@"b"];
+        [cache setData:AUCMappedSpecData(200 * 1024, 8) forKey:@"b"];
+        expect(overwritten).to.equal(large);
+        expect([cache dataForKey:@"b"]).to.equal(AUCMappedSpecData(200 * 1024, 8));
+    });
+
+    it(@"survives concurrent eviction while readers hold mapped data", ^{
+        NSData *large = AUCMappedSpecData(128 * 1024, 9);
+        for (NSUInteger i = 0; i < 16; i++) {
+            [cache setData:large forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+        __block NSUInteger mismatches = 0;
+        dispatch_apply(64, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long)(i % 16)];
+            if (i % 4 == 0) {
+                [cache removeCacheForKey:key];
+                return;
+            }
+            NSData *data = [cache dataForKey:key];
+            if (data && ![data isEqualToData:large]) {
+                @synchronized (cache) {
+                    mismatches++;
+                }
+            }
+        });
+        expect(mismatches).to.equal(0);
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"measures latency and footprint against the copying path", ^{
+        NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        [NSFileManager.defaultManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+        NSUInteger fileCount = 8;
+        NSUInteger length = 4 * 1024 * 1024;
+        NSMutableArray<NSString *> *paths = [NSMutableArray array];
+        for (NSUInteger i = 0; i < fileCount; i++) {
+            NSString *path = [directory stringByAppendingPathComponent:[NSString stringWithFormat:@"file%lu", (unsigned long)i]];
+            [AUCMappedSpecData(length, (uint32_t)i) writeToFile:path atomically:YES];
+            [paths addObject:path];
+        }
+
+        // 同时持有全部数据，对比两种方式增加的内存占用
+        __block uint64_t checksum = 0;
+        NSMutableArray<NSData *> *held = [NSMutableArray array];
+        uint64_t footprint = AUCMappedSpecFootprint();
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSString *path in paths) {
+            NSData *data = [NSData dataWithContentsOfFile:path];
+            checksum += AUCMappedSpecTouch(data);
+            [held addObject:data];
+        }
+        CFAbsoluteTime copyTime = CFAbsoluteTimeGetCurrent() - start;
+        uint64_t copyFootprint = AUCMappedSpecFootprint() - footprint;
+        [held removeAllObjects];
+
+        footprint = AUCMappedSpecFootprint();
+        start = CFAbsoluteTimeGetCurrent();
+        for (NSString *path in paths) {
+            NSData *data = [AUCMappedData dataWithContentsOfFile:path accessPattern:AUCIOAccessPatternSequential];
+            checksum += AUCMappedSpecTouch(data);
+            [held addObject:data];
+        }
+        CFAbsoluteTime mapTime = CFAbsoluteTimeGetCurrent() - start;
+        uint64_t mapFootprint = AUCMappedSpecFootprint() - footprint;
+        [held removeAllObjects];
+
+        NSLog(@"[AUCMappedData] %lu x %luMB: copy %.2fms +%lluKB footprint, mmap %.2fms +%lluKB footprint (checksum %llu)",
+              (unsigned long)fileCount, (unsigned long)(length >> 20),
+              copyTime * 1000, copyFootprint >> 10, mapTime * 1000, mapFootprint >> 10, checksum);
+
+        // 映射的干净文件页不计入内存占用
+        expect(mapFootprint).to.beLessThan(copyFootprint / 2);
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+});
+
+SpecEnd
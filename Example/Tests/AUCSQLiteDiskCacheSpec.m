@@ -0,0 +1,163 @@
+//
+//  AUCSQLiteDiskCacheSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCSQLiteDiskCache.h>
+#import <AUCCache/AUCDiskCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+#import <AUCCache/AUCFileAttributeHelper.h>
+
+/// 长度为 `length` 的数据，内容随 `seed` 变化
+static NSData *AUCSQLiteSpecData(NSUInteger length, uint8_t seed) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    memset(data.mutableBytes, seed, length);
+    return data;
+}
+
+/// 依次写入、读取 `count` 个数据，返回总耗时
+static CFAbsoluteTime AUCSQLiteSpecRoundTrip(id<AUCDiskCacheProtocol> cache, NSUInteger count, NSUInteger length) {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < count; i++) {
+        [cache setData:AUCSQLiteSpecData(length, (uint8_t)i) forKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+    }
+    for (NSUInteger i = 0; i < count; i++) {
+        @autoreleasepool {
+            [cache dataForKey:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+        }
+    }
+    return CFAbsoluteTimeGetCurrent() - start;
+}
+
+SpecBegin(AUCSQLiteDiskCache)
+
+describe(@"storage", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+    __block AUCSQLiteDiskCache *cache;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        config.diskCacheClass = AUCSQLiteDiskCache.class;
+        config.diskCacheInlineThreshold = 1024;
+        cache = [[AUCSQLiteDiskCache alloc] initWithCachePath:directory config:config];
+    });
+
+    afterEach(^{
+        cache = nil;
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"opens the database in WAL mode", ^{
+        [cache setData:AUCSQLiteSpecData(10, 1) forKey:@"a"];
+        expect([NSFileManager.defaultManager fileExistsAtPath:[directory stringByAppendingPathComponent:@"manifest.sqlite"]]).to.beTruthy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:[directory stringByAppendingPathComponent:@"manifest.sqlite-wal"]]).to.beTruthy();
+    });
+
+    it(@"keeps values up to the threshold inline and writes larger ones to files", ^{
+        NSData *small = AUCSQLiteSpecData(1024, 1);
+        NSData *large = AUCSQLiteSpecData(1025, 2);
+        [cache setData:small forKey:@"small"];
+        [cache setData:large forKey:@"large"];
+
+        expect([cache cachePathForKey:@"small"]).to.beNil();
+        NSString *largePath = [cache cachePathForKey:@"large"];
+        expect(largePath).notTo.beNil();
+        expect([NSData dataWithContentsOfFile:largePath]).to.equal(large);
+        expect([cache dataForKey:@"small"]).to.equal(small);
+        expect([cache dataForKey:@"large"]).to.equal(large);
+        expect(cache.totalCount).to.equal(2);
+        expect(cache.totalSize).to.equal(2049);
+    });
+
+    it(@"removes the file when a value moves inline or is removed", ^{
+        [cache setData:AUCSQLiteSpecData(4096, 1) forKey:@"a"];
+        NSString *path = [cache cachePathForKey:@"a"];
+        expect([NSFileManager.defaultManager fileExistsAtPath:path]).to.beTruthy();
+
+        [cache setData:AUCSQLiteSpecData(16, 2) forKey:@"a"];
+        expect([NSFileManager.defaultManager fileExistsAtPath:path]).to.beFalsy();
+        expect([cache dataForKey:@"a"]).to.equal(AUCSQLiteSpecData(16, 2));
+
+        [cache setData:AUCSQLiteSpecData(4096, 3) forKey:@"b"];
+        path = [cache cachePathForKey:@"b"];
+        [cache removeCacheForKey:@"b"];
+        expect([NSFileManager.defaultManager fileExistsAtPath:path]).to.beFalsy();
+        expect([cache containsDataForKey:@"b"]).to.beFalsy();
+        expect([cache dataForKey:@"b"]).to.beNil();
+    });
+
+    it(@"stores extended data in a column rather than an extended attribute", ^{
+        NSData *extendedData = AUCSQLiteSpecData(32, 9);
+        [cache setData:AUCSQLiteSpecData(4096, 1) forKey:@"a"];
+        [cache setExtendedData:extendedData forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.equal(extendedData);
+        expect([AUCFileAttributeHelper hasExtendedAttribute:@"com.vantage.AUCCache" atPath:[cache cachePathForKey:@"a"] traverseLink:NO error:nil]).to.beFalsy();
+        // 扩展数据不改变数据文件
+        expect([NSData dataWithContentsOfFile:[cache cachePathForKey:@"a"]]).to.equal(AUCSQLiteSpecData(4096, 1));
+
+        [cache setData:AUCSQLiteSpecData(10, 2) extendedData:extendedData forKey:@"b"];
+        expect([cache extendedDataForKeys:@[@"a", @"b", @"missing"]]).to.equal((@{@"a": extendedData, @"b": extendedData}));
+
+        [cache setExtendedData:nil forKey:@"a"];
+        expect([cache extendedDataForKey:@"a"]).to.beNil();
+    });
+
+    it(@"keeps its contents across reopening", ^{
+        [cache setData:AUCSQLiteSpecData(10, 1) forKey:@"small"];
+        [cache setData:AUCSQLiteSpecData(4096, 2) extendedData:AUCSQLiteSpecData(8, 3) forKey:@"large"];
+        cache = nil;
+
+        AUCSQLiteDiskCache *reopened = [[AUCSQLiteDiskCache alloc] initWithCachePath:directory config:config];
+        expect([reopened recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]]).to.beTruthy();
+        expect(reopened.totalCount).to.equal(2);
+        expect([reopened dataForKey:@"small"]).to.equal(AUCSQLiteSpecData(10, 1));
+        expect([reopened dataForKey:@"large"]).to.equal(AUCSQLiteSpecData(4096, 2));
+        expect([reopened extendedDataForKey:@"large"]).to.equal(AUCSQLiteSpecData(8, 3));
+    });
+
+    it(@"removes data files that no row refers to during recovery", ^{
+        [cache setData:AUCSQLiteSpecData(4096, 1) forKey:@"a"];
+        NSString *orphan = [[cache cachePathForKey:@"a"].stringByDeletingLastPathComponent stringByAppendingPathComponent:@"orphan"];
+        [AUCSQLiteSpecData(4096, 2) writeToFile:orphan atomically:NO];
+        // 孤立文件需早于恢复开始时间
+        NSDate *past = [NSDate dateWithTimeIntervalSinceNow:-3600];
+        [NSFileManager.defaultManager setAttributes:@{NSFileModificationDate: past} ofItemAtPath:orphan error:NULL];
+
+        AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+        expect([cache recoverWithTimeBudget:10 report:report]).to.beTruthy();
+        expect([NSFileManager.defaultManager fileExistsAtPath:orphan]).to.beFalsy();
+        expect([cache dataForKey:@"a"]).to.equal(AUCSQLiteSpecData(4096, 1));
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"measures small-value round trips against the file-per-key cache", ^{
+        NSUInteger count = 1000;
+        NSUInteger length = 2048;
+        AUCCacheConfig *config = [[AUCCacheConfig alloc] init];
+        NSString *sqliteDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        NSString *fileDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+
+        AUCSQLiteDiskCache *sqliteCache = [[AUCSQLiteDiskCache alloc] initWithCachePath:sqliteDirectory config:config];
+        AUCDiskCache *fileCache = [[AUCDiskCache alloc] initWithCachePath:fileDirectory config:config];
+        [fileCache recoverWithTimeBudget:10 report:[AUCDiskCacheRecoveryReport new]];
+
+        CFAbsoluteTime sqliteTime = AUCSQLiteSpecRoundTrip(sqliteCache, count, length);
+        CFAbsoluteTime fileTime = AUCSQLiteSpecRoundTrip(fileCache, count, length);
+        NSLog(@"[AUCSQLiteDiskCache] %lu x %luB set+get: sqlite %.1fms, file per key %.1fms",
+              (unsigned long)count, (unsigned long)length, sqliteTime * 1000, fileTime * 1000);
+
+        expect(sqliteCache.totalCount).to.equal(count);
+        expect(fileCache.totalCount).to.equal(count);
+
+        [NSFileManager.defaultManager removeItemAtPath:sqliteDirectory error:NULL];
+        [NSFileManager.defaultManager removeItemAtPath:fileDirectory error:NULL];
+    });
+});
+
+SpecEnd
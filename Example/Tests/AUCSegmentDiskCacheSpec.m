@@ -0,0 +1,291 @@
+//
+//  AUCSegmentDiskCacheSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCSegmentDiskCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCDiskCacheRecoveryReport.h>
+
+/// 内容可区分的测试数据：`length` 字节，全部填充为 `fill`
+static NSData *AUCSegmentSpecData(NSUInteger length, uint8_t fill) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    memset(data.mutableBytes, fill, length);
+    return data;
+}
+
+/// 第一个分段文件的路径（分段 ID 从 0 开始，文件名为 10 位 ID）
+static NSString *AUCSegmentSpecFirstSegmentPath(NSString *directory) {
+    return [directory stringByAppendingPathComponent:@"0000000000.segment"];
+}
+
+/// 在分段文件的 `offset` 处覆盖写入
+static void AUCSegmentSpecOverwrite(NSString *path, unsigned long long offset, NSData *data) {
+    NSFileHandle *handle = [NSFileHandle fileHandleForUpdatingAtPath:path];
+    [handle seekToFileOffset:offset];
+    [handle writeData:data];
+    [handle closeFile];
+}
+
+SpecBegin(AUCSegmentDiskCache)
+
+describe(@"recovery", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"rebuilds the index from the segments on reopen", ^{
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            [cache setData:AUCSegmentSpecData(100, 1) forKey:@"a"];
+            [cache setData:AUCSegmentSpecData(200, 2) forKey:@"b"];
+            [cache setData:AUCSegmentSpecData(300, 3) forKey:@"a"];
+            [cache removeCacheForKey:@"b"];
+            [cache setData:AUCSegmentSpecData(10, 4) extendedData:AUCSegmentSpecData(5, 5) forKey:@"c"];
+        }
+
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect(reopened.totalCount).to.equal(2);
+        expect([reopened dataForKey:@"a"]).to.equal(AUCSegmentSpecData(300, 3));
+        expect([reopened containsDataForKey:@"b"]).to.beFalsy();
+        expect([reopened dataForKey:@"c"]).to.equal(AUCSegmentSpecData(10, 4));
+        expect([reopened extendedDataForKey:@"c"]).to.equal(AUCSegmentSpecData(5, 5));
+    });
+
+    it(@"skips a record with a bad checksum and keeps the records after it", ^{
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            [cache setData:AUCSegmentSpecData(64, 1) forKey:@"a"];
+            [cache setData:AUCSegmentSpecData(64, 2) forKey:@"b"];
+        }
+        // 记录头 32 字节 + 键 "a" 1 字节之后是值，改写其中一个字节
+        AUCSegmentSpecOverwrite(AUCSegmentSpecFirstSegmentPath(directory), 32 + 1 + 10, AUCSegmentSpecData(1, 0xff));
+
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect([reopened containsDataForKey:@"a"]).to.beFalsy();
+        expect([reopened dataForKey:@"b"]).to.equal(AUCSegmentSpecData(64, 2));
+
+        AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+        expect([reopened recoverWithTimeBudget:1 report:report]).to.beTruthy();
+        expect(report.repairedEntryCount).to.equal(1);
+    });
+
+    it(@"resyncs past a record whose header lengths are corrupt", ^{
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            [cache setData:AUCSegmentSpecData(64, 1) forKey:@"a"];
+            [cache setData:AUCSegmentSpecData(64, 2) forKey:@"b"];
+            [cache setData:AUCSegmentSpecData(64, 3) forKey:@"c"];
+        }
+        // 记录头偏移 12 处为值长度，改写后长度仍落在文件范围内
+        AUCSegmentSpecOverwrite(AUCSegmentSpecFirstSegmentPath(directory), 12, AUCSegmentSpecData(1, 0x80));
+
+        @autoreleasepool {
+            AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            expect([reopened containsDataForKey:@"a"]).to.beFalsy();
+            expect([reopened dataForKey:@"b"]).to.equal(AUCSegmentSpecData(64, 2));
+            expect([reopened dataForKey:@"c"]).to.equal(AUCSegmentSpecData(64, 3));
+
+            AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+            [reopened recoverWithTimeBudget:1 report:report];
+            expect(report.repairedEntryCount).to.equal(1);
+            expect(report.truncatedByteCount).to.equal(0);
+            [reopened setData:AUCSegmentSpecData(8, 4) forKey:@"d"];
+        }
+
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect([reopened dataForKey:@"c"]).to.equal(AUCSegmentSpecData(64, 3));
+        expect([reopened dataForKey:@"d"]).to.equal(AUCSegmentSpecData(8, 4));
+    });
+
+    it(@"never rewrites a sealed segment", ^{
+        // 每个分段只能容纳 3 条 1000 字节的记录，第 4 条写入新的分段
+        config.diskSegmentSize = 4096;
+        uint64_t sealedEnd = 0;
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            for (NSUInteger i = 0; i < 3; i++) {
+                [cache setData:AUCSegmentSpecData(1000, (uint8_t)i) forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+            }
+            sealedEnd = cache.totalSize;
+            [cache setData:AUCSegmentSpecData(1000, 3) forKey:@"k3"];
+        }
+        NSString *sealedPath = AUCSegmentSpecFirstSegmentPath(directory);
+        AUCSegmentSpecOverwrite(sealedPath, 12, AUCSegmentSpecData(1, 0x80));
+        AUCSegmentSpecOverwrite(sealedPath, sealedEnd, AUCSegmentSpecData(20, 0x41));
+
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect([reopened containsDataForKey:@"k0"]).to.beFalsy();
+        for (NSUInteger i = 1; i < 4; i++) {
+            expect([reopened dataForKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]]).to.equal(AUCSegmentSpecData(1000, (uint8_t)i));
+        }
+        AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+        [reopened recoverWithTimeBudget:1 report:report];
+        expect(report.truncatedByteCount).to.equal(0);
+
+        NSData *sealed = [NSData dataWithContentsOfFile:sealedPath];
+        expect([sealed subdataWithRange:NSMakeRange((NSUInteger)sealedEnd, 20)]).to.equal(AUCSegmentSpecData(20, 0x41));
+    });
+
+    it(@"clears a torn tail so later appends stay readable", ^{
+        uint64_t tailOffset = 0;
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            [cache setData:AUCSegmentSpecData(64, 1) forKey:@"a"];
+            tailOffset = cache.totalSize;
+        }
+        // 模拟崩溃时只写了一半的记录：末尾之后出现非 0 字节
+        AUCSegmentSpecOverwrite(AUCSegmentSpecFirstSegmentPath(directory), tailOffset, AUCSegmentSpecData(20, 0x41));
+
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            AUCDiskCacheRecoveryReport *report = [AUCDiskCacheRecoveryReport new];
+            [cache recoverWithTimeBudget:1 report:report];
+            expect(report.truncatedByteCount).to.equal(20);
+            expect(cache.totalSize).to.equal(tailOffset);
+            [cache setData:AUCSegmentSpecData(4, 2) forKey:@"b"];
+        }
+
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect([reopened dataForKey:@"a"]).to.equal(AUCSegmentSpecData(64, 1));
+        expect([reopened dataForKey:@"b"]).to.equal(AUCSegmentSpecData(4, 2));
+    });
+});
+
+describe(@"concurrency", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        config.diskSegmentSize = 4096;
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"reads consistent data while segments are compacted and dropped", ^{
+        AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        NSUInteger count = 40;
+        for (NSUInteger i = 0; i < count; i++) {
+            [cache setData:AUCSegmentSpecData(1000, (uint8_t)i) extendedData:AUCSegmentSpecData(10, (uint8_t)i) forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+        }
+        __block BOOL mismatch = NO;
+        dispatch_apply(4000, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+            NSUInteger i = iteration % count;
+            NSString *key = [NSString stringWithFormat:@"k%lu", (unsigned long)i];
+            if (iteration % 100 == 0) {
+                // 删除一部分键后压缩，同时继续读取
+                [cache removeCacheForKey:key];
+                [cache removeExpiredData];
+                return;
+            }
+            NSData *data = [cache dataForKey:key];
+            NSData *extendedData = [cache extendedDataForKey:key];
+            if ((data && ![data isEqualToData:AUCSegmentSpecData(1000, (uint8_t)i)]) ||
+                (extendedData && ![extendedData isEqualToData:AUCSegmentSpecData(10, (uint8_t)i)])) {
+                mismatch = YES;
+            }
+        });
+        expect(mismatch).to.beFalsy();
+
+        NSDictionary<NSString *, NSData *> *extendedDataMap = [cache extendedDataForKeys:@[@"k1", @"k2", @"k2"]];
+        expect(extendedDataMap.count).to.equal(2);
+        expect(extendedDataMap[@"k1"]).to.equal(AUCSegmentSpecData(10, 1));
+    });
+});
+
+describe(@"removeExpiredData", ^{
+    __block NSString *directory;
+    __block AUCCacheConfig *config;
+
+    beforeEach(^{
+        directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+        config = [[AUCCacheConfig alloc] init];
+        // 每个分段只能容纳 3 条 1000 字节的记录
+        config.diskSegmentSize = 4096;
+    });
+
+    afterEach(^{
+        [NSFileManager.defaultManager removeItemAtPath:directory error:NULL];
+    });
+
+    it(@"does not bring expired data back after a reopen", ^{
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            [cache setData:AUCSegmentSpecData(100, 1) forKey:@"a"];
+            [NSThread sleepForTimeInterval:0.01];
+            config.maxDiskAge = 0;
+            [cache removeExpiredData];
+            expect(cache.totalCount).to.equal(0);
+        }
+
+        config.maxDiskAge = -1;
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect([reopened containsDataForKey:@"a"]).to.beFalsy();
+    });
+
+    it(@"compacts sparse segments without resurrecting removed keys", ^{
+        NSUInteger count = 20;
+        NSUInteger sizeBefore = 0;
+        @autoreleasepool {
+            AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+            for (NSUInteger i = 0; i < count; i++) {
+                [cache setData:AUCSegmentSpecData(1000, (uint8_t)i) forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+            }
+            for (NSUInteger i = 0; i < 5; i++) {
+                [cache removeCacheForKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+            }
+            for (NSUInteger i = 5; i < 15; i++) {
+                [cache setData:AUCSegmentSpecData(1000, (uint8_t)(i + 100)) forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+            }
+            sizeBefore = cache.totalSize;
+            [cache removeExpiredData];
+            expect(cache.totalSize).to.beLessThan(sizeBefore);
+            expect(cache.totalCount).to.equal(count - 5);
+        }
+
+        AUCSegmentDiskCache *reopened = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        expect(reopened.totalCount).to.equal(count - 5);
+        for (NSUInteger i = 0; i < count; i++) {
+            NSData *data = [reopened dataForKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+            if (i < 5) {
+                expect(data).to.beNil();
+            } else if (i < 15) {
+                expect(data).to.equal(AUCSegmentSpecData(1000, (uint8_t)(i + 100)));
+            } else {
+                expect(data).to.equal(AUCSegmentSpecData(1000, (uint8_t)i));
+            }
+        }
+        // 压缩后再次清理不会继续缩小，不会反复压缩
+        NSUInteger sizeAfter = reopened.totalSize;
+        [reopened removeExpiredData];
+        expect(reopened.totalSize).to.equal(sizeAfter);
+    });
+
+    it(@"drops the oldest segments over the size limit", ^{
+        AUCSegmentDiskCache *cache = [[AUCSegmentDiskCache alloc] initWithCachePath:directory config:config];
+        for (NSUInteger i = 0; i < 12; i++) {
+            [cache setData:AUCSegmentSpecData(1000, (uint8_t)i) forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+        }
+        config.maxDiskSize = 6000;
+        [cache removeExpiredData];
+        expect(cache.totalSize).to.beLessThanOrEqualTo(6000);
+        expect([cache containsDataForKey:@"k0"]).to.beFalsy();
+        expect([cache dataForKey:@"k11"]).to.equal(AUCSegmentSpecData(1000, 11));
+    });
+});
+
+SpecEnd
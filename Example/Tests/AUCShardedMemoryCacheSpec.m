@@ -0,0 +1,315 @@
+//
+//  AUCShardedMemoryCacheSpec.m
+//  AUCCache_Tests
+//
+//  Created by aaron lee on 2024/12/03.
+//
+
+#import <AUCCache/AUCShardedMemoryCache.h>
+#import <AUCCache/AUCMemoryCache.h>
+#import <AUCCache/AUCCacheConfig.h>
+#import <AUCCache/AUCFrequencySketch.h>
+
+/// 单分片的缓存，淘汰顺序与全局 LRU 一致，便于断言
+static AUCShardedMemoryCache *AUCShardSpecCache(NSUInteger shardCount, NSUInteger maxCount, NSUInteger maxCost, AUCCacheMemoryEvictionPolicy policy) {
+    AUCCacheConfig *config = [[AUCCacheConfig alloc] init];
+    config.memoryCacheShardCount = shardCount;
+    config.maxMemoryCount = maxCount;
+    config.maxMemoryCost = maxCost;
+    config.memoryCacheEvictionPolicy = policy;
+    config.shouldUseWeakMemoryCache = NO;
+    return [[AUCShardedMemoryCache alloc] initWithConfig:config];
+}
+
+/// 模拟使用方的读取路径：未命中时回填
+static void AUCShardSpecLoad(AUCShardedMemoryCache *cache, id key) {
+    if (![cache objectForKey:key]) {
+        [cache setObject:key forKey:key];
+    }
+}
+
+/// 热点数据反复读取后，经历一次只访问一遍的冷数据扫描，返回仍保留的热点数量
+static NSUInteger AUCShardSpecHotSurvivors(AUCShardedMemoryCache *cache, NSUInteger hotCount, NSUInteger scanCount) {
+    for (NSUInteger i = 0; i < hotCount; i++) {
+        AUCShardSpecLoad(cache, @(i));
+    }
+    for (NSUInteger round = 0; round < 4; round++) {
+        for (NSUInteger i = 0; i < hotCount; i++) {
+            AUCShardSpecLoad(cache, @(i));
+        }
+    }
+    for (NSUInteger i = 0; i < scanCount; i++) {
+        AUCShardSpecLoad(cache, @(100000 + i));
+    }
+    NSUInteger survivors = 0;
+    for (NSUInteger i = 0; i < hotCount; i++) {
+        if ([cache objectForKey:@(i)]) survivors++;
+    }
+    return survivors;
+}
+
+/// 多线程混合读写（90% 读、10% 写），返回每秒操作数
+static double AUCShardSpecThroughput(id<AUCMemoryCacheProtocol> cache, NSArray<NSString *> *keys, NSUInteger threads, NSUInteger operationsPerThread) {
+    for (NSString *key in keys) {
+        [cache setObject:key forKey:key];
+    }
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    dispatch_apply(threads, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t thread) {
+        uint64_t state = thread * 0x9e3779b97f4a7c15ULL + 1;
+        for (NSUInteger i = 0; i < operationsPerThread; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            NSString *key = keys[state % keys.count];
+            if (state % 10 == 0) {
+                [cache setObject:key forKey:key];
+            } else {
+                [cache objectForKey:key];
+            }
+        }
+    });
+    return threads * operationsPerThread / (CFAbsoluteTimeGetCurrent() - start);
+}
+
+SpecBegin(AUCShardedMemoryCache)
+
+describe(@"LRU", ^{
+    it(@"rounds the shard count up to a power of two", ^{
+        expect(AUCShardSpecCache(3, 0, 0, AUCCacheMemoryEvictionPolicyLRU).shardCount).to.equal(4);
+        expect(AUCShardSpecCache(1, 0, 0, AUCCacheMemoryEvictionPolicyLRU).shardCount).to.equal(1);
+        expect(AUCShardSpecCache(1000, 0, 0, AUCCacheMemoryEvictionPolicyLRU).shardCount).to.equal(64);
+    });
+
+    it(@"evicts the least recently used object over the count limit", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 3, 0, AUCCacheMemoryEvictionPolicyLRU);
+        [cache setObject:@"a" forKey:@"a"];
+        [cache setObject:@"b" forKey:@"b"];
+        [cache setObject:@"c" forKey:@"c"];
+        // 读取 a 后，b 成为最久未使用
+        expect([cache objectForKey:@"a"]).to.equal(@"a");
+        [cache setObject:@"d" forKey:@"d"];
+
+        expect(cache.totalCount).to.equal(3);
+        expect([cache objectForKey:@"b"]).to.beNil();
+        expect([cache objectForKey:@"a"]).to.equal(@"a");
+        expect([cache objectForKey:@"c"]).to.equal(@"c");
+        expect([cache objectForKey:@"d"]).to.equal(@"d");
+    });
+
+    it(@"evicts by cost and tracks cost updates", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 0, 10, AUCCacheMemoryEvictionPolicyLRU);
+        [cache setObject:@"a" forKey:@"a" cost:4];
+        [cache setObject:@"b" forKey:@"b" cost:4];
+        expect(cache.totalCost).to.equal(8);
+        // 更新已有的键只替换成本，不重复计入
+        [cache setObject:@"b2" forKey:@"b" cost:2];
+        expect(cache.totalCost).to.equal(6);
+        [cache setObject:@"c" forKey:@"c" cost:5];
+
+        expect([cache objectForKey:@"a"]).to.beNil();
+        expect([cache objectForKey:@"b"]).to.equal(@"b2");
+        expect(cache.totalCount).to.equal(2);
+        expect(cache.totalCost).to.equal(7);
+    });
+
+    it(@"applies limit changes to existing objects", ^{
+        AUCCacheConfig *config = [[AUCCacheConfig alloc] init];
+        config.memoryCacheShardCount = 1;
+        config.shouldUseWeakMemoryCache = NO;
+        AUCShardedMemoryCache *cache = [[AUCShardedMemoryCache alloc] initWithConfig:config];
+        for (NSUInteger i = 0; i < 10; i++) {
+            [cache setObject:@(i) forKey:@(i)];
+        }
+        config.maxMemoryCount = 4;
+        expect(cache.totalCount).to.equal(4);
+        expect([cache objectForKey:@(9)]).to.equal(@(9));
+        expect([cache objectForKey:@(0)]).to.beNil();
+    });
+
+    it(@"removes objects and keeps the index consistent across table growth", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 0, 0, AUCCacheMemoryEvictionPolicyLRU);
+        NSUInteger count = 1000;
+        for (NSUInteger i = 0; i < count; i++) {
+            [cache setObject:@(i) forKey:[NSString stringWithFormat:@"key-%lu", (unsigned long)i]];
+        }
+        // 删除偶数键，触发探测链的后移压缩
+        for (NSUInteger i = 0; i < count; i += 2) {
+            [cache removeObjectForKey:[NSString stringWithFormat:@"key-%lu", (unsigned long)i]];
+        }
+        expect(cache.totalCount).to.equal(count / 2);
+        for (NSUInteger i = 0; i < count; i++) {
+            id object = [cache objectForKey:[NSString stringWithFormat:@"key-%lu", (unsigned long)i]];
+            if (i % 2 == 0) {
+                expect(object).to.beNil();
+            } else {
+                expect(object).to.equal(@(i));
+            }
+        }
+        [cache removeAllObjects];
+        expect(cache.totalCount).to.equal(0);
+        expect([cache objectForKey:@"key-1"]).to.beNil();
+    });
+
+    it(@"reduces the shard count so each shard keeps a meaningful count share", ^{
+        expect(AUCShardSpecCache(16, 100, 0, AUCCacheMemoryEvictionPolicyLRU).shardCount).to.equal(1);
+        expect(AUCShardSpecCache(16, 256, 0, AUCCacheMemoryEvictionPolicyLRU).shardCount).to.equal(4);
+        expect(AUCShardSpecCache(16, 0, 1000, AUCCacheMemoryEvictionPolicyLRU).shardCount).to.equal(16);
+    });
+
+    it(@"keeps an object larger than the per-shard share of the cost limit", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(16, 0, 1600, AUCCacheMemoryEvictionPolicyLRU);
+        for (NSUInteger i = 0; i < 200; i++) {
+            [cache setObject:@(i) forKey:@(i) cost:10];
+        }
+        // 平均份额为 100，全局限制为 1600
+        [cache setObject:@"large" forKey:@"large" cost:500];
+        expect([cache objectForKey:@"large"]).to.equal(@"large");
+        expect(cache.totalCost).to.beLessThanOrEqualTo(1600);
+        expect(cache.totalCost).to.beGreaterThan(1500);
+    });
+
+    it(@"drops an object that alone exceeds the global cost limit", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(4, 0, 100, AUCCacheMemoryEvictionPolicyLRU);
+        [cache setObject:@"a" forKey:@"a" cost:10];
+        [cache setObject:@"huge" forKey:@"huge" cost:101];
+        expect([cache objectForKey:@"huge"]).to.beNil();
+        expect(cache.totalCost).to.beLessThanOrEqualTo(100);
+    });
+
+    it(@"keeps the last written values and the global totals consistent under concurrent access", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(8, 1024, 0, AUCCacheMemoryEvictionPolicyLRU);
+        // 每个线程独占 64 个键，反复覆盖写入递增的版本，同时读取其他线程的键
+        NSUInteger workers = 8;
+        NSUInteger keysPerWorker = 64;
+        NSUInteger versions = 20;
+        dispatch_apply(workers, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t worker) {
+            for (NSUInteger version = 1; version <= versions; version++) {
+                for (NSUInteger j = 0; j < keysPerWorker; j++) {
+                    NSNumber *key = @(worker * keysPerWorker + j);
+                    [cache setObject:@(version) forKey:key cost:version];
+                    [cache objectForKey:@(((worker + 1) % workers) * keysPerWorker + j)];
+                }
+            }
+        });
+        expect(cache.totalCount).to.equal(workers * keysPerWorker);
+        expect(cache.totalCost).to.equal(workers * keysPerWorker * versions);
+        for (NSUInteger i = 0; i < workers * keysPerWorker; i++) {
+            expect([cache objectForKey:@(i)]).to.equal(@(versions));
+        }
+    });
+
+    it(@"stays within the global limits under concurrent access", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(8, 256, 1500, AUCCacheMemoryEvictionPolicyLRU);
+        dispatch_apply(4000, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            NSNumber *key = @(i % 700);
+            if (![cache objectForKey:key]) {
+                [cache setObject:key forKey:key cost:key.unsignedIntegerValue % 7 + 1];
+            }
+        });
+        expect(cache.totalCount).to.beLessThanOrEqualTo(256);
+        expect(cache.totalCost).to.beLessThanOrEqualTo(1500);
+
+        // 总量等于剩余数据的成本之和
+        NSUInteger count = 0;
+        NSUInteger cost = 0;
+        for (NSUInteger i = 0; i < 700; i++) {
+            NSNumber *object = [cache objectForKey:@(i)];
+            if (!object) continue;
+            expect(object).to.equal(@(i));
+            count++;
+            cost += i % 7 + 1;
+        }
+        expect(cache.totalCount).to.equal(count);
+        expect(cache.totalCost).to.equal(cost);
+    });
+});
+
+describe(@"TinyLFU", ^{
+    it(@"keeps frequently read objects through a one-pass scan", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 100, 0, AUCCacheMemoryEvictionPolicyTinyLFU);
+        // 扫描量低于草图的老化阈值（10 * 128），热点频率不会被减半
+        expect(AUCShardSpecHotSurvivors(cache, 50, 500)).to.equal(50);
+        expect(cache.totalCount).to.equal(100);
+    });
+
+    it(@"differs from LRU, which loses the hot set to the scan", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 100, 0, AUCCacheMemoryEvictionPolicyLRU);
+        expect(AUCShardSpecHotSurvivors(cache, 50, 500)).to.equal(0);
+    });
+
+    it(@"admits new objects while the cache is below its limits", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 100, 0, AUCCacheMemoryEvictionPolicyTinyLFU);
+        for (NSUInteger i = 0; i < 100; i++) {
+            [cache setObject:@(i) forKey:@(i)];
+        }
+        expect(cache.totalCount).to.equal(100);
+        for (NSUInteger i = 0; i < 100; i++) {
+            expect([cache objectForKey:@(i)]).to.equal(@(i));
+        }
+    });
+
+    it(@"still honours the cost limit", ^{
+        AUCShardedMemoryCache *cache = AUCShardSpecCache(1, 0, 1000, AUCCacheMemoryEvictionPolicyTinyLFU);
+        for (NSUInteger i = 0; i < 500; i++) {
+            if (![cache objectForKey:@(i)]) {
+                [cache setObject:@(i) forKey:@(i) cost:10];
+            }
+        }
+        expect(cache.totalCost).to.beLessThanOrEqualTo(1000);
+        expect(cache.totalCost).to.equal(cache.totalCount * 10);
+    });
+});
+
+describe(@"benchmark", ^{
+    it(@"scales better than AUCMemoryCache under multi-threaded access", ^{
+        NSMutableArray<NSString *> *keys = [NSMutableArray array];
+        for (NSUInteger i = 0; i < 10000; i++) {
+            [keys addObject:[NSString stringWithFormat:@"https://example.com/images/%lu.png", (unsigned long)i]];
+        }
+        NSUInteger threads = MAX(NSProcessInfo.processInfo.activeProcessorCount, 2);
+        NSUInteger operations = 200000;
+
+        AUCCacheConfig *config = [[AUCCacheConfig alloc] init];
+        config.shouldUseWeakMemoryCache = NO;
+        double baseline = AUCShardSpecThroughput([[AUCMemoryCache alloc] initWithConfig:config], keys, threads, operations);
+        double sharded = AUCShardSpecThroughput([[AUCShardedMemoryCache alloc] initWithConfig:config], keys, threads, operations);
+        NSLog(@"[AUCShardedMemoryCache] %lu threads: AUCMemoryCache %.0f ops/s, AUCShardedMemoryCache %.0f ops/s (%.2fx)",
+              (unsigned long)threads, baseline, sharded, sharded / baseline);
+        // 吞吐量受运行环境影响较大，只防止明显的退化
+        expect(sharded).to.beGreaterThan(baseline * 0.5);
+    });
+});
+
+describe(@"AUCFrequencySketch", ^{
+    it(@"counts increments up to the 4-bit maximum", ^{
+        AUCFrequencySketch *sketch = [[AUCFrequencySketch alloc] initWithMaximumSize:1024];
+        uint64_t hash = 0x123456789abcdef0ULL;
+        expect([sketch frequency:hash]).to.equal(0);
+        for (NSUInteger i = 0; i < 7; i++) {
+            [sketch increment:hash];
+        }
+        expect([sketch frequency:hash]).to.equal(7);
+        for (NSUInteger i = 0; i < 20; i++) {
+            [sketch increment:hash];
+        }
+        expect([sketch frequency:hash]).to.equal(15);
+        [sketch clear];
+        expect([sketch frequency:hash]).to.equal(0);
+    });
+
+    it(@"halves counters after the sample size is reached", ^{
+        // 最小宽度 16，老化阈值为 160 次有效增加
+        AUCFrequencySketch *sketch = [[AUCFrequencySketch alloc] initWithMaximumSize:16];
+        uint64_t hash = 0x0fedcba987654321ULL;
+        for (NSUInteger i = 0; i < 8; i++) {
+            [sketch increment:hash];
+        }
+        expect([sketch frequency:hash]).to.equal(8);
+        for (uint64_t i = 1; i <= 152; i++) {
+            [sketch increment:i * 0x9e3779b97f4a7c15ULL];
+        }
+        expect([sketch frequency:hash]).to.beLessThan(8);
+    });
+});
+
+SpecEnd